@@ -190,8 +190,11 @@ local hardcoded_projection = {
 -- projection = hardcoded_projection
 
 local view = cglm.mat4()
-view = cglm.translate(view, cglm.vec3(0, 0, -5)) -- Move camera further back
+view:translate_(0, 0, -5) -- Move camera further back
 local model = cglm.mat4_identity()
+-- Reused every frame: the in-place forms below allocate nothing
+local view_projection = cglm.mat4_mul_into(cglm.mat4(), projection, view)
+local mvp = cglm.mat4()
 
 -- Debug matrices
 print("Projection matrix (cglm.perspective):")
@@ -199,6 +202,8 @@ print(tostring(projection))
 print("View matrix:")
 print(tostring(view))
 
+local mvp_loc = gl.get_uniform_location(shader_program, "mvp")
+
 -- Animation variables
 local angle_y = 0
 local angle_z = 0
@@ -218,6 +223,7 @@ while running do
             gl.viewport(0, 0, event.width, event.height)
             projection = cglm.debug_perspective() -- Use debug function
             -- projection = hardcoded_projection -- Uncomment for hardcoded test
+            cglm.mat4_mul_into(view_projection, projection, view)
         end
     end
 
@@ -225,13 +231,12 @@ while running do
     angle_y = angle_y + 0.01
     angle_z = angle_z + 0.01
     -- print("angle_y: " .. angle_y .. ", angle_z: " .. angle_z)
-    model = cglm.mat4_identity()
-    model = cglm.rotate(model, angle_y, cglm.vec3(0, 1, 0)) -- Rotate around Y-axis
-    model = cglm.rotate(model, angle_z, cglm.vec3(0, 0, 1)) -- Rotate around Z-axis
+    model:identity_()
+        :rotate_(angle_y, 0, 1, 0) -- Rotate around Y-axis
+        :rotate_(angle_z, 0, 0, 1) -- Rotate around Z-axis
 
     -- Compute MVP matrix (proj * view * model)
-    local temp = cglm.mat4_mul(view, model)
-    local mvp = cglm.mat4_mul(projection, temp)
+    cglm.mat4_mul_into(mvp, view_projection, model)
 
     -- Debug MVP matrix for first two frames
     -- if angle_y <= 0.02 then
@@ -244,7 +249,6 @@ while running do
     gl.clear(gl.COLOR_BUFFER_BIT | gl.DEPTH_BUFFER_BIT)
 
     gl.use_program(shader_program)
-    local mvp_loc = gl.get_uniform_location(shader_program, "mvp")
     gl.uniform_matrix4fv(mvp_loc, 1, gl.FALSE, mvp)
 
     gl.bind_vertex_array(vao)
@@ -0,0 +1,224 @@
+-- modules
+local sdl = require("module_sdl")
+local gl = require("module_gl")
+local cglm = require("module_cglm")
+local lua_util = require("lua_util")
+
+-- Initialize SDL video subsystem
+local success, err = sdl.init(sdl.INIT_VIDEO)
+if not success then
+    lua_util.log("Failed to initialize SDL: " .. err)
+    sdl.quit()
+    return
+end
+
+-- Create window with OpenGL and resizable flags
+local window, err = sdl.init_window("sdl3 cube3d instanced", 800, 600, sdl.WINDOW_OPENGL + sdl.WINDOW_RESIZABLE)
+if not window then
+    lua_util.log("Failed to create window: " .. err)
+    sdl.quit()
+    return
+end
+
+-- Initialize OpenGL
+local gl_context, success, err = gl.init(window)
+if not success then
+    lua_util.log("Failed to initialize OpenGL: " .. err)
+    gl.destroy()
+    sdl.quit()
+    return
+end
+
+-- Instanced cubes: one draw call, one MVP per instance in a vertex buffer.
+-- The transforms live in cglm arrays and are rebuilt every frame with two bulk
+-- calls, so the frame loop makes no per-cube Lua calls. Cubes outside the view
+-- are culled against bounding spheres first; only the visible ones are drawn.
+local GRID = 100                   -- GRID * GRID * 10 cubes
+local LAYERS = 10
+local COUNT = GRID * GRID * LAYERS
+
+-- Vertex Shader: the per-instance MVP takes attribute locations 2..5
+local vertex_shader_source = [[
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aColor;
+layout (location = 2) in mat4 aMvp;
+out vec3 vertexColor;
+void main() {
+    gl_Position = aMvp * vec4(aPos, 1.0);
+    vertexColor = aColor;
+}
+]]
+
+-- Fragment Shader
+local fragment_shader_source = [[
+#version 330 core
+in vec3 vertexColor;
+out vec4 FragColor;
+void main() {
+    FragColor = vec4(vertexColor, 1.0);
+}
+]]
+
+local function compile(kind, source, name)
+    local shader = gl.create_shader(kind)
+    gl.shader_source(shader, source)
+    local ok, compile_err = gl.compile_shader(shader)
+    if not ok then
+        lua_util.log(name .. " shader compilation failed: " .. compile_err)
+        gl.destroy()
+        sdl.quit()
+        os.exit(1)
+    end
+    return shader
+end
+
+local vertex_shader = compile(gl.VERTEX_SHADER, vertex_shader_source, "Vertex")
+local fragment_shader = compile(gl.FRAGMENT_SHADER, fragment_shader_source, "Fragment")
+
+local shader_program = gl.create_program()
+gl.attach_shader(shader_program, vertex_shader)
+gl.attach_shader(shader_program, fragment_shader)
+success, err = gl.link_program(shader_program)
+if not success then
+    lua_util.log("Shader program linking failed: " .. err)
+    gl.destroy()
+    sdl.quit()
+    return
+end
+
+-- Cube vertex data (8 vertices: x, y, z, r, g, b)
+local vertices = {
+    -0.5, -0.5,  0.5,  1.0, 0.0, 0.0,
+     0.5, -0.5,  0.5,  0.0, 1.0, 0.0,
+     0.5,  0.5,  0.5,  0.0, 0.0, 1.0,
+    -0.5,  0.5,  0.5,  1.0, 1.0, 0.0,
+    -0.5, -0.5, -0.5,  1.0, 0.0, 1.0,
+     0.5, -0.5, -0.5,  0.0, 1.0, 1.0,
+     0.5,  0.5, -0.5,  1.0, 0.5, 0.0,
+    -0.5,  0.5, -0.5,  0.5, 0.5, 0.5
+}
+
+-- Cube indices (36 indices for 12 triangles, counterclockwise winding)
+local indices = {
+    0, 1, 2,  0, 2, 3,
+    1, 5, 6,  1, 6, 2,
+    5, 4, 7,  5, 7, 6,
+    4, 0, 3,  4, 3, 7,
+    3, 2, 6,  3, 6, 7,
+    4, 5, 1,  4, 1, 0
+}
+
+local vertex_data = string.pack(string.rep("f", #vertices), table.unpack(vertices))
+local index_data = string.pack(string.rep("I", #indices), table.unpack(indices))
+
+-- Per-instance state: set up once, then updated in bulk
+local positions = cglm.vec3_array(COUNT)
+local rotations = cglm.vec3_array(COUNT)
+local scales = cglm.vec3_array(COUNT, 0.5, 0.5, 0.5)
+local models = cglm.mat4_array(COUNT)
+local drawn = cglm.mat4_array(COUNT)   -- models of the visible cubes
+local mvps = cglm.mat4_array(COUNT)
+local visible = cglm.index_array(COUNT)
+local i = 0
+for layer = 0, LAYERS - 1 do
+    for z = 0, GRID - 1 do
+        for x = 0, GRID - 1 do
+            positions:set(i, (x - GRID / 2) * 1.5, (layer - LAYERS / 2) * 1.5, -z * 1.5)
+            rotations:set(i, x * 0.1, z * 0.1, layer * 0.3)
+            i = i + 1
+        end
+    end
+end
+-- The cubes do not move, so their bounds are set once: a unit cube scaled by
+-- 0.5 fits in a sphere of radius sqrt(3) / 4 whatever its rotation
+local bounds = cglm.sphere_array(COUNT, math.sqrt(3) / 4):set_centers(positions)
+
+-- Set up VAO, VBO, EBO and the instance buffer
+local vao = gl.gen_vertex_arrays()
+gl.bind_vertex_array(vao)
+
+local vbo = gl.gen_buffers()
+gl.bind_buffer(gl.ARRAY_BUFFER, vbo)
+gl.buffer_data(gl.ARRAY_BUFFER, vertex_data, #vertex_data, gl.STATIC_DRAW)
+gl.vertex_attrib_pointer(0, 3, gl.FLOAT, false, 6 * 4, 0) -- Position (3 floats)
+gl.enable_vertex_attrib_array(0)
+gl.vertex_attrib_pointer(1, 3, gl.FLOAT, false, 6 * 4, 3 * 4) -- Color (3 floats, offset by 3 floats)
+gl.enable_vertex_attrib_array(1)
+
+local ebo = gl.gen_buffers()
+gl.bind_buffer(gl.ELEMENT_ARRAY_BUFFER, ebo)
+gl.buffer_data(gl.ELEMENT_ARRAY_BUFFER, index_data, #index_data, gl.STATIC_DRAW)
+
+local instance_vbo = gl.gen_buffers()
+gl.bind_buffer(gl.ARRAY_BUFFER, instance_vbo)
+gl.buffer_data(gl.ARRAY_BUFFER, mvps, nil, gl.STREAM_DRAW)
+for column = 0, 3 do
+    gl.vertex_attrib_pointer(2 + column, 4, gl.FLOAT, false, 16 * 4, column * 4 * 4)
+    gl.enable_vertex_attrib_array(2 + column)
+    gl.vertex_attrib_divisor(2 + column, 1) -- one matrix per instance
+end
+
+gl.enable(gl.DEPTH_TEST)
+gl.viewport(0, 0, 800, 600)
+
+local projection = cglm.perspective(math.rad(45), 800 / 600, 0.1, 500)
+local view = cglm.mat4()
+view:translate_(0, -5, -40)
+local view_projection = cglm.mat4_mul_into(cglm.mat4(), projection, view)
+local frustum = cglm.frustum(view_projection)
+
+-- Main loop
+local running = true
+while running do
+    -- Handle events
+    local events = sdl.poll_events()
+    for _, event in ipairs(events) do
+        if event.type == sdl.EVENT_QUIT then
+            running = false
+        elseif event.type == sdl.EVENT_WINDOW_RESIZED then
+            gl.viewport(0, 0, event.width, event.height)
+            projection:perspective_(math.rad(45), event.width / math.max(event.height, 1), 0.1, 500)
+            cglm.mat4_mul_into(view_projection, projection, view)
+            frustum:set_(view_projection)
+        end
+    end
+
+    -- Update every instance: bulk calls instead of COUNT Lua calls, then keep
+    -- the visible ones and upload only their MVPs
+    rotations:add_(0.01, 0.013, 0)
+    cglm.mat4_array_compose(models, positions, rotations, scales)
+    local drawn_count = cglm.frustum_cull(frustum, bounds, visible)
+    cglm.mat4_array_gather(drawn, models, visible, drawn_count)
+    cglm.mat4_array_mul(mvps, view_projection, drawn, drawn_count)
+
+    -- Render
+    gl.clear_color(0.2, 0.3, 0.3, 1.0)
+    gl.clear(gl.COLOR_BUFFER_BIT | gl.DEPTH_BUFFER_BIT)
+
+    gl.use_program(shader_program)
+    gl.bind_buffer(gl.ARRAY_BUFFER, instance_vbo)
+    gl.buffer_sub_data(gl.ARRAY_BUFFER, 0, mvps, drawn_count * 16 * 4)
+
+    gl.bind_vertex_array(vao)
+    gl.draw_elements_instanced(gl.TRIANGLES, #indices, gl.UNSIGNED_INT, 0, drawn_count)
+    gl.bind_vertex_array(0)
+
+    -- Check for OpenGL errors
+    local err_code = gl.get_error()
+    if err_code ~= 0 then
+        lua_util.log("OpenGL error: " .. err_code)
+    end
+
+    -- Swap window
+    sdl.gl_swap_window(window)
+end
+
+-- Cleanup
+gl.delete_vertex_arrays({vao})
+gl.delete_buffers({vbo, ebo, instance_vbo})
+gl.delete_shader(vertex_shader)
+gl.delete_shader(fragment_shader)
+gl.delete_program(shader_program)
+gl.destroy()
+sdl.quit()
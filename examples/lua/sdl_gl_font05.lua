@@ -6,6 +6,10 @@ local stb = require("module_stb")
 local lua_util = require("lua_util")
 local cglm = require("module_cglm")
 
+-- Per-frame traces are "debug" in the "font" category, filtered out (and not
+-- formatted) unless enabled with lua_util.log_level("debug", "font")
+local LOG_FONT = lua_util.log_category("font")
+
 -- Initialize SDL video subsystem
 local success, err = sdl.init(sdl.INIT_VIDEO + sdl.INIT_EVENTS)
 if not success then
@@ -332,17 +336,17 @@ while running do
             vertices[#vertices + 1] = s0
             vertices[#vertices + 1] = t1_flipped
             x = x + x_advance
-            lua_util.log(string.format("Char %d: x0=%.2f, y0=%.2f, x1=%.2f, y1=%.2f, s0=%.2f, t0=%.2f, s1=%.2f, t1=%.2f, x_advance=%.2f", char, x0, y0, x1, y1, s0, t0, s1, t1, x_advance))
+            lua_util.logf("debug", LOG_FONT, "Char %d: x0=%.2f, y0=%.2f, x1=%.2f, y1=%.2f, s0=%.2f, t0=%.2f, s1=%.2f, t1=%.2f, x_advance=%.2f", char, x0, y0, x1, y1, s0, t0, s1, t1, x_advance)
         else
-            lua_util.log("Failed to get quad for char " .. char .. ": " .. err)
+            lua_util.logf("warn", LOG_FONT, "Failed to get quad for char %d: %s", char, tostring(err))
         end
     end
     local text_vertexData = ""
     for _, v in ipairs(vertices) do
         text_vertexData = text_vertexData .. string.pack("f", v)
     end
-    lua_util.log("Text vertices: " .. #vertices)
-    lua_util.log("Final text position: x=" .. x .. ", y=" .. y)
+    lua_util.logf("debug", LOG_FONT, "Text vertices: %d", #vertices)
+    lua_util.logf("debug", LOG_FONT, "Final text position: x=%s, y=%s", x, y)
 
     -- Render
     gl.clear_color(0.2, 0.3, 0.3, 1.0)
@@ -359,7 +363,7 @@ while running do
     gl.bind_texture(gl.TEXTURE_2D, image_texture)
     gl.bind_vertex_array(image_vao)
     gl.draw_elements(gl.TRIANGLES, 6, gl.UNSIGNED_INT, 0)
-    lua_util.log("Drew image quad")
+    lua_util.logf("debug", LOG_FONT, "Drew image quad")
 
     -- Draw text quads
     if #vertices > 0 then
@@ -372,7 +376,7 @@ while running do
         gl.bind_buffer(gl.ARRAY_BUFFER, text_vbo)
         gl.buffer_data(gl.ARRAY_BUFFER, text_vertexData, #text_vertexData, gl.DYNAMIC_DRAW)
         gl.draw_arrays(gl.TRIANGLES, 0, #vertices / 4)
-        lua_util.log("Drew text quads")
+        lua_util.logf("debug", LOG_FONT, "Drew text quads")
     end
 
     -- Check for OpenGL errors
@@ -0,0 +1,86 @@
+// app_log.h
+// Asynchronous logger with levels, categories and rate limits. A producer (any
+// thread) first checks the level and rate limit of the message's category, so a
+// filtered message is never formatted, then copies the text into a bounded
+// lock-free ring. A writer thread drains the ring in batches to stdout and an
+// optional log file. When the ring is full the message is dropped and counted;
+// the writer reports dropped counts as "log" warnings.
+//   APP_LOG(APP_LOG_CAT_LUA, APP_LOG_DEBUG, "glyph %d", c);  // arguments not evaluated when filtered
+// Before app_log_init and after app_log_shutdown (tools) messages are written
+// synchronously.
+//
+// Binary log files start with "SLG1", followed by records in native endianness:
+//   category: Uint8 type=1, Uint8 id, Uint8 name_len, name
+//   message:  Uint8 type=2, Uint8 level, Uint8 category, Uint8 pad, Uint32 length, Uint64 time_ns, text
+// A category record comes before the first message of that category.
+// tools/log_dump.lua prints them as text.
+#ifndef APP_LOG_H
+#define APP_LOG_H
+
+#include <SDL3/SDL.h>
+#include <stddef.h>
+
+enum {
+    APP_LOG_TRACE,
+    APP_LOG_DEBUG,
+    APP_LOG_INFO,
+    APP_LOG_WARN,
+    APP_LOG_ERROR,
+    APP_LOG_OFF
+};
+
+#define APP_LOG_CAT_LUA 0           // "Lua": lua_util.log
+#define APP_LOG_CAT_LOG 1           // "log": the logger's own warnings
+#define APP_LOG_MAX_CATEGORIES 64
+
+#define APP_LOG(category, level, ...) \
+    do { if (app_log_enabled((category), (level))) app_log_printf((category), (level), __VA_ARGS__); } while (0)
+
+typedef struct {
+    Uint32 written;             // messages the writer has output
+    Uint32 pending;             // messages in the ring
+    Uint32 dropped_full;        // dropped because the ring was full
+    Uint32 dropped_rate;        // dropped by rate limits, all categories
+} app_log_stats;
+
+// Start the writer thread; 0 on failure (logging stays synchronous)
+int app_log_init(void);
+// Drain the ring, stop the writer and close the log file
+void app_log_shutdown(void);
+// Block until everything logged so far has been written
+void app_log_flush(void);
+
+// Id of the category called name, registered on first use; -1 (SDL_GetError) when
+// all ids are taken or name is longer than 31 characters
+int app_log_category(const char *name);
+const char *app_log_category_name(int category);
+int app_log_category_count(void);
+
+// "trace", "debug", "info", "warn", "error", "off"; -1 for unknown names
+int app_log_level_from_name(const char *name);
+const char *app_log_level_name(int level);
+
+// Minimum level of category; category -1 sets the default of every category
+// without a level of its own (APP_LOG_INFO at startup)
+void app_log_set_level(int category, int level);
+int app_log_get_level(int category);
+// At most per_sec messages per second from category, 0 for no limit
+void app_log_set_rate(int category, int per_sec);
+int app_log_get_rate(int category);
+Uint32 app_log_category_dropped(int category);
+
+// Whether level passes the category filter, without touching the rate limit
+int app_log_enabled(int category, int level);
+// Filter and rate limit: 1 when a message may be submitted (and formatted)
+int app_log_admit(int category, int level);
+// Queue an admitted message, text is copied
+void app_log_submit(int category, int level, const char *text, size_t len);
+// app_log_admit + app_log_submit
+void app_log_write(int category, int level, const char *text);
+void app_log_printf(int category, int level, SDL_PRINTF_FORMAT_STRING const char *fmt, ...) SDL_PRINTF_VARARG_FUNC(3);
+
+// Also write to path, as text or in the binary format; NULL closes the file. 0 on failure.
+int app_log_open_file(const char *path, int binary);
+void app_log_get_stats(app_log_stats *stats);
+
+#endif // APP_LOG_H
@@ -0,0 +1,67 @@
+// asset_pack.h
+// Read-only asset packs built by tools/pack_tool.c. A pack is memory-mapped
+// when mounted; lookups are a binary search of its index, so opening an asset
+// costs no syscalls. Stored entries are handed out as lua_blob views of the
+// mapping (no copy), LZ4 entries are decompressed into a new blob. The mapping
+// stays alive until the pack is unmounted and every view is released.
+//
+// Packs are consulted before the file system by the package.searchers entry
+// (script_cache.c), stb.load_image, stb.bake_font, audio sources,
+// lua_util.await_load and lua_util.load_asset. Later mounts shadow earlier ones.
+// Mounting is safe while job workers look assets up (a reader-writer lock).
+//
+// Layout (little endian):
+//   asset_pack_header
+//   asset_pack_entry[count], sorted by hash, then name
+//   names (not NUL-terminated)
+//   entry data, each entry aligned to 16 bytes
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+#include "lua_blob.h"
+#include <SDL3/SDL.h>
+
+#define ASSET_PACK_MAGIC "SPAK"
+#define ASSET_PACK_VERSION 1
+#define ASSET_PACK_LZ4 1            // asset_pack_entry.flags: data is an LZ4 block
+#define ASSET_PACK_MAX_MOUNTS 16
+
+typedef struct {
+    char magic[4];
+    Uint32 version;
+    Uint32 count;
+    Uint32 reserved;
+    Uint64 names_offset;
+    Uint64 names_size;
+} asset_pack_header;
+
+typedef struct {
+    Uint64 hash;                // asset_pack_hash of the name
+    Uint64 offset;              // from the start of the file
+    Uint64 size;                // stored size
+    Uint64 raw_size;            // size after decompression
+    Uint32 name_offset;         // into the names block
+    Uint32 name_len;
+    Uint32 flags;
+    Uint32 reserved;
+} asset_pack_entry;
+
+// FNV-1a 64 of a normalized path ("examples/lua/a.lua": no "./", '/' separators)
+Uint64 asset_pack_hash(const char *name, size_t len);
+// "./examples\lua/a.lua" -> "examples/lua/a.lua", the form entry names use
+void asset_pack_normalize(const char *path, char *out, size_t out_size);
+
+// Map a pack and add it to the search list; 0 on failure (SDL_GetError)
+int asset_pack_mount(const char *path);
+void asset_pack_unmount_all(void);
+int asset_pack_mount_count(void);
+
+// Whether path is in a mounted pack
+int asset_pack_contains(const char *path);
+// New reference to the contents of path, NULL if no pack has it (or on a
+// corrupt entry, with SDL_GetError set)
+lua_blob *asset_pack_load(const char *path);
+// SDL_LoadFile from the packs, then the file system; free with SDL_free
+void *asset_pack_load_file(const char *path, size_t *size);
+
+#endif // ASSET_PACK_H
@@ -0,0 +1,29 @@
+// frustum_cull.h
+// View-frustum culling of bounding spheres or boxes stored as
+// structure-of-arrays columns. Each volume is tested against the six planes
+// with 8-wide (AVX), 4-wide (SSE2, NEON) or scalar code, whichever the build
+// targets, and the indices of the volumes that are at least partly inside are
+// written out in ascending order, ready for gathering instance data.
+//
+// A volume is outside when, for some plane, signed distance < -radius, where
+// the radius of a box is its half extents projected onto the plane normal.
+// The test is conservative: a few volumes near frustum corners are kept.
+#ifndef FRUSTUM_CULL_H
+#define FRUSTUM_CULL_H
+
+#include <SDL3/SDL.h>
+
+// Planes as (a, b, c, d) with unit normals pointing inwards: inside where
+// a*x + b*y + c*z + d >= 0 (glm_frustum_planes order and form)
+typedef float frustum_planes[6][4];
+
+typedef struct {
+    const float *cx, *cy, *cz;  // centers
+    const float *ex;            // radius of spheres, half extent x of boxes
+    const float *ey, *ez;       // half extents y and z of boxes, NULL for spheres
+} frustum_bounds;
+
+// Indices i < count of the visible volumes into out (room for count); their number
+Uint32 frustum_cull(const frustum_planes planes, const frustum_bounds *b, Uint32 count, Uint32 *out);
+
+#endif // FRUSTUM_CULL_H
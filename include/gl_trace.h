@@ -0,0 +1,101 @@
+// gl_trace.h
+// Binary GL call trace format shared by module_gl (recorder) and sdl3_gl_replay (replayer).
+//
+// File layout:
+//   gl_trace_header
+//   gl_trace_record, argc * gl_trace_arg, payload bytes   (repeated)
+//
+// Object names returned by GL (shaders, programs, buffers, ...) are recorded as the
+// last argument of the creating call so the replayer can map them to its own names.
+#ifndef GL_TRACE_H
+#define GL_TRACE_H
+
+#include <stdint.h>
+
+#define GL_TRACE_MAGIC 0x52544C47u // "GLTR"
+#define GL_TRACE_VERSION 1
+
+// X(id, name)
+#define GL_TRACE_CALLS(X) \
+    X(FRAME_END, "frame_end") \
+    X(CLEAR, "clear") \
+    X(CLEAR_COLOR, "clear_color") \
+    X(VIEWPORT, "viewport") \
+    X(CREATE_SHADER, "create_shader") \
+    X(DELETE_SHADER, "delete_shader") \
+    X(SHADER_SOURCE, "shader_source") \
+    X(COMPILE_SHADER, "compile_shader") \
+    X(CREATE_PROGRAM, "create_program") \
+    X(DELETE_PROGRAM, "delete_program") \
+    X(ATTACH_SHADER, "attach_shader") \
+    X(LINK_PROGRAM, "link_program") \
+    X(USE_PROGRAM, "use_program") \
+    X(GEN_VERTEX_ARRAYS, "gen_vertex_arrays") \
+    X(BIND_VERTEX_ARRAY, "bind_vertex_array") \
+    X(GEN_BUFFERS, "gen_buffers") \
+    X(BIND_BUFFER, "bind_buffer") \
+    X(BUFFER_DATA, "buffer_data") \
+    X(VERTEX_ATTRIB_POINTER, "vertex_attrib_pointer") \
+    X(ENABLE_VERTEX_ATTRIB_ARRAY, "enable_vertex_attrib_array") \
+    X(DRAW_ARRAYS, "draw_arrays") \
+    X(GEN_TEXTURES, "gen_textures") \
+    X(BIND_TEXTURE, "bind_texture") \
+    X(TEX_IMAGE_2D, "tex_image_2d") \
+    X(TEX_PARAMETER_I, "tex_parameter_i") \
+    X(DRAW_ELEMENTS, "draw_elements") \
+    X(UNIFORM_MATRIX4FV, "uniform_matrix4fv") \
+    X(GET_UNIFORM_LOCATION, "get_uniform_location") \
+    X(UNIFORM1I, "uniform1i") \
+    X(UNIFORM1F, "uniform1f") \
+    X(UNIFORM4F, "uniform4f") \
+    X(ACTIVE_TEXTURE, "active_texture") \
+    X(ENABLE, "enable") \
+    X(DISABLE, "disable") \
+    X(GET_ERROR, "get_error") \
+    X(BLEND_FUNC, "blend_func") \
+    X(DELETE_TEXTURES, "delete_textures") \
+    X(DELETE_BUFFERS, "delete_buffers") \
+    X(DELETE_VERTEX_ARRAYS, "delete_vertex_arrays") \
+    X(CULL_FACE, "cull_face") \
+    X(POLYGON_MODE, "polygon_mode") \
+    X(GET_INTEGER, "get_integer") \
+    X(BUFFER_SUB_DATA, "buffer_sub_data") \
+    X(BIND_BUFFER_BASE, "bind_buffer_base") \
+    X(VERTEX_ATTRIB_DIVISOR, "vertex_attrib_divisor") \
+    X(DRAW_ARRAYS_INSTANCED, "draw_arrays_instanced") \
+    X(DRAW_ELEMENTS_INSTANCED, "draw_elements_instanced")
+
+#define GL_TRACE_ENUM(id, name) GLT_##id,
+enum gl_trace_call {
+    GL_TRACE_CALLS(GL_TRACE_ENUM)
+    GLT_COUNT
+};
+#undef GL_TRACE_ENUM
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t start_ns;      // SDL_GetTicksNS() when recording started
+} gl_trace_header;
+
+typedef struct {
+    uint16_t call;          // enum gl_trace_call
+    uint8_t argc;           // number of gl_trace_arg following the record
+    uint8_t reserved;
+    uint32_t payload_size;  // bytes following the args (sources, buffer data, pixels)
+    uint64_t time_ns;       // CPU timestamp relative to gl_trace_header.start_ns
+} gl_trace_record;
+
+typedef union {
+    int64_t i;
+    double f;
+} gl_trace_arg;
+
+static inline const char *gl_trace_call_name(int call) {
+#define GL_TRACE_NAME(id, name) name,
+    static const char *const names[] = { GL_TRACE_CALLS(GL_TRACE_NAME) };
+#undef GL_TRACE_NAME
+    return (call >= 0 && call < GLT_COUNT) ? names[call] : "unknown";
+}
+
+#endif // GL_TRACE_H
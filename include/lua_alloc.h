@@ -0,0 +1,54 @@
+// lua_alloc.h
+// Lua allocator with size-class pools for small objects and per-module accounting.
+//   lua_State *L = lua_newstate(lua_alloc_fn, lua_alloc_create());
+//   ...
+//   void *ud; lua_getallocf(L, &ud); lua_close(L); lua_alloc_destroy(ud);
+#ifndef LUA_ALLOC_H
+#define LUA_ALLOC_H
+
+#include <lua.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Who a block is accounted to. Userdata created with lua_alloc_newuserdata carry
+// their module's tag, everything else Lua allocates is LUA_TAG_LUA.
+typedef enum {
+    LUA_TAG_LUA,
+    LUA_TAG_SDL,
+    LUA_TAG_CGLM,
+    LUA_TAG_STB,
+    LUA_TAG_ENET,
+    LUA_TAG_AUDIO,
+    LUA_TAG_COUNT
+} lua_alloc_tag;
+
+typedef struct {
+    size_t live_bytes;
+    size_t peak_bytes;
+    uint64_t allocs;            // allocations since the state was created
+} lua_alloc_tag_stats;
+
+typedef struct {
+    size_t live_bytes;          // bytes Lua has asked for and not freed
+    size_t peak_bytes;
+    size_t pool_bytes;          // memory held in pool pages
+    size_t large_bytes;         // blocks above the largest size class
+    uint64_t allocs;
+    uint64_t total_bytes;       // bytes allocated since the state was created
+    lua_alloc_tag_stats tags[LUA_TAG_COUNT];
+} lua_alloc_stats;
+
+void *lua_alloc_create(void);
+void lua_alloc_destroy(void *ud);
+void *lua_alloc_fn(void *ud, void *ptr, size_t osize, size_t nsize);
+
+// Allocate a full userdata accounted to tag (plain lua_newuserdatauv under other allocators)
+void *lua_alloc_newuserdata(lua_State *L, size_t size, int nuvalue, lua_alloc_tag tag);
+// Fill out with the stats of L's allocator, returns 0 if L does not use lua_alloc_fn
+int lua_alloc_get_stats(lua_State *L, lua_alloc_stats *out);
+// Allocations per second of L's allocator since the previous call (or since it
+// was created). Each allocator keeps its own sample, so states do not interfere.
+double lua_alloc_sample_rate(lua_State *L);
+const char *lua_alloc_tag_name(int tag);
+
+#endif // LUA_ALLOC_H
@@ -0,0 +1,45 @@
+// lua_blob.h
+// Immutable, reference-counted byte blobs ("lua_blob" userdata). The bytes live
+// outside any lua_State, so one blob can be held by the main state, worker states
+// (module_jobs passes blobs by reference) and C consumers (enet packets) at once.
+// gl.buffer_data, gl.tex_image_2d, enet.packet_create and the stb loaders read
+// blobs in place.
+//   lua_blob *b = lua_blob_create(size);   // refs = 1
+//   SDL_memcpy(lua_blob_bytes(b), src, size);
+//   lua_blob_push(L, b);                    // the userdata now owns that ref
+#ifndef LUA_BLOB_H
+#define LUA_BLOB_H
+
+#include <lua.h>
+#include <stddef.h>
+
+#define LUA_BLOB_MT "lua_blob"
+
+typedef struct lua_blob lua_blob;
+typedef void (*lua_blob_free_fn)(void *data, void *userdata);
+
+// New blob with size uninitialized bytes, fill it before sharing it. NULL on failure.
+lua_blob *lua_blob_create(size_t size);
+// Adopt existing memory, free_fn(data, userdata) runs when the last ref is released
+lua_blob *lua_blob_wrap(void *data, size_t size, lua_blob_free_fn free_fn, void *userdata);
+// Sub-range of parent sharing its bytes, keeps parent alive
+lua_blob *lua_blob_view(lua_blob *parent, size_t offset, size_t size);
+
+// Thread-safe
+void lua_blob_retain(lua_blob *blob);
+void lua_blob_release(lua_blob *blob);
+
+const void *lua_blob_data(const lua_blob *blob);
+size_t lua_blob_size(const lua_blob *blob);
+// Writable bytes of a blob from lua_blob_create, only until it is shared
+void *lua_blob_bytes(lua_blob *blob);
+
+// Push a userdata that takes over one reference of blob
+void lua_blob_push(lua_State *L, lua_blob *blob);
+// Blob at idx or NULL if the value is not one (or was released)
+lua_blob *lua_blob_test(lua_State *L, int idx);
+lua_blob *lua_blob_check(lua_State *L, int idx);
+// Bytes of a blob or string at idx without copying, NULL for other values
+const void *lua_blob_tobytes(lua_State *L, int idx, size_t *size);
+
+#endif // LUA_BLOB_H
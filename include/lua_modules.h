@@ -0,0 +1,18 @@
+// lua_modules.h
+// Registers the C modules in package.preload, shared by the main state and the
+// module_jobs worker states.
+#ifndef LUA_MODULES_H
+#define LUA_MODULES_H
+
+#include <lua.h>
+
+// Main thread: every module. Workers: no GL, ImGui, audio, test or jobs.
+#define LUA_MODULES_MAIN 0
+#define LUA_MODULES_WORKER 1
+
+void lua_modules_preload(lua_State *L, int kind);
+// Kind the state was preloaded as; LUA_MODULES_MAIN for states not preloaded
+// (tools). Modules use it to leave out functions that keep process-wide state.
+int lua_modules_kind(lua_State *L);
+
+#endif // LUA_MODULES_H
@@ -0,0 +1,8 @@
+#ifndef MODULE_AUDIO_H
+#define MODULE_AUDIO_H
+
+#include <lua.h>
+
+int luaopen_module_audio(lua_State *L);
+
+#endif // MODULE_AUDIO_H
@@ -2,7 +2,24 @@
 #define MODULE_CGLM_H
 
 #include <lua.h>
+#include <stddef.h>
 
 int luaopen_module_cglm(lua_State *L);
 
-#endif // MODULE_GL_H
\ No newline at end of file
+// Contiguous arrays of transforms, points and indices ("cglm.mat4_array",
+// "cglm.vec3_array" and "cglm.index_array" userdata). module_gl uploads them
+// without a copy.
+#define CGLM_MAT4_ARRAY_MT "cglm.mat4_array"
+#define CGLM_VEC3_ARRAY_MT "cglm.vec3_array"
+#define CGLM_INDEX_ARRAY_MT "cglm.index_array"
+#define CGLM_ARRAY_MAX (1 << 24)    // elements per array
+typedef struct {
+    void *data;                     // 64-byte aligned, count * width floats (Uint32 for indices)
+    unsigned int count;
+    int width;                      // values per element: 16 (mat4), 3 (vec3) or 1 (index)
+} cglm_array;
+
+// Data of the array at idx, NULL if the value is not one; size in bytes
+const void *module_cglm_test_array(lua_State *L, int idx, size_t *size);
+
+#endif // MODULE_CGLM_H
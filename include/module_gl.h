@@ -5,4 +5,15 @@
 
 int luaopen_module_gl(lua_State *L);
 
-#endif // MODULE_GL_H
\ No newline at end of file
+// GL call trace recording (see gl_trace.h for the file format)
+int module_gl_trace_begin(const char *path);
+void module_gl_trace_end(void);
+// Marks the end of a frame in the trace, called on buffer swap
+void module_gl_trace_frame(void);
+// Non-blocking fence check: 1 signaled, 0 pending, -1 wait failed
+int module_gl_sync_status(void *sync);
+// Use a context made outside gl.init (tools/bench_bindings.c passes a dummy
+// with GLAD loaded from stubs). gl.destroy will destroy it.
+void module_gl_set_context(void *context);
+
+#endif // MODULE_GL_H
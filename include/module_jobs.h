@@ -0,0 +1,17 @@
+#ifndef MODULE_JOBS_H
+#define MODULE_JOBS_H
+
+#include <lua.h>
+
+int luaopen_module_jobs(lua_State *L);
+
+// Run fn(userdata, i) for every i in [0, count) on the job workers and the
+// calling thread; returns when all calls have finished. Workers take indices
+// between Lua jobs. Runs inline before jobs.init, when count is 1, or while
+// another batch is running. fn must not touch any lua_State.
+typedef void (*module_jobs_task_fn)(void *userdata, int index);
+void module_jobs_parallel_for(int count, module_jobs_task_fn fn, void *userdata);
+// Number of worker threads, 0 before jobs.init
+int module_jobs_thread_count(void);
+
+#endif // MODULE_JOBS_H
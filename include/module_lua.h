@@ -5,4 +5,18 @@
 
 int luaopen_module_lua(lua_State *L);
 
+// Step the collector for at most min(slack_ms, budget) when lua_util.gc_frame_budget
+// is set, no-op otherwise and on job workers. Called by sdl.run before each swap.
+void module_lua_gc_frame(lua_State *L, double slack_ms);
+// Reload required modules whose files changed when lua_util.hot_reload is on,
+// no-op otherwise and on job workers. Called by sdl.run once per frame.
+void module_lua_reload_poll(lua_State *L);
+// One task scheduler tick: wake due timers, finished loads and signaled fences,
+// then resume the ready tasks. Called by sdl.run once per frame. Returns resumed count.
+// The scheduler serves the main state only: on job workers this and
+// module_lua_tasks_signal do nothing and return 0.
+int module_lua_tasks_tick(lua_State *L);
+// Wake the tasks in lua_util.await(key) with the value at value_idx, returns how many
+int module_lua_tasks_signal(lua_State *L, int key_idx, int value_idx);
+
 #endif // MODULE_LUA_H
\ No newline at end of file
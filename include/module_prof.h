@@ -0,0 +1,24 @@
+#ifndef MODULE_PROF_H
+#define MODULE_PROF_H
+
+#include <lua.h>
+
+int luaopen_module_prof(lua_State *L);
+
+// CPU profiler zones recorded into per-thread rings with SDL_GetPerformanceCounter.
+// Zone names are interned (copied) once and referred to by id afterwards.
+int prof_register_name(const char *name);
+void prof_begin(int name_id);
+void prof_end(void);
+// Write all recorded zones as Chrome trace JSON (chrome://tracing, ui.perfetto.dev)
+int prof_export_chrome(const char *path);
+
+// Zone macros for use inside the C modules, the name lookup runs once per call site
+#define PROF_BEGIN(name) do { \
+        static int prof_zone_id_ = -1; \
+        if (prof_zone_id_ < 0) prof_zone_id_ = prof_register_name(name); \
+        prof_begin(prof_zone_id_); \
+    } while (0)
+#define PROF_END() prof_end()
+
+#endif // MODULE_PROF_H
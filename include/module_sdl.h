@@ -5,4 +5,37 @@
 
 int luaopen_module_sdl(lua_State *L);
 
-#endif // MODULE_SDL_H
\ No newline at end of file
+// Typed byte buffer returned by the async file loader ("sdl.buffer" userdata).
+// module_stb and module_gl accept it wherever they take pixel or vertex data.
+#define SDL_BUFFER_MT "sdl.buffer"
+typedef struct {
+    void *data;  // SDL_malloc'd, NULL once freed
+    size_t size;
+} sdl_buffer;
+
+// Push a buffer that takes ownership of data (allocated with SDL_malloc)
+sdl_buffer *module_sdl_push_buffer(lua_State *L, void *data, size_t size);
+// Return the buffer at idx or NULL if the value is not one
+sdl_buffer *module_sdl_test_buffer(lua_State *L, int idx);
+
+// Headless run mode (set from main before the script runs)
+// frames: number of swapped frames before an SDL_EVENT_QUIT is pushed
+// video_driver: SDL video driver to force, NULL for "offscreen"
+// Returns 0 if the frame-time buffer could not be allocated (SDL_GetError)
+int module_sdl_set_headless(int frames, const char *video_driver);
+int module_sdl_is_headless(void);
+// Free the frame times, after the report
+void module_sdl_headless_end(void);
+// Print the headless frame-time report, optionally also as JSON to json_path
+void module_sdl_frame_report(const char *json_path);
+// Set the GL swap interval for the current context (-1 adaptive, 0 off, 1 vsync).
+// Adaptive falls back to vsync. Returns the applied interval, -2 on failure.
+int module_sdl_set_swap_interval(int interval);
+// Input recording / replay of the events returned by the poll functions.
+// Replay injects the recorded events with SDL_PushEvent on the same frame numbers
+// (counted in swaps) and ignores live input; quit_at_end pushes EVENT_QUIT when done.
+int module_sdl_record_begin(const char *path);
+void module_sdl_record_end(void);
+int module_sdl_replay_begin(const char *path, int quit_at_end);
+
+#endif // MODULE_SDL_H
@@ -0,0 +1,54 @@
+// scene_graph.h
+// Transform hierarchy stored as structure-of-arrays in depth-first order: a
+// node's descendants directly follow it, so every subtree is one contiguous
+// range of slots and every parent comes before its children. Setting a local
+// position, rotation or scale marks the node dirty; scene_graph_update
+// recomputes world matrices only for dirty subtrees
+//   world = parent world * translate(position) * rotate_xyz(rotation) * scale(scale)
+// so a frame where nothing moved costs nothing. With parallel set, disjoint
+// dirty subtrees are spread over the job workers (module_jobs_parallel_for).
+//
+// Nodes are referred to by ids, which stay valid until the node is removed
+// (ids of removed nodes are reused). Adding, removing or reparenting a node
+// moves the slots after it, O(nodes); transform changes are O(1).
+#ifndef SCENE_GRAPH_H
+#define SCENE_GRAPH_H
+
+#define SCENE_GRAPH_NONE -1
+#define SCENE_GRAPH_MAX_NODES (1 << 24)
+
+typedef struct scene_graph scene_graph;
+
+// NULL on failure
+scene_graph *scene_graph_create(int capacity);
+void scene_graph_destroy(scene_graph *g);
+
+// New node under parent (SCENE_GRAPH_NONE for a root) with an identity local
+// transform; its id, or -1 when out of memory
+int scene_graph_add(scene_graph *g, int parent);
+// Remove id and all of its descendants
+void scene_graph_remove(scene_graph *g, int id);
+// Move id and its subtree under parent (SCENE_GRAPH_NONE: make it a root);
+// 0 when parent is id or one of its descendants, or out of memory
+int scene_graph_set_parent(scene_graph *g, int id, int parent);
+
+int scene_graph_valid(const scene_graph *g, int id);
+int scene_graph_parent(const scene_graph *g, int id);
+int scene_graph_count(const scene_graph *g);
+// Every live id is below this
+int scene_graph_id_limit(const scene_graph *g);
+
+// Local transform; rotation is Euler angles in radians, applied X, then Y, then Z
+void scene_graph_set_position(scene_graph *g, int id, const float v[3]);
+void scene_graph_set_rotation(scene_graph *g, int id, const float v[3]);
+void scene_graph_set_scale(scene_graph *g, int id, const float v[3]);
+void scene_graph_get_position(const scene_graph *g, int id, float out[3]);
+void scene_graph_get_rotation(const scene_graph *g, int id, float out[3]);
+void scene_graph_get_scale(const scene_graph *g, int id, float out[3]);
+
+// Recompute the world matrices of dirty subtrees; the number recomputed
+int scene_graph_update(scene_graph *g, int parallel);
+// World matrix of id as of the last update: 16 floats, column-major
+const float *scene_graph_world(const scene_graph *g, int id);
+
+#endif // SCENE_GRAPH_H
@@ -0,0 +1,33 @@
+// script_cache.h
+// Loads Lua scripts as precompiled bytecode instead of reparsing the source on
+// every start. Sources, checked in this order:
+//   - mounted asset packs (asset_pack.h): compiled from the mapped pack, not cached
+//   - files on disk, through the disk cache: lua_dump output stored under
+//     cache_dir, keyed on the script path and validated against its mtime and a
+//     hash of its source; misses are compiled from source (and cached)
+//   - the embedded bundle (SDL3_LUA_EMBED_SCRIPTS build option): stripped bytecode
+//     compiled into the binary by tools/lua_embed.c, for scripts not on disk
+#ifndef SCRIPT_CACHE_H
+#define SCRIPT_CACHE_H
+
+#include <lua.h>
+#include <stddef.h>
+
+typedef struct {
+    const char *path;           // relative path with '/' separators, e.g. "examples/lua/triangle.lua"
+    const unsigned char *data;  // stripped bytecode
+    size_t size;
+} script_bundle_entry;
+
+// Set the disk cache directory (created on first write), NULL disables the disk cache.
+// Also adds a package.searchers entry so require() goes through the cache.
+void script_cache_init(lua_State *L, const char *cache_dir);
+// Add the package.searchers entry to another state (worker threads), keeping the
+// directory set by script_cache_init
+void script_cache_install(lua_State *L);
+// Like luaL_loadfile: pushes the compiled chunk, or an error message and returns non-zero
+int script_cache_loadfile(lua_State *L, const char *path);
+// Whether path is in the embedded bundle
+int script_cache_is_bundled(const char *path);
+
+#endif // SCRIPT_CACHE_H
@@ -0,0 +1,507 @@
+// app_log.c
+// The ring is a bounded Vyukov queue (as in module_jobs) with the record stored
+// in the cell, so producers never allocate except for text longer than
+// LOG_INLINE_TEXT. The writer is the only consumer. Output goes through
+// per-sink buffers, one write per batch, under the output mutex; synchronous
+// logging takes the same mutex. It is a mutex, not a spinlock, because it is
+// held across file writes.
+#include "app_log.h"
+#include <stdio.h>
+
+#define LOG_RING_SIZE 4096          // power of two
+#define LOG_INLINE_TEXT 224
+#define LOG_WAKE_MASK 1023          // also wake the writer every 1024 messages
+#define LOG_FLUSH_INTERVAL_MS 10
+#define LOG_OUT_BUFFER 16384
+#define LOG_FILE_MAGIC "SLG1"
+
+enum { RECORD_CATEGORY = 1, RECORD_MESSAGE = 2 };
+
+typedef struct {
+    SDL_AtomicInt sequence;
+    Uint8 level;
+    Uint8 category;
+    Uint32 length;
+    Uint64 time_ns;
+    char *long_text;            // heap copy when length > LOG_INLINE_TEXT
+    char text[LOG_INLINE_TEXT];
+} log_cell;
+
+typedef struct {
+    char name[32];
+    int level;
+    int has_level;              // set explicitly, not following the default
+    int rate;                   // messages per second, 0 = unlimited
+    SDL_AtomicU32 window;       // current second of the rate limit
+    SDL_AtomicInt window_count;
+    SDL_AtomicInt dropped;
+    int reported;               // dropped count already reported, under the output mutex
+} log_category;
+
+typedef struct {
+    SDL_IOStream *io;           // NULL: stdout
+    size_t len;
+    char data[LOG_OUT_BUFFER];
+} log_out;
+
+typedef struct {
+    log_out out;
+    int binary;
+    Uint64 categories_written;  // binary: category records already in the file
+} log_file;
+
+static const char *const level_names[] = {"trace", "debug", "info", "warn", "error", "off"};
+static const char *const level_labels[] = {"TRACE", "DEBUG", "", "WARN", "ERROR", ""};
+
+static log_category g_categories[APP_LOG_MAX_CATEGORIES] = {
+    {.name = "Lua", .level = APP_LOG_INFO},
+    {.name = "log", .level = APP_LOG_INFO},
+};
+static SDL_AtomicInt g_category_count = {2};
+static SDL_SpinLock g_category_lock;
+static int g_default_level = APP_LOG_INFO;
+
+static log_out g_console;
+
+static struct {
+    int running;
+    log_cell *cells;
+    Uint32 mask;
+    SDL_AtomicInt enqueue_pos;
+    char pad[64];               // keep producers and the writer on separate cache lines
+    Uint32 dequeue_pos;         // writer only
+    SDL_AtomicInt written_pos;
+    SDL_AtomicInt dropped_full;
+    int reported_full;          // under the output mutex
+    Uint32 written_sync;        // under the output mutex
+    SDL_Semaphore *wake;
+    SDL_AtomicInt quit;
+    SDL_Thread *thread;
+    log_file *file;
+} g_log;
+
+static void *g_out_mutex;           // SDL_Mutex, created on first use, lives for the process
+static SDL_SpinLock g_out_mutex_create;
+
+// Helper: Lock the outputs; logging works before app_log_init, so the mutex is
+// created lazily (SDL_LockMutex(NULL) is a no-op if that failed)
+static void lock_outputs(void) {
+    SDL_Mutex *m = (SDL_Mutex *)SDL_GetAtomicPointer(&g_out_mutex);
+    if (!m) {
+        SDL_LockSpinlock(&g_out_mutex_create);
+        m = (SDL_Mutex *)SDL_GetAtomicPointer(&g_out_mutex);
+        if (!m) {
+            m = SDL_CreateMutex();
+            SDL_SetAtomicPointer(&g_out_mutex, m);
+        }
+        SDL_UnlockSpinlock(&g_out_mutex_create);
+    }
+    SDL_LockMutex(m);
+}
+
+static void unlock_outputs(void) {
+    SDL_UnlockMutex((SDL_Mutex *)SDL_GetAtomicPointer(&g_out_mutex));
+}
+
+//===============================================
+// output
+//===============================================
+
+static void out_raw(log_out *o, const void *data, size_t size) {
+    if (o->io) SDL_WriteIO(o->io, data, size);
+    else fwrite(data, 1, size, stdout);
+}
+
+static void out_flush(log_out *o) {
+    if (o->len == 0) return;
+    out_raw(o, o->data, o->len);
+    o->len = 0;
+}
+
+static void out_write(log_out *o, const void *data, size_t size) {
+    if (o->len + size > sizeof(o->data)) {
+        out_flush(o);
+        if (size > sizeof(o->data)) {
+            out_raw(o, data, size);
+            return;
+        }
+    }
+    SDL_memcpy(o->data + o->len, data, size);
+    o->len += size;
+}
+
+// Helper: "[Lua] " for info, "[Lua] WARN: " for other levels
+static size_t format_prefix(char *out, size_t out_size, int category, int level) {
+    const char *label = level_labels[level < APP_LOG_OFF ? level : APP_LOG_INFO];
+    int n = label[0]
+        ? SDL_snprintf(out, out_size, "[%s] %s: ", g_categories[category].name, label)
+        : SDL_snprintf(out, out_size, "[%s] ", g_categories[category].name);
+    return n < 0 ? 0 : SDL_min((size_t)n, out_size - 1);
+}
+
+// Write one message to the console and the log file, under the output mutex
+static void output_message(int category, int level, Uint64 time_ns, const char *text, size_t len) {
+    char prefix[64];
+    size_t prefix_len = format_prefix(prefix, sizeof(prefix), category, level);
+    out_write(&g_console, prefix, prefix_len);
+    out_write(&g_console, text, len);
+    out_write(&g_console, "\n", 1);
+
+    log_file *f = g_log.file;
+    if (!f) return;
+    if (f->binary) {
+        Uint64 bit = (Uint64)1 << category;
+        if (!(f->categories_written & bit)) {
+            const char *name = g_categories[category].name;
+            Uint8 head[3] = {RECORD_CATEGORY, (Uint8)category, (Uint8)SDL_strlen(name)};
+            out_write(&f->out, head, sizeof(head));
+            out_write(&f->out, name, head[2]);
+            f->categories_written |= bit;
+        }
+        Uint8 head[4] = {RECORD_MESSAGE, (Uint8)level, (Uint8)category, 0};
+        Uint32 length = (Uint32)len;
+        out_write(&f->out, head, sizeof(head));
+        out_write(&f->out, &length, sizeof(length));
+        out_write(&f->out, &time_ns, sizeof(time_ns));
+        out_write(&f->out, text, len);
+    } else {
+        char stamp[32];
+        int n = SDL_snprintf(stamp, sizeof(stamp), "[%.3f] ", (double)time_ns / 1e9);
+        out_write(&f->out, stamp, (size_t)n);
+        out_write(&f->out, prefix, prefix_len);
+        out_write(&f->out, text, len);
+        out_write(&f->out, "\n", 1);
+    }
+}
+
+// Report new drops as "log" warnings, under the output mutex
+static void report_drops(void) {
+    char msg[160];
+    int full = SDL_GetAtomicInt(&g_log.dropped_full);
+    if (full != g_log.reported_full) {
+        int n = SDL_snprintf(msg, sizeof(msg), "%d messages dropped, log queue full", full - g_log.reported_full);
+        output_message(APP_LOG_CAT_LOG, APP_LOG_WARN, SDL_GetTicksNS(), msg, (size_t)n);
+        g_log.reported_full = full;
+    }
+    int count = SDL_GetAtomicInt(&g_category_count);
+    for (int i = 0; i < count; i++) {
+        log_category *c = &g_categories[i];
+        int dropped = SDL_GetAtomicInt(&c->dropped);
+        if (dropped != c->reported) {
+            int n = SDL_snprintf(msg, sizeof(msg), "%d '%s' messages over the rate limit of %d/s",
+                                 dropped - c->reported, c->name, c->rate);
+            output_message(APP_LOG_CAT_LOG, APP_LOG_WARN, SDL_GetTicksNS(), msg, (size_t)n);
+            c->reported = dropped;
+        }
+    }
+}
+
+static void flush_outputs(void) {
+    out_flush(&g_console);
+    fflush(stdout);
+    if (g_log.file) {
+        out_flush(&g_log.file->out);
+        SDL_FlushIO(g_log.file->out.io);
+    }
+}
+
+//===============================================
+// writer
+//===============================================
+
+// Output every published record, returns the number written
+static int drain(void) {
+    int written = 0;
+    lock_outputs();
+    for (;;) {
+        Uint32 pos = g_log.dequeue_pos;
+        log_cell *cell = &g_log.cells[pos & g_log.mask];
+        if ((int)((Uint32)SDL_GetAtomicInt(&cell->sequence) - (pos + 1)) < 0) break;  // empty
+        output_message(cell->category, cell->level, cell->time_ns,
+                       cell->long_text ? cell->long_text : cell->text, cell->length);
+        SDL_free(cell->long_text);
+        cell->long_text = NULL;
+        SDL_SetAtomicInt(&cell->sequence, (int)(pos + g_log.mask + 1));
+        g_log.dequeue_pos = pos + 1;
+        if (++written == LOG_RING_SIZE) break;  // let app_log_open_file in under constant load
+    }
+    report_drops();
+    flush_outputs();
+    unlock_outputs();
+    SDL_SetAtomicInt(&g_log.written_pos, (int)g_log.dequeue_pos);
+    return written;
+}
+
+static int SDLCALL writer_main(void *userdata) {
+    for (;;) {
+        SDL_WaitSemaphoreTimeout(g_log.wake, LOG_FLUSH_INTERVAL_MS);
+        int quit = SDL_GetAtomicInt(&g_log.quit);
+        while (drain() == LOG_RING_SIZE) {}
+        if (quit) break;
+    }
+    return 0;
+}
+
+int app_log_init(void) {
+    if (g_log.running) return 1;
+    g_log.cells = (log_cell *)SDL_calloc(LOG_RING_SIZE, sizeof(log_cell));
+    g_log.wake = SDL_CreateSemaphore(0);
+    if (!g_log.cells || !g_log.wake) goto fail;
+    g_log.mask = LOG_RING_SIZE - 1;
+    for (Uint32 i = 0; i < LOG_RING_SIZE; i++) {
+        SDL_SetAtomicInt(&g_log.cells[i].sequence, (int)i);
+    }
+    SDL_SetAtomicInt(&g_log.enqueue_pos, 0);
+    SDL_SetAtomicInt(&g_log.written_pos, 0);
+    SDL_SetAtomicInt(&g_log.quit, 0);
+    g_log.dequeue_pos = 0;
+    g_log.running = 1;
+    g_log.thread = SDL_CreateThread(writer_main, "app_log", NULL);
+    if (!g_log.thread) goto fail;
+    return 1;
+
+fail:
+    g_log.running = 0;
+    SDL_free(g_log.cells);
+    g_log.cells = NULL;
+    if (g_log.wake) SDL_DestroySemaphore(g_log.wake);
+    g_log.wake = NULL;
+    return 0;
+}
+
+void app_log_shutdown(void) {
+    if (g_log.running) {
+        SDL_SetAtomicInt(&g_log.quit, 1);
+        SDL_SignalSemaphore(g_log.wake);
+        SDL_WaitThread(g_log.thread, NULL);
+        g_log.running = 0;
+        SDL_free(g_log.cells);
+        SDL_DestroySemaphore(g_log.wake);
+        g_log.cells = NULL;
+        g_log.wake = NULL;
+        g_log.thread = NULL;
+    }
+    app_log_open_file(NULL, 0);
+    fflush(stdout);
+}
+
+void app_log_flush(void) {
+    if (!g_log.running) {
+        lock_outputs();
+        flush_outputs();
+        unlock_outputs();
+        return;
+    }
+    Uint32 target = (Uint32)SDL_GetAtomicInt(&g_log.enqueue_pos);
+    while ((int)((Uint32)SDL_GetAtomicInt(&g_log.written_pos) - target) < 0) {
+        SDL_SignalSemaphore(g_log.wake);
+        SDL_Delay(1);
+    }
+}
+
+//===============================================
+// categories and filters
+//===============================================
+
+int app_log_category(const char *name) {
+    // Names are stored in log_category.name; a longer one could never be found again
+    if (SDL_strlen(name) >= sizeof(g_categories[0].name)) {
+        SDL_SetError("log category name '%s' is longer than %d characters", name, (int)sizeof(g_categories[0].name) - 1);
+        return -1;
+    }
+    int count = SDL_GetAtomicInt(&g_category_count);
+    for (int i = 0; i < count; i++) {
+        if (SDL_strcmp(g_categories[i].name, name) == 0) return i;
+    }
+    SDL_LockSpinlock(&g_category_lock);
+    // Another thread may have added it meanwhile
+    count = SDL_GetAtomicInt(&g_category_count);
+    int id = -1;
+    for (int i = 0; i < count; i++) {
+        if (SDL_strcmp(g_categories[i].name, name) == 0) id = i;
+    }
+    if (id < 0 && count < APP_LOG_MAX_CATEGORIES) {
+        log_category *c = &g_categories[count];
+        SDL_strlcpy(c->name, name, sizeof(c->name));
+        c->level = g_default_level;
+        id = count;
+        SDL_SetAtomicInt(&g_category_count, count + 1);  // publishes the entry
+    }
+    SDL_UnlockSpinlock(&g_category_lock);
+    return id;
+}
+
+const char *app_log_category_name(int category) {
+    return category >= 0 && category < SDL_GetAtomicInt(&g_category_count) ? g_categories[category].name : NULL;
+}
+
+int app_log_category_count(void) {
+    return SDL_GetAtomicInt(&g_category_count);
+}
+
+int app_log_level_from_name(const char *name) {
+    for (int i = 0; i <= APP_LOG_OFF; i++) {
+        if (SDL_strcmp(level_names[i], name) == 0) return i;
+    }
+    return -1;
+}
+
+const char *app_log_level_name(int level) {
+    return level >= 0 && level <= APP_LOG_OFF ? level_names[level] : "off";
+}
+
+void app_log_set_level(int category, int level) {
+    if (category < 0) {
+        g_default_level = level;
+        int count = SDL_GetAtomicInt(&g_category_count);
+        for (int i = 0; i < count; i++) {
+            if (!g_categories[i].has_level) g_categories[i].level = level;
+        }
+    } else if (category < SDL_GetAtomicInt(&g_category_count)) {
+        g_categories[category].level = level;
+        g_categories[category].has_level = 1;
+    }
+}
+
+int app_log_get_level(int category) {
+    return category >= 0 && category < SDL_GetAtomicInt(&g_category_count)
+        ? g_categories[category].level : g_default_level;
+}
+
+void app_log_set_rate(int category, int per_sec) {
+    if (category >= 0 && category < SDL_GetAtomicInt(&g_category_count)) {
+        g_categories[category].rate = per_sec > 0 ? per_sec : 0;
+    }
+}
+
+int app_log_get_rate(int category) {
+    return category >= 0 && category < SDL_GetAtomicInt(&g_category_count) ? g_categories[category].rate : 0;
+}
+
+Uint32 app_log_category_dropped(int category) {
+    return category >= 0 && category < SDL_GetAtomicInt(&g_category_count)
+        ? (Uint32)SDL_GetAtomicInt(&g_categories[category].dropped) : 0;
+}
+
+int app_log_enabled(int category, int level) {
+    return category >= 0 && category < SDL_GetAtomicInt(&g_category_count) &&
+           level >= g_categories[category].level && level < APP_LOG_OFF;
+}
+
+int app_log_admit(int category, int level) {
+    if (!app_log_enabled(category, level)) return 0;
+    log_category *c = &g_categories[category];
+    if (c->rate <= 0) return 1;
+    // Fixed one-second windows: the first message of a new second resets the count
+    Uint32 second = (Uint32)(SDL_GetTicksNS() / SDL_NS_PER_SECOND);
+    Uint32 window = SDL_GetAtomicU32(&c->window);
+    if (window != second && SDL_CompareAndSwapAtomicU32(&c->window, window, second)) {
+        SDL_SetAtomicInt(&c->window_count, 0);
+    }
+    if (SDL_AddAtomicInt(&c->window_count, 1) >= c->rate) {
+        SDL_AtomicIncRef(&c->dropped);
+        return 0;
+    }
+    return 1;
+}
+
+//===============================================
+// messages
+//===============================================
+
+void app_log_submit(int category, int level, const char *text, size_t len) {
+    Uint64 now = SDL_GetTicksNS();
+    if (!g_log.running) {
+        lock_outputs();
+        report_drops();
+        output_message(category, level, now, text, len);
+        flush_outputs();
+        g_log.written_sync++;
+        unlock_outputs();
+        return;
+    }
+
+    Uint32 pos = (Uint32)SDL_GetAtomicInt(&g_log.enqueue_pos);
+    log_cell *cell;
+    for (;;) {
+        cell = &g_log.cells[pos & g_log.mask];
+        int diff = (int)((Uint32)SDL_GetAtomicInt(&cell->sequence) - pos);
+        if (diff == 0) {
+            if (SDL_CompareAndSwapAtomicInt(&g_log.enqueue_pos, (int)pos, (int)(pos + 1))) break;
+        } else if (diff < 0) {
+            SDL_AtomicIncRef(&g_log.dropped_full);
+            return;
+        }
+        pos = (Uint32)SDL_GetAtomicInt(&g_log.enqueue_pos);
+    }
+    cell->level = (Uint8)level;
+    cell->category = (Uint8)category;
+    cell->time_ns = now;
+    cell->long_text = len > LOG_INLINE_TEXT ? (char *)SDL_malloc(len) : NULL;
+    if (cell->long_text) {
+        SDL_memcpy(cell->long_text, text, len);
+    } else {
+        len = SDL_min(len, LOG_INLINE_TEXT);  // truncated if the copy failed
+        SDL_memcpy(cell->text, text, len);
+    }
+    cell->length = (Uint32)len;
+    SDL_SetAtomicInt(&cell->sequence, (int)(pos + 1));
+    // Warnings and errors go out right away, the rest within LOG_FLUSH_INTERVAL_MS
+    if (level >= APP_LOG_WARN || (pos & LOG_WAKE_MASK) == LOG_WAKE_MASK) {
+        SDL_SignalSemaphore(g_log.wake);
+    }
+}
+
+void app_log_write(int category, int level, const char *text) {
+    if (app_log_admit(category, level)) {
+        app_log_submit(category, level, text, SDL_strlen(text));
+    }
+}
+
+void app_log_printf(int category, int level, const char *fmt, ...) {
+    if (!app_log_admit(category, level)) return;
+    char text[1024];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = SDL_vsnprintf(text, sizeof(text), fmt, ap);
+    va_end(ap);
+    if (n < 0) return;
+    app_log_submit(category, level, text, SDL_min((size_t)n, sizeof(text) - 1));
+}
+
+int app_log_open_file(const char *path, int binary) {
+    log_file *f = NULL;
+    if (path) {
+        f = (log_file *)SDL_calloc(1, sizeof(log_file));
+        if (!f) return SDL_OutOfMemory();
+        f->out.io = SDL_IOFromFile(path, binary ? "wb" : "w");
+        if (!f->out.io) {
+            SDL_free(f);
+            return 0;
+        }
+        f->binary = binary;
+        if (binary) out_write(&f->out, LOG_FILE_MAGIC, 4);
+    }
+    lock_outputs();
+    log_file *old = g_log.file;
+    g_log.file = f;
+    unlock_outputs();
+    if (old) {
+        out_flush(&old->out);
+        SDL_CloseIO(old->out.io);
+        SDL_free(old);
+    }
+    return 1;
+}
+
+void app_log_get_stats(app_log_stats *stats) {
+    Uint32 written = (Uint32)SDL_GetAtomicInt(&g_log.written_pos);
+    stats->written = written + g_log.written_sync;
+    stats->pending = g_log.running ? (Uint32)SDL_GetAtomicInt(&g_log.enqueue_pos) - written : 0;
+    stats->dropped_full = (Uint32)SDL_GetAtomicInt(&g_log.dropped_full);
+    stats->dropped_rate = 0;
+    int count = SDL_GetAtomicInt(&g_category_count);
+    for (int i = 0; i < count; i++) {
+        stats->dropped_rate += (Uint32)SDL_GetAtomicInt(&g_categories[i].dropped);
+    }
+}
@@ -0,0 +1,271 @@
+// asset_pack.c
+#include "asset_pack.h"
+#include <lz4.h>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+typedef struct {
+    lua_blob *file;             // the mapping; entry views keep it alive
+    const Uint8 *base;
+    const asset_pack_entry *entries;
+    Uint32 count;
+    const char *names;
+} mounted_pack;
+
+static mounted_pack g_packs[ASSET_PACK_MAX_MOUNTS];
+static int g_pack_count = 0;
+static void *g_packs_lock;          // SDL_RWLock, created on first use, lives for the process
+static SDL_SpinLock g_packs_lock_create;
+
+// Helper: The lock guarding g_packs; lua_util.pack_mount can run while job
+// workers look up modules, so mounts write-lock and lookups read-lock
+static SDL_RWLock *packs_lock(void) {
+    SDL_RWLock *lock = (SDL_RWLock *)SDL_GetAtomicPointer(&g_packs_lock);
+    if (!lock) {
+        SDL_LockSpinlock(&g_packs_lock_create);
+        lock = (SDL_RWLock *)SDL_GetAtomicPointer(&g_packs_lock);
+        if (!lock) {
+            lock = SDL_CreateRWLock();
+            SDL_SetAtomicPointer(&g_packs_lock, lock);
+        }
+        SDL_UnlockSpinlock(&g_packs_lock_create);
+    }
+    return lock;
+}
+
+Uint64 asset_pack_hash(const char *name, size_t len) {
+    Uint64 h = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (Uint8)name[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+void asset_pack_normalize(const char *path, char *out, size_t out_size) {
+    while (path[0] == '.' && (path[1] == '/' || path[1] == '\\')) {
+        path += 2;
+    }
+    size_t n = 0;
+    for (; *path && n + 1 < out_size; path++) {
+        out[n++] = *path == '\\' ? '/' : *path;
+    }
+    out[n] = '\0';
+}
+
+//===============================================
+// mapping
+//===============================================
+
+#ifdef _WIN32
+static void unmap_file(void *data, void *userdata) {
+    UnmapViewOfFile(data);
+}
+
+static void *map_file(const char *path, size_t *size) {
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        SDL_SetError("Could not open %s", path);
+        return NULL;
+    }
+    LARGE_INTEGER file_size;
+    void *data = NULL;
+    if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0) {
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping) {
+            data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);  // the view keeps the mapping
+        }
+        *size = (size_t)file_size.QuadPart;
+    }
+    CloseHandle(file);
+    if (!data) SDL_SetError("Could not map %s", path);
+    return data;
+}
+#else
+static void unmap_file(void *data, void *userdata) {
+    munmap(data, (size_t)(uintptr_t)userdata);
+}
+
+static void *map_file(const char *path, size_t *size) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        SDL_SetError("Could not open %s", path);
+        return NULL;
+    }
+    struct stat st;
+    void *data = NULL;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) data = NULL;
+        *size = (size_t)st.st_size;
+    }
+    close(fd);  // the mapping stays valid
+    if (!data) SDL_SetError("Could not map %s", path);
+    return data;
+}
+#endif
+
+// Helper: Check the header and that every entry lies inside the file
+static int validate_pack(const Uint8 *base, size_t size, mounted_pack *pack) {
+    asset_pack_header h;
+    if (size < sizeof(h)) return 0;
+    SDL_memcpy(&h, base, sizeof(h));
+    if (SDL_memcmp(h.magic, ASSET_PACK_MAGIC, 4) != 0 || h.version != ASSET_PACK_VERSION) return 0;
+    if (h.count > (size - sizeof(h)) / sizeof(asset_pack_entry)) return 0;
+    if (h.names_offset > size || h.names_size > size - h.names_offset) return 0;
+
+    const asset_pack_entry *entries = (const asset_pack_entry *)(base + sizeof(h));
+    for (Uint32 i = 0; i < h.count; i++) {
+        const asset_pack_entry *e = &entries[i];
+        if ((Uint64)e->name_offset + e->name_len > h.names_size) return 0;
+        if (e->offset > size || e->size > size - e->offset) return 0;
+        if (!(e->flags & ASSET_PACK_LZ4) && e->size != e->raw_size) return 0;
+        if (i > 0 && entries[i - 1].hash > e->hash) return 0;  // lookups need the order
+    }
+    pack->base = base;
+    pack->entries = entries;
+    pack->count = h.count;
+    pack->names = (const char *)base + h.names_offset;
+    return 1;
+}
+
+int asset_pack_mount(const char *path) {
+    size_t size = 0;
+    void *data = map_file(path, &size);
+    if (!data) return 0;
+    lua_blob *file = lua_blob_wrap(data, size, unmap_file, (void *)(uintptr_t)size);
+    if (!file) {
+        unmap_file(data, (void *)(uintptr_t)size);
+        return SDL_OutOfMemory();
+    }
+    mounted_pack pack;
+    if (!validate_pack((const Uint8 *)data, size, &pack)) {
+        lua_blob_release(file);
+        return SDL_SetError("%s is not a valid asset pack", path);
+    }
+    pack.file = file;
+    SDL_RWLock *lock = packs_lock();
+    SDL_LockRWLockForWriting(lock);
+    int mounted = g_pack_count < ASSET_PACK_MAX_MOUNTS;
+    if (mounted) g_packs[g_pack_count++] = pack;
+    SDL_UnlockRWLock(lock);
+    if (!mounted) {
+        lua_blob_release(file);
+        return SDL_SetError("Too many asset packs mounted");
+    }
+    return 1;
+}
+
+void asset_pack_unmount_all(void) {
+    SDL_RWLock *lock = packs_lock();
+    SDL_LockRWLockForWriting(lock);
+    for (int i = 0; i < g_pack_count; i++) {
+        lua_blob_release(g_packs[i].file);  // views handed out keep their mapping
+    }
+    SDL_zeroa(g_packs);
+    g_pack_count = 0;
+    SDL_UnlockRWLock(lock);
+}
+
+int asset_pack_mount_count(void) {
+    SDL_RWLock *lock = packs_lock();
+    SDL_LockRWLockForReading(lock);
+    int count = g_pack_count;
+    SDL_UnlockRWLock(lock);
+    return count;
+}
+
+//===============================================
+// lookup
+//===============================================
+
+// Helper: Entry for name in the most recently mounted pack that has it; the
+// caller holds packs_lock for reading while it uses the entry
+static const asset_pack_entry *find_entry(const char *path, mounted_pack **out) {
+    if (g_pack_count == 0) return NULL;
+    char name[1024];
+    asset_pack_normalize(path, name, sizeof(name));
+    size_t len = SDL_strlen(name);
+    Uint64 hash = asset_pack_hash(name, len);
+
+    for (int p = g_pack_count - 1; p >= 0; p--) {
+        mounted_pack *pack = &g_packs[p];
+        Uint32 lo = 0, hi = pack->count;
+        while (lo < hi) {
+            Uint32 mid = lo + (hi - lo) / 2;
+            if (pack->entries[mid].hash < hash) lo = mid + 1;
+            else hi = mid;
+        }
+        for (Uint32 i = lo; i < pack->count && pack->entries[i].hash == hash; i++) {
+            const asset_pack_entry *e = &pack->entries[i];
+            if (e->name_len == len && SDL_memcmp(pack->names + e->name_offset, name, len) == 0) {
+                *out = pack;
+                return e;
+            }
+        }
+    }
+    return NULL;
+}
+
+int asset_pack_contains(const char *path) {
+    mounted_pack *pack;
+    SDL_RWLock *lock = packs_lock();
+    SDL_LockRWLockForReading(lock);
+    int found = find_entry(path, &pack) != NULL;
+    SDL_UnlockRWLock(lock);
+    return found;
+}
+
+// Helper: asset_pack_load with packs_lock held
+static lua_blob *load_entry(const char *path) {
+    mounted_pack *pack;
+    const asset_pack_entry *e = find_entry(path, &pack);
+    if (!e) return NULL;
+    if (!(e->flags & ASSET_PACK_LZ4)) {
+        return lua_blob_view(pack->file, (size_t)e->offset, (size_t)e->size);
+    }
+    if (e->size > LZ4_MAX_INPUT_SIZE || e->raw_size > LZ4_MAX_INPUT_SIZE) {
+        SDL_SetError("%s: entry too large", path);
+        return NULL;
+    }
+    lua_blob *blob = lua_blob_create((size_t)e->raw_size);
+    if (!blob) return NULL;
+    int n = LZ4_decompress_safe((const char *)pack->base + e->offset, (char *)lua_blob_bytes(blob),
+                                (int)e->size, (int)e->raw_size);
+    if (n < 0 || (Uint64)n != e->raw_size) {
+        lua_blob_release(blob);
+        SDL_SetError("%s: corrupt LZ4 data", path);
+        return NULL;
+    }
+    return blob;
+}
+
+lua_blob *asset_pack_load(const char *path) {
+    SDL_RWLock *lock = packs_lock();
+    SDL_LockRWLockForReading(lock);
+    lua_blob *blob = load_entry(path);
+    SDL_UnlockRWLock(lock);
+    return blob;
+}
+
+void *asset_pack_load_file(const char *path, size_t *size) {
+    lua_blob *blob = asset_pack_load(path);
+    if (!blob) return SDL_LoadFile(path, size);
+    // Like SDL_LoadFile: a NUL after the data, for callers that parse text
+    *size = lua_blob_size(blob);
+    Uint8 *data = (Uint8 *)SDL_malloc(*size + 1);
+    if (data) {
+        SDL_memcpy(data, lua_blob_data(blob), *size);
+        data[*size] = '\0';
+    }
+    lua_blob_release(blob);
+    return data;
+}
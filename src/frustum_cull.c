@@ -0,0 +1,107 @@
+// frustum_cull.c
+#include "frustum_cull.h"
+
+// Vector width: AVX when the build enables it (e.g. -mavx), else SSE2 on
+// x86-64 and NEON on AArch64, else scalar only
+#if defined(__AVX__)
+#include <immintrin.h>
+#define LANES 8
+typedef __m256 vfloat;
+#define V_LOAD(p) _mm256_loadu_ps(p)
+#define V_SET1(x) _mm256_set1_ps(x)
+#define V_ADD(a, b) _mm256_add_ps(a, b)
+#define V_MUL(a, b) _mm256_mul_ps(a, b)
+#define V_MASK_GE0(a) (Uint32)_mm256_movemask_ps(_mm256_cmp_ps(a, _mm256_setzero_ps(), _CMP_GE_OQ))
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LANES 4
+typedef __m128 vfloat;
+#define V_LOAD(p) _mm_loadu_ps(p)
+#define V_SET1(x) _mm_set1_ps(x)
+#define V_ADD(a, b) _mm_add_ps(a, b)
+#define V_MUL(a, b) _mm_mul_ps(a, b)
+#define V_MASK_GE0(a) (Uint32)_mm_movemask_ps(_mm_cmpge_ps(a, _mm_setzero_ps()))
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define LANES 4
+typedef float32x4_t vfloat;
+#define V_LOAD(p) vld1q_f32(p)
+#define V_SET1(x) vdupq_n_f32(x)
+#define V_ADD(a, b) vaddq_f32(a, b)
+#define V_MUL(a, b) vmulq_f32(a, b)
+SDL_FORCE_INLINE Uint32 V_MASK_GE0(float32x4_t a) {
+    static const uint32_t bits[4] = {1, 2, 4, 8};
+    return vaddvq_u32(vandq_u32(vcgeq_f32(a, vdupq_n_f32(0.0f)), vld1q_u32(bits)));
+}
+#endif
+
+#ifdef LANES
+// Helper: Bit k set when volume i + k is visible; pv holds each plane's a, b,
+// c, d and |a|, |b|, |c| broadcast to all lanes
+SDL_FORCE_INLINE Uint32 test_group(const vfloat pv[6][7], const frustum_bounds *b, Uint32 i, int box) {
+    vfloat x = V_LOAD(b->cx + i);
+    vfloat y = V_LOAD(b->cy + i);
+    vfloat z = V_LOAD(b->cz + i);
+    vfloat ex = V_LOAD(b->ex + i);
+    vfloat ey = box ? V_LOAD(b->ey + i) : ex;
+    vfloat ez = box ? V_LOAD(b->ez + i) : ex;
+    Uint32 mask = (1u << LANES) - 1;
+    for (int k = 0; k < 6; k++) {
+        const vfloat *q = pv[k];
+        vfloat dist = V_ADD(V_ADD(V_MUL(q[0], x), V_MUL(q[1], y)), V_ADD(V_MUL(q[2], z), q[3]));
+        vfloat r = box ? V_ADD(V_ADD(V_MUL(q[4], ex), V_MUL(q[5], ey)), V_MUL(q[6], ez)) : ex;
+        mask &= V_MASK_GE0(V_ADD(dist, r));
+    }
+    return mask;
+}
+#endif
+
+// Helper: Whether volume i is visible
+SDL_FORCE_INLINE int test_one(const frustum_planes p, const float an[6][3],
+                              const frustum_bounds *b, Uint32 i, int box) {
+    float x = b->cx[i], y = b->cy[i], z = b->cz[i];
+    for (int k = 0; k < 6; k++) {
+        float r = box ? an[k][0] * b->ex[i] + an[k][1] * b->ey[i] + an[k][2] * b->ez[i] : b->ex[i];
+        if (!(p[k][0] * x + p[k][1] * y + p[k][2] * z + p[k][3] + r >= 0.0f)) return 0;
+    }
+    return 1;
+}
+
+// Helper: One loop per volume kind, box is a constant after inlining
+SDL_FORCE_INLINE Uint32 cull(const frustum_planes p, const frustum_bounds *b, Uint32 count,
+                             Uint32 *out, int box) {
+    float an[6][3];  // absolute plane normals, to project box extents
+    for (int k = 0; k < 6; k++) {
+        an[k][0] = SDL_fabsf(p[k][0]);
+        an[k][1] = SDL_fabsf(p[k][1]);
+        an[k][2] = SDL_fabsf(p[k][2]);
+    }
+    Uint32 visible = 0;
+    Uint32 i = 0;
+#ifdef LANES
+    vfloat pv[6][7];
+    for (int k = 0; k < 6; k++) {
+        for (int j = 0; j < 4; j++) pv[k][j] = V_SET1(p[k][j]);
+        for (int j = 0; j < 3; j++) pv[k][4 + j] = V_SET1(an[k][j]);
+    }
+    for (; i + LANES <= count; i += LANES) {
+        Uint32 mask = test_group(pv, b, i, box);
+        // Branchless compaction: every lane stores its index, only visible
+        // ones advance (out has room for count, so visible <= i + k is safe).
+        // No early outs: with scattered objects the mispredictions cost more
+        for (Uint32 k = 0; k < LANES; k++) {
+            out[visible] = i + k;
+            visible += (mask >> k) & 1;
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        out[visible] = i;
+        visible += (Uint32)test_one(p, an, b, i, box);
+    }
+    return visible;
+}
+
+Uint32 frustum_cull(const frustum_planes planes, const frustum_bounds *b, Uint32 count, Uint32 *out) {
+    return b->ey ? cull(planes, b, count, out, 1) : cull(planes, b, count, out, 0);
+}
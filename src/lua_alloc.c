@@ -0,0 +1,268 @@
+// lua_alloc.c
+// Blocks up to POOL_MAX_SIZE come from 16KB aligned pages that each hold one
+// size class for one tag; a block's page (and so its class and tag) is found by
+// masking the pointer. Lua passes the old size to every free/realloc, so small
+// blocks need no header. Larger blocks go to SDL_malloc with a small header
+// that remembers the tag.
+#include "lua_alloc.h"
+#include <SDL3/SDL.h>
+
+#define POOL_PAGE_SIZE 16384
+#define POOL_PAGE_HEADER 64         // keeps blocks 16-byte aligned
+#define POOL_MAX_SIZE 256
+#define POOL_CLASSES 12
+
+static const Uint16 g_class_size[POOL_CLASSES] = {
+    16, 32, 48, 64, 80, 96, 112, 128, 160, 192, 224, 256
+};
+
+static const char *const g_tag_names[LUA_TAG_COUNT] = {
+    "lua", "sdl", "cglm", "stb", "enet", "audio"
+};
+
+typedef struct pool_page {
+    struct pool_page *prev, *next;  // partial list of this class/tag
+    void *free_list;
+    Uint32 bump;                    // offset of the first never-used block
+    Uint16 used;
+    Uint16 capacity;
+    Uint8 size_class;
+    Uint8 tag;
+    Uint8 in_partial;
+} pool_page;
+
+typedef struct {
+    size_t size;
+    size_t tag;
+} large_header;                     // 16 bytes, keeps the block 16-byte aligned
+
+typedef struct {
+    pool_page *partial[LUA_TAG_COUNT][POOL_CLASSES];
+    int next_tag;                   // tag for the next allocation only, -1 = LUA_TAG_LUA
+    lua_alloc_stats stats;
+    Uint64 sample_ns;               // previous lua_alloc_sample_rate call
+    Uint64 sample_allocs;
+} lua_alloc_state;
+
+static int size_class(size_t size) {
+    if (size <= 128) return (int)((size + 15) / 16) - 1;
+    return 8 + (int)((size - 129) / 32);
+}
+
+static pool_page *page_of(void *ptr) {
+    return (pool_page *)((uintptr_t)ptr & ~(uintptr_t)(POOL_PAGE_SIZE - 1));
+}
+
+static void partial_push(lua_alloc_state *s, pool_page *page) {
+    pool_page **head = &s->partial[page->tag][page->size_class];
+    page->prev = NULL;
+    page->next = *head;
+    if (*head) (*head)->prev = page;
+    *head = page;
+    page->in_partial = 1;
+}
+
+static void partial_remove(lua_alloc_state *s, pool_page *page) {
+    if (page->prev) page->prev->next = page->next;
+    else s->partial[page->tag][page->size_class] = page->next;
+    if (page->next) page->next->prev = page->prev;
+    page->prev = page->next = NULL;
+    page->in_partial = 0;
+}
+
+static void account_alloc(lua_alloc_state *s, int tag, size_t size) {
+    lua_alloc_stats *st = &s->stats;
+    st->live_bytes += size;
+    st->total_bytes += size;
+    st->allocs++;
+    if (st->live_bytes > st->peak_bytes) st->peak_bytes = st->live_bytes;
+    lua_alloc_tag_stats *t = &st->tags[tag];
+    t->live_bytes += size;
+    t->allocs++;
+    if (t->live_bytes > t->peak_bytes) t->peak_bytes = t->live_bytes;
+}
+
+static void account_free(lua_alloc_state *s, int tag, size_t size) {
+    s->stats.live_bytes -= size;
+    s->stats.tags[tag].live_bytes -= size;
+}
+
+// Helper: Take the pending one-shot tag. It covers exactly the next block, so
+// finalizers run by the GC step after a tagged allocation are not misattributed.
+static int take_tag(lua_alloc_state *s) {
+    int tag = s->next_tag;
+    s->next_tag = -1;
+    return tag < 0 ? LUA_TAG_LUA : tag;
+}
+
+static void *pool_alloc(lua_alloc_state *s, size_t size, int tag) {
+    int cls = size_class(size);
+    pool_page *page = s->partial[tag][cls];
+    if (!page) {
+        page = (pool_page *)SDL_aligned_alloc(POOL_PAGE_SIZE, POOL_PAGE_SIZE);
+        if (!page) return NULL;
+        SDL_zerop(page);
+        page->bump = POOL_PAGE_HEADER;
+        page->capacity = (Uint16)((POOL_PAGE_SIZE - POOL_PAGE_HEADER) / g_class_size[cls]);
+        page->size_class = (Uint8)cls;
+        page->tag = (Uint8)tag;
+        partial_push(s, page);
+        s->stats.pool_bytes += POOL_PAGE_SIZE;
+    }
+
+    void *block;
+    if (page->free_list) {
+        block = page->free_list;
+        page->free_list = *(void **)block;
+    } else {
+        block = (Uint8 *)page + page->bump;
+        page->bump += g_class_size[cls];
+    }
+    if (++page->used == page->capacity) {
+        partial_remove(s, page);
+    }
+    account_alloc(s, tag, size);
+    return block;
+}
+
+static void pool_free(lua_alloc_state *s, void *ptr, size_t size) {
+    pool_page *page = page_of(ptr);
+    account_free(s, page->tag, size);
+    *(void **)ptr = page->free_list;
+    page->free_list = ptr;
+    page->used--;
+    if (!page->in_partial) {
+        partial_push(s, page);
+    } else if (page->used == 0 && (page->prev || page->next)) {
+        // Keep one empty page per class/tag to avoid churn, release the rest
+        partial_remove(s, page);
+        SDL_aligned_free(page);
+        s->stats.pool_bytes -= POOL_PAGE_SIZE;
+    }
+}
+
+static void *large_alloc(lua_alloc_state *s, size_t size, int tag) {
+    large_header *h = (large_header *)SDL_malloc(sizeof(large_header) + size);
+    if (!h) return NULL;
+    h->size = size;
+    h->tag = (size_t)tag;
+    s->stats.large_bytes += size;
+    account_alloc(s, tag, size);
+    return h + 1;
+}
+
+static void large_free(lua_alloc_state *s, void *ptr) {
+    large_header *h = (large_header *)ptr - 1;
+    s->stats.large_bytes -= h->size;
+    account_free(s, (int)h->tag, h->size);
+    SDL_free(h);
+}
+
+void *lua_alloc_fn(void *ud, void *ptr, size_t osize, size_t nsize) {
+    lua_alloc_state *s = (lua_alloc_state *)ud;
+    if (nsize == 0) {
+        if (ptr) {
+            if (osize <= POOL_MAX_SIZE) pool_free(s, ptr, osize);
+            else large_free(s, ptr);
+        }
+        return NULL;
+    }
+    if (!ptr) {
+        int tag = take_tag(s);
+        return nsize <= POOL_MAX_SIZE ? pool_alloc(s, nsize, tag) : large_alloc(s, nsize, tag);
+    }
+
+    // Realloc: stay in place when the size class does not change
+    if (osize <= POOL_MAX_SIZE && nsize <= POOL_MAX_SIZE && size_class(osize) == size_class(nsize)) {
+        int tag = page_of(ptr)->tag;
+        account_free(s, tag, osize);
+        account_alloc(s, tag, nsize);
+        return ptr;
+    }
+    if (osize > POOL_MAX_SIZE && nsize > POOL_MAX_SIZE) {
+        large_header *h = (large_header *)ptr - 1;
+        int tag = (int)h->tag;
+        large_header *n = (large_header *)SDL_realloc(h, sizeof(large_header) + nsize);
+        if (!n) return NULL;
+        s->stats.large_bytes += nsize - osize;
+        account_free(s, tag, osize);
+        account_alloc(s, tag, nsize);
+        n->size = nsize;
+        return n + 1;
+    }
+
+    // Moving between pool and large keeps the block's original tag
+    int tag = osize <= POOL_MAX_SIZE ? page_of(ptr)->tag : (int)((large_header *)ptr - 1)->tag;
+    void *block = nsize <= POOL_MAX_SIZE ? pool_alloc(s, nsize, tag) : large_alloc(s, nsize, tag);
+    if (!block) return NULL;
+    SDL_memcpy(block, ptr, osize < nsize ? osize : nsize);
+    if (osize <= POOL_MAX_SIZE) pool_free(s, ptr, osize);
+    else large_free(s, ptr);
+    return block;
+}
+
+void *lua_alloc_create(void) {
+    lua_alloc_state *s = (lua_alloc_state *)SDL_calloc(1, sizeof(lua_alloc_state));
+    if (s) {
+        s->next_tag = -1;
+        s->sample_ns = SDL_GetTicksNS();
+    }
+    return s;
+}
+
+void lua_alloc_destroy(void *ud) {
+    lua_alloc_state *s = (lua_alloc_state *)ud;
+    if (!s) return;
+    // After lua_close only the kept empty pages remain
+    for (int t = 0; t < LUA_TAG_COUNT; t++) {
+        for (int c = 0; c < POOL_CLASSES; c++) {
+            pool_page *page = s->partial[t][c];
+            while (page) {
+                pool_page *next = page->next;
+                SDL_aligned_free(page);
+                page = next;
+            }
+        }
+    }
+    SDL_free(s);
+}
+
+// Helper: The allocator state of L, NULL under another allocator
+static lua_alloc_state *get_state(lua_State *L) {
+    void *ud = NULL;
+    lua_Alloc f = lua_getallocf(L, &ud);
+    return f == lua_alloc_fn ? (lua_alloc_state *)ud : NULL;
+}
+
+void *lua_alloc_newuserdata(lua_State *L, size_t size, int nuvalue, lua_alloc_tag tag) {
+    lua_alloc_state *s = get_state(L);
+    if (!s) return lua_newuserdatauv(L, size, nuvalue);
+    s->next_tag = tag;
+    void *p = lua_newuserdatauv(L, size, nuvalue);
+    s->next_tag = -1;
+    return p;
+}
+
+int lua_alloc_get_stats(lua_State *L, lua_alloc_stats *out) {
+    lua_alloc_state *s = get_state(L);
+    if (!s) return 0;
+    *out = s->stats;
+    return 1;
+}
+
+double lua_alloc_sample_rate(lua_State *L) {
+    lua_alloc_state *s = get_state(L);
+    if (!s) return 0.0;
+    Uint64 now = SDL_GetTicksNS();
+    double rate = 0.0;
+    if (now > s->sample_ns) {
+        rate = (double)(s->stats.allocs - s->sample_allocs) * 1e9 / (double)(now - s->sample_ns);
+    }
+    s->sample_ns = now;
+    s->sample_allocs = s->stats.allocs;
+    return rate;
+}
+
+const char *lua_alloc_tag_name(int tag) {
+    return (tag >= 0 && tag < LUA_TAG_COUNT) ? g_tag_names[tag] : "unknown";
+}
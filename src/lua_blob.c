@@ -0,0 +1,187 @@
+// lua_blob.c
+#include "lua_blob.h"
+#include <SDL3/SDL.h>
+#include <lauxlib.h>
+
+struct lua_blob {
+    SDL_AtomicInt refs;
+    const Uint8 *data;
+    size_t size;
+    lua_blob_free_fn free_fn;   // NULL: data is allocated with the header
+    void *free_userdata;
+    lua_blob *parent;           // views: the blob that owns the bytes
+};
+
+// Bytes of lua_blob_create follow the header, aligned for any upload type
+#define BLOB_HEADER_SIZE ((sizeof(lua_blob) + 15) & ~(size_t)15)
+
+lua_blob *lua_blob_create(size_t size) {
+    if (size > SDL_SIZE_MAX - BLOB_HEADER_SIZE) return NULL;
+    lua_blob *blob = (lua_blob *)SDL_malloc(BLOB_HEADER_SIZE + size);
+    if (!blob) return NULL;
+    SDL_SetAtomicInt(&blob->refs, 1);
+    blob->data = (const Uint8 *)blob + BLOB_HEADER_SIZE;
+    blob->size = size;
+    blob->free_fn = NULL;
+    blob->free_userdata = NULL;
+    blob->parent = NULL;
+    return blob;
+}
+
+lua_blob *lua_blob_wrap(void *data, size_t size, lua_blob_free_fn free_fn, void *userdata) {
+    lua_blob *blob = (lua_blob *)SDL_malloc(sizeof(lua_blob));
+    if (!blob) return NULL;
+    SDL_SetAtomicInt(&blob->refs, 1);
+    blob->data = (const Uint8 *)data;
+    blob->size = size;
+    blob->free_fn = free_fn;
+    blob->free_userdata = userdata;
+    blob->parent = NULL;
+    return blob;
+}
+
+lua_blob *lua_blob_view(lua_blob *parent, size_t offset, size_t size) {
+    if (offset > parent->size || size > parent->size - offset) return NULL;
+    lua_blob *blob = (lua_blob *)SDL_malloc(sizeof(lua_blob));
+    if (!blob) return NULL;
+    lua_blob_retain(parent);
+    SDL_SetAtomicInt(&blob->refs, 1);
+    blob->data = parent->data + offset;
+    blob->size = size;
+    blob->free_fn = NULL;
+    blob->free_userdata = NULL;
+    blob->parent = parent;
+    return blob;
+}
+
+void lua_blob_retain(lua_blob *blob) {
+    SDL_AtomicIncRef(&blob->refs);
+}
+
+void lua_blob_release(lua_blob *blob) {
+    while (blob) {
+        if (!SDL_AtomicDecRef(&blob->refs)) return;
+        lua_blob *parent = blob->parent;
+        if (blob->free_fn) {
+            blob->free_fn((void *)blob->data, blob->free_userdata);
+        }
+        SDL_free(blob);
+        blob = parent;
+    }
+}
+
+const void *lua_blob_data(const lua_blob *blob) {
+    return blob->data;
+}
+
+size_t lua_blob_size(const lua_blob *blob) {
+    return blob->size;
+}
+
+void *lua_blob_bytes(lua_blob *blob) {
+    return (void *)blob->data;
+}
+
+//===============================================
+// lua userdata
+//===============================================
+
+// Lua: blob:size() / #blob -> bytes
+static int blob_size(lua_State *L) {
+    lua_blob **ud = (lua_blob **)luaL_checkudata(L, 1, LUA_BLOB_MT);
+    lua_pushinteger(L, *ud ? (lua_Integer)(*ud)->size : 0);
+    return 1;
+}
+
+// Lua: blob:to_string([offset], [length]) -> string (copies)
+static int blob_to_string(lua_State *L) {
+    lua_blob *blob = lua_blob_check(L, 1);
+    lua_Integer offset = luaL_optinteger(L, 2, 0);
+    luaL_argcheck(L, offset >= 0 && (size_t)offset <= blob->size, 2, "offset out of range");
+    lua_Integer length = luaL_optinteger(L, 3, (lua_Integer)(blob->size - (size_t)offset));
+    luaL_argcheck(L, length >= 0 && (size_t)length <= blob->size - (size_t)offset, 3, "length out of range");
+    lua_pushlstring(L, (const char *)blob->data + offset, (size_t)length);
+    return 1;
+}
+
+// Lua: blob:sub(offset, [length]) -> blob
+// A view of the range that shares the bytes (no copy).
+static int blob_sub(lua_State *L) {
+    lua_blob *blob = lua_blob_check(L, 1);
+    lua_Integer offset = luaL_checkinteger(L, 2);
+    luaL_argcheck(L, offset >= 0 && (size_t)offset <= blob->size, 2, "offset out of range");
+    lua_Integer length = luaL_optinteger(L, 3, (lua_Integer)(blob->size - (size_t)offset));
+    luaL_argcheck(L, length >= 0 && (size_t)length <= blob->size - (size_t)offset, 3, "length out of range");
+    lua_blob *view = lua_blob_view(blob, (size_t)offset, (size_t)length);
+    if (!view) return luaL_error(L, "Out of memory");
+    lua_blob_push(L, view);
+    return 1;
+}
+
+// Lua: blob:release() -- drop this handle's reference now instead of at collection
+static int blob_release(lua_State *L) {
+    lua_blob **ud = (lua_blob **)luaL_checkudata(L, 1, LUA_BLOB_MT);
+    if (*ud) {
+        lua_blob_release(*ud);
+        *ud = NULL;
+    }
+    return 0;
+}
+
+static int blob_tostring(lua_State *L) {
+    lua_blob *blob = lua_blob_test(L, 1);
+    if (blob) {
+        lua_pushfstring(L, "lua_blob: %p (%I bytes)", (void *)blob, (lua_Integer)blob->size);
+    } else {
+        lua_pushstring(L, "lua_blob: released");
+    }
+    return 1;
+}
+
+static const luaL_Reg blob_methods[] = {
+    {"size", blob_size},
+    {"to_string", blob_to_string},
+    {"sub", blob_sub},
+    {"release", blob_release},
+    {NULL, NULL}
+};
+
+void lua_blob_push(lua_State *L, lua_blob *blob) {
+    lua_blob **ud = (lua_blob **)lua_newuserdatauv(L, sizeof(lua_blob *), 0);
+    *ud = blob;
+    if (luaL_newmetatable(L, LUA_BLOB_MT)) {
+        luaL_newlib(L, blob_methods);
+        lua_setfield(L, -2, "__index");
+        lua_pushcfunction(L, blob_size);
+        lua_setfield(L, -2, "__len");
+        lua_pushcfunction(L, blob_release);
+        lua_setfield(L, -2, "__gc");
+        lua_pushcfunction(L, blob_tostring);
+        lua_setfield(L, -2, "__tostring");
+    }
+    lua_setmetatable(L, -2);
+}
+
+lua_blob *lua_blob_test(lua_State *L, int idx) {
+    lua_blob **ud = (lua_blob **)luaL_testudata(L, idx, LUA_BLOB_MT);
+    return ud ? *ud : NULL;
+}
+
+lua_blob *lua_blob_check(lua_State *L, int idx) {
+    lua_blob **ud = (lua_blob **)luaL_checkudata(L, idx, LUA_BLOB_MT);
+    luaL_argcheck(L, *ud != NULL, idx, "blob was released");
+    return *ud;
+}
+
+const void *lua_blob_tobytes(lua_State *L, int idx, size_t *size) {
+    lua_blob *blob = lua_blob_test(L, idx);
+    if (blob) {
+        *size = blob->size;
+        return blob->data;
+    }
+    if (lua_type(L, idx) == LUA_TSTRING) {
+        return lua_tolstring(L, idx, size);
+    }
+    *size = 0;
+    return NULL;
+}
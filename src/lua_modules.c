@@ -0,0 +1,56 @@
+// lua_modules.c
+#include "lua_modules.h"
+#include "module_sdl.h"
+#include "module_lua.h"
+#include "module_gl.h"
+#include "module_cimgui.h"
+#include "module_enet.h"
+#include "module_cglm.h"
+#include "module_stb.h"
+#include "module_prof.h"
+#include "module_audio.h"
+#include "module_jobs.h"
+#include "module_test.h"
+#include <lauxlib.h>
+
+typedef struct {
+    const char *name;
+    lua_CFunction open;
+    int main_only;          // needs the GL context, the audio device or the main state
+} preload_entry;
+
+static const preload_entry g_modules[] = {
+    {"module_sdl", luaopen_module_sdl, 0},
+    {"lua_util", luaopen_module_lua, 0},
+    {"module_gl", luaopen_module_gl, 1},
+    {"module_imgui", luaopen_module_imgui, 1},
+    {"module_enet", luaopen_module_enet, 0},
+    {"module_cglm", luaopen_module_cglm, 0},
+    {"module_stb", luaopen_module_stb, 0},
+    {"module_prof", luaopen_module_prof, 0},
+    {"module_audio", luaopen_module_audio, 1},
+    {"module_jobs", luaopen_module_jobs, 1},
+    {"module_test", luaopen_module_test, 1},
+    {NULL, NULL, 0}
+};
+
+#define KIND_KEY "lua_modules.kind"
+
+void lua_modules_preload(lua_State *L, int kind) {
+    lua_pushinteger(L, kind);
+    lua_setfield(L, LUA_REGISTRYINDEX, KIND_KEY);
+    lua_getglobal(L, "package");
+    lua_getfield(L, -1, "preload");
+    for (const preload_entry *m = g_modules; m->name; m++) {
+        if (m->main_only && kind == LUA_MODULES_WORKER) continue;
+        lua_pushcfunction(L, m->open);
+        lua_setfield(L, -2, m->name);
+    }
+    lua_pop(L, 2); // Pop package.preload and package tables
+}
+
+int lua_modules_kind(lua_State *L) {
+    int kind = lua_getfield(L, LUA_REGISTRYINDEX, KIND_KEY) == LUA_TNUMBER ? (int)lua_tointeger(L, -1) : LUA_MODULES_MAIN;
+    lua_pop(L, 1);
+    return kind;
+}
@@ -1,19 +1,18 @@
 // main entry
 #include "module_sdl.h"
-#include "module_lua.h"
 #include "module_gl.h"
-#include "module_cimgui.h"
-#include "module_enet.h"
-#include "module_cglm.h"
-#include "module_stb.h"
-
-#include "module_test.h"
+#include "app_log.h"
+#include "asset_pack.h"
+#include "lua_alloc.h"
+#include "lua_modules.h"
+#include "script_cache.h"
 #include <SDL3/SDL.h>
 #include <lua.h>
 #include <lauxlib.h>
 #include <lualib.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/stat.h>
 
 static int lua_panic(lua_State *L) {
@@ -21,57 +20,161 @@ static int lua_panic(lua_State *L) {
     return 0;
 }
 
+static void print_usage(const char *exe) {
+    fprintf(stderr, "Usage: %s [--headless] [--frames N] [--video-driver NAME] [--report FILE] [--gl-trace FILE] [--record FILE] [--replay FILE] [--script-cache DIR] [--no-script-cache] [--log-level LEVEL] [--log-file FILE] [--log-binary FILE] [--pack FILE]... [script.lua]\n", exe);
+}
+
 int main(int argc, char **argv) {
     const char *lua_script = "main.lua";
-    if (argc > 1) lua_script = argv[1];
+    int headless = 0;
+    int headless_frames = 600;
+    const char *video_driver = NULL;
+    const char *report_path = NULL;
+    const char *gl_trace_path = NULL;
+    const char *record_path = NULL;
+    const char *replay_path = NULL;
+    const char *script_cache_dir = ".luacache";
+    const char *log_level = NULL;
+    const char *log_path = NULL;
+    int log_binary = 0;
+    const char *pack_paths[ASSET_PACK_MAX_MOUNTS];
+    int pack_count = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--headless") == 0) {
+            headless = 1;
+        } else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            headless_frames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--video-driver") == 0 && i + 1 < argc) {
+            video_driver = argv[++i];
+        } else if (strcmp(argv[i], "--report") == 0 && i + 1 < argc) {
+            report_path = argv[++i];
+        } else if (strcmp(argv[i], "--gl-trace") == 0 && i + 1 < argc) {
+            gl_trace_path = argv[++i];
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            record_path = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replay_path = argv[++i];
+        } else if (strcmp(argv[i], "--script-cache") == 0 && i + 1 < argc) {
+            script_cache_dir = argv[++i];
+        } else if (strcmp(argv[i], "--no-script-cache") == 0) {
+            script_cache_dir = NULL;
+        } else if (strcmp(argv[i], "--log-level") == 0 && i + 1 < argc) {
+            log_level = argv[++i];
+        } else if ((strcmp(argv[i], "--log-file") == 0 || strcmp(argv[i], "--log-binary") == 0) && i + 1 < argc) {
+            log_binary = strcmp(argv[i], "--log-binary") == 0;
+            log_path = argv[++i];
+        } else if (strcmp(argv[i], "--pack") == 0 && i + 1 < argc && pack_count < ASSET_PACK_MAX_MOUNTS) {
+            pack_paths[pack_count++] = argv[++i];
+        } else if (strncmp(argv[i], "--", 2) == 0) {
+            print_usage(argv[0]);
+            return 1;
+        } else {
+            lua_script = argv[i];
+        }
+    }
+
+    // Headless: offscreen video driver, runs the script for a fixed number of frames
+    if (headless && !module_sdl_set_headless(headless_frames, video_driver)) {
+        fprintf(stderr, "Error: headless mode: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    // Asset packs, mapped once; later packs shadow earlier ones
+    for (int i = 0; i < pack_count; i++) {
+        if (!asset_pack_mount(pack_paths[i])) {
+            fprintf(stderr, "Error: could not mount asset pack '%s': %s\n", pack_paths[i], SDL_GetError());
+            asset_pack_unmount_all();
+            return 1;
+        }
+    }
 
     struct stat st;
-    if (stat(lua_script, &st) != 0) {
+    if (stat(lua_script, &st) != 0 && !script_cache_is_bundled(lua_script) && !asset_pack_contains(lua_script)) {
         fprintf(stderr, "Error: Lua script '%s' not found.\n", lua_script);
         return 1;
     }
 
-    lua_State *L = luaL_newstate();
-    if (!L) {
+    // Record every bound GL call, replay with sdl3_gl_replay
+    if (gl_trace_path && !module_gl_trace_begin(gl_trace_path)) {
+        fprintf(stderr, "Error: could not open GL trace file '%s'.\n", gl_trace_path);
         return 1;
     }
-    lua_atpanic(L, lua_panic);
-    luaL_openlibs(L);
 
-    // Preload custom modules into package.preload
-    lua_getglobal(L, "package");
-    lua_getfield(L, -1, "preload");
+    // Input recording / replay of the polled event stream
+    if (record_path && replay_path) {
+        fprintf(stderr, "Error: --record and --replay cannot be combined.\n");
+        return 1;
+    }
+    if (record_path && !module_sdl_record_begin(record_path)) {
+        fprintf(stderr, "Error: could not open input recording '%s'.\n", record_path);
+        return 1;
+    }
+    if (replay_path && !module_sdl_replay_begin(replay_path, 1)) {
+        fprintf(stderr, "Error: could not load input recording '%s': %s\n", replay_path, SDL_GetError());
+        return 1;
+    }
 
-    lua_pushcfunction(L, luaopen_module_sdl);
-    lua_setfield(L, -2, "module_sdl");
-    lua_pushcfunction(L, luaopen_module_lua);
-    lua_setfield(L, -2, "lua_util");
-    lua_pushcfunction(L, luaopen_module_gl);
-    lua_setfield(L, -2, "module_gl");
-    lua_pushcfunction(L, luaopen_module_imgui);
-    lua_setfield(L, -2, "module_imgui");
-    lua_pushcfunction(L, luaopen_module_enet);
-    lua_setfield(L, -2, "module_enet");
+    // Default log level for every category, and a copy of the output in a file
+    if (log_level && app_log_level_from_name(log_level) < 0) {
+        fprintf(stderr, "Error: unknown log level '%s' (trace, debug, info, warn, error, off).\n", log_level);
+        return 1;
+    }
+    if (log_path && !app_log_open_file(log_path, log_binary)) {
+        fprintf(stderr, "Error: could not open log file '%s'.\n", log_path);
+        return 1;
+    }
+    if (log_level) {
+        app_log_set_level(-1, app_log_level_from_name(log_level));
+    }
 
-    lua_pushcfunction(L, luaopen_module_cglm);
-    lua_setfield(L, -2, "module_cglm");
+    // Pooled allocator with per-module accounting (lua_util.mem_stats)
+    void *alloc_ud = lua_alloc_create();
+    lua_State *L = alloc_ud ? lua_newstate(lua_alloc_fn, alloc_ud) : NULL;
+    if (!L) {
+        lua_alloc_destroy(alloc_ud);
+        asset_pack_unmount_all();
+        app_log_shutdown();
+        return 1;
+    }
 
-    lua_pushcfunction(L, luaopen_module_stb);
-    lua_setfield(L, -2, "module_stb");
+    // lua_util.log and friends go through a ring drained by a writer thread
+    app_log_init();
+    lua_atpanic(L, lua_panic);
+    luaL_openlibs(L);
 
-    lua_pushcfunction(L, luaopen_module_test);
-    lua_setfield(L, -2, "module_test");
+    // Preload custom modules into package.preload
+    lua_modules_preload(L, LUA_MODULES_MAIN);
 
-    lua_pop(L, 2); // Pop package.preload and package tables
+    // Scripts and required modules load as bytecode (disk cache, then embedded bundle)
+    script_cache_init(L, script_cache_dir);
 
     // Run Lua script
-    if (luaL_dofile(L, lua_script) != LUA_OK) {
+    if (script_cache_loadfile(L, lua_script) != LUA_OK || lua_pcall(L, 0, LUA_MULTRET, 0) != LUA_OK) {
+        app_log_flush();  // script output first
         fprintf(stderr, "Error running '%s': %s\n", lua_script, lua_tostring(L, -1));
+        module_sdl_headless_end();
+        module_sdl_record_end();
+        module_gl_trace_end();
         lua_close(L);
+        lua_alloc_destroy(alloc_ud);
+        asset_pack_unmount_all();
+        app_log_shutdown();
         return 1;
     }
 
+    if (headless) {
+        app_log_flush();
+        module_sdl_frame_report(report_path);
+    }
+
     // Cleanup
+    module_sdl_headless_end();
+    module_sdl_record_end();
+    module_gl_trace_end();
     lua_close(L);
+    lua_alloc_destroy(alloc_ud);
+    asset_pack_unmount_all();
+    app_log_shutdown();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,878 @@
+// module_audio.c
+// Voice mixer on an SDL_AudioStream callback.
+//
+// Threads:
+//   main  - Lua calls, loading, stream decoding (audio.update), voice slot bookkeeping
+//   audio - SDL's stream callback, mixes the voices it owns
+// The two only talk through fixed-size single-producer/single-consumer rings
+// (commands main -> audio, finished voices audio -> main, decoded stream frames
+// main -> audio), so the audio thread never locks or allocates.
+#include <stb_vorbis.c>
+#include "module_audio.h"
+#include "module_sdl.h"
+#include "lua_alloc.h"
+#include "asset_pack.h"
+#include <SDL3/SDL.h>
+#include <lauxlib.h>
+#include <math.h>
+#include <stdio.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define AUDIO_SSE 1
+#endif
+
+#define AUDIO_SOURCE_MT "audio.source"
+
+#define MAX_VOICES 256
+#define MIX_FRAMES 1024             // frames mixed per step of the callback
+#define MAX_PITCH 4.0f
+#define STREAM_SCRATCH_FRAMES (MIX_FRAMES * 4 + 2) // MIX_FRAMES at MAX_PITCH plus interpolation
+#define CMD_RING_SIZE 1024          // power of two
+#define DONE_RING_SIZE (MAX_VOICES * 2)
+#define STREAM_RING_FRAMES 65536    // decoded frames buffered per stream, power of two
+#define MAX_STREAMS 32
+
+enum { SOURCE_SOUND, SOURCE_STREAM };
+
+typedef struct audio_source {
+    int kind;
+    int channels;               // 1 or 2
+    int rate;
+    int refs;                   // main thread only: Lua handle + playing voice
+    // SOURCE_SOUND: fully decoded
+    float *data;
+    Sint64 frames;
+    // SOURCE_STREAM: decoded ahead by audio.update into the ring
+    stb_vorbis *vorbis;
+    Uint8 *file_data;           // backing memory for stb_vorbis_open_memory, NULL when streaming from disk
+    float *ring;
+    SDL_AtomicU32 write_pos;    // frames written (main)
+    SDL_AtomicU32 read_pos;     // frames consumed (audio)
+    SDL_AtomicInt eof;          // decoder reached the end and does not loop
+    int loop;
+    lua_Integer voice;          // handle of the voice playing the stream, 0 if none
+} audio_source;
+
+enum { CMD_PLAY, CMD_STOP, CMD_GAIN, CMD_PAN, CMD_PITCH, CMD_MASTER };
+
+typedef struct {
+    Uint8 type;
+    Uint8 loop;
+    Uint16 slot;
+    float value[3];             // gain, pan, pitch
+    audio_source *src;
+} audio_cmd;
+
+// Owned by the audio thread
+typedef struct {
+    int active;
+    audio_source *src;
+    double pos;                 // frame position in the source (streams: fraction within the ring read)
+    float gain, pan, pitch;
+    float gain_l, gain_r;
+    int loop;
+} audio_voice;
+
+// Main thread view of a voice slot
+typedef struct {
+    Uint16 generation;
+    int busy;
+    audio_source *src;
+} voice_slot;
+
+static SDL_AudioStream *g_stream = NULL;
+static int g_rate = 48000;
+
+static audio_cmd g_cmds[CMD_RING_SIZE];
+static SDL_AtomicU32 g_cmd_write, g_cmd_read;
+static Uint16 g_done[DONE_RING_SIZE];
+static SDL_AtomicU32 g_done_write, g_done_read;
+
+static audio_voice g_voices[MAX_VOICES];
+static float g_master = 1.0f;
+static float g_mix[MIX_FRAMES * 2];
+static float g_scratch[MIX_FRAMES * 2];
+static float g_stream_scratch[STREAM_SCRATCH_FRAMES * 2];
+static SDL_AtomicU32 g_mix_us;          // time spent in the last callback
+static SDL_AtomicInt g_underruns;       // stream voices that ran out of decoded frames
+
+static voice_slot g_slots[MAX_VOICES];
+static Uint16 g_free_slots[MAX_VOICES];
+static int g_free_count = 0;
+static int g_active_count = 0;
+static audio_source *g_streams[MAX_STREAMS];
+
+//===============================================
+// sources
+//===============================================
+
+static void source_release(audio_source *src) {
+    if (--src->refs > 0) return;
+    if (src->kind == SOURCE_STREAM) {
+        for (int i = 0; i < MAX_STREAMS; i++) {
+            if (g_streams[i] == src) g_streams[i] = NULL;
+        }
+        stb_vorbis_close(src->vorbis);
+        SDL_free(src->file_data);
+        SDL_free(src->ring);
+    }
+    SDL_free(src->data);
+    SDL_free(src);
+}
+
+// Helper: Decode as many frames as fit into the stream ring
+static void stream_fill(audio_source *src) {
+    if (SDL_GetAtomicInt(&src->eof)) return;
+    Uint32 write = SDL_GetAtomicU32(&src->write_pos);
+    Uint32 read = SDL_GetAtomicU32(&src->read_pos);
+    Uint32 space = STREAM_RING_FRAMES - (write - read);
+    int rewound = 0;
+    while (space > 0) {
+        Uint32 offset = write & (STREAM_RING_FRAMES - 1);
+        Uint32 contiguous = STREAM_RING_FRAMES - offset;
+        int want = (int)(space < contiguous ? space : contiguous);
+        int got = stb_vorbis_get_samples_float_interleaved(src->vorbis, src->channels,
+                                                           src->ring + offset * src->channels,
+                                                           want * src->channels);
+        if (got <= 0) {
+            if (src->loop && !rewound) {
+                stb_vorbis_seek_start(src->vorbis);
+                rewound = 1; // guard against an empty stream looping forever
+                continue;
+            }
+            if (!src->loop) SDL_SetAtomicInt(&src->eof, 1);
+            break;
+        }
+        rewound = 0;
+        write += (Uint32)got;
+        space -= (Uint32)got;
+        SDL_SetAtomicU32(&src->write_pos, write);
+    }
+}
+
+// Helper: Start a stream over from the beginning; only while no voice reads its ring
+static void stream_rewind(audio_source *src) {
+    stb_vorbis_seek_start(src->vorbis);
+    SDL_SetAtomicU32(&src->read_pos, 0);
+    SDL_SetAtomicU32(&src->write_pos, 0);
+    SDL_SetAtomicInt(&src->eof, 0);
+    stream_fill(src);
+}
+
+// Helper: Convert decoded PCM to float with at most 2 channels at the source rate
+static int convert_to_float(const SDL_AudioSpec *spec, const Uint8 *pcm, int len, audio_source *src) {
+    SDL_AudioSpec dst = { SDL_AUDIO_F32, spec->channels > 2 ? 2 : spec->channels, spec->freq };
+    Uint8 *out = NULL;
+    int out_len = 0;
+    if (!SDL_ConvertAudioSamples(spec, pcm, len, &dst, &out, &out_len)) return 0;
+    src->data = (float *)out;
+    src->channels = dst.channels;
+    src->rate = dst.freq;
+    src->frames = out_len / (Sint64)(sizeof(float) * dst.channels);
+    return 1;
+}
+
+static int is_ogg(const Uint8 *data, size_t size) {
+    return size >= 4 && SDL_memcmp(data, "OggS", 4) == 0;
+}
+
+// Helper: Decode a whole WAV or OGG file held in memory into a sound source
+static audio_source *load_sound(const Uint8 *data, size_t size, const char **err) {
+    audio_source *src = (audio_source *)SDL_calloc(1, sizeof(audio_source));
+    if (!src) {
+        *err = "out of memory";
+        return NULL;
+    }
+    src->kind = SOURCE_SOUND;
+    src->refs = 1;
+
+    if (is_ogg(data, size)) {
+        int error = 0;
+        stb_vorbis *v = stb_vorbis_open_memory(data, (int)size, &error, NULL);
+        if (!v) {
+            *err = "invalid ogg vorbis data";
+            SDL_free(src);
+            return NULL;
+        }
+        stb_vorbis_info info = stb_vorbis_get_info(v);
+        src->channels = info.channels > 2 ? 2 : info.channels;
+        src->rate = (int)info.sample_rate;
+        src->frames = stb_vorbis_stream_length_in_samples(v);
+        src->data = (float *)SDL_malloc((size_t)src->frames * src->channels * sizeof(float));
+        if (!src->data) {
+            stb_vorbis_close(v);
+            SDL_free(src);
+            *err = "out of memory";
+            return NULL;
+        }
+        src->frames = stb_vorbis_get_samples_float_interleaved(v, src->channels, src->data,
+                                                               (int)(src->frames * src->channels));
+        stb_vorbis_close(v);
+        return src;
+    }
+
+    SDL_AudioSpec spec;
+    Uint8 *pcm = NULL;
+    Uint32 pcm_len = 0;
+    if (!SDL_LoadWAV_IO(SDL_IOFromConstMem(data, size), true, &spec, &pcm, &pcm_len) ||
+        !convert_to_float(&spec, pcm, (int)pcm_len, src)) {
+        SDL_free(pcm);
+        SDL_free(src);
+        *err = SDL_GetError();
+        return NULL;
+    }
+    SDL_free(pcm);
+    return src;
+}
+
+//===============================================
+// rings
+//===============================================
+
+static int push_cmd(const audio_cmd *cmd) {
+    Uint32 write = SDL_GetAtomicU32(&g_cmd_write);
+    if (write - SDL_GetAtomicU32(&g_cmd_read) >= CMD_RING_SIZE) return 0;
+    g_cmds[write & (CMD_RING_SIZE - 1)] = *cmd;
+    SDL_SetAtomicU32(&g_cmd_write, write + 1);
+    return 1;
+}
+
+// Audio thread: report a finished voice, the ring holds every slot twice so it cannot fill
+static void push_done(int slot) {
+    Uint32 write = SDL_GetAtomicU32(&g_done_write);
+    g_done[write & (DONE_RING_SIZE - 1)] = (Uint16)slot;
+    SDL_SetAtomicU32(&g_done_write, write + 1);
+}
+
+//===============================================
+// mixing (audio thread)
+//===============================================
+
+static void update_pan_gains(audio_voice *v) {
+    // Constant power pan, pan in [-1, 1]
+    float angle = (v->pan + 1.0f) * 0.25f * (float)SDL_PI_D;
+    v->gain_l = v->gain * cosf(angle);
+    v->gain_r = v->gain * sinf(angle);
+}
+
+static void mix_add_stereo(float *out, const float *in, int frames, float gl, float gr) {
+    int i = 0;
+#ifdef AUDIO_SSE
+    __m128 g = _mm_set_ps(gr, gl, gr, gl);
+    for (; i + 2 <= frames; i += 2) {
+        __m128 s = _mm_loadu_ps(in + i * 2);
+        __m128 o = _mm_loadu_ps(out + i * 2);
+        _mm_storeu_ps(out + i * 2, _mm_add_ps(o, _mm_mul_ps(s, g)));
+    }
+#endif
+    for (; i < frames; i++) {
+        out[i * 2] += in[i * 2] * gl;
+        out[i * 2 + 1] += in[i * 2 + 1] * gr;
+    }
+}
+
+static void mix_add_mono(float *out, const float *in, int frames, float gl, float gr) {
+    int i = 0;
+#ifdef AUDIO_SSE
+    __m128 g = _mm_set_ps(gr, gl, gr, gl);
+    for (; i + 4 <= frames; i += 4) {
+        __m128 m = _mm_loadu_ps(in + i);
+        __m128 lo = _mm_unpacklo_ps(m, m);
+        __m128 hi = _mm_unpackhi_ps(m, m);
+        _mm_storeu_ps(out + i * 2, _mm_add_ps(_mm_loadu_ps(out + i * 2), _mm_mul_ps(lo, g)));
+        _mm_storeu_ps(out + i * 2 + 4, _mm_add_ps(_mm_loadu_ps(out + i * 2 + 4), _mm_mul_ps(hi, g)));
+    }
+#endif
+    for (; i < frames; i++) {
+        out[i * 2] += in[i] * gl;
+        out[i * 2 + 1] += in[i] * gr;
+    }
+}
+
+static void mix_finish(float *buf, int count, float master) {
+    int i = 0;
+#ifdef AUDIO_SSE
+    __m128 m = _mm_set1_ps(master);
+    __m128 lo = _mm_set1_ps(-1.0f);
+    __m128 hi = _mm_set1_ps(1.0f);
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_mul_ps(_mm_loadu_ps(buf + i), m);
+        _mm_storeu_ps(buf + i, _mm_min_ps(_mm_max_ps(x, lo), hi));
+    }
+#endif
+    for (; i < count; i++) {
+        float x = buf[i] * master;
+        buf[i] = x < -1.0f ? -1.0f : (x > 1.0f ? 1.0f : x);
+    }
+}
+
+// Helper: Linear resample from src (avail frames) starting at *pos into out, returns frames written
+static int resample(const float *src, int channels, Sint64 avail, double *pos, double step, float *out, int frames) {
+    int n = 0;
+    double p = *pos;
+    if (channels == 1) {
+        for (; n < frames && p < (double)avail; n++, p += step) {
+            Sint64 i = (Sint64)p;
+            float t = (float)(p - (double)i);
+            float a = src[i];
+            float b = i + 1 < avail ? src[i + 1] : a;
+            out[n] = a + (b - a) * t;
+        }
+    } else {
+        for (; n < frames && p < (double)avail; n++, p += step) {
+            Sint64 i = (Sint64)p;
+            float t = (float)(p - (double)i);
+            const float *a = src + i * 2;
+            const float *b = i + 1 < avail ? a + 2 : a;
+            out[n * 2] = a[0] + (b[0] - a[0]) * t;
+            out[n * 2 + 1] = a[1] + (b[1] - a[1]) * t;
+        }
+    }
+    *pos = p;
+    return n;
+}
+
+// Helper: Mix one sound voice, returns 0 when it finished
+static int mix_sound_voice(audio_voice *v, float *out, int frames) {
+    audio_source *src = v->src;
+    double step = (double)src->rate / g_rate * v->pitch;
+    int done = 0;
+    while (done < frames) {
+        if (v->pos >= (double)src->frames) {
+            if (!v->loop || src->frames == 0) return 0;
+            v->pos = fmod(v->pos, (double)src->frames);
+        }
+        int n;
+        if (step == 1.0 && v->pos == (double)(Sint64)v->pos) {
+            // Same rate, no pitch: mix straight from the source
+            Sint64 start = (Sint64)v->pos;
+            Sint64 left = src->frames - start;
+            n = (int)(left < frames - done ? left : frames - done);
+            const float *in = src->data + start * src->channels;
+            if (src->channels == 1) mix_add_mono(out + done * 2, in, n, v->gain_l, v->gain_r);
+            else mix_add_stereo(out + done * 2, in, n, v->gain_l, v->gain_r);
+            v->pos += n;
+        } else {
+            n = resample(src->data, src->channels, src->frames, &v->pos, step, g_scratch, frames - done);
+            if (src->channels == 1) mix_add_mono(out + done * 2, g_scratch, n, v->gain_l, v->gain_r);
+            else mix_add_stereo(out + done * 2, g_scratch, n, v->gain_l, v->gain_r);
+        }
+        done += n;
+    }
+    return 1;
+}
+
+// Helper: Mix one stream voice from its decoded ring, returns 0 when it finished
+static int mix_stream_voice(audio_voice *v, float *out, int frames) {
+    audio_source *src = v->src;
+    int ch = src->channels;
+    double step = (double)src->rate / g_rate * v->pitch;
+    Uint32 read = SDL_GetAtomicU32(&src->read_pos);
+    Uint32 avail = SDL_GetAtomicU32(&src->write_pos) - read;
+    if (avail == 0) {
+        if (SDL_GetAtomicInt(&src->eof)) return 0;
+        SDL_AddAtomicInt(&g_underruns, 1);
+        return 1;
+    }
+
+    // Copy the frames this chunk needs out of the ring so resampling sees them contiguous
+    Uint32 need = (Uint32)(v->pos + frames * step) + 2;
+    if (need > avail) need = avail;
+    if (need > STREAM_SCRATCH_FRAMES) need = STREAM_SCRATCH_FRAMES;
+    Uint32 offset = read & (STREAM_RING_FRAMES - 1);
+    Uint32 first = STREAM_RING_FRAMES - offset;
+    if (first > need) first = need;
+    SDL_memcpy(g_stream_scratch, src->ring + offset * ch, first * ch * sizeof(float));
+    SDL_memcpy(g_stream_scratch + first * ch, src->ring, (need - first) * ch * sizeof(float));
+
+    int n = resample(g_stream_scratch, ch, need, &v->pos, step, g_scratch, frames);
+    if (ch == 1) mix_add_mono(out, g_scratch, n, v->gain_l, v->gain_r);
+    else mix_add_stereo(out, g_scratch, n, v->gain_l, v->gain_r);
+
+    Uint32 consumed = (Uint32)v->pos;
+    if (consumed > avail) consumed = avail;
+    v->pos -= consumed;
+    SDL_SetAtomicU32(&src->read_pos, read + consumed);
+    if (n < frames && !SDL_GetAtomicInt(&src->eof)) {
+        SDL_AddAtomicInt(&g_underruns, 1);
+    }
+    return 1;
+}
+
+static void process_commands(void) {
+    Uint32 read = SDL_GetAtomicU32(&g_cmd_read);
+    Uint32 write = SDL_GetAtomicU32(&g_cmd_write);
+    for (; read != write; read++) {
+        const audio_cmd *cmd = &g_cmds[read & (CMD_RING_SIZE - 1)];
+        if (cmd->type == CMD_MASTER) {
+            g_master = cmd->value[0];
+            continue;
+        }
+        audio_voice *v = &g_voices[cmd->slot];
+        switch (cmd->type) {
+        case CMD_PLAY:
+            v->active = 1;
+            v->src = cmd->src;
+            v->pos = 0.0;
+            v->gain = cmd->value[0];
+            v->pan = cmd->value[1];
+            v->pitch = cmd->value[2];
+            v->loop = cmd->loop;
+            update_pan_gains(v);
+            break;
+        case CMD_STOP:
+            if (v->active) {
+                v->active = 0;
+                push_done(cmd->slot);
+            }
+            break;
+        case CMD_GAIN:
+            v->gain = cmd->value[0];
+            update_pan_gains(v);
+            break;
+        case CMD_PAN:
+            v->pan = cmd->value[0];
+            update_pan_gains(v);
+            break;
+        case CMD_PITCH:
+            v->pitch = cmd->value[0];
+            break;
+        }
+    }
+    SDL_SetAtomicU32(&g_cmd_read, read);
+}
+
+static void SDLCALL audio_callback(void *userdata, SDL_AudioStream *stream, int additional_amount, int total_amount) {
+    Uint64 start = SDL_GetPerformanceCounter();
+    process_commands();
+
+    int frames_left = additional_amount / (int)(sizeof(float) * 2);
+    while (frames_left > 0) {
+        int frames = frames_left < MIX_FRAMES ? frames_left : MIX_FRAMES;
+        SDL_memset(g_mix, 0, sizeof(float) * 2 * frames);
+        for (int i = 0; i < MAX_VOICES; i++) {
+            audio_voice *v = &g_voices[i];
+            if (!v->active) continue;
+            int playing = v->src->kind == SOURCE_STREAM ? mix_stream_voice(v, g_mix, frames)
+                                                        : mix_sound_voice(v, g_mix, frames);
+            if (!playing) {
+                v->active = 0;
+                push_done(i);
+            }
+        }
+        mix_finish(g_mix, frames * 2, g_master);
+        SDL_PutAudioStreamData(stream, g_mix, (int)(sizeof(float) * 2 * frames));
+        frames_left -= frames;
+    }
+
+    Uint64 us = (SDL_GetPerformanceCounter() - start) * 1000000 / SDL_GetPerformanceFrequency();
+    SDL_SetAtomicU32(&g_mix_us, (Uint32)us);
+}
+
+//===============================================
+// voice handles (main thread)
+//===============================================
+
+// Handle layout: generation << 16 | slot, never 0
+static lua_Integer make_handle(int slot) {
+    return ((lua_Integer)g_slots[slot].generation << 16) | (lua_Integer)slot;
+}
+
+static int handle_slot(lua_Integer handle) {
+    int slot = (int)(handle & 0xFFFF);
+    if (handle <= 0 || slot >= MAX_VOICES) return -1;
+    if (!g_slots[slot].busy || g_slots[slot].generation != (Uint16)(handle >> 16)) return -1;
+    return slot;
+}
+
+// Helper: Recycle the slots the audio thread finished with
+static void collect_finished(void) {
+    Uint32 read = SDL_GetAtomicU32(&g_done_read);
+    Uint32 write = SDL_GetAtomicU32(&g_done_write);
+    for (; read != write; read++) {
+        int slot = g_done[read & (DONE_RING_SIZE - 1)];
+        voice_slot *s = &g_slots[slot];
+        if (!s->busy) continue;
+        if (s->src->kind == SOURCE_STREAM) {
+            // Stopped or played to the end: the next play starts from the beginning
+            s->src->voice = 0;
+            if (s->src->refs > 1) stream_rewind(s->src);
+        }
+        source_release(s->src);
+        s->src = NULL;
+        s->busy = 0;
+        if (++s->generation == 0) s->generation = 1;
+        g_free_slots[g_free_count++] = (Uint16)slot;
+        g_active_count--;
+    }
+    SDL_SetAtomicU32(&g_done_read, read);
+}
+
+static void reset_voices(void) {
+    SDL_zeroa(g_voices);
+    for (int i = 0; i < MAX_VOICES; i++) {
+        if (g_slots[i].busy) {
+            if (g_slots[i].src->kind == SOURCE_STREAM) {
+                g_slots[i].src->voice = 0;
+                if (g_slots[i].src->refs > 1) stream_rewind(g_slots[i].src);
+            }
+            source_release(g_slots[i].src);
+        }
+        g_slots[i].busy = 0;
+        g_slots[i].src = NULL;
+        if (g_slots[i].generation == 0) g_slots[i].generation = 1;
+        g_free_slots[i] = (Uint16)(MAX_VOICES - 1 - i);
+    }
+    g_free_count = MAX_VOICES;
+    g_active_count = 0;
+    SDL_SetAtomicU32(&g_cmd_write, 0);
+    SDL_SetAtomicU32(&g_cmd_read, 0);
+    SDL_SetAtomicU32(&g_done_write, 0);
+    SDL_SetAtomicU32(&g_done_read, 0);
+}
+
+//===============================================
+// lua
+//===============================================
+
+static audio_source *check_source(lua_State *L, int idx) {
+    audio_source **ud = (audio_source **)luaL_checkudata(L, idx, AUDIO_SOURCE_MT);
+    luaL_argcheck(L, *ud != NULL, idx, "audio source was freed");
+    return *ud;
+}
+
+static void push_source(lua_State *L, audio_source *src) {
+    audio_source **ud = (audio_source **)lua_alloc_newuserdata(L, sizeof(audio_source *), 0, LUA_TAG_AUDIO);
+    *ud = src;
+    luaL_setmetatable(L, AUDIO_SOURCE_MT);
+}
+
+// Helper: Read a path (asset packs first) or sdl.buffer argument into memory the caller frees with SDL_free
+static Uint8 *read_source_arg(lua_State *L, int idx, size_t *size) {
+    sdl_buffer *buf = module_sdl_test_buffer(L, idx);
+    if (buf) {
+        luaL_argcheck(L, buf->data != NULL, idx, "buffer was freed");
+        Uint8 *copy = (Uint8 *)SDL_malloc(buf->size);
+        if (copy) SDL_memcpy(copy, buf->data, buf->size);
+        *size = buf->size;
+        return copy;
+    }
+    return (Uint8 *)asset_pack_load_file(luaL_checkstring(L, idx), size);
+}
+
+// Lua: audio.init([{driver=name, freq=48000}]) -> bool, err_msg
+// driver: SDL audio driver, e.g. "dummy" or "disk" for tests (defaults to "dummy" in headless mode)
+static int audio_init(lua_State *L) {
+    if (g_stream) {
+        lua_pushboolean(L, 1);
+        return 1;
+    }
+    const char *driver = module_sdl_is_headless() ? "dummy" : NULL;
+    int freq = 48000;
+    if (lua_istable(L, 1)) {
+        lua_getfield(L, 1, "driver");
+        if (lua_isstring(L, -1)) driver = lua_tostring(L, -1);
+        lua_getfield(L, 1, "freq");
+        freq = (int)luaL_optinteger(L, -1, freq);
+        lua_pop(L, 2);
+    }
+    if (driver) {
+        SDL_SetHint(SDL_HINT_AUDIO_DRIVER, driver);
+    }
+    if (!SDL_InitSubSystem(SDL_INIT_AUDIO)) {
+        lua_pushboolean(L, 0);
+        lua_pushstring(L, SDL_GetError());
+        return 2;
+    }
+
+    reset_voices();
+    g_rate = freq;
+    g_master = 1.0f;
+    SDL_AudioSpec spec = { SDL_AUDIO_F32, 2, freq };
+    g_stream = SDL_OpenAudioDeviceStream(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, &spec, audio_callback, NULL);
+    if (!g_stream) {
+        lua_pushboolean(L, 0);
+        lua_pushstring(L, SDL_GetError());
+        SDL_QuitSubSystem(SDL_INIT_AUDIO);
+        return 2;
+    }
+    SDL_ResumeAudioStreamDevice(g_stream);
+    printf("Audio: driver %s, %d Hz\n", SDL_GetCurrentAudioDriver(), freq);
+    lua_pushboolean(L, 1);
+    return 1;
+}
+
+// Lua: audio.quit()
+static int audio_quit(lua_State *L) {
+    if (!g_stream) return 0;
+    SDL_DestroyAudioStream(g_stream); // stops the callback
+    g_stream = NULL;
+    reset_voices();
+    SDL_QuitSubSystem(SDL_INIT_AUDIO);
+    return 0;
+}
+
+// Lua: audio.load(path | buffer) -> source | nil, err_msg
+// Decodes a whole WAV or OGG file, for short sounds that play many times.
+static int audio_load(lua_State *L) {
+    size_t size = 0;
+    Uint8 *data = read_source_arg(L, 1, &size);
+    if (!data) {
+        lua_pushnil(L);
+        lua_pushstring(L, SDL_GetError());
+        return 2;
+    }
+    const char *err = NULL;
+    audio_source *src = load_sound(data, size, &err);
+    SDL_free(data);
+    if (!src) {
+        lua_pushnil(L);
+        lua_pushstring(L, err ? err : "failed to decode audio");
+        return 2;
+    }
+    push_source(L, src);
+    return 1;
+}
+
+// Lua: audio.open_stream(path | buffer, [loop]) -> source | nil, err_msg
+// OGG stream decoded incrementally by audio.update(), for music and long ambience.
+static int audio_open_stream(lua_State *L) {
+    int loop = lua_toboolean(L, 2);
+    int slot = -1;
+    for (int i = 0; i < MAX_STREAMS; i++) {
+        if (!g_streams[i]) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot < 0) {
+        lua_pushnil(L);
+        lua_pushstring(L, "too many open streams");
+        return 2;
+    }
+
+    audio_source *src = (audio_source *)SDL_calloc(1, sizeof(audio_source));
+    if (!src) return luaL_error(L, "out of memory");
+    int error = 0;
+    if (module_sdl_test_buffer(L, 1)) {
+        size_t size = 0;
+        src->file_data = read_source_arg(L, 1, &size);
+        src->vorbis = src->file_data ? stb_vorbis_open_memory(src->file_data, (int)size, &error, NULL) : NULL;
+    } else {
+        src->vorbis = stb_vorbis_open_filename(luaL_checkstring(L, 1), &error, NULL);
+    }
+    if (!src->vorbis) {
+        SDL_free(src->file_data);
+        SDL_free(src);
+        lua_pushnil(L);
+        lua_pushfstring(L, "could not open ogg vorbis stream (error %d)", error);
+        return 2;
+    }
+    stb_vorbis_info info = stb_vorbis_get_info(src->vorbis);
+    src->kind = SOURCE_STREAM;
+    src->refs = 1;
+    src->channels = info.channels > 2 ? 2 : info.channels;
+    src->rate = (int)info.sample_rate;
+    src->loop = loop;
+    src->ring = (float *)SDL_malloc((size_t)STREAM_RING_FRAMES * src->channels * sizeof(float));
+    if (!src->ring) {
+        stb_vorbis_close(src->vorbis);
+        SDL_free(src->file_data);
+        SDL_free(src);
+        return luaL_error(L, "out of memory");
+    }
+    stream_fill(src);
+    g_streams[slot] = src;
+    push_source(L, src);
+    return 1;
+}
+
+// Lua: source:free() -- drop the Lua reference now, playing voices keep the data alive
+static int audio_source_free(lua_State *L) {
+    audio_source **ud = (audio_source **)luaL_checkudata(L, 1, AUDIO_SOURCE_MT);
+    if (*ud) {
+        source_release(*ud);
+        *ud = NULL;
+    }
+    return 0;
+}
+
+// Lua: source:duration() -> seconds (streams: nil)
+static int audio_source_duration(lua_State *L) {
+    audio_source *src = check_source(L, 1);
+    if (src->kind == SOURCE_STREAM) {
+        lua_pushnil(L);
+        return 1;
+    }
+    lua_pushnumber(L, (double)src->frames / src->rate);
+    return 1;
+}
+
+// Lua: audio.play(source, [gain=1], [pan=0], [pitch=1], [loop=false]) -> voice | nil, err_msg
+static int audio_play(lua_State *L) {
+    audio_source *src = check_source(L, 1);
+    if (!g_stream) {
+        lua_pushnil(L);
+        lua_pushstring(L, "audio not initialized");
+        return 2;
+    }
+    collect_finished();
+    if (src->kind == SOURCE_STREAM && src->voice) {
+        lua_pushnil(L);
+        lua_pushstring(L, "stream is already playing");
+        return 2;
+    }
+    if (g_free_count == 0) {
+        lua_pushnil(L);
+        lua_pushstring(L, "no free voice");
+        return 2;
+    }
+    audio_cmd cmd = {0};
+    cmd.type = CMD_PLAY;
+    cmd.slot = g_free_slots[g_free_count - 1];
+    cmd.value[0] = (float)luaL_optnumber(L, 2, 1.0);
+    cmd.value[1] = SDL_clamp((float)luaL_optnumber(L, 3, 0.0), -1.0f, 1.0f);
+    cmd.value[2] = SDL_clamp((float)luaL_optnumber(L, 4, 1.0), 0.01f, MAX_PITCH);
+    cmd.loop = (Uint8)lua_toboolean(L, 5);
+    cmd.src = src;
+    if (!push_cmd(&cmd)) {
+        lua_pushnil(L);
+        lua_pushstring(L, "audio command queue full");
+        return 2;
+    }
+
+    g_free_count--;
+    voice_slot *s = &g_slots[cmd.slot];
+    s->busy = 1;
+    s->src = src;
+    src->refs++;
+    g_active_count++;
+    lua_Integer handle = make_handle(cmd.slot);
+    if (src->kind == SOURCE_STREAM) src->voice = handle;
+    lua_pushinteger(L, handle);
+    return 1;
+}
+
+// Helper: Send a per-voice command, false when the handle is stale
+static int send_voice_cmd(lua_State *L, int type, float value) {
+    int slot = handle_slot(luaL_checkinteger(L, 1));
+    if (slot < 0 || !g_stream) {
+        lua_pushboolean(L, 0);
+        return 1;
+    }
+    audio_cmd cmd = {0};
+    cmd.type = (Uint8)type;
+    cmd.slot = (Uint16)slot;
+    cmd.value[0] = value;
+    lua_pushboolean(L, push_cmd(&cmd));
+    return 1;
+}
+
+// Lua: audio.stop(voice) -> bool
+static int audio_stop(lua_State *L) {
+    return send_voice_cmd(L, CMD_STOP, 0.0f);
+}
+
+// Lua: audio.set_gain(voice, gain) -> bool
+static int audio_set_gain(lua_State *L) {
+    return send_voice_cmd(L, CMD_GAIN, (float)luaL_checknumber(L, 2));
+}
+
+// Lua: audio.set_pan(voice, pan) -> bool  (-1 left .. 1 right)
+static int audio_set_pan(lua_State *L) {
+    return send_voice_cmd(L, CMD_PAN, SDL_clamp((float)luaL_checknumber(L, 2), -1.0f, 1.0f));
+}
+
+// Lua: audio.set_pitch(voice, pitch) -> bool  (playback rate multiplier)
+static int audio_set_pitch(lua_State *L) {
+    return send_voice_cmd(L, CMD_PITCH, SDL_clamp((float)luaL_checknumber(L, 2), 0.01f, MAX_PITCH));
+}
+
+// Lua: audio.is_playing(voice) -> bool
+static int audio_is_playing(lua_State *L) {
+    collect_finished();
+    lua_pushboolean(L, handle_slot(luaL_checkinteger(L, 1)) >= 0);
+    return 1;
+}
+
+// Lua: audio.set_master_gain(gain)
+static int audio_set_master_gain(lua_State *L) {
+    audio_cmd cmd = {0};
+    cmd.type = CMD_MASTER;
+    cmd.value[0] = (float)luaL_checknumber(L, 1);
+    push_cmd(&cmd);
+    return 0;
+}
+
+// Lua: audio.pause(bool)
+static int audio_pause(lua_State *L) {
+    if (!g_stream) return 0;
+    if (lua_toboolean(L, 1)) SDL_PauseAudioStreamDevice(g_stream);
+    else SDL_ResumeAudioStreamDevice(g_stream);
+    return 0;
+}
+
+// Lua: audio.update() -- call once per frame: decodes streams ahead and recycles finished voices
+static int audio_update(lua_State *L) {
+    collect_finished();
+    for (int i = 0; i < MAX_STREAMS; i++) {
+        if (g_streams[i]) stream_fill(g_streams[i]);
+    }
+    return 0;
+}
+
+// Lua: audio.stats() -> {voices, max_voices, mix_us, underruns, rate}
+static int audio_stats(lua_State *L) {
+    lua_createtable(L, 0, 5);
+    lua_pushinteger(L, g_active_count);
+    lua_setfield(L, -2, "voices");
+    lua_pushinteger(L, MAX_VOICES);
+    lua_setfield(L, -2, "max_voices");
+    lua_pushinteger(L, (lua_Integer)SDL_GetAtomicU32(&g_mix_us));
+    lua_setfield(L, -2, "mix_us");
+    lua_pushinteger(L, SDL_GetAtomicInt(&g_underruns));
+    lua_setfield(L, -2, "underruns");
+    lua_pushinteger(L, g_rate);
+    lua_setfield(L, -2, "rate");
+    return 1;
+}
+
+static const luaL_Reg audio_source_methods[] = {
+    {"free", audio_source_free},
+    {"duration", audio_source_duration},
+    {NULL, NULL}
+};
+
+static const luaL_Reg audio_lib[] = {
+    {"init", audio_init},
+    {"quit", audio_quit},
+    {"load", audio_load},
+    {"open_stream", audio_open_stream},
+    {"play", audio_play},
+    {"stop", audio_stop},
+    {"set_gain", audio_set_gain},
+    {"set_pan", audio_set_pan},
+    {"set_pitch", audio_set_pitch},
+    {"is_playing", audio_is_playing},
+    {"set_master_gain", audio_set_master_gain},
+    {"pause", audio_pause},
+    {"update", audio_update},
+    {"stats", audio_stats},
+    {NULL, NULL}
+};
+
+int luaopen_module_audio(lua_State *L) {
+    luaL_newmetatable(L, AUDIO_SOURCE_MT);
+    lua_newtable(L);
+    luaL_setfuncs(L, audio_source_methods, 0);
+    lua_setfield(L, -2, "__index");
+    lua_pushcfunction(L, audio_source_free);
+    lua_setfield(L, -2, "__gc");
+    lua_pop(L, 1);
+
+    luaL_newlib(L, audio_lib);
+    lua_pushinteger(L, MAX_VOICES);
+    lua_setfield(L, -2, "MAX_VOICES");
+    return 1;
+}
@@ -1,6 +1,12 @@
 // module_cglm.c
+#include "module_cglm.h"
+#include "frustum_cull.h"
+#include "lua_alloc.h"
+#include "scene_graph.h"
+#include <SDL3/SDL.h>
 #include <lua.h>
 #include <lauxlib.h>
+#include <limits.h>
 #include <stdlib.h>
 #include <cglm/cglm.h>
 
@@ -30,7 +36,7 @@ static mat4* check_mat4(lua_State *L, int idx) {
 
 // Helper to push userdata types
 static vec3* push_vec3(lua_State *L, float x, float y, float z) {
-    vec3 *v = (vec3*)lua_newuserdata(L, sizeof(vec3));
+    vec3 *v = (vec3*)lua_alloc_newuserdata(L, sizeof(vec3), 1, LUA_TAG_CGLM);
     (*v)[0] = x; (*v)[1] = y; (*v)[2] = z;
     luaL_getmetatable(L, VEC3_TYPE);
     lua_setmetatable(L, -2);
@@ -38,7 +44,7 @@ static vec3* push_vec3(lua_State *L, float x, float y, float z) {
 }
 
 static vec4* push_vec4(lua_State *L, float x, float y, float z, float w) {
-    vec4 *v = (vec4*)lua_newuserdata(L, sizeof(vec4));
+    vec4 *v = (vec4*)lua_alloc_newuserdata(L, sizeof(vec4), 1, LUA_TAG_CGLM);
     (*v)[0] = x; (*v)[1] = y; (*v)[2] = z; (*v)[3] = w;
     luaL_getmetatable(L, VEC4_TYPE);
     lua_setmetatable(L, -2);
@@ -46,7 +52,7 @@ static vec4* push_vec4(lua_State *L, float x, float y, float z, float w) {
 }
 
 static mat4* push_mat4(lua_State *L, mat4 m) { // Removed const
-    mat4 *m_out = (mat4*)lua_newuserdata(L, sizeof(mat4));
+    mat4 *m_out = (mat4*)lua_alloc_newuserdata(L, sizeof(mat4), 1, LUA_TAG_CGLM);
     glm_mat4_copy(m, *m_out);
     luaL_getmetatable(L, MAT4_TYPE);
     lua_setmetatable(L, -2);
@@ -392,32 +398,6 @@ static int vec3_gc(lua_State *L) { return 0; }
 static int vec4_gc(lua_State *L) { return 0; }
 static int mat4_gc(lua_State *L) { return 0; }
 
-// Metatable methods
-static const luaL_Reg vec3_methods[] = {
-    {"dot", vec3_dot},
-    {"cross", vec3_cross},
-    {"normalize", vec3_normalize},
-    {"length", vec3_length},
-    {"get", vec3_get},
-    {"set", vec3_set},
-    {NULL, NULL}
-};
-
-static const luaL_Reg vec4_methods[] = {
-    {"dot", vec4_dot},
-    {"normalize", vec4_normalize},
-    {"length", vec4_length},
-    {"get", vec4_get},
-    {"set", vec4_set},
-    {NULL, NULL}
-};
-
-static const luaL_Reg mat4_methods[] = {
-    {"get", mat4_get},
-    {"set", mat4_set},
-    {NULL, NULL}
-};
-
 // Lua: cglm.ortho(left, right, bottom, top, near, far) -> mat4
 static int mat4_ortho(lua_State *L) {
     float left = (float)luaL_checknumber(L, 1);
@@ -445,29 +425,1206 @@ static int mat4_perspective(lua_State *L) {
 }
 
 
-// Lua: cglm.rotate(matrix, angle, axis) -> mat4
+// Helper: A vec3 at idx, or three numbers starting at idx (no temporary vec3)
+static void check_vec3_args(lua_State *L, int idx, vec3 out) {
+    if (lua_type(L, idx) == LUA_TNUMBER) {
+        out[0] = (float)luaL_checknumber(L, idx);
+        out[1] = (float)luaL_checknumber(L, idx + 1);
+        out[2] = (float)luaL_checknumber(L, idx + 2);
+    } else {
+        glm_vec3_copy(*check_vec3(L, idx), out);
+    }
+}
+
+// Lua: cglm.rotate(matrix, angle, axis | x, y, z) -> mat4
 static int mat4_rotate(lua_State *L) {
     mat4 *m = check_mat4(L, 1);
     float angle = (float)luaL_checknumber(L, 2);
-    vec3 *axis = check_vec3(L, 3);
+    vec3 axis;
+    check_vec3_args(L, 3, axis);
     mat4 result;
     glm_mat4_copy(*m, result);
-    glm_rotate(result, angle, *axis);
+    glm_rotate(result, angle, axis);
     push_mat4(L, result);
     return 1;
 }
 
-// Lua: cglm.translate(matrix, vec3) -> mat4
+// Lua: cglm.translate(matrix, vec3 | x, y, z) -> mat4
 static int mat4_translate(lua_State *L) {
     mat4 *m = check_mat4(L, 1);
-    vec3 *v = check_vec3(L, 2);
+    vec3 v;
+    check_vec3_args(L, 2, v);
     mat4 result;
     glm_mat4_copy(*m, result); // Copy input matrix to result
-    glm_translate(result, *v); // Apply translation to result
+    glm_translate(result, v); // Apply translation to result
     push_mat4(L, result);
     return 1;
 }
 
+//===============================================
+// in-place and out-parameter forms
+//===============================================
+// Methods ending in '_' modify their object and return it for chaining;
+// cglm.*_into(dst, ...) write into an existing dst (which may be an input).
+// Neither allocates, so per-frame transform updates create no garbage:
+//   model:identity_():rotate_(angle_y, 0, 1, 0):rotate_(angle_z, 0, 0, 1)
+//   cglm.mat4_mul_into(mvp, view_projection, model)
+
+// Lua: m:identity_() -> m
+static int mat4_identity_(lua_State *L) {
+    glm_mat4_identity(*check_mat4(L, 1));
+    lua_settop(L, 1);
+    return 1;
+}
+
+// Lua: m:copy_(src) -> m
+static int mat4_copy_(lua_State *L) {
+    mat4 *m = check_mat4(L, 1);
+    glm_mat4_copy(*check_mat4(L, 2), *m);
+    lua_settop(L, 1);
+    return 1;
+}
+
+// Lua: m:rotate_(angle, axis | x, y, z) -> m
+static int mat4_rotate_(lua_State *L) {
+    mat4 *m = check_mat4(L, 1);
+    float angle = (float)luaL_checknumber(L, 2);
+    vec3 axis;
+    check_vec3_args(L, 3, axis);
+    glm_rotate(*m, angle, axis);
+    lua_settop(L, 1);
+    return 1;
+}
+
+// Lua: m:translate_(vec3 | x, y, z) -> m
+static int mat4_translate_(lua_State *L) {
+    mat4 *m = check_mat4(L, 1);
+    vec3 v;
+    check_vec3_args(L, 2, v);
+    glm_translate(*m, v);
+    lua_settop(L, 1);
+    return 1;
+}
+
+// Lua: m:scale_(vec3 | x, y, z | s) -> m
+static int mat4_scale_(lua_State *L) {
+    mat4 *m = check_mat4(L, 1);
+    vec3 v;
+    if (lua_type(L, 2) == LUA_TNUMBER && lua_isnone(L, 3)) {
+        float s = (float)lua_tonumber(L, 2);
+        glm_vec3_fill(v, s);
+    } else {
+        check_vec3_args(L, 2, v);
+    }
+    glm_scale(*m, v);
+    lua_settop(L, 1);
+    return 1;
+}
+
+// Lua: m:mul_(b) -> m -- m = m * b
+static int mat4_mul_(lua_State *L) {
+    mat4 *m = check_mat4(L, 1);
+    mat4 *b = check_mat4(L, 2);
+    mat4 result;
+    glm_mat4_mul(*m, *b, result);
+    glm_mat4_copy(result, *m);
+    lua_settop(L, 1);
+    return 1;
+}
+
+// Lua: m:perspective_(fovy, aspect, near, far) -> m
+static int mat4_perspective_(lua_State *L) {
+    mat4 *m = check_mat4(L, 1);
+    glm_perspective((float)luaL_checknumber(L, 2), (float)luaL_checknumber(L, 3),
+                    (float)luaL_checknumber(L, 4), (float)luaL_checknumber(L, 5), *m);
+    lua_settop(L, 1);
+    return 1;
+}
+
+// Lua: m:ortho_(left, right, bottom, top, near, far) -> m
+static int mat4_ortho_(lua_State *L) {
+    mat4 *m = check_mat4(L, 1);
+    glm_ortho((float)luaL_checknumber(L, 2), (float)luaL_checknumber(L, 3),
+              (float)luaL_checknumber(L, 4), (float)luaL_checknumber(L, 5),
+              (float)luaL_checknumber(L, 6), (float)luaL_checknumber(L, 7), *m);
+    lua_settop(L, 1);
+    return 1;
+}
+
+// Lua: cglm.mat4_mul_into(dst, a, b) -> dst -- dst = a * b
+static int mat4_mul_into(lua_State *L) {
+    mat4 *dst = check_mat4(L, 1);
+    mat4 *a = check_mat4(L, 2);
+    mat4 *b = check_mat4(L, 3);
+    mat4 result;
+    glm_mat4_mul(*a, *b, result);
+    glm_mat4_copy(result, *dst);
+    lua_settop(L, 1);
+    return 1;
+}
+
+// Lua: cglm.rotate_into(dst, m, angle, axis | x, y, z) -> dst
+static int mat4_rotate_into(lua_State *L) {
+    mat4 *dst = check_mat4(L, 1);
+    mat4 *m = check_mat4(L, 2);
+    float angle = (float)luaL_checknumber(L, 3);
+    vec3 axis;
+    check_vec3_args(L, 4, axis);
+    glm_mat4_copy(*m, *dst);
+    glm_rotate(*dst, angle, axis);
+    lua_settop(L, 1);
+    return 1;
+}
+
+// Lua: cglm.translate_into(dst, m, vec3 | x, y, z) -> dst
+static int mat4_translate_into(lua_State *L) {
+    mat4 *dst = check_mat4(L, 1);
+    mat4 *m = check_mat4(L, 2);
+    vec3 v;
+    check_vec3_args(L, 3, v);
+    glm_mat4_copy(*m, *dst);
+    glm_translate(*dst, v);
+    lua_settop(L, 1);
+    return 1;
+}
+
+// Lua: v:set_(x, y, z) -> v
+static int vec3_set_(lua_State *L) {
+    vec3 *v = check_vec3(L, 1);
+    check_vec3_args(L, 2, *v);
+    lua_settop(L, 1);
+    return 1;
+}
+
+// Lua: v:add_(b | x, y, z) -> v
+static int vec3_add_(lua_State *L) {
+    vec3 *v = check_vec3(L, 1);
+    vec3 b;
+    check_vec3_args(L, 2, b);
+    glm_vec3_add(*v, b, *v);
+    lua_settop(L, 1);
+    return 1;
+}
+
+// Lua: v:sub_(b | x, y, z) -> v
+static int vec3_sub_(lua_State *L) {
+    vec3 *v = check_vec3(L, 1);
+    vec3 b;
+    check_vec3_args(L, 2, b);
+    glm_vec3_sub(*v, b, *v);
+    lua_settop(L, 1);
+    return 1;
+}
+
+// Lua: v:scale_(s) -> v
+static int vec3_scale_(lua_State *L) {
+    vec3 *v = check_vec3(L, 1);
+    glm_vec3_scale(*v, (float)luaL_checknumber(L, 2), *v);
+    lua_settop(L, 1);
+    return 1;
+}
+
+// Lua: v:normalize_() -> v
+static int vec3_normalize_(lua_State *L) {
+    glm_vec3_normalize(*check_vec3(L, 1));
+    lua_settop(L, 1);
+    return 1;
+}
+
+// Lua: cglm.vec3_add_into(dst, a, b) -> dst
+static int vec3_add_into(lua_State *L) {
+    vec3 *dst = check_vec3(L, 1);
+    glm_vec3_add(*check_vec3(L, 2), *check_vec3(L, 3), *dst);
+    lua_settop(L, 1);
+    return 1;
+}
+
+// Lua: cglm.vec3_sub_into(dst, a, b) -> dst
+static int vec3_sub_into(lua_State *L) {
+    vec3 *dst = check_vec3(L, 1);
+    glm_vec3_sub(*check_vec3(L, 2), *check_vec3(L, 3), *dst);
+    lua_settop(L, 1);
+    return 1;
+}
+
+// Lua: cglm.vec3_scale_into(dst, v, s) -> dst
+static int vec3_scale_into(lua_State *L) {
+    vec3 *dst = check_vec3(L, 1);
+    glm_vec3_scale(*check_vec3(L, 2), (float)luaL_checknumber(L, 3), *dst);
+    lua_settop(L, 1);
+    return 1;
+}
+
+// Lua: cglm.vec3_cross_into(dst, a, b) -> dst
+static int vec3_cross_into(lua_State *L) {
+    vec3 *dst = check_vec3(L, 1);
+    vec3 result;
+    glm_vec3_cross(*check_vec3(L, 2), *check_vec3(L, 3), result);
+    glm_vec3_copy(result, *dst);
+    lua_settop(L, 1);
+    return 1;
+}
+
+// Lua: v:set_(x, y, z, w) -> v
+static int vec4_set_(lua_State *L) {
+    vec4 *v = check_vec4(L, 1);
+    (*v)[0] = (float)luaL_checknumber(L, 2);
+    (*v)[1] = (float)luaL_checknumber(L, 3);
+    (*v)[2] = (float)luaL_checknumber(L, 4);
+    (*v)[3] = (float)luaL_checknumber(L, 5);
+    lua_settop(L, 1);
+    return 1;
+}
+
+// Lua: v:add_(b) -> v
+static int vec4_add_(lua_State *L) {
+    vec4 *v = check_vec4(L, 1);
+    glm_vec4_add(*v, *check_vec4(L, 2), *v);
+    lua_settop(L, 1);
+    return 1;
+}
+
+// Lua: v:sub_(b) -> v
+static int vec4_sub_(lua_State *L) {
+    vec4 *v = check_vec4(L, 1);
+    glm_vec4_sub(*v, *check_vec4(L, 2), *v);
+    lua_settop(L, 1);
+    return 1;
+}
+
+// Lua: v:scale_(s) -> v
+static int vec4_scale_(lua_State *L) {
+    vec4 *v = check_vec4(L, 1);
+    glm_vec4_scale(*v, (float)luaL_checknumber(L, 2), *v);
+    lua_settop(L, 1);
+    return 1;
+}
+
+// Lua: v:normalize_() -> v
+static int vec4_normalize_(lua_State *L) {
+    glm_vec4_normalize(*check_vec4(L, 1));
+    lua_settop(L, 1);
+    return 1;
+}
+
+// Lua: cglm.mat4_mulv_into(dst, m, v) -> dst -- dst = m * v (vec4)
+static int mat4_mulv_into(lua_State *L) {
+    vec4 *dst = check_vec4(L, 1);
+    mat4 *m = check_mat4(L, 2);
+    vec4 result;
+    glm_mat4_mulv(*m, *check_vec4(L, 3), result);
+    glm_vec4_copy(result, *dst);
+    lua_settop(L, 1);
+    return 1;
+}
+
+//===============================================
+// mat4_array / vec3_array
+//===============================================
+// Contiguous, 64-byte aligned storage for many transforms or points. Bulk
+// operations run over the whole array in one call through cglm's SIMD paths
+// (the count argument limits them to the first count elements), and
+// gl.buffer_data / gl.buffer_sub_data / gl.uniform_matrix4fv upload the floats
+// directly. Elements are 0-based like the component indices of vec3:get.
+//   local models = cglm.mat4_array(n)
+//   cglm.mat4_array_compose(models, positions, rotations, scales)
+//   cglm.mat4_array_mul(mvps, view_projection, models)
+//   gl.buffer_sub_data(gl.ARRAY_BUFFER, 0, mvps)
+
+#define ARRAY_ALIGN 64
+
+// Helper: Userdata of both array types, the floats live outside the Lua heap
+static cglm_array *new_array(lua_State *L, lua_Integer count, int width, const char *type) {
+    luaL_argcheck(L, count >= 0 && count <= CGLM_ARRAY_MAX, 1, "count out of range");
+    cglm_array *a = (cglm_array *)lua_alloc_newuserdata(L, sizeof(cglm_array), 0, LUA_TAG_CGLM);
+    a->data = NULL;
+    a->count = 0;
+    a->width = width;
+    luaL_setmetatable(L, type);
+    size_t bytes = (size_t)count * width * sizeof(float);
+    a->data = SDL_aligned_alloc(ARRAY_ALIGN, bytes ? bytes : ARRAY_ALIGN);
+    if (!a->data) luaL_error(L, "cglm: out of memory for %d elements", (int)count);
+    a->count = (unsigned int)count;
+    return a;
+}
+
+static cglm_array *check_mat4_array(lua_State *L, int idx) {
+    return (cglm_array *)luaL_checkudata(L, idx, CGLM_MAT4_ARRAY_MT);
+}
+
+static cglm_array *check_vec3_array(lua_State *L, int idx) {
+    return (cglm_array *)luaL_checkudata(L, idx, CGLM_VEC3_ARRAY_MT);
+}
+
+static cglm_array *check_index_array(lua_State *L, int idx) {
+    return (cglm_array *)luaL_checkudata(L, idx, CGLM_INDEX_ARRAY_MT);
+}
+
+// Helper: Any array type
+static cglm_array *check_array(lua_State *L, int idx) {
+    size_t size;
+    if (!module_cglm_test_array(L, idx, &size)) luaL_typeerror(L, idx, "mat4_array, vec3_array or index_array");
+    return (cglm_array *)lua_touserdata(L, idx);
+}
+
+// Helper: 0-based element index argument
+static Uint32 check_index(lua_State *L, int idx, const cglm_array *a) {
+    lua_Integer i = luaL_checkinteger(L, idx);
+    luaL_argcheck(L, i >= 0 && i < (lua_Integer)a->count, idx, "index out of range");
+    return (Uint32)i;
+}
+
+// Helper: Optional element count of a bulk operation, default and limit: the
+// smallest of the arrays involved
+static Uint32 check_bulk_count(lua_State *L, int idx, Uint32 limit) {
+    if (lua_isnoneornil(L, idx)) return limit;
+    lua_Integer n = luaL_checkinteger(L, idx);
+    luaL_argcheck(L, n >= 0 && n <= (lua_Integer)limit, idx, "count exceeds an array");
+    return (Uint32)n;
+}
+
+// Helper: A mat4 argument copied to aligned storage
+static void check_mat4_arg(lua_State *L, int idx, mat4 out) {
+    SDL_memcpy(out, *check_mat4(L, idx), sizeof(mat4));
+}
+
+const void *module_cglm_test_array(lua_State *L, int idx, size_t *size) {
+    cglm_array *a = (cglm_array *)luaL_testudata(L, idx, CGLM_MAT4_ARRAY_MT);
+    if (!a) a = (cglm_array *)luaL_testudata(L, idx, CGLM_VEC3_ARRAY_MT);
+    if (!a) a = (cglm_array *)luaL_testudata(L, idx, CGLM_INDEX_ARRAY_MT);
+    if (!a) return NULL;
+    *size = (size_t)a->count * a->width * sizeof(float);
+    return a->data;
+}
+
+// Lua: cglm.mat4_array(count) -> mat4_array, every element the identity
+static int mat4_array_new(lua_State *L) {
+    cglm_array *a = new_array(L, luaL_checkinteger(L, 1), 16, CGLM_MAT4_ARRAY_MT);
+    mat4 *m = (mat4 *)a->data;
+    for (Uint32 i = 0; i < a->count; i++) {
+        glm_mat4_identity(m[i]);
+    }
+    return 1;
+}
+
+// Lua: cglm.vec3_array(count [, x, y, z]) -> vec3_array, every element (x, y, z) (default 0)
+static int vec3_array_new(lua_State *L) {
+    cglm_array *a = new_array(L, luaL_checkinteger(L, 1), 3, CGLM_VEC3_ARRAY_MT);
+    vec3 v = {0.0f, 0.0f, 0.0f};
+    if (!lua_isnoneornil(L, 2)) check_vec3_args(L, 2, v);
+    vec3 *p = (vec3 *)a->data;
+    for (Uint32 i = 0; i < a->count; i++) {
+        glm_vec3_copy(v, p[i]);
+    }
+    return 1;
+}
+
+static int array_gc(lua_State *L) {
+    cglm_array *a = (cglm_array *)lua_touserdata(L, 1);
+    SDL_aligned_free(a->data);
+    a->data = NULL;
+    a->count = 0;
+    return 0;
+}
+
+// Lua: a:count() -> integer (also #a)
+static int array_count(lua_State *L) {
+    cglm_array *a = check_array(L, 1);
+    lua_pushinteger(L, a->count);
+    return 1;
+}
+
+// Lua: a:size() -> integer, bytes of data (for gl.buffer_data)
+static int array_size(lua_State *L) {
+    cglm_array *a = check_array(L, 1);
+    lua_pushinteger(L, (lua_Integer)a->count * a->width * sizeof(float));
+    return 1;
+}
+
+static int mat4_array_tostring(lua_State *L) {
+    lua_pushfstring(L, "mat4_array(%d)", (int)check_mat4_array(L, 1)->count);
+    return 1;
+}
+
+static int vec3_array_tostring(lua_State *L) {
+    lua_pushfstring(L, "vec3_array(%d)", (int)check_vec3_array(L, 1)->count);
+    return 1;
+}
+
+// Lua: a:get(i [, dst]) -> mat4, a copy of element i (into dst when given)
+static int mat4_array_get(lua_State *L) {
+    cglm_array *a = check_mat4_array(L, 1);
+    mat4 *m = (mat4 *)a->data + check_index(L, 2, a);
+    if (lua_isnoneornil(L, 3)) {
+        push_mat4(L, *m);
+    } else {
+        glm_mat4_copy(*m, *check_mat4(L, 3));
+        lua_settop(L, 3);
+    }
+    return 1;
+}
+
+// Lua: a:set(i, mat4) -> a
+static int mat4_array_set(lua_State *L) {
+    cglm_array *a = check_mat4_array(L, 1);
+    mat4 *m = (mat4 *)a->data + check_index(L, 2, a);
+    glm_mat4_copy(*check_mat4(L, 3), *m);
+    lua_settop(L, 1);
+    return 1;
+}
+
+// Lua: a:identity_([count]) -> a
+static int mat4_array_identity_(lua_State *L) {
+    cglm_array *a = check_mat4_array(L, 1);
+    Uint32 n = check_bulk_count(L, 2, a->count);
+    mat4 *m = (mat4 *)a->data;
+    for (Uint32 i = 0; i < n; i++) {
+        glm_mat4_identity(m[i]);
+    }
+    lua_settop(L, 1);
+    return 1;
+}
+
+// Lua: a:get(i [, dst]) -> vec3, a copy of element i (into dst when given)
+static int vec3_array_get(lua_State *L) {
+    cglm_array *a = check_vec3_array(L, 1);
+    vec3 *v = (vec3 *)a->data + check_index(L, 2, a);
+    if (lua_isnoneornil(L, 3)) {
+        push_vec3(L, (*v)[0], (*v)[1], (*v)[2]);
+    } else {
+        glm_vec3_copy(*v, *check_vec3(L, 3));
+        lua_settop(L, 3);
+    }
+    return 1;
+}
+
+// Lua: a:set(i, vec3 | x, y, z) -> a
+static int vec3_array_set(lua_State *L) {
+    cglm_array *a = check_vec3_array(L, 1);
+    vec3 *v = (vec3 *)a->data + check_index(L, 2, a);
+    check_vec3_args(L, 3, *v);
+    lua_settop(L, 1);
+    return 1;
+}
+
+// Lua: a:fill_(vec3 | x, y, z) -> a
+static int vec3_array_fill_(lua_State *L) {
+    cglm_array *a = check_vec3_array(L, 1);
+    vec3 v;
+    check_vec3_args(L, 2, v);
+    vec3 *p = (vec3 *)a->data;
+    for (Uint32 i = 0; i < a->count; i++) {
+        glm_vec3_copy(v, p[i]);
+    }
+    lua_settop(L, 1);
+    return 1;
+}
+
+// Lua: cglm.mat4_array_mul(dst, m, src [, count]) -> dst -- dst[i] = m * src[i], dst may be src
+static int mat4_array_mul(lua_State *L) {
+    cglm_array *dst = check_mat4_array(L, 1);
+    mat4 m;
+    check_mat4_arg(L, 2, m);
+    cglm_array *src = check_mat4_array(L, 3);
+    Uint32 n = check_bulk_count(L, 4, SDL_min(dst->count, src->count));
+    mat4 *d = (mat4 *)dst->data;
+    mat4 *s = (mat4 *)src->data;
+    for (Uint32 i = 0; i < n; i++) {
+        glm_mat4_mul(m, s[i], d[i]);  // cglm copes with d[i] aliasing s[i]
+    }
+    lua_settop(L, 1);
+    return 1;
+}
+
+// Lua: cglm.mat4_array_compose(dst, positions, rotations [, scales [, count]]) -> dst
+// dst[i] = translate(positions[i]) * rotate_xyz(rotations[i]) * scale(scales[i]);
+// rotations are Euler angles in radians (X, then Y, then Z), scales default to 1
+static int mat4_array_compose(lua_State *L) {
+    cglm_array *dst = check_mat4_array(L, 1);
+    cglm_array *pos = check_vec3_array(L, 2);
+    cglm_array *rot = check_vec3_array(L, 3);
+    cglm_array *scl = lua_isnoneornil(L, 4) ? NULL : check_vec3_array(L, 4);
+    Uint32 limit = SDL_min(dst->count, SDL_min(pos->count, rot->count));
+    if (scl) limit = SDL_min(limit, scl->count);
+    Uint32 n = check_bulk_count(L, 5, limit);
+    mat4 *d = (mat4 *)dst->data;
+    vec3 *p = (vec3 *)pos->data;
+    vec3 *r = (vec3 *)rot->data;
+    vec3 *s = scl ? (vec3 *)scl->data : NULL;
+    for (Uint32 i = 0; i < n; i++) {
+        glm_euler_xyz(r[i], d[i]);
+        if (s) {
+            glm_vec4_scale(d[i][0], s[i][0], d[i][0]);
+            glm_vec4_scale(d[i][1], s[i][1], d[i][1]);
+            glm_vec4_scale(d[i][2], s[i][2], d[i][2]);
+        }
+        d[i][3][0] = p[i][0];
+        d[i][3][1] = p[i][1];
+        d[i][3][2] = p[i][2];
+    }
+    lua_settop(L, 1);
+    return 1;
+}
+
+// Lua: cglm.vec3_array_transform(dst, m, src [, w [, count]]) -> dst
+// dst[i] = (m * vec4(src[i], w)).xyz, w = 1 (points) by default, 0 for directions
+static int vec3_array_transform(lua_State *L) {
+    cglm_array *dst = check_vec3_array(L, 1);
+    mat4 m;
+    check_mat4_arg(L, 2, m);
+    cglm_array *src = check_vec3_array(L, 3);
+    float w = (float)luaL_optnumber(L, 4, 1.0);
+    Uint32 n = check_bulk_count(L, 5, SDL_min(dst->count, src->count));
+    vec3 *d = (vec3 *)dst->data;
+    vec3 *s = (vec3 *)src->data;
+    for (Uint32 i = 0; i < n; i++) {
+        glm_mat4_mulv3(m, s[i], w, d[i]);
+    }
+    lua_settop(L, 1);
+    return 1;
+}
+
+// Lua: a:add_(vec3 | x, y, z) -> a -- adds the offset to every element
+static int vec3_array_add_(lua_State *L) {
+    cglm_array *a = check_vec3_array(L, 1);
+    vec3 v;
+    check_vec3_args(L, 2, v);
+    vec3 *p = (vec3 *)a->data;
+    for (Uint32 i = 0; i < a->count; i++) {
+        glm_vec3_add(p[i], v, p[i]);
+    }
+    lua_settop(L, 1);
+    return 1;
+}
+
+static const luaL_Reg mat4_array_methods[] = {
+    {"count", array_count},
+    {"size", array_size},
+    {"get", mat4_array_get},
+    {"set", mat4_array_set},
+    {"identity_", mat4_array_identity_},
+    {NULL, NULL}
+};
+
+static const luaL_Reg vec3_array_methods[] = {
+    {"count", array_count},
+    {"size", array_size},
+    {"get", vec3_array_get},
+    {"set", vec3_array_set},
+    {"fill_", vec3_array_fill_},
+    {"add_", vec3_array_add_},
+    {NULL, NULL}
+};
+
+//===============================================
+// scene
+//===============================================
+// Transform hierarchy in C (scene_graph.c). Setting a local transform marks
+// the node dirty, scene:update() recomputes world matrices of dirty subtrees
+// only, so static nodes cost nothing per frame.
+//   local scene = cglm.scene()
+//   local body = scene:add()
+//   local arm = scene:add(body)
+//   scene:set_position(arm, 1, 0, 0)
+//   scene:update()
+//   gl.uniform_matrix4fv(loc, 1, gl.FALSE, scene:world(arm, model))
+
+#define SCENE_TYPE "cglm.scene"
+
+typedef struct {
+    scene_graph *graph;
+} lua_scene;
+
+static scene_graph *check_scene(lua_State *L, int idx) {
+    lua_scene *s = (lua_scene *)luaL_checkudata(L, idx, SCENE_TYPE);
+    if (!s->graph) luaL_argerror(L, idx, "scene was destroyed");
+    return s->graph;
+}
+
+// Helper: Node id argument of a live node
+static int check_node(lua_State *L, int idx, scene_graph *g) {
+    lua_Integer id = luaL_checkinteger(L, idx);
+    luaL_argcheck(L, id >= 0 && id <= INT_MAX && scene_graph_valid(g, (int)id), idx, "no such node");
+    return (int)id;
+}
+
+// Helper: Optional parent argument, nil for a root
+static int opt_node(lua_State *L, int idx, scene_graph *g) {
+    return lua_isnoneornil(L, idx) ? SCENE_GRAPH_NONE : check_node(L, idx, g);
+}
+
+// Lua: cglm.scene([capacity]) -> scene
+static int scene_new(lua_State *L) {
+    lua_Integer capacity = luaL_optinteger(L, 1, 64);
+    luaL_argcheck(L, capacity >= 1 && capacity <= SCENE_GRAPH_MAX_NODES, 1, "capacity out of range");
+    lua_scene *s = (lua_scene *)lua_alloc_newuserdata(L, sizeof(lua_scene), 0, LUA_TAG_CGLM);
+    s->graph = NULL;
+    luaL_setmetatable(L, SCENE_TYPE);
+    s->graph = scene_graph_create((int)capacity);
+    if (!s->graph) return luaL_error(L, "cglm.scene: out of memory");
+    return 1;
+}
+
+static int scene_gc(lua_State *L) {
+    lua_scene *s = (lua_scene *)lua_touserdata(L, 1);
+    scene_graph_destroy(s->graph);
+    s->graph = NULL;
+    return 0;
+}
+
+// Lua: scene:add([parent]) -> id -- new node with an identity local transform
+static int scene_add(lua_State *L) {
+    scene_graph *g = check_scene(L, 1);
+    int id = scene_graph_add(g, opt_node(L, 2, g));
+    if (id < 0) return luaL_error(L, "cglm.scene: %s", SDL_GetError());
+    lua_pushinteger(L, id);
+    return 1;
+}
+
+// Lua: scene:remove(id) -- removes the node and its descendants
+static int scene_remove(lua_State *L) {
+    scene_graph *g = check_scene(L, 1);
+    scene_graph_remove(g, check_node(L, 2, g));
+    return 0;
+}
+
+// Lua: scene:set_parent(id, parent | nil) -> true | nil, err
+static int scene_set_parent(lua_State *L) {
+    scene_graph *g = check_scene(L, 1);
+    int id = check_node(L, 2, g);
+    if (!scene_graph_set_parent(g, id, opt_node(L, 3, g))) {
+        lua_pushnil(L);
+        lua_pushstring(L, SDL_GetError());
+        return 2;
+    }
+    lua_pushboolean(L, 1);
+    return 1;
+}
+
+// Lua: scene:parent(id) -> id | nil
+static int scene_parent(lua_State *L) {
+    scene_graph *g = check_scene(L, 1);
+    int parent = scene_graph_parent(g, check_node(L, 2, g));
+    if (parent == SCENE_GRAPH_NONE) lua_pushnil(L);
+    else lua_pushinteger(L, parent);
+    return 1;
+}
+
+// Lua: scene:valid(id) -> boolean
+static int scene_valid(lua_State *L) {
+    scene_graph *g = check_scene(L, 1);
+    lua_Integer id = luaL_checkinteger(L, 2);
+    lua_pushboolean(L, id >= 0 && id <= INT_MAX && scene_graph_valid(g, (int)id));
+    return 1;
+}
+
+// Lua: scene:count() -> integer (also #scene)
+static int scene_count(lua_State *L) {
+    lua_pushinteger(L, scene_graph_count(check_scene(L, 1)));
+    return 1;
+}
+
+// Lua: scene:set_position(id, vec3 | x, y, z)
+static int scene_set_position(lua_State *L) {
+    scene_graph *g = check_scene(L, 1);
+    int id = check_node(L, 2, g);
+    vec3 v;
+    check_vec3_args(L, 3, v);
+    scene_graph_set_position(g, id, v);
+    return 0;
+}
+
+// Lua: scene:set_rotation(id, vec3 | x, y, z) -- Euler angles in radians, X then Y then Z
+static int scene_set_rotation(lua_State *L) {
+    scene_graph *g = check_scene(L, 1);
+    int id = check_node(L, 2, g);
+    vec3 v;
+    check_vec3_args(L, 3, v);
+    scene_graph_set_rotation(g, id, v);
+    return 0;
+}
+
+// Lua: scene:set_scale(id, vec3 | x, y, z | s)
+static int scene_set_scale(lua_State *L) {
+    scene_graph *g = check_scene(L, 1);
+    int id = check_node(L, 2, g);
+    vec3 v;
+    if (lua_type(L, 3) == LUA_TNUMBER && lua_isnone(L, 4)) {
+        glm_vec3_fill(v, (float)lua_tonumber(L, 3));
+    } else {
+        check_vec3_args(L, 3, v);
+    }
+    scene_graph_set_scale(g, id, v);
+    return 0;
+}
+
+// Helper: Push x, y, z
+static int push_xyz(lua_State *L, const vec3 v) {
+    lua_pushnumber(L, v[0]);
+    lua_pushnumber(L, v[1]);
+    lua_pushnumber(L, v[2]);
+    return 3;
+}
+
+// Lua: scene:get_position(id) -> x, y, z
+static int scene_get_position(lua_State *L) {
+    scene_graph *g = check_scene(L, 1);
+    vec3 v;
+    scene_graph_get_position(g, check_node(L, 2, g), v);
+    return push_xyz(L, v);
+}
+
+// Lua: scene:get_rotation(id) -> x, y, z
+static int scene_get_rotation(lua_State *L) {
+    scene_graph *g = check_scene(L, 1);
+    vec3 v;
+    scene_graph_get_rotation(g, check_node(L, 2, g), v);
+    return push_xyz(L, v);
+}
+
+// Lua: scene:get_scale(id) -> x, y, z
+static int scene_get_scale(lua_State *L) {
+    scene_graph *g = check_scene(L, 1);
+    vec3 v;
+    scene_graph_get_scale(g, check_node(L, 2, g), v);
+    return push_xyz(L, v);
+}
+
+// Lua: scene:update([parallel]) -> integer, world matrices recomputed
+// parallel: spread large updates over the job workers (after jobs.init)
+static int scene_update(lua_State *L) {
+    scene_graph *g = check_scene(L, 1);
+    lua_pushinteger(L, scene_graph_update(g, lua_toboolean(L, 2)));
+    return 1;
+}
+
+// Lua: scene:world(id [, dst]) -> mat4, the world matrix as of the last update
+static int scene_world(lua_State *L) {
+    scene_graph *g = check_scene(L, 1);
+    const float *world = scene_graph_world(g, check_node(L, 2, g));
+    if (lua_isnoneornil(L, 3)) {
+        mat4 m;
+        SDL_memcpy(m, world, sizeof(mat4));
+        push_mat4(L, m);
+    } else {
+        SDL_memcpy(*check_mat4(L, 3), world, sizeof(mat4));
+        lua_settop(L, 3);
+    }
+    return 1;
+}
+
+// Lua: scene:copy_worlds(dst) -> dst -- dst[id] = world of node id, for every
+// live id below #dst (mat4_array, e.g. for instancing)
+static int scene_copy_worlds(lua_State *L) {
+    scene_graph *g = check_scene(L, 1);
+    cglm_array *dst = check_mat4_array(L, 2);
+    int limit = SDL_min((int)dst->count, scene_graph_id_limit(g));
+    mat4 *d = (mat4 *)dst->data;
+    for (int id = 0; id < limit; id++) {
+        if (scene_graph_valid(g, id)) SDL_memcpy(d[id], scene_graph_world(g, id), sizeof(mat4));
+    }
+    lua_settop(L, 2);
+    return 1;
+}
+
+static int scene_tostring(lua_State *L) {
+    lua_pushfstring(L, "scene(%d nodes)", scene_graph_count(check_scene(L, 1)));
+    return 1;
+}
+
+static const luaL_Reg scene_methods[] = {
+    {"add", scene_add},
+    {"remove", scene_remove},
+    {"set_parent", scene_set_parent},
+    {"parent", scene_parent},
+    {"valid", scene_valid},
+    {"count", scene_count},
+    {"set_position", scene_set_position},
+    {"set_rotation", scene_set_rotation},
+    {"set_scale", scene_set_scale},
+    {"get_position", scene_get_position},
+    {"get_rotation", scene_get_rotation},
+    {"get_scale", scene_get_scale},
+    {"update", scene_update},
+    {"world", scene_world},
+    {"copy_worlds", scene_copy_worlds},
+    {NULL, NULL}
+};
+
+//===============================================
+// culling
+//===============================================
+// Frustum culling of many bounding volumes in one call (frustum_cull.c, SIMD).
+// Bounds are stored as structure-of-arrays columns; cglm.frustum_cull writes
+// the indices of the visible ones to an index_array, which either goes to the
+// GPU as is or selects the instance matrices to upload:
+//   frustum:set_(view_projection)
+//   local n = cglm.frustum_cull(frustum, bounds, visible)
+//   cglm.mat4_array_gather(draw_models, models, visible, n)
+//   gl.buffer_sub_data(gl.ARRAY_BUFFER, 0, draw_models, n * 64)
+//   gl.draw_arrays_instanced(gl.TRIANGLES, 0, 36, n)
+
+#define FRUSTUM_TYPE "cglm.frustum"
+#define BOUNDS_TYPE "cglm.bounds"
+
+typedef struct {
+    frustum_planes planes;
+} lua_frustum;
+
+typedef struct {
+    float *data;                // 64-byte aligned columns cx, cy, cz, ex[, ey, ez]
+    Uint32 count;
+    Uint32 stride;              // floats per column, count rounded up to 16
+    int box;                    // AABBs (center, half extents), else spheres (center, radius)
+} lua_bounds;
+
+static lua_frustum *check_frustum(lua_State *L, int idx) {
+    return (lua_frustum *)luaL_checkudata(L, idx, FRUSTUM_TYPE);
+}
+
+static lua_bounds *check_bounds(lua_State *L, int idx) {
+    return (lua_bounds *)luaL_checkudata(L, idx, BOUNDS_TYPE);
+}
+
+// Helper: The columns of b in the form frustum_cull takes
+static frustum_bounds bounds_columns(const lua_bounds *b) {
+    const float *d = b->data;
+    frustum_bounds f = {d, d + b->stride, d + 2 * b->stride, d + 3 * b->stride, NULL, NULL};
+    if (b->box) {
+        f.ey = d + 4 * b->stride;
+        f.ez = d + 5 * b->stride;
+    }
+    return f;
+}
+
+// Helper: Planes of a view-projection matrix
+static void set_frustum(lua_State *L, int idx, lua_frustum *f) {
+    mat4 m;
+    vec4 planes[6];
+    check_mat4_arg(L, idx, m);
+    glm_frustum_planes(m, planes);
+    SDL_memcpy(f->planes, planes, sizeof(f->planes));
+}
+
+// Lua: cglm.frustum([view_projection]) -> frustum, everything is inside until set_
+static int frustum_new(lua_State *L) {
+    lua_frustum *f = (lua_frustum *)lua_alloc_newuserdata(L, sizeof(lua_frustum), 0, LUA_TAG_CGLM);
+    luaL_setmetatable(L, FRUSTUM_TYPE);
+    for (int k = 0; k < 6; k++) {
+        f->planes[k][0] = f->planes[k][1] = f->planes[k][2] = 0.0f;
+        f->planes[k][3] = 1.0f;
+    }
+    if (!lua_isnoneornil(L, 1)) set_frustum(L, 1, f);
+    return 1;
+}
+
+// Lua: f:set_(view_projection) -> f
+static int frustum_set_(lua_State *L) {
+    set_frustum(L, 2, check_frustum(L, 1));
+    lua_settop(L, 1);
+    return 1;
+}
+
+// Lua: f:plane(i) -> a, b, c, d -- i = 0..5: left, right, bottom, top, near, far
+static int frustum_plane(lua_State *L) {
+    lua_frustum *f = check_frustum(L, 1);
+    lua_Integer i = luaL_checkinteger(L, 2);
+    luaL_argcheck(L, i >= 0 && i < 6, 2, "plane index out of range");
+    for (int j = 0; j < 4; j++) {
+        lua_pushnumber(L, f->planes[i][j]);
+    }
+    return 4;
+}
+
+// Helper: Test a single volume given as numbers from index 2
+static int test_volume(lua_State *L, int box) {
+    lua_frustum *f = check_frustum(L, 1);
+    float v[6];
+    for (int j = 0; j < (box ? 6 : 4); j++) {
+        v[j] = (float)luaL_checknumber(L, 2 + j);
+    }
+    frustum_bounds b = {&v[0], &v[1], &v[2], &v[3], box ? &v[4] : NULL, box ? &v[5] : NULL};
+    Uint32 index;
+    lua_pushboolean(L, frustum_cull(f->planes, &b, 1, &index) == 1);
+    return 1;
+}
+
+// Lua: f:test_sphere(x, y, z, radius) -> boolean, at least partly inside
+static int frustum_test_sphere(lua_State *L) {
+    return test_volume(L, 0);
+}
+
+// Lua: f:test_aabb(x, y, z, ex, ey, ez) -> boolean, box at center x, y, z with
+// half extents ex, ey, ez at least partly inside
+static int frustum_test_aabb(lua_State *L) {
+    return test_volume(L, 1);
+}
+
+static int frustum_tostring(lua_State *L) {
+    check_frustum(L, 1);
+    lua_pushstring(L, "frustum");
+    return 1;
+}
+
+// Helper: Bounds userdata with every volume at the origin and the given size
+static lua_bounds *new_bounds(lua_State *L, int box) {
+    lua_Integer count = luaL_checkinteger(L, 1);
+    luaL_argcheck(L, count >= 0 && count <= CGLM_ARRAY_MAX, 1, "count out of range");
+    float size[3];
+    size[0] = (float)luaL_optnumber(L, 2, 0.0);
+    size[1] = box ? (float)luaL_optnumber(L, 3, size[0]) : size[0];
+    size[2] = box ? (float)luaL_optnumber(L, 4, size[0]) : size[0];
+
+    lua_bounds *b = (lua_bounds *)lua_alloc_newuserdata(L, sizeof(lua_bounds), 0, LUA_TAG_CGLM);
+    b->data = NULL;
+    b->count = 0;
+    b->stride = ((Uint32)count + 15) & ~15u;
+    b->box = box;
+    luaL_setmetatable(L, BOUNDS_TYPE);
+    int columns = box ? 6 : 4;
+    b->data = (float *)SDL_aligned_alloc(ARRAY_ALIGN, (size_t)(b->stride ? b->stride : 16) * columns * sizeof(float));
+    if (!b->data) luaL_error(L, "cglm: out of memory for %d bounds", (int)count);
+    b->count = (Uint32)count;
+    SDL_memset(b->data, 0, (size_t)b->stride * 3 * sizeof(float));
+    for (int c = 3; c < columns; c++) {
+        float *col = b->data + c * b->stride;
+        for (Uint32 i = 0; i < b->stride; i++) {
+            col[i] = size[c - 3];
+        }
+    }
+    return b;
+}
+
+// Lua: cglm.sphere_array(count [, radius]) -> bounds, spheres at the origin (radius default 0)
+static int sphere_array_new(lua_State *L) {
+    new_bounds(L, 0);
+    return 1;
+}
+
+// Lua: cglm.aabb_array(count [, ex [, ey, ez]]) -> bounds, boxes at the origin
+// with half extents ex, ey, ez (default 0; ey and ez default to ex)
+static int aabb_array_new(lua_State *L) {
+    new_bounds(L, 1);
+    return 1;
+}
+
+static int bounds_gc(lua_State *L) {
+    lua_bounds *b = (lua_bounds *)lua_touserdata(L, 1);
+    SDL_aligned_free(b->data);
+    b->data = NULL;
+    b->count = 0;
+    return 0;
+}
+
+// Lua: b:count() -> integer (also #b)
+static int bounds_count(lua_State *L) {
+    lua_pushinteger(L, check_bounds(L, 1)->count);
+    return 1;
+}
+
+// Helper: 0-based volume index argument
+static Uint32 check_volume(lua_State *L, int idx, const lua_bounds *b) {
+    lua_Integer i = luaL_checkinteger(L, idx);
+    luaL_argcheck(L, i >= 0 && i < (lua_Integer)b->count, idx, "index out of range");
+    return (Uint32)i;
+}
+
+// Lua: b:set(i, x, y, z, radius | ex, ey, ez) -> b
+static int bounds_set(lua_State *L) {
+    lua_bounds *b = check_bounds(L, 1);
+    Uint32 i = check_volume(L, 2, b);
+    int columns = b->box ? 6 : 4;
+    for (int c = 0; c < columns; c++) {
+        b->data[c * b->stride + i] = (float)luaL_checknumber(L, 3 + c);
+    }
+    lua_settop(L, 1);
+    return 1;
+}
+
+// Lua: b:get(i) -> x, y, z, radius | ex, ey, ez
+static int bounds_get(lua_State *L) {
+    lua_bounds *b = check_bounds(L, 1);
+    Uint32 i = check_volume(L, 2, b);
+    int columns = b->box ? 6 : 4;
+    for (int c = 0; c < columns; c++) {
+        lua_pushnumber(L, b->data[c * b->stride + i]);
+    }
+    return columns;
+}
+
+// Lua: b:set_centers(vec3_array | mat4_array [, count]) -> b -- centers from
+// points, or from the translation of transforms (e.g. instance matrices)
+static int bounds_set_centers(lua_State *L) {
+    lua_bounds *b = check_bounds(L, 1);
+    cglm_array *src = (cglm_array *)luaL_testudata(L, 2, CGLM_MAT4_ARRAY_MT);
+    if (!src) src = check_vec3_array(L, 2);
+    Uint32 n = check_bulk_count(L, 3, SDL_min(b->count, src->count));
+    const float *s = (const float *)src->data + (src->width == 16 ? 12 : 0);
+    float *cx = b->data, *cy = cx + b->stride, *cz = cy + b->stride;
+    for (Uint32 i = 0; i < n; i++, s += src->width) {
+        cx[i] = s[0];
+        cy[i] = s[1];
+        cz[i] = s[2];
+    }
+    lua_settop(L, 1);
+    return 1;
+}
+
+// Lua: b:fill_extent_(radius | ex, ey, ez) -> b -- same size for every volume
+static int bounds_fill_extent_(lua_State *L) {
+    lua_bounds *b = check_bounds(L, 1);
+    float size[3];
+    size[0] = (float)luaL_checknumber(L, 2);
+    size[1] = b->box ? (float)luaL_optnumber(L, 3, size[0]) : size[0];
+    size[2] = b->box ? (float)luaL_optnumber(L, 4, size[0]) : size[0];
+    for (int c = 3; c < (b->box ? 6 : 4); c++) {
+        float *col = b->data + c * b->stride;
+        for (Uint32 i = 0; i < b->count; i++) {
+            col[i] = size[c - 3];
+        }
+    }
+    lua_settop(L, 1);
+    return 1;
+}
+
+static int bounds_tostring(lua_State *L) {
+    lua_bounds *b = check_bounds(L, 1);
+    lua_pushfstring(L, "%s(%d)", b->box ? "aabb_array" : "sphere_array", (int)b->count);
+    return 1;
+}
+
+// Lua: cglm.index_array(count) -> index_array, every element 0
+static int index_array_new(lua_State *L) {
+    cglm_array *a = new_array(L, luaL_checkinteger(L, 1), 1, CGLM_INDEX_ARRAY_MT);
+    SDL_memset(a->data, 0, (size_t)a->count * sizeof(Uint32));
+    return 1;
+}
+
+// Lua: a:get(i) -> integer
+static int index_array_get(lua_State *L) {
+    cglm_array *a = check_index_array(L, 1);
+    lua_pushinteger(L, ((Uint32 *)a->data)[check_index(L, 2, a)]);
+    return 1;
+}
+
+// Lua: a:set(i, value) -> a
+static int index_array_set(lua_State *L) {
+    cglm_array *a = check_index_array(L, 1);
+    Uint32 i = check_index(L, 2, a);
+    lua_Integer v = luaL_checkinteger(L, 3);
+    luaL_argcheck(L, v >= 0 && v <= 0xFFFFFFFF, 3, "value out of range");
+    ((Uint32 *)a->data)[i] = (Uint32)v;
+    lua_settop(L, 1);
+    return 1;
+}
+
+static int index_array_tostring(lua_State *L) {
+    lua_pushfstring(L, "index_array(%d)", (int)check_index_array(L, 1)->count);
+    return 1;
+}
+
+// Lua: cglm.frustum_cull(frustum, bounds, out [, count]) -> integer
+// Writes the indices of the volumes among the first count (default: all that
+// fit in out) that are at least partly inside the frustum to out, in
+// ascending order, and returns how many there are
+static int cglm_frustum_cull(lua_State *L) {
+    lua_frustum *f = check_frustum(L, 1);
+    lua_bounds *b = check_bounds(L, 2);
+    cglm_array *out = check_index_array(L, 3);
+    Uint32 n = check_bulk_count(L, 4, SDL_min(b->count, out->count));
+    frustum_bounds columns = bounds_columns(b);
+    lua_pushinteger(L, frustum_cull(f->planes, &columns, n, (Uint32 *)out->data));
+    return 1;
+}
+
+// Lua: cglm.mat4_array_gather(dst, src, indices [, count]) -> dst
+// dst[k] = src[indices[k]] for the first count indices (default: all that fit in dst)
+static int mat4_array_gather(lua_State *L) {
+    cglm_array *dst = check_mat4_array(L, 1);
+    cglm_array *src = check_mat4_array(L, 2);
+    luaL_argcheck(L, dst != src, 2, "dst and src must differ");
+    cglm_array *indices = check_index_array(L, 3);
+    Uint32 n = check_bulk_count(L, 4, SDL_min(dst->count, indices->count));
+    mat4 *d = (mat4 *)dst->data;
+    const mat4 *s = (const mat4 *)src->data;
+    const Uint32 *idx = (const Uint32 *)indices->data;
+    for (Uint32 k = 0; k < n; k++) {
+        if (idx[k] >= src->count) return luaL_error(L, "mat4_array_gather: index %d out of range", (int)idx[k]);
+        SDL_memcpy(d[k], s[idx[k]], sizeof(mat4));
+    }
+    lua_settop(L, 1);
+    return 1;
+}
+
+static const luaL_Reg frustum_methods[] = {
+    {"set_", frustum_set_},
+    {"plane", frustum_plane},
+    {"test_sphere", frustum_test_sphere},
+    {"test_aabb", frustum_test_aabb},
+    {NULL, NULL}
+};
+
+static const luaL_Reg bounds_methods[] = {
+    {"count", bounds_count},
+    {"set", bounds_set},
+    {"get", bounds_get},
+    {"set_centers", bounds_set_centers},
+    {"fill_extent_", bounds_fill_extent_},
+    {NULL, NULL}
+};
+
+static const luaL_Reg index_array_methods[] = {
+    {"count", array_count},
+    {"size", array_size},
+    {"get", index_array_get},
+    {"set", index_array_set},
+    {NULL, NULL}
+};
+
+// Metatable methods
+static const luaL_Reg vec3_methods[] = {
+    {"dot", vec3_dot},
+    {"cross", vec3_cross},
+    {"normalize", vec3_normalize},
+    {"length", vec3_length},
+    {"get", vec3_get},
+    {"set", vec3_set},
+    {"set_", vec3_set_},
+    {"add_", vec3_add_},
+    {"sub_", vec3_sub_},
+    {"scale_", vec3_scale_},
+    {"normalize_", vec3_normalize_},
+    {NULL, NULL}
+};
+
+static const luaL_Reg vec4_methods[] = {
+    {"dot", vec4_dot},
+    {"normalize", vec4_normalize},
+    {"length", vec4_length},
+    {"get", vec4_get},
+    {"set", vec4_set},
+    {"set_", vec4_set_},
+    {"add_", vec4_add_},
+    {"sub_", vec4_sub_},
+    {"scale_", vec4_scale_},
+    {"normalize_", vec4_normalize_},
+    {NULL, NULL}
+};
+
+static const luaL_Reg mat4_methods[] = {
+    {"get", mat4_get},
+    {"set", mat4_set},
+    {"identity_", mat4_identity_},
+    {"copy_", mat4_copy_},
+    {"rotate_", mat4_rotate_},
+    {"translate_", mat4_translate_},
+    {"scale_", mat4_scale_},
+    {"mul_", mat4_mul_},
+    {"perspective_", mat4_perspective_},
+    {"ortho_", mat4_ortho_},
+    {NULL, NULL}
+};
+
 static int debug_perspective(lua_State *L) {
     float fovy = glm_rad(45.0f);
     float aspect = 800.0f / 600.0f;
@@ -496,6 +1653,26 @@ static const luaL_Reg module_glm_funcs[] = {
     {"rotate", mat4_rotate},
     {"translate", mat4_translate},
     {"mat4_mul", mat4_mul},
+    {"mat4_mul_into", mat4_mul_into},
+    {"mat4_mulv_into", mat4_mulv_into},
+    {"rotate_into", mat4_rotate_into},
+    {"translate_into", mat4_translate_into},
+    {"vec3_add_into", vec3_add_into},
+    {"vec3_sub_into", vec3_sub_into},
+    {"vec3_scale_into", vec3_scale_into},
+    {"vec3_cross_into", vec3_cross_into},
+    {"mat4_array", mat4_array_new},
+    {"vec3_array", vec3_array_new},
+    {"mat4_array_mul", mat4_array_mul},
+    {"mat4_array_compose", mat4_array_compose},
+    {"vec3_array_transform", vec3_array_transform},
+    {"scene", scene_new},
+    {"frustum", frustum_new},
+    {"sphere_array", sphere_array_new},
+    {"aabb_array", aabb_array_new},
+    {"index_array", index_array_new},
+    {"frustum_cull", cglm_frustum_cull},
+    {"mat4_array_gather", mat4_array_gather},
     {"debug_perspective", debug_perspective},
     {NULL, NULL}
 };
@@ -549,6 +1726,77 @@ int luaopen_module_cglm(lua_State *L) {
     luaL_setfuncs(L, mat4_methods, 0);
     lua_pop(L, 1);
 
+    // mat4_array and vec3_array metatables
+    luaL_newmetatable(L, CGLM_MAT4_ARRAY_MT);
+    lua_pushvalue(L, -1);
+    lua_setfield(L, -2, "__index");
+    lua_pushcfunction(L, mat4_array_tostring);
+    lua_setfield(L, -2, "__tostring");
+    lua_pushcfunction(L, array_count);
+    lua_setfield(L, -2, "__len");
+    lua_pushcfunction(L, array_gc);
+    lua_setfield(L, -2, "__gc");
+    luaL_setfuncs(L, mat4_array_methods, 0);
+    lua_pop(L, 1);
+
+    luaL_newmetatable(L, CGLM_VEC3_ARRAY_MT);
+    lua_pushvalue(L, -1);
+    lua_setfield(L, -2, "__index");
+    lua_pushcfunction(L, vec3_array_tostring);
+    lua_setfield(L, -2, "__tostring");
+    lua_pushcfunction(L, array_count);
+    lua_setfield(L, -2, "__len");
+    lua_pushcfunction(L, array_gc);
+    lua_setfield(L, -2, "__gc");
+    luaL_setfuncs(L, vec3_array_methods, 0);
+    lua_pop(L, 1);
+
+    luaL_newmetatable(L, CGLM_INDEX_ARRAY_MT);
+    lua_pushvalue(L, -1);
+    lua_setfield(L, -2, "__index");
+    lua_pushcfunction(L, index_array_tostring);
+    lua_setfield(L, -2, "__tostring");
+    lua_pushcfunction(L, array_count);
+    lua_setfield(L, -2, "__len");
+    lua_pushcfunction(L, array_gc);
+    lua_setfield(L, -2, "__gc");
+    luaL_setfuncs(L, index_array_methods, 0);
+    lua_pop(L, 1);
+
+    // scene metatable
+    luaL_newmetatable(L, SCENE_TYPE);
+    lua_pushvalue(L, -1);
+    lua_setfield(L, -2, "__index");
+    lua_pushcfunction(L, scene_tostring);
+    lua_setfield(L, -2, "__tostring");
+    lua_pushcfunction(L, scene_count);
+    lua_setfield(L, -2, "__len");
+    lua_pushcfunction(L, scene_gc);
+    lua_setfield(L, -2, "__gc");
+    luaL_setfuncs(L, scene_methods, 0);
+    lua_pop(L, 1);
+
+    // frustum and bounds metatables
+    luaL_newmetatable(L, FRUSTUM_TYPE);
+    lua_pushvalue(L, -1);
+    lua_setfield(L, -2, "__index");
+    lua_pushcfunction(L, frustum_tostring);
+    lua_setfield(L, -2, "__tostring");
+    luaL_setfuncs(L, frustum_methods, 0);
+    lua_pop(L, 1);
+
+    luaL_newmetatable(L, BOUNDS_TYPE);
+    lua_pushvalue(L, -1);
+    lua_setfield(L, -2, "__index");
+    lua_pushcfunction(L, bounds_tostring);
+    lua_setfield(L, -2, "__tostring");
+    lua_pushcfunction(L, bounds_count);
+    lua_setfield(L, -2, "__len");
+    lua_pushcfunction(L, bounds_gc);
+    lua_setfield(L, -2, "__gc");
+    luaL_setfuncs(L, bounds_methods, 0);
+    lua_pop(L, 1);
+
     // Create module table
     luaL_newlib(L, module_glm_funcs);
     return 1;
@@ -1,4 +1,7 @@
 #include "module_enet.h"
+#include "lua_alloc.h"
+#include "lua_blob.h"
+#include "module_lua.h"     // wakes lua_util.await(host) / await(peer) tasks
 #include <lauxlib.h>
 #include <lualib.h>
 #include <enet.h>
@@ -16,7 +19,7 @@
 
 // Helper to push ENetHost userdata
 static ENetHost** push_enet_host(lua_State *L) {
-    ENetHost **host = (ENetHost**)lua_newuserdata(L, sizeof(ENetHost*));
+    ENetHost **host = (ENetHost**)lua_alloc_newuserdata(L, sizeof(ENetHost*), 1, LUA_TAG_ENET);
     luaL_getmetatable(L, ENET_HOST_MT);
     lua_setmetatable(L, -2);
     return host;
@@ -24,7 +27,7 @@ static ENetHost** push_enet_host(lua_State *L) {
 
 // Helper to push ENetPeer userdata
 static ENetPeer** push_enet_peer(lua_State *L) {
-    ENetPeer **peer = (ENetPeer**)lua_newuserdata(L, sizeof(ENetPeer*));
+    ENetPeer **peer = (ENetPeer**)lua_alloc_newuserdata(L, sizeof(ENetPeer*), 1, LUA_TAG_ENET);
     luaL_getmetatable(L, ENET_PEER_MT);
     lua_setmetatable(L, -2);
     return peer;
@@ -32,7 +35,7 @@ static ENetPeer** push_enet_peer(lua_State *L) {
 
 // Helper to push ENetPacket userdata
 static ENetPacket** push_enet_packet(lua_State *L) {
-    ENetPacket **packet = (ENetPacket**)lua_newuserdata(L, sizeof(ENetPacket*));
+    ENetPacket **packet = (ENetPacket**)lua_alloc_newuserdata(L, sizeof(ENetPacket*), 1, LUA_TAG_ENET);
     luaL_getmetatable(L, ENET_PACKET_MT);
     lua_setmetatable(L, -2);
     return packet;
@@ -160,6 +163,17 @@ static int l_enet_host_connect(lua_State *L) {
     return 1;
 }
 
+// Helper: Wake tasks in lua_util.await(host) or lua_util.await(event.peer) with
+// the event table on top of the stack
+static void signal_event_waiters(lua_State *L) {
+    int event = lua_gettop(L);
+    module_lua_tasks_signal(L, 1, event);
+    if (lua_getfield(L, event, "peer") != LUA_TNIL) {
+        module_lua_tasks_signal(L, -1, event);
+    }
+    lua_pop(L, 1);
+}
+
 // enet.host_service(host, timeout)
 static int l_enet_host_service(lua_State *L) {
     ENetHost **host = (ENetHost**)luaL_checkudata(L, 1, ENET_HOST_MT);
@@ -206,6 +220,7 @@ static int l_enet_host_service(lua_State *L) {
         }
         lua_pushinteger(L, (lua_Integer)event.data);
         lua_setfield(L, -2, "data");
+        signal_event_waiters(L);
         return 1;
     }
     lua_pushinteger(L, result);
@@ -257,6 +272,7 @@ static int l_enet_host_check_events(lua_State *L) {
         }
         lua_pushinteger(L, (lua_Integer)event.data);
         lua_setfield(L, -2, "data");
+        signal_event_waiters(L);
         return 1;
     }
     lua_pushinteger(L, result);
@@ -277,13 +293,31 @@ static int l_enet_host_bandwidth_limit(lua_State *L) {
     return 0;
 }
 
+// Packet free callback: drop the reference taken by packet_create
+static void ENET_CALLBACK release_packet_blob(void *packet) {
+    lua_blob_release((lua_blob *)((ENetPacket *)packet)->userData);
+}
+
 // enet.packet_create(data, flags)
+// data: string (copied) or lua_blob (sent from the blob's memory, no copy)
 static int l_enet_packet_create(lua_State *L) {
+    lua_blob *blob = lua_blob_test(L, 1);
     size_t data_len;
-    const char *data = luaL_checklstring(L, 1, &data_len);
+    const char *data = blob ? (const char *)lua_blob_data(blob) : luaL_checklstring(L, 1, &data_len);
     enet_uint32 flags = (enet_uint32)luaL_optinteger(L, 2, ENET_PACKET_FLAG_RELIABLE);
 
-    ENetPacket *packet = enet_packet_create(data, data_len, flags);
+    ENetPacket *packet;
+    if (blob) {
+        // Blobs are immutable, so the packet can point at the bytes until it is freed
+        packet = enet_packet_create(data, lua_blob_size(blob), flags | ENET_PACKET_FLAG_NO_ALLOCATE);
+        if (packet) {
+            lua_blob_retain(blob);
+            packet->userData = blob;
+            packet->freeCallback = release_packet_blob;
+        }
+    } else {
+        packet = enet_packet_create(data, data_len, flags);
+    }
     if (packet == NULL) {
         fprintf(stderr, "enet.packet_create: Failed to create packet\n");
         lua_pushnil(L);
@@ -1,13 +1,94 @@
 #include "module_gl.h"
+#include "module_sdl.h"
+#include "module_cglm.h"
+#include "lua_blob.h"
 #include <SDL3/SDL.h>
 #include <glad/gl.h>  // GLAD 2.0
 #include <lauxlib.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <cglm/cglm.h>
+#include "gl_trace.h"
 
 // Static variable to store the OpenGL context
 static SDL_GLContext g_gl_context = NULL;
 
+//===============================================
+// call trace recorder
+//===============================================
+
+static FILE *g_trace_file = NULL;
+static Uint64 g_trace_start_ns = 0;
+
+#define TI(v) { .i = (int64_t)(v) }
+#define TF(v) { .f = (double)(v) }
+
+static void trace_write(int call, int argc, const gl_trace_arg *args, const void *payload, size_t payload_size) {
+    gl_trace_record rec;
+    rec.call = (uint16_t)call;
+    rec.argc = (uint8_t)argc;
+    rec.reserved = 0;
+    rec.payload_size = (uint32_t)payload_size;
+    rec.time_ns = SDL_GetTicksNS() - g_trace_start_ns;
+    fwrite(&rec, sizeof(rec), 1, g_trace_file);
+    if (argc > 0) fwrite(args, sizeof(gl_trace_arg), (size_t)argc, g_trace_file);
+    if (payload_size > 0) fwrite(payload, 1, payload_size, g_trace_file);
+}
+
+// GL_TRACE(GLT_X, TI(a), TF(b)) records a call with arguments, GL_TRACE_DATA also attaches a payload
+#define GL_TRACE(call, ...) do { \
+    if (g_trace_file) { \
+        gl_trace_arg trace_args_[] = { __VA_ARGS__ }; \
+        trace_write((call), (int)SDL_arraysize(trace_args_), trace_args_, NULL, 0); \
+    } \
+} while (0)
+#define GL_TRACE0(call) do { if (g_trace_file) trace_write((call), 0, NULL, NULL, 0); } while (0)
+#define GL_TRACE_DATA(call, data, size, ...) do { \
+    if (g_trace_file) { \
+        gl_trace_arg trace_args_[] = { __VA_ARGS__ }; \
+        trace_write((call), (int)SDL_arraysize(trace_args_), trace_args_, (data), (size)); \
+    } \
+} while (0)
+
+int module_gl_trace_begin(const char *path) {
+    module_gl_trace_end();
+    g_trace_file = fopen(path, "wb");
+    if (!g_trace_file) return 0;
+    setvbuf(g_trace_file, NULL, _IOFBF, 1 << 20);
+    gl_trace_header header = { GL_TRACE_MAGIC, GL_TRACE_VERSION, SDL_GetTicksNS() };
+    g_trace_start_ns = header.start_ns;
+    fwrite(&header, sizeof(header), 1, g_trace_file);
+    return 1;
+}
+
+void module_gl_trace_end(void) {
+    if (g_trace_file) {
+        fclose(g_trace_file);
+        g_trace_file = NULL;
+    }
+}
+
+void module_gl_trace_frame(void) {
+    GL_TRACE0(GLT_FRAME_END);
+}
+
+// Size of a client pixel upload with the default GL_UNPACK_ALIGNMENT of 4
+static size_t pixel_data_size(GLsizei width, GLsizei height, GLenum format, GLenum type) {
+    size_t components = 4;
+    switch (format) {
+        case GL_RED: case GL_ALPHA: components = 1; break;
+        case GL_RG: components = 2; break;
+        case GL_RGB: components = 3; break;
+        default: break;
+    }
+    size_t type_size = (type == GL_FLOAT || type == GL_UNSIGNED_INT || type == GL_INT) ? 4 :
+                       (type == GL_UNSIGNED_SHORT || type == GL_SHORT || type == GL_HALF_FLOAT) ? 2 : 1;
+    size_t row = (size_t)width * components * type_size;
+    if (width <= 0 || height <= 0) return 0;
+    return ((row + 3) & ~(size_t)3) * (size_t)(height - 1) + row;
+}
+
 // Helper to check OpenGL errors and push to Lua
 static int push_gl_error(lua_State *L, const char *context) {
     GLenum err = glGetError();
@@ -50,7 +131,7 @@ static int gl_get_gl_context(lua_State *L) {
     return 1;
 }
 
-// Lua: gl.init(window) -> bool, context, err_msg
+// Lua: gl.init(window, [swap_interval]) -> bool, context, err_msg
 static int gl_init(lua_State *L) {
     SDL_Window *window = get_sdl_window(L);
     if (!window) {
@@ -94,8 +175,10 @@ static int gl_init(lua_State *L) {
         return 3;
     }
 
-    if (SDL_GL_SetSwapInterval(1) < 0) {
-        printf("Warning: Failed to set VSync: %s\n", SDL_GetError());
+    // No vsync in headless mode, frame times should measure rendering only
+    int swap_interval = (int)luaL_optinteger(L, 2, module_sdl_is_headless() ? 0 : 1);
+    if (module_sdl_set_swap_interval(swap_interval) == -2) {
+        printf("Warning: Failed to set swap interval %d: %s\n", swap_interval, SDL_GetError());
     }
 
     printf("OpenGL loaded: %s %s\n", glGetString(GL_VERSION), glGetString(GL_RENDERER));
@@ -115,6 +198,7 @@ static int gl_clear(lua_State *L) {
     GLbitfield mask = (GLbitfield)luaL_checkinteger(L, 1);
     // Call glClear with the provided bitmask
     // glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // test
+    GL_TRACE(GLT_CLEAR, TI(mask));
     glClear(mask);
 
     return 0; // No return values on success
@@ -125,6 +209,7 @@ static int gl_clear_color(lua_State *L) {
     float g = (float)luaL_checknumber(L, 2);
     float b = (float)luaL_checknumber(L, 3);
     float a = (float)luaL_optnumber(L, 4, 1.0f);
+    GL_TRACE(GLT_CLEAR_COLOR, TF(r), TF(g), TF(b), TF(a));
     glClearColor(r, g, b, a);
     return 0;
 }
@@ -134,6 +219,7 @@ static int gl_viewport(lua_State *L) {
     int y = (int)luaL_checkinteger(L, 2);
     int w = (int)luaL_checkinteger(L, 3);
     int h = (int)luaL_checkinteger(L, 4);
+    GL_TRACE(GLT_VIEWPORT, TI(x), TI(y), TI(w), TI(h));
     glViewport(x, y, w, h);
     return 0;
 }
@@ -151,6 +237,7 @@ static int gl_destroy(lua_State *L) {
 static int gl_create_shader(lua_State *L) {
     GLenum type = (GLenum)luaL_checkinteger(L, 1);
     GLuint shader = glCreateShader(type);
+    GL_TRACE(GLT_CREATE_SHADER, TI(type), TI(shader));
     lua_pushinteger(L, shader);
     return 1;
 }
@@ -158,12 +245,14 @@ static int gl_create_shader(lua_State *L) {
 static int gl_shader_source(lua_State *L) {
     GLuint shader = (GLuint)luaL_checkinteger(L, 1);
     const char *source = luaL_checkstring(L, 2);
+    GL_TRACE_DATA(GLT_SHADER_SOURCE, source, strlen(source), TI(shader));
     glShaderSource(shader, 1, &source, NULL);
     return 0;
 }
 
 static int gl_compile_shader(lua_State *L) {
     GLuint shader = (GLuint)luaL_checkinteger(L, 1);
+    GL_TRACE(GLT_COMPILE_SHADER, TI(shader));
     glCompileShader(shader);
     GLint success;
     glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
@@ -180,6 +269,7 @@ static int gl_compile_shader(lua_State *L) {
 
 static int gl_create_program(lua_State *L) {
     GLuint program = glCreateProgram();
+    GL_TRACE(GLT_CREATE_PROGRAM, TI(program));
     lua_pushinteger(L, program);
     return 1;
 }
@@ -187,12 +277,14 @@ static int gl_create_program(lua_State *L) {
 static int gl_attach_shader(lua_State *L) {
     GLuint program = (GLuint)luaL_checkinteger(L, 1);
     GLuint shader = (GLuint)luaL_checkinteger(L, 2);
+    GL_TRACE(GLT_ATTACH_SHADER, TI(program), TI(shader));
     glAttachShader(program, shader);
     return 0;
 }
 
 static int gl_link_program(lua_State *L) {
     GLuint program = (GLuint)luaL_checkinteger(L, 1);
+    GL_TRACE(GLT_LINK_PROGRAM, TI(program));
     glLinkProgram(program);
     GLint success;
     glGetProgramiv(program, GL_LINK_STATUS, &success);
@@ -209,6 +301,7 @@ static int gl_link_program(lua_State *L) {
 
 static int gl_use_program(lua_State *L) {
     GLuint program = (GLuint)luaL_checkinteger(L, 1);
+    GL_TRACE(GLT_USE_PROGRAM, TI(program));
     glUseProgram(program);
     return 0;
 }
@@ -217,12 +310,14 @@ static int gl_use_program(lua_State *L) {
 static int gl_gen_vertex_arrays(lua_State *L) {
     GLuint vao;
     glGenVertexArrays(1, &vao);
+    GL_TRACE(GLT_GEN_VERTEX_ARRAYS, TI(vao));
     lua_pushinteger(L, vao);
     return 1;
 }
 
 static int gl_bind_vertex_array(lua_State *L) {
     GLuint vao = (GLuint)luaL_checkinteger(L, 1);
+    GL_TRACE(GLT_BIND_VERTEX_ARRAY, TI(vao));
     glBindVertexArray(vao);
     return 0;
 }
@@ -230,6 +325,7 @@ static int gl_bind_vertex_array(lua_State *L) {
 static int gl_gen_buffers(lua_State *L) {
     GLuint vbo;
     glGenBuffers(1, &vbo);
+    GL_TRACE(GLT_GEN_BUFFERS, TI(vbo));
     lua_pushinteger(L, vbo);
     return 1;
 }
@@ -237,19 +333,76 @@ static int gl_gen_buffers(lua_State *L) {
 static int gl_bind_buffer(lua_State *L) {
     GLenum target = (GLenum)luaL_checkinteger(L, 1);
     GLuint vbo = (GLuint)luaL_checkinteger(L, 2);
+    GL_TRACE(GLT_BIND_BUFFER, TI(target), TI(vbo));
     glBindBuffer(target, vbo);
     return 0;
 }
 
+// Helper: Bytes of a buffer data argument without copying: a string of raw
+// bytes, an sdl.buffer, a lua_blob or a cglm array (mat4, vec3 or index)
+static const char *check_buffer_bytes(lua_State *L, int idx, size_t *len) {
+    sdl_buffer *buf = module_sdl_test_buffer(L, idx);
+    if (buf) {
+        *len = buf->data ? buf->size : 0;
+        return (const char *)buf->data;
+    }
+    lua_blob *blob = lua_blob_test(L, idx);
+    if (blob) {
+        *len = lua_blob_size(blob);
+        return (const char *)lua_blob_data(blob);
+    }
+    const void *array = module_cglm_test_array(L, idx, len);
+    if (array) return (const char *)array;
+    return luaL_checklstring(L, idx, len); // Expect a string of raw float data
+}
+
+// Lua: gl.buffer_data(target, data, size, usage)
+// data: string of raw bytes, an sdl.buffer, a lua_blob or a cglm array (size may be nil to upload the whole buffer)
 static int gl_buffer_data(lua_State *L) {
     GLenum target = (GLenum)luaL_checkinteger(L, 1);
-    const char *data = luaL_checkstring(L, 2); // Expect a string of raw float data
-    size_t size = luaL_checkinteger(L, 3);
+    size_t data_len;
+    const char *data = check_buffer_bytes(L, 2, &data_len);
+    size_t size = lua_isnil(L, 3) ? data_len : (size_t)luaL_checkinteger(L, 3);
+    luaL_argcheck(L, size <= data_len, 3, "size exceeds data length");
     GLenum usage = (GLenum)luaL_checkinteger(L, 4);
+    GL_TRACE_DATA(GLT_BUFFER_DATA, data, size, TI(target), TI(size), TI(usage));
     glBufferData(target, size, data, usage);
     return 0;
 }
 
+// Lua: gl.buffer_sub_data(target, offset, data [, size])
+// Updates part of the bound buffer in place (per-frame instance data, UBOs)
+static int gl_buffer_sub_data(lua_State *L) {
+    GLenum target = (GLenum)luaL_checkinteger(L, 1);
+    GLintptr offset = (GLintptr)luaL_checkinteger(L, 2);
+    size_t data_len;
+    const char *data = check_buffer_bytes(L, 3, &data_len);
+    size_t size = lua_isnoneornil(L, 4) ? data_len : (size_t)luaL_checkinteger(L, 4);
+    luaL_argcheck(L, size <= data_len, 4, "size exceeds data length");
+    GL_TRACE_DATA(GLT_BUFFER_SUB_DATA, data, size, TI(target), TI(offset));
+    glBufferSubData(target, offset, (GLsizeiptr)size, data);
+    return 0;
+}
+
+// Lua: gl.bind_buffer_base(target, index, buffer) -- e.g. a UBO to a binding point
+static int gl_bind_buffer_base(lua_State *L) {
+    GLenum target = (GLenum)luaL_checkinteger(L, 1);
+    GLuint index = (GLuint)luaL_checkinteger(L, 2);
+    GLuint buffer = (GLuint)luaL_checkinteger(L, 3);
+    GL_TRACE(GLT_BIND_BUFFER_BASE, TI(target), TI(index), TI(buffer));
+    glBindBufferBase(target, index, buffer);
+    return 0;
+}
+
+// Lua: gl.vertex_attrib_divisor(index, divisor) -- 1: advance once per instance
+static int gl_vertex_attrib_divisor(lua_State *L) {
+    GLuint index = (GLuint)luaL_checkinteger(L, 1);
+    GLuint divisor = (GLuint)luaL_checkinteger(L, 2);
+    GL_TRACE(GLT_VERTEX_ATTRIB_DIVISOR, TI(index), TI(divisor));
+    glVertexAttribDivisor(index, divisor);
+    return 0;
+}
+
 static int gl_vertex_attrib_pointer(lua_State *L) {
     GLuint index = (GLuint)luaL_checkinteger(L, 1);
     GLint size = (GLint)luaL_checkinteger(L, 2);
@@ -257,12 +410,14 @@ static int gl_vertex_attrib_pointer(lua_State *L) {
     GLboolean normalized = (GLboolean)lua_toboolean(L, 4);
     GLsizei stride = (GLsizei)luaL_checkinteger(L, 5);
     GLintptr offset = (GLintptr)luaL_checkinteger(L, 6);
+    GL_TRACE(GLT_VERTEX_ATTRIB_POINTER, TI(index), TI(size), TI(type), TI(normalized), TI(stride), TI(offset));
     glVertexAttribPointer(index, size, type, normalized, stride, (const void *)offset);
     return 0;
 }
 
 static int gl_enable_vertex_attrib_array(lua_State *L) {
     GLuint index = (GLuint)luaL_checkinteger(L, 1);
+    GL_TRACE(GLT_ENABLE_VERTEX_ATTRIB_ARRAY, TI(index));
     glEnableVertexAttribArray(index);
     return 0;
 }
@@ -272,6 +427,7 @@ static int gl_draw_arrays(lua_State *L) {
     GLenum mode = (GLenum)luaL_checkinteger(L, 1);
     GLint first = (GLint)luaL_checkinteger(L, 2);
     GLsizei count = (GLsizei)luaL_checkinteger(L, 3);
+    GL_TRACE(GLT_DRAW_ARRAYS, TI(mode), TI(first), TI(count));
     glDrawArrays(mode, first, count);
     return 0;
 }
@@ -280,6 +436,7 @@ static int gl_delete_shader(lua_State *L) {
     int ret = check_gl_context(L);
     if (ret) return ret;
     GLuint shader = (GLuint)luaL_checkinteger(L, 1);
+    GL_TRACE(GLT_DELETE_SHADER, TI(shader));
     glDeleteShader(shader);
     return 0;
 }
@@ -288,6 +445,7 @@ static int gl_delete_program(lua_State *L) {
     int ret = check_gl_context(L);
     if (ret) return ret;
     GLuint program = (GLuint)luaL_checkinteger(L, 1);
+    GL_TRACE(GLT_DELETE_PROGRAM, TI(program));
     glDeleteProgram(program);
     return 0;
 }
@@ -296,6 +454,7 @@ static int gl_delete_program(lua_State *L) {
 static int gl_gen_textures(lua_State *L) {
     GLuint texture;
     glGenTextures(1, &texture);
+    GL_TRACE(GLT_GEN_TEXTURES, TI(texture));
     lua_pushinteger(L, texture);
     return 1;
 }
@@ -304,6 +463,7 @@ static int gl_gen_textures(lua_State *L) {
 static int gl_bind_texture(lua_State *L) {
     GLenum target = (GLenum)luaL_checkinteger(L, 1);
     GLuint texture = (GLuint)luaL_checkinteger(L, 2);
+    GL_TRACE(GLT_BIND_TEXTURE, TI(target), TI(texture));
     glBindTexture(target, texture);
     return 0;
 }
@@ -318,7 +478,23 @@ static int gl_tex_image_2d(lua_State *L) {
     GLint border = (GLint)luaL_checkinteger(L, 6);
     GLenum format = (GLenum)luaL_checkinteger(L, 7);
     GLenum type = (GLenum)luaL_checkinteger(L, 8);
-    void *data = lua_isnil(L, 9) ? NULL : lua_touserdata(L, 9);
+    // data: lightuserdata (image:get_data()), an sdl.buffer or lua_blob of raw pixels, or nil
+    sdl_buffer *buf = module_sdl_test_buffer(L, 9);
+    lua_blob *blob = buf ? NULL : lua_blob_test(L, 9);
+    const void *data;
+    if (buf) {
+        data = buf->data;
+        luaL_argcheck(L, buf->data != NULL && buf->size >= pixel_data_size(width, height, format, type), 9,
+                      "buffer too small for the image");
+    } else if (blob) {
+        data = lua_blob_data(blob);
+        luaL_argcheck(L, lua_blob_size(blob) >= pixel_data_size(width, height, format, type), 9,
+                      "blob too small for the image");
+    } else {
+        data = lua_isnil(L, 9) ? NULL : lua_touserdata(L, 9);
+    }
+    GL_TRACE_DATA(GLT_TEX_IMAGE_2D, data, data ? pixel_data_size(width, height, format, type) : 0,
+                  TI(target), TI(level), TI(internal_format), TI(width), TI(height), TI(border), TI(format), TI(type));
     glTexImage2D(target, level, internal_format, width, height, border, format, type, data);
     GLenum err = glGetError();
     if (err != GL_NO_ERROR) {
@@ -335,6 +511,7 @@ static int gl_tex_parameter_i(lua_State *L) {
     GLenum target = (GLenum)luaL_checkinteger(L, 1);
     GLenum pname = (GLenum)luaL_checkinteger(L, 2);
     GLint param = (GLint)luaL_checkinteger(L, 3);
+    GL_TRACE(GLT_TEX_PARAMETER_I, TI(target), TI(pname), TI(param));
     glTexParameteri(target, pname, param);
     return 0;
 }
@@ -345,10 +522,34 @@ static int gl_draw_elements(lua_State *L) {
     GLsizei count = (GLsizei)luaL_checkinteger(L, 2);
     GLenum type = (GLenum)luaL_checkinteger(L, 3);
     GLintptr offset = (GLintptr)luaL_checkinteger(L, 4);
+    GL_TRACE(GLT_DRAW_ELEMENTS, TI(mode), TI(count), TI(type), TI(offset));
     glDrawElements(mode, count, type, (const void *)offset);
     return 0;
 }
 
+// Lua: gl.draw_arrays_instanced(mode, first, count, instances)
+static int gl_draw_arrays_instanced(lua_State *L) {
+    GLenum mode = (GLenum)luaL_checkinteger(L, 1);
+    GLint first = (GLint)luaL_checkinteger(L, 2);
+    GLsizei count = (GLsizei)luaL_checkinteger(L, 3);
+    GLsizei instances = (GLsizei)luaL_checkinteger(L, 4);
+    GL_TRACE(GLT_DRAW_ARRAYS_INSTANCED, TI(mode), TI(first), TI(count), TI(instances));
+    glDrawArraysInstanced(mode, first, count, instances);
+    return 0;
+}
+
+// Lua: gl.draw_elements_instanced(mode, count, type, offset, instances)
+static int gl_draw_elements_instanced(lua_State *L) {
+    GLenum mode = (GLenum)luaL_checkinteger(L, 1);
+    GLsizei count = (GLsizei)luaL_checkinteger(L, 2);
+    GLenum type = (GLenum)luaL_checkinteger(L, 3);
+    GLintptr offset = (GLintptr)luaL_checkinteger(L, 4);
+    GLsizei instances = (GLsizei)luaL_checkinteger(L, 5);
+    GL_TRACE(GLT_DRAW_ELEMENTS_INSTANCED, TI(mode), TI(count), TI(type), TI(offset), TI(instances));
+    glDrawElementsInstanced(mode, count, type, (const void *)offset, instances);
+    return 0;
+}
+
 // Helper to check cglm mat4 userdata
 static mat4* check_mat4(lua_State *L, int idx) {
     void *ud = luaL_checkudata(L, idx, "cglm.mat4");
@@ -356,15 +557,24 @@ static mat4* check_mat4(lua_State *L, int idx) {
     return (mat4*)ud;
 }
 
-// Lua: gl.uniform_matrix4fv(location, count, transpose, matrix)
+// Lua: gl.uniform_matrix4fv(location, count, transpose, matrix | mat4_array)
 static int gl_uniform_matrix4fv(lua_State *L) {
     GLint location = (GLint)luaL_checkinteger(L, 1);
     GLsizei count = (GLsizei)luaL_checkinteger(L, 2);
     GLboolean transpose = (GLboolean)luaL_checkinteger(L, 3);
     
-    // Check if the 4th argument is a cglm mat4 userdata
-    if (luaL_testudata(L, 4, "cglm.mat4")) {
+    if (luaL_testudata(L, 4, CGLM_MAT4_ARRAY_MT)) {
+        // The first count matrices of the array, e.g. a uniform mat4[N]
+        size_t len;
+        const float *floats = (const float *)module_cglm_test_array(L, 4, &len);
+        luaL_argcheck(L, count >= 0 && (size_t)count * sizeof(mat4) <= len, 2, "count exceeds the array");
+        GL_TRACE_DATA(GLT_UNIFORM_MATRIX4FV, floats, (size_t)count * sizeof(mat4), TI(location), TI(count), TI(transpose));
+        glUniformMatrix4fv(location, count, transpose, floats);
+    } else if (luaL_testudata(L, 4, "cglm.mat4")) {
+        // Check if the 4th argument is a cglm mat4 userdata
         mat4 *matrix = check_mat4(L, 4);
+        luaL_argcheck(L, count == 1, 2, "count must be 1 for a single mat4");
+        GL_TRACE_DATA(GLT_UNIFORM_MATRIX4FV, *matrix, sizeof(mat4), TI(location), TI(1), TI(transpose));
         glUniformMatrix4fv(location, count, transpose, (const GLfloat *)(*matrix));
         // printf("Using cglm.mat4: [0][0]=%f, [1][1]=%f, [3][0]=%f, [3][1]=%f\n",
         //        (*matrix)[0][0], (*matrix)[1][1], (*matrix)[3][0], (*matrix)[3][1]);
@@ -381,6 +591,8 @@ static int gl_uniform_matrix4fv(lua_State *L) {
             //        float_matrix[0], float_matrix[1], float_matrix[5],
             //        float_matrix[12], float_matrix[13], float_matrix[15]);
         }
+        luaL_argcheck(L, count >= 0 && (size_t)count * sizeof(mat4) <= len, 2, "count exceeds the matrix data");
+        GL_TRACE_DATA(GLT_UNIFORM_MATRIX4FV, matrix, (size_t)count * sizeof(mat4), TI(location), TI(count), TI(transpose));
         glUniformMatrix4fv(location, count, transpose, (const GLfloat *)matrix);
     }
     return 0;
@@ -391,6 +603,7 @@ static int gl_get_uniform_location(lua_State *L) {
     GLuint program = (GLuint)luaL_checkinteger(L, 1);
     const char *name = luaL_checkstring(L, 2);
     GLint location = glGetUniformLocation(program, name);
+    GL_TRACE_DATA(GLT_GET_UNIFORM_LOCATION, name, strlen(name) + 1, TI(program), TI(location));
     lua_pushinteger(L, location);
     return 1;
 }
@@ -399,6 +612,7 @@ static int gl_get_uniform_location(lua_State *L) {
 static int gl_uniform1i(lua_State *L) {
     GLint location = (GLint)luaL_checkinteger(L, 1);
     GLint value = (GLint)luaL_checkinteger(L, 2);
+    GL_TRACE(GLT_UNIFORM1I, TI(location), TI(value));
     glUniform1i(location, value);
     return 0;
 }
@@ -406,17 +620,20 @@ static int gl_uniform1i(lua_State *L) {
 // Lua: gl.active_texture(texture_unit)
 static int gl_active_texture(lua_State *L) {
     GLenum texture_unit = (GLenum)luaL_checkinteger(L, 1);
+    GL_TRACE(GLT_ACTIVE_TEXTURE, TI(texture_unit));
     glActiveTexture(texture_unit);
     return 0;
 }
 
 static int gl_enable(lua_State *L) {
     GLenum cap = (GLenum)luaL_checkinteger(L, 1);
+    GL_TRACE(GLT_ENABLE, TI(cap));
     glEnable(cap);
     return 0;
 }
 
 static int gl_get_error(lua_State *L) {
+    GL_TRACE0(GLT_GET_ERROR);
     GLenum err = glGetError();
     lua_pushinteger(L, err);
     return 1;
@@ -425,6 +642,7 @@ static int gl_get_error(lua_State *L) {
 static int gl_blend_func(lua_State *L) {
     GLenum sfactor = (GLenum)luaL_checkinteger(L, 1);
     GLenum dfactor = (GLenum)luaL_checkinteger(L, 2);
+    GL_TRACE(GLT_BLEND_FUNC, TI(sfactor), TI(dfactor));
     glBlendFunc(sfactor, dfactor);
     return 0;
 }
@@ -443,6 +661,7 @@ static int gl_dummy_uniform_matrix4fv(lua_State *L) {
         -1.0f, -1.0f, 0.0f, 1.0f
     };
     
+    GL_TRACE_DATA(GLT_UNIFORM_MATRIX4FV, matrix, sizeof(matrix), TI(location), TI(1), TI(transpose));
     glUniformMatrix4fv(location, count, transpose, matrix);
     return 0;
 }
@@ -454,6 +673,7 @@ static int gl_uniform4f(lua_State *L) {
     GLfloat y = (GLfloat)luaL_checknumber(L, 3);
     GLfloat z = (GLfloat)luaL_checknumber(L, 4);
     GLfloat w = (GLfloat)luaL_checknumber(L, 5);
+    GL_TRACE(GLT_UNIFORM4F, TI(location), TF(x), TF(y), TF(z), TF(w));
     glUniform4f(location, x, y, z, w);
     return 0;
 }
@@ -474,6 +694,7 @@ static int gl_delete_textures(lua_State *L) {
         lua_pop(L, 1);
     }
 
+    GL_TRACE_DATA(GLT_DELETE_TEXTURES, textures, n * sizeof(GLuint), TI(n));
     glDeleteTextures(n, textures);
     free(textures);
     return 0;
@@ -495,6 +716,7 @@ static int gl_delete_buffers(lua_State *L) {
         lua_pop(L, 1);
     }
 
+    GL_TRACE_DATA(GLT_DELETE_BUFFERS, buffers, n * sizeof(GLuint), TI(n));
     glDeleteBuffers(n, buffers);
     free(buffers);
     return 0;
@@ -516,6 +738,7 @@ static int gl_delete_vertex_arrays(lua_State *L) {
         lua_pop(L, 1);
     }
 
+    GL_TRACE_DATA(GLT_DELETE_VERTEX_ARRAYS, arrays, n * sizeof(GLuint), TI(n));
     glDeleteVertexArrays(n, arrays);
     free(arrays);
     return 0;
@@ -525,6 +748,7 @@ static int gl_delete_vertex_arrays(lua_State *L) {
 static int gl_uniform1f(lua_State *L) {
     GLint location = (GLint)luaL_checkinteger(L, 1);
     GLfloat value = (GLfloat)luaL_checknumber(L, 2);
+    GL_TRACE(GLT_UNIFORM1F, TI(location), TF(value));
     glUniform1f(location, value);
     return 0;
 }
@@ -532,6 +756,7 @@ static int gl_uniform1f(lua_State *L) {
 // Lua: gl.disable(cap) -> bool, err_msg
 static int gl_disable(lua_State *L) {
     GLenum cap = (GLenum)luaL_checkinteger(L, 1); // Expect GLenum like GL_CULL_FACE
+    GL_TRACE(GLT_DISABLE, TI(cap));
     glDisable(cap);
     GLenum err = glGetError();
     if (err != GL_NO_ERROR) {
@@ -546,6 +771,7 @@ static int gl_disable(lua_State *L) {
 // Lua: gl.cull_face(mode) -> bool, err_msg
 static int gl_cull_face(lua_State *L) {
     GLenum mode = (GLenum)luaL_checkinteger(L, 1); // Expect GLenum like GL_FALSE
+    GL_TRACE(GLT_CULL_FACE, TI(mode));
     glCullFace(mode);
     GLenum err = glGetError();
     if (err != GL_NO_ERROR) {
@@ -561,6 +787,7 @@ static int gl_cull_face(lua_State *L) {
 static int gl_polygon_mode(lua_State *L) {
     GLenum face = (GLenum)luaL_checkinteger(L, 1);
     GLenum mode = (GLenum)luaL_checkinteger(L, 2);
+    GL_TRACE(GLT_POLYGON_MODE, TI(face), TI(mode));
     glPolygonMode(face, mode);
     return push_gl_error(L, "glPolygonMode");
 }
@@ -568,11 +795,79 @@ static int gl_polygon_mode(lua_State *L) {
 static int gl_get_integer(lua_State *L) {
     GLenum pname = (GLenum)luaL_checkinteger(L, 1);
     GLint value;
+    GL_TRACE(GLT_GET_INTEGER, TI(pname));
     glGetIntegerv(pname, &value);
     lua_pushinteger(L, value);
     return 1;
 }
 
+void module_gl_set_context(void *context) {
+    g_gl_context = (SDL_GLContext)context;
+}
+
+// Sync objects are not traced: the replayer has no fences to wait on
+
+int module_gl_sync_status(void *sync) {
+    GLenum status = glClientWaitSync((GLsync)sync, 0, 0);
+    if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) return 1;
+    return status == GL_WAIT_FAILED ? -1 : 0;
+}
+
+// Lua: gl.fence_sync() -> sync
+// Fence after the commands issued so far, pass it to lua_util.await_fence or
+// gl.client_wait_sync and free it with gl.delete_sync.
+static int gl_fence_sync(lua_State *L) {
+    GLsync sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    if (!sync) {
+        lua_pushnil(L);
+        lua_pushstring(L, "glFenceSync failed");
+        return 2;
+    }
+    lua_pushlightuserdata(L, (void *)sync);
+    return 1;
+}
+
+// Lua: gl.client_wait_sync(sync, [timeout_ns=0], [flush=false]) -> status
+static int gl_client_wait_sync(lua_State *L) {
+    luaL_checktype(L, 1, LUA_TLIGHTUSERDATA);
+    GLsync sync = (GLsync)lua_touserdata(L, 1);
+    GLuint64 timeout = (GLuint64)luaL_optinteger(L, 2, 0);
+    GLbitfield flags = lua_toboolean(L, 3) ? GL_SYNC_FLUSH_COMMANDS_BIT : 0;
+    lua_pushinteger(L, glClientWaitSync(sync, flags, timeout));
+    return 1;
+}
+
+// Lua: gl.delete_sync(sync)
+static int gl_delete_sync(lua_State *L) {
+    luaL_checktype(L, 1, LUA_TLIGHTUSERDATA);
+    glDeleteSync((GLsync)lua_touserdata(L, 1));
+    return 0;
+}
+
+// Lua: gl.trace_begin(path) -> bool, err_msg
+static int gl_trace_begin(lua_State *L) {
+    const char *path = luaL_checkstring(L, 1);
+    if (!module_gl_trace_begin(path)) {
+        lua_pushboolean(L, 0);
+        lua_pushfstring(L, "Failed to open trace file: %s", path);
+        return 2;
+    }
+    lua_pushboolean(L, 1);
+    return 1;
+}
+
+// Lua: gl.trace_end()
+static int gl_trace_end(lua_State *L) {
+    module_gl_trace_end();
+    return 0;
+}
+
+// Lua: gl.is_tracing() -> bool
+static int gl_is_tracing(lua_State *L) {
+    lua_pushboolean(L, g_trace_file != NULL);
+    return 1;
+}
+
 static const struct luaL_Reg gl_lib[] = {
     {"init", gl_init},
     {"destroy", gl_destroy},
@@ -594,8 +889,11 @@ static const struct luaL_Reg gl_lib[] = {
     {"gen_buffers", gl_gen_buffers},
     {"bind_buffer", gl_bind_buffer},
     {"buffer_data", gl_buffer_data},
+    {"buffer_sub_data", gl_buffer_sub_data},
+    {"bind_buffer_base", gl_bind_buffer_base},
     {"vertex_attrib_pointer", gl_vertex_attrib_pointer},
     {"enable_vertex_attrib_array", gl_enable_vertex_attrib_array},
+    {"vertex_attrib_divisor", gl_vertex_attrib_divisor},
     {"draw_arrays", gl_draw_arrays},
 
     {"gen_textures", gl_gen_textures},
@@ -603,6 +901,8 @@ static const struct luaL_Reg gl_lib[] = {
     {"tex_image_2d", gl_tex_image_2d},
     {"tex_parameter_i", gl_tex_parameter_i},
     {"draw_elements", gl_draw_elements},
+    {"draw_arrays_instanced", gl_draw_arrays_instanced},
+    {"draw_elements_instanced", gl_draw_elements_instanced},
 
     {"uniform_matrix4fv", gl_uniform_matrix4fv},
     {"get_uniform_location", gl_get_uniform_location},
@@ -624,6 +924,14 @@ static const struct luaL_Reg gl_lib[] = {
     {"polygon_mode", gl_polygon_mode},
     {"get_integer", gl_get_integer},
 
+    {"trace_begin", gl_trace_begin},
+    {"trace_end", gl_trace_end},
+    {"is_tracing", gl_is_tracing},
+
+    {"fence_sync", gl_fence_sync},
+    {"client_wait_sync", gl_client_wait_sync},
+    {"delete_sync", gl_delete_sync},
+
     
     {NULL, NULL}
 };
@@ -667,6 +975,8 @@ int luaopen_module_gl(lua_State *L) {
     lua_pushinteger(L, GL_TEXTURE_WRAP_T); lua_setfield(L, -2, "TEXTURE_WRAP_T");
     lua_pushinteger(L, GL_CLAMP_TO_EDGE); lua_setfield(L, -2, "CLAMP_TO_EDGE");
     lua_pushinteger(L, GL_DYNAMIC_DRAW); lua_setfield(L, -2, "DYNAMIC_DRAW");
+    lua_pushinteger(L, GL_STREAM_DRAW); lua_setfield(L, -2, "STREAM_DRAW");
+    lua_pushinteger(L, GL_UNIFORM_BUFFER); lua_setfield(L, -2, "UNIFORM_BUFFER");
     lua_pushinteger(L, GL_DEPTH_TEST); lua_setfield(L, -2, "DEPTH_TEST");
     lua_pushinteger(L, GL_CULL_FACE); lua_setfield(L, -2, "CULL_FACE");
     lua_pushinteger(L, GL_BACK); lua_setfield(L, -2, "BACK");
@@ -676,6 +986,10 @@ int luaopen_module_gl(lua_State *L) {
     lua_pushinteger(L, GL_FRONT); lua_setfield(L, -2, "FRONT");
     lua_pushinteger(L, GL_TEXTURE_BINDING_2D); lua_setfield(L, -2, "TEXTURE_BINDING_2D");
     lua_pushinteger(L, GL_NO_ERROR); lua_setfield(L, -2, "NO_ERROR");
+    lua_pushinteger(L, GL_ALREADY_SIGNALED); lua_setfield(L, -2, "ALREADY_SIGNALED");
+    lua_pushinteger(L, GL_TIMEOUT_EXPIRED); lua_setfield(L, -2, "TIMEOUT_EXPIRED");
+    lua_pushinteger(L, GL_CONDITION_SATISFIED); lua_setfield(L, -2, "CONDITION_SATISFIED");
+    lua_pushinteger(L, GL_WAIT_FAILED); lua_setfield(L, -2, "WAIT_FAILED");
     
     return 1;
 }
\ No newline at end of file
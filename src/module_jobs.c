@@ -0,0 +1,722 @@
+#include "module_jobs.h"
+#include "lua_alloc.h"
+#include "lua_blob.h"
+#include "lua_modules.h"
+#include "module_prof.h"
+#include "script_cache.h"
+#include <SDL3/SDL.h>
+#include <lauxlib.h>
+#include <lualib.h>
+
+// Worker threads that each own a lua_State. A job is a function name plus
+// arguments, serialized into a byte buffer; the worker runs it and sends the
+// serialized results back. Jobs and results travel through two bounded
+// lock-free MPMC rings (Vyukov); a semaphore only wakes idle workers.
+// lua_blob values travel by reference: a message holds one ref per blob it
+// contains, released when the message is freed.
+
+#define JOBS_MAX_THREADS 64
+#define JOBS_MAX_DEPTH 32
+
+//===============================================
+// queue
+//===============================================
+
+typedef struct {
+    SDL_AtomicInt sequence;
+    void *item;
+} job_cell;
+
+typedef struct {
+    job_cell *cells;
+    Uint32 mask;
+    SDL_AtomicInt enqueue_pos;
+    char pad[64];               // keep producers and consumers on separate cache lines
+    SDL_AtomicInt dequeue_pos;
+} job_queue;
+
+static int queue_init(job_queue *q, Uint32 capacity) {
+    q->cells = (job_cell *)SDL_calloc(capacity, sizeof(job_cell));
+    if (!q->cells) return 0;
+    q->mask = capacity - 1;
+    for (Uint32 i = 0; i < capacity; i++) {
+        SDL_SetAtomicInt(&q->cells[i].sequence, (int)i);
+    }
+    SDL_SetAtomicInt(&q->enqueue_pos, 0);
+    SDL_SetAtomicInt(&q->dequeue_pos, 0);
+    return 1;
+}
+
+static int queue_push(job_queue *q, void *item) {
+    Uint32 pos = (Uint32)SDL_GetAtomicInt(&q->enqueue_pos);
+    job_cell *cell;
+    for (;;) {
+        cell = &q->cells[pos & q->mask];
+        int diff = (int)((Uint32)SDL_GetAtomicInt(&cell->sequence) - pos);
+        if (diff == 0) {
+            if (SDL_CompareAndSwapAtomicInt(&q->enqueue_pos, (int)pos, (int)(pos + 1))) break;
+        } else if (diff < 0) {
+            return 0; // full
+        }
+        pos = (Uint32)SDL_GetAtomicInt(&q->enqueue_pos);
+    }
+    cell->item = item;
+    SDL_SetAtomicInt(&cell->sequence, (int)(pos + 1));
+    return 1;
+}
+
+static void *queue_pop(job_queue *q) {
+    Uint32 pos = (Uint32)SDL_GetAtomicInt(&q->dequeue_pos);
+    job_cell *cell;
+    for (;;) {
+        cell = &q->cells[pos & q->mask];
+        int diff = (int)((Uint32)SDL_GetAtomicInt(&cell->sequence) - (pos + 1));
+        if (diff == 0) {
+            if (SDL_CompareAndSwapAtomicInt(&q->dequeue_pos, (int)pos, (int)(pos + 1))) break;
+        } else if (diff < 0) {
+            return NULL; // empty
+        }
+        pos = (Uint32)SDL_GetAtomicInt(&q->dequeue_pos);
+    }
+    void *item = cell->item;
+    SDL_SetAtomicInt(&cell->sequence, (int)(pos + q->mask + 1));
+    return item;
+}
+
+//===============================================
+// serialization
+//===============================================
+
+enum {
+    SER_NIL, SER_FALSE, SER_TRUE, SER_INTEGER, SER_NUMBER,
+    SER_STRING, SER_TABLE, SER_TABLE_END, SER_LIGHTUSERDATA, SER_BLOB
+};
+
+typedef struct {
+    Uint8 *data;
+    size_t size;
+    size_t capacity;
+} ser_buffer;
+
+static int ser_put(ser_buffer *b, const void *p, size_t n) {
+    if (b->size + n > b->capacity) {
+        size_t capacity = b->capacity ? b->capacity * 2 : 256;
+        while (capacity < b->size + n) capacity *= 2;
+        Uint8 *data = (Uint8 *)SDL_realloc(b->data, capacity);
+        if (!data) return 0;
+        b->data = data;
+        b->capacity = capacity;
+    }
+    SDL_memcpy(b->data + b->size, p, n);
+    b->size += n;
+    return 1;
+}
+
+static int ser_tag(ser_buffer *b, Uint8 tag) {
+    return ser_put(b, &tag, 1);
+}
+
+// Helper: Append the value at idx, returns an error message or NULL
+static const char *ser_value(lua_State *L, int idx, ser_buffer *b, int depth) {
+    idx = lua_absindex(L, idx);
+    switch (lua_type(L, idx)) {
+    case LUA_TNIL:
+        return ser_tag(b, SER_NIL) ? NULL : "out of memory";
+    case LUA_TBOOLEAN:
+        return ser_tag(b, lua_toboolean(L, idx) ? SER_TRUE : SER_FALSE) ? NULL : "out of memory";
+    case LUA_TNUMBER:
+        if (lua_isinteger(L, idx)) {
+            lua_Integer v = lua_tointeger(L, idx);
+            return ser_tag(b, SER_INTEGER) && ser_put(b, &v, sizeof(v)) ? NULL : "out of memory";
+        } else {
+            lua_Number v = lua_tonumber(L, idx);
+            return ser_tag(b, SER_NUMBER) && ser_put(b, &v, sizeof(v)) ? NULL : "out of memory";
+        }
+    case LUA_TSTRING: {
+        size_t len;
+        const char *s = lua_tolstring(L, idx, &len);
+        Uint64 n = len;
+        return ser_tag(b, SER_STRING) && ser_put(b, &n, sizeof(n)) && ser_put(b, s, len) ? NULL : "out of memory";
+    }
+    case LUA_TLIGHTUSERDATA: {
+        void *p = lua_touserdata(L, idx);
+        return ser_tag(b, SER_LIGHTUSERDATA) && ser_put(b, &p, sizeof(p)) ? NULL : "out of memory";
+    }
+    case LUA_TUSERDATA: {
+        lua_blob *blob = lua_blob_test(L, idx);
+        if (!blob) return "functions, non-blob userdata and threads cannot be passed to jobs";
+        if (!ser_tag(b, SER_BLOB) || !ser_put(b, &blob, sizeof(blob))) return "out of memory";
+        lua_blob_retain(blob);
+        return NULL;
+    }
+    case LUA_TTABLE: {
+        if (depth >= JOBS_MAX_DEPTH) return "tables nested too deep (cycle?)";
+        if (!lua_checkstack(L, 3)) return "stack overflow";
+        if (!ser_tag(b, SER_TABLE)) return "out of memory";
+        lua_pushnil(L);
+        while (lua_next(L, idx)) {
+            const char *err = ser_value(L, -2, b, depth + 1);
+            if (!err) err = ser_value(L, -1, b, depth + 1);
+            if (err) {
+                lua_pop(L, 2);
+                return err;
+            }
+            lua_pop(L, 1);
+        }
+        return ser_tag(b, SER_TABLE_END) ? NULL : "out of memory";
+    }
+    default:
+        return "functions, non-blob userdata and threads cannot be passed to jobs";
+    }
+}
+
+// Helper: Serialize count values starting at idx, returns an error message or NULL
+static const char *ser_values(lua_State *L, int idx, int count, ser_buffer *b) {
+    Uint32 n = (Uint32)count;
+    if (!ser_put(b, &n, sizeof(n))) return "out of memory";
+    for (int i = 0; i < count; i++) {
+        const char *err = ser_value(L, idx + i, b, 0);
+        if (err) return err;
+    }
+    return NULL;
+}
+
+typedef struct {
+    const Uint8 *p;
+    const Uint8 *end;
+} ser_reader;
+
+static int ser_get(ser_reader *r, void *out, size_t n) {
+    if ((size_t)(r->end - r->p) < n) return 0;
+    SDL_memcpy(out, r->p, n);
+    r->p += n;
+    return 1;
+}
+
+// Helper: Push one value, returns 0 on malformed data (nothing pushed)
+static int deser_value(lua_State *L, ser_reader *r, int depth) {
+    Uint8 tag;
+    if (!ser_get(r, &tag, 1) || !lua_checkstack(L, 3)) return 0;
+    switch (tag) {
+    case SER_NIL: lua_pushnil(L); return 1;
+    case SER_FALSE: lua_pushboolean(L, 0); return 1;
+    case SER_TRUE: lua_pushboolean(L, 1); return 1;
+    case SER_INTEGER: {
+        lua_Integer v;
+        if (!ser_get(r, &v, sizeof(v))) return 0;
+        lua_pushinteger(L, v);
+        return 1;
+    }
+    case SER_NUMBER: {
+        lua_Number v;
+        if (!ser_get(r, &v, sizeof(v))) return 0;
+        lua_pushnumber(L, v);
+        return 1;
+    }
+    case SER_STRING: {
+        Uint64 n;
+        if (!ser_get(r, &n, sizeof(n)) || (Uint64)(r->end - r->p) < n) return 0;
+        lua_pushlstring(L, (const char *)r->p, (size_t)n);
+        r->p += n;
+        return 1;
+    }
+    case SER_LIGHTUSERDATA: {
+        void *p;
+        if (!ser_get(r, &p, sizeof(p))) return 0;
+        lua_pushlightuserdata(L, p);
+        return 1;
+    }
+    case SER_BLOB: {
+        lua_blob *blob;
+        if (!ser_get(r, &blob, sizeof(blob))) return 0;
+        lua_blob_retain(blob);      // the message keeps its own ref until freed
+        lua_blob_push(L, blob);
+        return 1;
+    }
+    case SER_TABLE:
+        if (depth >= JOBS_MAX_DEPTH) return 0;
+        lua_newtable(L);
+        for (;;) {
+            if (r->p < r->end && *r->p == SER_TABLE_END) {
+                r->p++;
+                return 1;
+            }
+            if (!deser_value(L, r, depth + 1)) break;
+            if (!deser_value(L, r, depth + 1)) {
+                lua_pop(L, 1);
+                break;
+            }
+            if (lua_isnil(L, -2)) {
+                lua_pop(L, 2);
+                break;
+            }
+            lua_rawset(L, -3);
+        }
+        lua_pop(L, 1);
+        return 0;
+    default:
+        return 0;
+    }
+}
+
+// Helper: Push all values of a message, returns their count or -1 on malformed data
+static int deser_values(lua_State *L, const Uint8 *data, size_t size) {
+    ser_reader r = {data, data + size};
+    Uint32 n;
+    if (!ser_get(&r, &n, sizeof(n)) || !lua_checkstack(L, (int)n + LUA_MINSTACK)) return -1;
+    for (Uint32 i = 0; i < n; i++) {
+        if (!deser_value(L, &r, 0)) {
+            lua_pop(L, (int)i);
+            return -1;
+        }
+    }
+    return (int)n;
+}
+
+// Release the blob refs held by a message, then free it. Tables are flat
+// runs of tagged values, so a linear scan finds every blob (also in a message
+// cut short by a serialization error).
+static void ser_free(Uint8 *data, size_t size) {
+    ser_reader r = {data, data + size};
+    Uint32 n;
+    if (data && ser_get(&r, &n, sizeof(n))) {
+        Uint8 tag;
+        while (ser_get(&r, &tag, 1)) {
+            size_t skip = 0;
+            if (tag == SER_INTEGER) skip = sizeof(lua_Integer);
+            else if (tag == SER_NUMBER) skip = sizeof(lua_Number);
+            else if (tag == SER_LIGHTUSERDATA) skip = sizeof(void *);
+            else if (tag == SER_STRING) {
+                Uint64 len;
+                if (!ser_get(&r, &len, sizeof(len))) break;
+                skip = len > (Uint64)(r.end - r.p) ? (size_t)-1 : (size_t)len;
+            } else if (tag == SER_BLOB) {
+                lua_blob *blob;
+                if (!ser_get(&r, &blob, sizeof(blob))) break;
+                lua_blob_release(blob);
+            }
+            if ((size_t)(r.end - r.p) < skip) break;
+            r.p += skip;
+        }
+    }
+    SDL_free(data);
+}
+
+//===============================================
+// workers
+//===============================================
+
+typedef struct {
+    lua_Integer id;
+    int ok;                     // result: the function returned without error
+    Uint8 *data;                // request: name and arguments, result: return values or error
+    size_t size;
+} job;
+
+static struct {
+    int running;
+    int thread_count;
+    SDL_Thread *threads[JOBS_MAX_THREADS];
+    job_queue submit;
+    job_queue done;
+    SDL_Mutex *lock;            // guards pending and the batch generation
+    SDL_Condition *wake;        // workers: a job was submitted or a batch started
+    SDL_Condition *batch_idle;  // parallel_for caller: the last helper left
+    int pending;                // submitted jobs no worker has claimed yet
+    SDL_AtomicInt quit;
+    int capacity;
+    int in_flight;              // main thread only
+    lua_Integer next_id;
+} g_jobs;
+
+//===============================================
+// C parallel for
+//===============================================
+// One batch at a time in a static struct. A worker counts itself in users
+// before looking at active, so once the caller has cleared active and seen
+// users drop to 0 no worker can still be reading the batch, and every index
+// taken has finished. Workers help each batch (generation) at most once, so
+// they sleep on g_jobs.wake instead of spinning until the caller is done.
+
+static struct {
+    SDL_AtomicInt busy;         // a caller owns the batch
+    SDL_AtomicInt active;       // workers may take indices
+    SDL_AtomicInt users;        // workers between checking active and leaving
+    SDL_AtomicInt next;
+    module_jobs_task_fn fn;
+    void *userdata;
+    int count;
+    Uint32 generation;          // under g_jobs.lock, bumped per batch
+} g_batch;
+
+// Helper: Take indices of the current batch until none are left
+static void batch_work(void) {
+    int i;
+    while ((i = SDL_AddAtomicInt(&g_batch.next, 1)) < g_batch.count) {
+        g_batch.fn(g_batch.userdata, i);
+    }
+}
+
+static void batch_help(void) {
+    SDL_AddAtomicInt(&g_batch.users, 1);
+    if (SDL_GetAtomicInt(&g_batch.active)) {
+        PROF_BEGIN("jobs.parallel_for");
+        batch_work();
+        PROF_END();
+    }
+    // The last helper out after the caller cleared active wakes the caller;
+    // signalling under the lock pairs with its check of users
+    if (SDL_AddAtomicInt(&g_batch.users, -1) == 1 && !SDL_GetAtomicInt(&g_batch.active)) {
+        SDL_LockMutex(g_jobs.lock);
+        SDL_SignalCondition(g_jobs.batch_idle);
+        SDL_UnlockMutex(g_jobs.lock);
+    }
+}
+
+// Protected: deserialize the request, resolve "module.function" and call it
+static int job_dispatch(lua_State *L) {
+    job *j = (job *)lua_touserdata(L, 1);
+    lua_settop(L, 0);
+    int n = deser_values(L, j->data, j->size);
+    if (n < 1 || !lua_isstring(L, 1)) {
+        return luaL_error(L, "malformed job data");
+    }
+    const char *name = lua_tostring(L, 1);
+    const char *dot = SDL_strrchr(name, '.');
+    if (dot) {
+        lua_getglobal(L, "require");
+        lua_pushlstring(L, name, (size_t)(dot - name));
+        lua_call(L, 1, 1);
+        lua_getfield(L, -1, dot + 1);
+        lua_remove(L, -2);
+    } else {
+        lua_getglobal(L, name);
+    }
+    if (!lua_isfunction(L, -1)) {
+        return luaL_error(L, "job function '%s' not found", name);
+    }
+    lua_replace(L, 1);
+    lua_call(L, n - 1, LUA_MULTRET);
+    return lua_gettop(L);
+}
+
+static void run_job(lua_State *L, job *j) {
+    PROF_BEGIN("jobs.run");
+    ser_buffer out = {0};
+    const char *err = NULL;
+    if (!L) {
+        err = "worker Lua state could not be created";
+    } else {
+        int top = lua_gettop(L);
+        lua_pushcfunction(L, job_dispatch);
+        lua_pushlightuserdata(L, j);
+        if (lua_pcall(L, 1, LUA_MULTRET, 0) == LUA_OK) {
+            int count = lua_gettop(L) - top;
+            err = ser_values(L, top + 1, count, &out);
+            j->ok = err == NULL;
+        } else {
+            j->ok = 0;
+            err = ser_values(L, lua_gettop(L), 1, &out);
+        }
+        lua_settop(L, top);
+    }
+    if (err) {
+        // Replace whatever was written with the error message
+        j->ok = 0;
+        ser_free(out.data, out.size);
+        out.data = NULL;
+        out.capacity = 0;
+        out.size = 0;
+        Uint32 n = 1;
+        Uint8 tag = SER_STRING;
+        Uint64 len = SDL_strlen(err);
+        ser_put(&out, &n, sizeof(n));
+        ser_put(&out, &tag, 1);
+        ser_put(&out, &len, sizeof(len));
+        ser_put(&out, err, (size_t)len);
+    }
+    ser_free(j->data, j->size);
+    j->data = out.data;
+    j->size = out.size;
+    PROF_END();
+}
+
+static int SDLCALL worker_main(void *userdata) {
+    void *alloc_ud = lua_alloc_create();
+    lua_State *L = alloc_ud ? lua_newstate(lua_alloc_fn, alloc_ud) : NULL;
+    if (L) {
+        luaL_openlibs(L);
+        lua_modules_preload(L, LUA_MODULES_WORKER);
+        script_cache_install(L);
+        lua_pushinteger(L, (lua_Integer)(intptr_t)userdata);
+        lua_setglobal(L, "JOB_WORKER");
+    }
+    Uint32 helped = 0;          // generation of the last batch this worker joined
+    for (;;) {
+        SDL_LockMutex(g_jobs.lock);
+        while (!SDL_GetAtomicInt(&g_jobs.quit) && g_jobs.pending == 0 &&
+               (!SDL_GetAtomicInt(&g_batch.active) || helped == g_batch.generation)) {
+            SDL_WaitCondition(g_jobs.wake, g_jobs.lock);
+        }
+        int claimed = g_jobs.pending > 0;
+        if (claimed) g_jobs.pending--;
+        Uint32 generation = g_batch.generation;
+        SDL_UnlockMutex(g_jobs.lock);
+        if (SDL_GetAtomicInt(&g_jobs.quit)) break;
+        if (generation != helped) {
+            helped = generation;
+            batch_help();
+        }
+        if (!claimed) continue;
+        job *j = (job *)queue_pop(&g_jobs.submit);
+        if (!j) continue;
+        run_job(L, j);
+        // Cannot stay full: submit keeps in_flight within the ring's capacity
+        while (!queue_push(&g_jobs.done, j)) {
+            SDL_Delay(0);
+        }
+    }
+    if (L) lua_close(L);
+    lua_alloc_destroy(alloc_ud);
+    return 0;
+}
+
+static void free_job(job *j) {
+    ser_free(j->data, j->size);
+    SDL_free(j);
+}
+
+static void jobs_shutdown(void) {
+    if (!g_jobs.running) return;
+    SDL_LockMutex(g_jobs.lock);
+    SDL_SetAtomicInt(&g_jobs.quit, 1);
+    SDL_BroadcastCondition(g_jobs.wake);
+    SDL_UnlockMutex(g_jobs.lock);
+    for (int i = 0; i < g_jobs.thread_count; i++) {
+        SDL_WaitThread(g_jobs.threads[i], NULL);
+    }
+    job *j;
+    while ((j = (job *)queue_pop(&g_jobs.submit)) != NULL) free_job(j);
+    while ((j = (job *)queue_pop(&g_jobs.done)) != NULL) free_job(j);
+    SDL_free(g_jobs.submit.cells);
+    SDL_free(g_jobs.done.cells);
+    SDL_DestroyCondition(g_jobs.wake);
+    SDL_DestroyCondition(g_jobs.batch_idle);
+    SDL_DestroyMutex(g_jobs.lock);
+    SDL_zero(g_jobs);
+}
+
+void module_jobs_parallel_for(int count, module_jobs_task_fn fn, void *userdata) {
+    if (count <= 0) return;
+    if (!g_jobs.running || count == 1 || !SDL_CompareAndSwapAtomicInt(&g_batch.busy, 0, 1)) {
+        for (int i = 0; i < count; i++) fn(userdata, i);
+        return;
+    }
+    g_batch.fn = fn;
+    g_batch.userdata = userdata;
+    g_batch.count = count;
+    SDL_SetAtomicInt(&g_batch.next, 0);
+    // Idle workers wake up; busy ones join after their current Lua job
+    SDL_LockMutex(g_jobs.lock);
+    g_batch.generation++;
+    SDL_SetAtomicInt(&g_batch.active, 1);
+    SDL_BroadcastCondition(g_jobs.wake);
+    SDL_UnlockMutex(g_jobs.lock);
+    batch_work();
+    // No index is left to take; sleep until the helpers still running one are out
+    SDL_SetAtomicInt(&g_batch.active, 0);
+    SDL_LockMutex(g_jobs.lock);
+    while (SDL_GetAtomicInt(&g_batch.users) > 0) {
+        SDL_WaitCondition(g_jobs.batch_idle, g_jobs.lock);
+    }
+    SDL_UnlockMutex(g_jobs.lock);
+    SDL_SetAtomicInt(&g_batch.busy, 0);
+}
+
+int module_jobs_thread_count(void) {
+    return g_jobs.running ? g_jobs.thread_count : 0;
+}
+
+//===============================================
+// lua api
+//===============================================
+
+// Helper: Optional integer field of an options table, def when absent
+static lua_Integer opt_int_field(lua_State *L, int idx, const char *field, lua_Integer def) {
+    lua_Integer value = def;
+    if (lua_getfield(L, idx, field) != LUA_TNIL) {
+        int isnum = 0;
+        value = lua_tointegerx(L, -1, &isnum);
+        if (!isnum) luaL_error(L, "jobs.init: field '%s' must be an integer, got %s", field, luaL_typename(L, -1));
+    }
+    lua_pop(L, 1);
+    return value;
+}
+
+// Lua: jobs.init([{threads=cores-1, queue_size=1024}]) -> true | nil, err
+// Worker states have the C modules except gl, imgui, audio and jobs (and
+// lua_util without its gc, reload, profile and task functions), and the
+// global JOB_WORKER (1..threads).
+static int jobs_init(lua_State *L) {
+    if (g_jobs.running) {
+        lua_pushnil(L);
+        lua_pushstring(L, "jobs already initialized");
+        return 2;
+    }
+    int cores = SDL_GetNumLogicalCPUCores();
+    lua_Integer threads = cores > 1 ? cores - 1 : 1;
+    lua_Integer queue_size = 1024;
+    if (lua_istable(L, 1)) {
+        threads = opt_int_field(L, 1, "threads", threads);
+        queue_size = opt_int_field(L, 1, "queue_size", queue_size);
+    }
+    luaL_argcheck(L, threads >= 1 && threads <= JOBS_MAX_THREADS, 1, "threads out of range");
+    luaL_argcheck(L, queue_size >= 2 && queue_size <= (1 << 20), 1, "queue_size out of range");
+
+    Uint32 capacity = 2;
+    while (capacity < (Uint32)queue_size) capacity *= 2;
+    g_jobs.lock = SDL_CreateMutex();
+    g_jobs.wake = SDL_CreateCondition();
+    g_jobs.batch_idle = SDL_CreateCondition();
+    if (!g_jobs.lock || !g_jobs.wake || !g_jobs.batch_idle ||
+        !queue_init(&g_jobs.submit, capacity) || !queue_init(&g_jobs.done, capacity)) {
+        SDL_free(g_jobs.submit.cells);
+        SDL_free(g_jobs.done.cells);
+        if (g_jobs.wake) SDL_DestroyCondition(g_jobs.wake);
+        if (g_jobs.batch_idle) SDL_DestroyCondition(g_jobs.batch_idle);
+        if (g_jobs.lock) SDL_DestroyMutex(g_jobs.lock);
+        SDL_zero(g_jobs);
+        lua_pushnil(L);
+        lua_pushstring(L, "Out of memory");
+        return 2;
+    }
+    g_jobs.capacity = (int)capacity;
+    g_jobs.next_id = 1;
+    g_jobs.running = 1;
+    SDL_SetAtomicInt(&g_jobs.quit, 0);
+    for (int i = 0; i < threads; i++) {
+        char name[32];
+        SDL_snprintf(name, sizeof(name), "lua_job_%d", i + 1);
+        g_jobs.threads[i] = SDL_CreateThread(worker_main, name, (void *)(intptr_t)(i + 1));
+        if (!g_jobs.threads[i]) {
+            const char *err = SDL_GetError();
+            jobs_shutdown();
+            lua_pushnil(L);
+            lua_pushstring(L, err);
+            return 2;
+        }
+        g_jobs.thread_count++;
+    }
+    lua_pushboolean(L, 1);
+    return 1;
+}
+
+// Lua: jobs.submit(name, ...) -> id | nil, err
+// name is "module.function" (required on the worker) or a global function name.
+// Arguments may be nil, booleans, numbers, strings, light userdata, lua_blobs
+// (shared, not copied) and tables of those.
+static int jobs_submit(lua_State *L) {
+    luaL_checkstring(L, 1);
+    if (!g_jobs.running) {
+        lua_pushnil(L);
+        lua_pushstring(L, "jobs not initialized");
+        return 2;
+    }
+    if (g_jobs.in_flight >= g_jobs.capacity) {
+        lua_pushnil(L);
+        lua_pushstring(L, "job queue full");
+        return 2;
+    }
+    ser_buffer b = {0};
+    const char *err = ser_values(L, 1, lua_gettop(L), &b);
+    job *j = err ? NULL : (job *)SDL_calloc(1, sizeof(job));
+    if (!j) {
+        ser_free(b.data, b.size);
+        lua_pushnil(L);
+        lua_pushstring(L, err ? err : "Out of memory");
+        return 2;
+    }
+    j->id = g_jobs.next_id++;
+    j->data = b.data;
+    j->size = b.size;
+    queue_push(&g_jobs.submit, j);
+    g_jobs.in_flight++;
+    SDL_LockMutex(g_jobs.lock);
+    g_jobs.pending++;
+    SDL_SignalCondition(g_jobs.wake);
+    SDL_UnlockMutex(g_jobs.lock);
+    lua_pushinteger(L, j->id);
+    return 1;
+}
+
+// Helper: Values of a job result; runs protected because restoring a value can
+// raise (e.g. a NaN table key), and the job must be freed either way
+static int push_job_result(lua_State *L) {
+    job *j = (job *)lua_touserdata(L, 1);
+    lua_pop(L, 1);
+    int n = deser_values(L, j->data, j->size);
+    if (n < 0) return luaL_error(L, "malformed job result");
+    return n;
+}
+
+// Lua: jobs.poll() -> id, ok, ... | nil
+// Next finished job: its id, whether it succeeded, then its return values
+// (or the error message).
+static int jobs_poll(lua_State *L) {
+    job *j = g_jobs.running ? (job *)queue_pop(&g_jobs.done) : NULL;
+    if (!j) {
+        lua_pushnil(L);
+        return 1;
+    }
+    g_jobs.in_flight--;
+    int base = lua_gettop(L);
+    lua_pushinteger(L, j->id);
+    lua_pushboolean(L, j->ok);
+    lua_pushcfunction(L, push_job_result);
+    lua_pushlightuserdata(L, j);
+    int status = lua_pcall(L, 1, LUA_MULTRET, 0);
+    free_job(j);
+    if (status != LUA_OK) {
+        lua_pushboolean(L, 0);
+        lua_replace(L, base + 2);   // ok = false, the error message follows
+    }
+    return lua_gettop(L) - base;
+}
+
+// Lua: jobs.pending() -> n -- submitted jobs whose results were not polled yet
+static int jobs_pending(lua_State *L) {
+    lua_pushinteger(L, g_jobs.in_flight);
+    return 1;
+}
+
+// Lua: jobs.threads() -> n
+static int jobs_threads(lua_State *L) {
+    lua_pushinteger(L, g_jobs.thread_count);
+    return 1;
+}
+
+// Lua: jobs.shutdown() -- waits for running jobs, drops queued ones and results
+static int jobs_shutdown_lua(lua_State *L) {
+    jobs_shutdown();
+    return 0;
+}
+
+static const struct luaL_Reg jobs_lib[] = {
+    {"init", jobs_init},
+    {"submit", jobs_submit},
+    {"poll", jobs_poll},
+    {"pending", jobs_pending},
+    {"threads", jobs_threads},
+    {"shutdown", jobs_shutdown_lua},
+    {NULL, NULL}
+};
+
+int luaopen_module_jobs(lua_State *L) {
+    luaL_newlib(L, jobs_lib);
+    // Stop the workers when the main state closes
+    lua_newtable(L);
+    lua_pushcfunction(L, jobs_shutdown_lua);
+    lua_setfield(L, -2, "__gc");
+    lua_setmetatable(L, -2);
+    return 1;
+}
@@ -1,29 +1,1633 @@
 #include "module_lua.h"
+#include "app_log.h"
+#include "asset_pack.h"
+#include "lua_alloc.h"
+#include "lua_blob.h"
+#include "lua_modules.h"
+#include "module_prof.h"
+#include "script_cache.h"
+#include "module_sdl.h"     // sdl.buffer results of lua_util.await_load
+#include "module_gl.h"      // fence status for lua_util.await_fence
+#include <SDL3/SDL.h>
 #include <lauxlib.h>
+#include <stdio.h>
 #include <sys/stat.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
 
 // Lua: module_lua.path_exists(path) -> bool
+// Also true for files in a mounted asset pack.
 static int lua_path_exists(lua_State *L) {
     const char *path = luaL_checkstring(L, 1);
     struct stat st;
-    lua_pushboolean(L, stat(path, &st) == 0);
+    lua_pushboolean(L, asset_pack_contains(path) || stat(path, &st) == 0);
     return 1;
 }
 
+// Lua: module_lua.pack_mount(path) -> true | nil, err
+// Mount before jobs.init, worker states read the packs without locking.
+static int lua_pack_mount(lua_State *L) {
+    if (!asset_pack_mount(luaL_checkstring(L, 1))) {
+        lua_pushnil(L);
+        lua_pushstring(L, SDL_GetError());
+        return 2;
+    }
+    script_cache_install(L);  // the require() searcher, if not installed yet
+    lua_pushboolean(L, 1);
+    return 1;
+}
+
+static void free_loaded_file(void *data, void *userdata) {
+    SDL_free(data);
+}
+
+// Lua: module_lua.load_asset(path) -> blob | nil, err
+// From the mounted asset packs (stored entries without a copy), else from disk.
+static int lua_load_asset(lua_State *L) {
+    const char *path = luaL_checkstring(L, 1);
+    lua_blob *blob = asset_pack_load(path);
+    if (!blob) {
+        size_t size = 0;
+        void *data = SDL_LoadFile(path, &size);
+        blob = data ? lua_blob_wrap(data, size, free_loaded_file, NULL) : NULL;
+        if (data && !blob) SDL_free(data);
+    }
+    if (!blob) {
+        lua_pushnil(L);
+        lua_pushstring(L, SDL_GetError());
+        return 2;
+    }
+    lua_blob_push(L, blob);
+    return 1;
+}
+
+//===============================================
+// logging (app_log.h)
+//===============================================
+
+#define LOG_CATEGORIES_KEY "lua_util.log_categories"  // name -> category id
+
+// Helper: Level at idx, a name ("debug") or a number; default when absent
+static int check_log_level(lua_State *L, int idx, int def) {
+    static const char *const names[] = {"trace", "debug", "info", "warn", "error", "off", NULL};
+    if (lua_type(L, idx) == LUA_TNUMBER) {
+        lua_Integer level = luaL_checkinteger(L, idx);
+        luaL_argcheck(L, level >= APP_LOG_TRACE && level <= APP_LOG_OFF, idx, "invalid log level");
+        return (int)level;
+    }
+    return lua_isnoneornil(L, idx) ? def : luaL_checkoption(L, idx, NULL, names);
+}
+
+// Helper: Category at idx: an id from log_category, a name (registered on
+// first use, the lookup is cached in the registry) or nil for "Lua"
+static int check_log_category(lua_State *L, int idx) {
+    int type = lua_type(L, idx);
+    if (type == LUA_TNONE || type == LUA_TNIL) return APP_LOG_CAT_LUA;
+    if (type == LUA_TNUMBER) {
+        lua_Integer id = luaL_checkinteger(L, idx);
+        luaL_argcheck(L, id >= 0 && id < app_log_category_count(), idx, "invalid log category");
+        return (int)id;
+    }
+    luaL_checktype(L, idx, LUA_TSTRING);
+    if (lua_getfield(L, LUA_REGISTRYINDEX, LOG_CATEGORIES_KEY) != LUA_TTABLE) {
+        lua_pop(L, 1);
+        lua_newtable(L);
+        lua_pushvalue(L, -1);
+        lua_setfield(L, LUA_REGISTRYINDEX, LOG_CATEGORIES_KEY);
+    }
+    lua_pushvalue(L, idx);
+    if (lua_rawget(L, -2) == LUA_TNUMBER) {
+        int id = (int)lua_tointeger(L, -1);
+        lua_pop(L, 2);
+        return id;
+    }
+    lua_pop(L, 1);
+    int id = app_log_category(lua_tostring(L, idx));
+    if (id < 0) {
+        return luaL_argerror(L, idx, SDL_GetError());
+    }
+    lua_pushvalue(L, idx);
+    lua_pushinteger(L, id);
+    lua_rawset(L, -3);
+    lua_pop(L, 1);
+    return id;
+}
+
 // Lua: module_lua.log(msg)
+// Info message in the "Lua" category
 static int lua_log(lua_State *L) {
-    const char *msg = luaL_checkstring(L, 1);
-    printf("[Lua] %s\n", msg);
+    size_t len;
+    const char *msg = luaL_checklstring(L, 1, &len);
+    if (app_log_admit(APP_LOG_CAT_LUA, APP_LOG_INFO)) {
+        app_log_submit(APP_LOG_CAT_LUA, APP_LOG_INFO, msg, len);
+    }
+    return 0;
+}
+
+// Lua: module_lua.logf(level, category, fmt, ...)
+// string.format(fmt, ...) runs only when the message passes the level and rate limit.
+static int lua_logf(lua_State *L) {
+    int level = check_log_level(L, 1, APP_LOG_INFO);
+    int category = check_log_category(L, 2);
+    if (!app_log_admit(category, level)) return 0;
+    luaL_checkstring(L, 3);
+    lua_getglobal(L, "string");
+    lua_getfield(L, -1, "format");
+    lua_replace(L, 2);
+    lua_settop(L, lua_gettop(L) - 1);
+    lua_call(L, lua_gettop(L) - 2, 1);
+    size_t len;
+    const char *text = lua_tolstring(L, -1, &len);
+    app_log_submit(category, level, text, len);
+    return 0;
+}
+
+// Lua: module_lua.log_enabled(level, [category]) -> bool
+static int lua_log_enabled(lua_State *L) {
+    int level = check_log_level(L, 1, APP_LOG_INFO);
+    lua_pushboolean(L, app_log_enabled(check_log_category(L, 2), level));
+    return 1;
+}
+
+// Lua: module_lua.log_category(name) -> id
+static int lua_log_category(lua_State *L) {
+    luaL_checkstring(L, 1);
+    lua_pushinteger(L, check_log_category(L, 1));
+    return 1;
+}
+
+// Lua: module_lua.log_level(level, [category]) -> previous
+// Without a category: the default of every category without a level of its own.
+static int lua_log_level(lua_State *L) {
+    int level = check_log_level(L, 1, APP_LOG_INFO);
+    int category = lua_isnoneornil(L, 2) ? -1 : check_log_category(L, 2);
+    lua_pushstring(L, app_log_level_name(app_log_get_level(category)));
+    app_log_set_level(category, level);
+    return 1;
+}
+
+// Lua: module_lua.log_rate(category, per_sec)
+static int lua_log_rate(lua_State *L) {
+    int category = check_log_category(L, 1);
+    lua_Integer per_sec = luaL_checkinteger(L, 2);
+    luaL_argcheck(L, per_sec >= 0 && per_sec <= SDL_MAX_SINT32, 2, "out of range");
+    app_log_set_rate(category, (int)per_sec);
+    return 0;
+}
+
+// Lua: module_lua.log_file(path | nil, [binary]) -> true | nil, err
+static int lua_log_file(lua_State *L) {
+    const char *path = luaL_optstring(L, 1, NULL);
+    if (!app_log_open_file(path, lua_toboolean(L, 2))) {
+        lua_pushnil(L);
+        lua_pushstring(L, SDL_GetError());
+        return 2;
+    }
+    lua_pushboolean(L, 1);
+    return 1;
+}
+
+// Lua: module_lua.log_flush()
+static int lua_log_flush(lua_State *L) {
+    app_log_flush();
+    return 0;
+}
+
+// Lua: module_lua.log_stats() -> table
+static int lua_log_stats(lua_State *L) {
+    app_log_stats st;
+    app_log_get_stats(&st);
+    lua_createtable(L, 0, 5);
+    lua_pushinteger(L, st.written);
+    lua_setfield(L, -2, "written");
+    lua_pushinteger(L, st.pending);
+    lua_setfield(L, -2, "pending");
+    lua_pushinteger(L, st.dropped_full);
+    lua_setfield(L, -2, "dropped_full");
+    lua_pushinteger(L, st.dropped_rate);
+    lua_setfield(L, -2, "dropped_rate");
+
+    int count = app_log_category_count();
+    lua_createtable(L, 0, count);
+    for (int i = 0; i < count; i++) {
+        lua_createtable(L, 0, 4);
+        lua_pushinteger(L, i);
+        lua_setfield(L, -2, "id");
+        lua_pushstring(L, app_log_level_name(app_log_get_level(i)));
+        lua_setfield(L, -2, "level");
+        lua_pushinteger(L, app_log_get_rate(i));
+        lua_setfield(L, -2, "rate");
+        lua_pushinteger(L, app_log_category_dropped(i));
+        lua_setfield(L, -2, "dropped");
+        lua_setfield(L, -2, app_log_category_name(i));
+    }
+    lua_setfield(L, -2, "categories");
+    return 1;
+}
+
+// Lua: module_lua.mem_stats() -> table | nil, err
+// allocs_per_sec is measured since the previous call in this state (or since it was created).
+static int lua_mem_stats(lua_State *L) {
+    lua_alloc_stats st;
+    if (!lua_alloc_get_stats(L, &st)) {
+        lua_pushnil(L);
+        lua_pushstring(L, "Lua state does not use the pooled allocator");
+        return 2;
+    }
+
+    double rate = lua_alloc_sample_rate(L);
+
+    lua_newtable(L);
+    lua_pushinteger(L, (lua_Integer)st.live_bytes);
+    lua_setfield(L, -2, "live");
+    lua_pushinteger(L, (lua_Integer)st.peak_bytes);
+    lua_setfield(L, -2, "peak");
+    lua_pushinteger(L, (lua_Integer)st.pool_bytes);
+    lua_setfield(L, -2, "pool");
+    lua_pushinteger(L, (lua_Integer)st.large_bytes);
+    lua_setfield(L, -2, "large");
+    lua_pushinteger(L, (lua_Integer)st.allocs);
+    lua_setfield(L, -2, "allocs");
+    lua_pushinteger(L, (lua_Integer)st.total_bytes);
+    lua_setfield(L, -2, "total_bytes");
+    lua_pushnumber(L, rate);
+    lua_setfield(L, -2, "allocs_per_sec");
+
+    lua_newtable(L);
+    for (int i = 0; i < LUA_TAG_COUNT; i++) {
+        lua_newtable(L);
+        lua_pushinteger(L, (lua_Integer)st.tags[i].live_bytes);
+        lua_setfield(L, -2, "live");
+        lua_pushinteger(L, (lua_Integer)st.tags[i].peak_bytes);
+        lua_setfield(L, -2, "peak");
+        lua_pushinteger(L, (lua_Integer)st.tags[i].allocs);
+        lua_setfield(L, -2, "allocs");
+        lua_setfield(L, -2, lua_alloc_tag_name(i));
+    }
+    lua_setfield(L, -2, "tags");
+    return 1;
+}
+
+static void free_sdl_memory(void *data, void *userdata) {
+    SDL_free(data);
+}
+
+// Lua: module_lua.blob(string | buffer) -> blob
+// A string is copied once; an sdl.buffer hands its memory to the blob and is
+// left freed. The blob can then be shared with jobs, gl, enet and stb without copies.
+static int lua_blob_new(lua_State *L) {
+    sdl_buffer *buf = module_sdl_test_buffer(L, 1);
+    lua_blob *blob;
+    if (buf) {
+        luaL_argcheck(L, buf->data != NULL, 1, "buffer was freed");
+        blob = lua_blob_wrap(buf->data, buf->size, free_sdl_memory, NULL);
+        if (blob) buf->data = NULL;
+    } else {
+        size_t len;
+        const char *s = luaL_checklstring(L, 1, &len);
+        blob = lua_blob_create(len);
+        if (blob) SDL_memcpy(lua_blob_bytes(blob), s, len);
+    }
+    if (!blob) return luaL_error(L, "Out of memory");
+    lua_blob_push(L, blob);
+    return 1;
+}
+
+//===============================================
+// per-frame GC budget
+//===============================================
+
+#define GC_HISTORY 256
+#define GC_CYCLE_PAUSE 2        // start a new cycle when memory doubled since the last one
+#define GC_BEHIND_FACTOR 4      // past this the budget is ignored until the cycle ends
+
+// While a budget is set the automatic collector is stopped and the collector only
+// runs in module_lua_gc_frame (or lua_util.gc_step), in bounded slices.
+static struct {
+    double budget_ms;
+    int generational;
+    int in_cycle;
+    int cycle_base_kb;          // heap size when the last cycle finished
+    int last_steps;
+    Uint64 frames;
+    Uint64 cycles;
+    Uint64 overruns;            // frames that went past the budget to catch up
+    Uint64 pause_ns[GC_HISTORY];
+} g_gc;
+
+// Helper: Run collector steps for about limit_ns and record the pause as one frame
+static Uint64 gc_run(lua_State *L, Uint64 limit_ns) {
+    PROF_BEGIN("lua_util gc");
+    Uint64 start = SDL_GetTicksNS();
+    int kb = lua_gc(L, LUA_GCCOUNT);
+    int steps = 0;
+
+    if (g_gc.generational) {
+        // A step is one minor collection, its cost follows the young objects only
+        lua_gc(L, LUA_GCSTEP, 0);
+        steps = 1;
+    } else {
+        if (!g_gc.in_cycle && kb >= g_gc.cycle_base_kb * GC_CYCLE_PAUSE) {
+            g_gc.in_cycle = 1;
+        }
+        if (g_gc.in_cycle) {
+            // Always make progress, even without slack, so the heap stays bounded
+            int behind = kb > g_gc.cycle_base_kb * GC_BEHIND_FACTOR;
+            do {
+                steps++;
+                if (lua_gc(L, LUA_GCSTEP, 0)) {
+                    g_gc.in_cycle = 0;
+                    g_gc.cycles++;
+                    g_gc.cycle_base_kb = lua_gc(L, LUA_GCCOUNT);
+                    break;
+                }
+            } while (behind || SDL_GetTicksNS() - start < limit_ns);
+            if (behind) g_gc.overruns++;
+        }
+    }
+
+    Uint64 pause = SDL_GetTicksNS() - start;
+    PROF_END();
+    g_gc.pause_ns[g_gc.frames % GC_HISTORY] = pause;
+    g_gc.frames++;
+    g_gc.last_steps = steps;
+    return pause;
+}
+
+void module_lua_gc_frame(lua_State *L, double slack_ms) {
+    if (g_gc.budget_ms <= 0.0 || lua_modules_kind(L) != LUA_MODULES_MAIN) return;
+    double ms = slack_ms < g_gc.budget_ms ? slack_ms : g_gc.budget_ms;
+    gc_run(L, ms > 0.0 ? (Uint64)(ms * 1e6) : 0);
+}
+
+// Helper: Reset the cycle tracking after the collector mode or budget changed
+static void gc_reset_cycle(lua_State *L) {
+    g_gc.in_cycle = 0;
+    g_gc.cycle_base_kb = lua_gc(L, LUA_GCCOUNT);
+}
+
+// Lua: module_lua.gc_frame_budget(ms) -> previous_ms
+// ms > 0 stops the automatic collector; sdl.run then steps it in the slack time
+// before each swap, at most ms per frame. 0 restores the automatic collector.
+static int lua_gc_frame_budget(lua_State *L) {
+    double ms = luaL_checknumber(L, 1);
+    luaL_argcheck(L, ms >= 0.0, 1, "budget must not be negative");
+    double previous = g_gc.budget_ms;
+    if (ms > 0.0 && previous <= 0.0) {
+        lua_gc(L, LUA_GCSTOP);
+        gc_reset_cycle(L);
+    } else if (ms <= 0.0 && previous > 0.0) {
+        lua_gc(L, LUA_GCRESTART);
+    }
+    g_gc.budget_ms = ms;
+    lua_pushnumber(L, previous);
+    return 1;
+}
+
+// Lua: module_lua.gc_step([ms]) -> pause_ms
+// Runs the collector now for about ms (default: the frame budget, or 1 ms),
+// for scripts with their own loop. Counts as one frame in gc_stats.
+static int lua_gc_step(lua_State *L) {
+    double ms = luaL_optnumber(L, 1, g_gc.budget_ms > 0.0 ? g_gc.budget_ms : 1.0);
+    luaL_argcheck(L, ms >= 0.0, 1, "time must not be negative");
+    lua_pushnumber(L, gc_run(L, (Uint64)(ms * 1e6)) / 1e6);
+    return 1;
+}
+
+// Lua: module_lua.gc_mode([mode]) -> previous_mode
+// mode is "incremental" or "generational"; without it returns the current mode.
+static int lua_gc_mode(lua_State *L) {
+    static const char *const modes[] = {"incremental", "generational", NULL};
+    lua_pushstring(L, modes[g_gc.generational]);
+    if (lua_isnoneornil(L, 1)) {
+        return 1;
+    }
+    int generational = luaL_checkoption(L, 1, NULL, modes);
+    if (generational != g_gc.generational) {
+        lua_gc(L, generational ? LUA_GCGEN : LUA_GCINC, 0, 0, 0);
+        g_gc.generational = generational;
+        gc_reset_cycle(L);
+    }
+    return 1;
+}
+
+// Lua: module_lua.gc_stats() -> table
+// Pause times cover the frames the budget (or gc_step) ran, the last GC_HISTORY at most.
+static int lua_gc_stats(lua_State *L) {
+    int n = g_gc.frames < GC_HISTORY ? (int)g_gc.frames : GC_HISTORY;
+    Uint64 max_ns = 0, sum_ns = 0;
+    for (int i = 0; i < n; i++) {
+        if (g_gc.pause_ns[i] > max_ns) max_ns = g_gc.pause_ns[i];
+        sum_ns += g_gc.pause_ns[i];
+    }
+    Uint64 last_ns = g_gc.frames ? g_gc.pause_ns[(g_gc.frames - 1) % GC_HISTORY] : 0;
+
+    lua_newtable(L);
+    lua_pushstring(L, g_gc.generational ? "generational" : "incremental");
+    lua_setfield(L, -2, "mode");
+    lua_pushnumber(L, g_gc.budget_ms);
+    lua_setfield(L, -2, "budget_ms");
+    lua_pushnumber(L, last_ns / 1e6);
+    lua_setfield(L, -2, "last_ms");
+    lua_pushnumber(L, max_ns / 1e6);
+    lua_setfield(L, -2, "max_ms");
+    lua_pushnumber(L, n ? (double)sum_ns / n / 1e6 : 0.0);
+    lua_setfield(L, -2, "avg_ms");
+    lua_pushinteger(L, g_gc.last_steps);
+    lua_setfield(L, -2, "steps");
+    lua_pushinteger(L, (lua_Integer)g_gc.cycles);
+    lua_setfield(L, -2, "cycles");
+    lua_pushinteger(L, (lua_Integer)g_gc.overruns);
+    lua_setfield(L, -2, "overruns");
+    lua_pushinteger(L, lua_gc(L, LUA_GCCOUNT));
+    lua_setfield(L, -2, "kb");
+    return 1;
+}
+
+// Lua: module_lua.gc_get_pause_history([t]) -> t
+// Fills t (or a new table) with per-frame pause times in ms, oldest first.
+static int lua_gc_get_pause_history(lua_State *L) {
+    int n = g_gc.frames < GC_HISTORY ? (int)g_gc.frames : GC_HISTORY;
+    if (lua_istable(L, 1)) {
+        lua_settop(L, 1);
+    } else {
+        lua_settop(L, 0);
+        lua_createtable(L, n, 0);
+    }
+    Uint64 first = g_gc.frames - (Uint64)n;
+    for (int i = 0; i < n; i++) {
+        lua_pushnumber(L, g_gc.pause_ns[(first + i) % GC_HISTORY] / 1e6);
+        lua_rawseti(L, 1, i + 1);
+    }
+    // Trim stale entries from a reused table
+    for (lua_Integer i = n + 1; lua_rawgeti(L, 1, i) != LUA_TNIL; i++) {
+        lua_pop(L, 1);
+        lua_pushnil(L);
+        lua_rawseti(L, 1, i);
+    }
+    lua_pop(L, 1);
+    return 1;
+}
+
+//===============================================
+// hot reload
+//===============================================
+
+#define RELOAD_SCAN_NS (250 * SDL_NS_PER_MS)    // look for newly required modules
+#define RELOAD_STATE_KEY "lua_util.state"
+#define RELOAD_SEEN_KEY "lua_util.reload_seen"
+
+typedef struct {
+    char *name;
+    char *path;
+    Sint64 mtime;
+} reload_entry;
+
+// Modules required from a file on package.path. On Linux inotify on their
+// directories says when to compare mtimes, elsewhere they are compared on every scan.
+static struct {
+    int enabled;
+    reload_entry *entries;
+    int count;
+    int capacity;
+    Uint64 last_scan_ns;
+#ifdef __linux__
+    int inotify_fd;
+#endif
+} g_reload;
+
+static Sint64 file_mtime(const char *path) {
+    SDL_PathInfo info;
+    return SDL_GetPathInfo(path, &info) ? (Sint64)info.modify_time : 0;
+}
+
+static void track_module(const char *name, const char *path) {
+    if (g_reload.count == g_reload.capacity) {
+        int capacity = g_reload.capacity ? g_reload.capacity * 2 : 32;
+        reload_entry *entries = (reload_entry *)SDL_realloc(g_reload.entries, capacity * sizeof(reload_entry));
+        if (!entries) return;
+        g_reload.entries = entries;
+        g_reload.capacity = capacity;
+    }
+    reload_entry *e = &g_reload.entries[g_reload.count++];
+    e->name = SDL_strdup(name);
+    e->path = SDL_strdup(path);
+    e->mtime = file_mtime(path);
+#ifdef __linux__
+    if (g_reload.inotify_fd >= 0) {
+        // Editors often save through a temporary file and a rename, so watch the directory
+        char dir[1024];
+        SDL_strlcpy(dir, path, sizeof(dir));
+        char *slash = SDL_strrchr(dir, '/');
+        if (slash) *slash = '\0';
+        else SDL_strlcpy(dir, ".", sizeof(dir));
+        inotify_add_watch(g_reload.inotify_fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    }
+#endif
+}
+
+// Helper: Track modules in package.loaded not seen before that came from a file
+static void track_loaded_modules(lua_State *L) {
+    int top = lua_gettop(L);
+    lua_getfield(L, LUA_REGISTRYINDEX, RELOAD_SEEN_KEY);
+    int seen = lua_gettop(L);
+    lua_getglobal(L, "package");
+    lua_getfield(L, -1, "loaded");
+    int loaded = lua_gettop(L);
+    lua_getfield(L, -2, "preload");
+    int preload = lua_gettop(L);
+    lua_getfield(L, -3, "searchpath");
+    int searchpath = lua_gettop(L);
+    lua_getfield(L, -4, "path");
+    int path = lua_gettop(L);
+    if (!lua_istable(L, seen) || !lua_istable(L, loaded) || !lua_isfunction(L, searchpath) || !lua_isstring(L, path)) {
+        lua_settop(L, top);
+        return;
+    }
+
+    lua_pushnil(L);
+    while (lua_next(L, loaded)) {
+        lua_pop(L, 1);
+        if (lua_type(L, -1) != LUA_TSTRING) continue;
+        lua_pushvalue(L, -1);
+        if (lua_rawget(L, seen) != LUA_TNIL) {
+            lua_pop(L, 1);
+            continue;
+        }
+        lua_pop(L, 1);
+        lua_pushvalue(L, -1);
+        lua_pushboolean(L, 1);
+        lua_rawset(L, seen);
+
+        // C modules are in package.preload and have no file
+        if (lua_istable(L, preload)) {
+            lua_pushvalue(L, -1);
+            int preloaded = lua_rawget(L, preload) != LUA_TNIL;
+            lua_pop(L, 1);
+            if (preloaded) continue;
+        }
+
+        lua_pushvalue(L, searchpath);
+        lua_pushvalue(L, -2);
+        lua_pushvalue(L, path);
+        if (lua_pcall(L, 2, 1, 0) == LUA_OK && lua_type(L, -1) == LUA_TSTRING) {
+            track_module(lua_tostring(L, -2), lua_tostring(L, -1));
+        }
+        lua_pop(L, 1);
+    }
+    lua_settop(L, top);
+}
+
+// Helper: Point upvalues of fn that hold the new module table at the old one,
+// so the new code keeps working on the live table. Upvalues are shared by all
+// closures of the chunk, so this also fixes local helper functions.
+static void rebind_module_upvalues(lua_State *L, int fn, int new_table, int old_table) {
+    for (int n = 1; lua_getupvalue(L, fn, n) != NULL; n++) {
+        int same = lua_rawequal(L, -1, new_table);
+        lua_pop(L, 1);
+        if (same) {
+            lua_pushvalue(L, old_table);
+            lua_setupvalue(L, fn, n);
+        }
+    }
+}
+
+// Helper: Run the module file again and patch the result into package.loaded[name].
+// Returns 1 on success, 0 with an error message pushed.
+static int reload_module(lua_State *L, const char *name, const char *path) {
+    int top = lua_gettop(L);
+    if (script_cache_loadfile(L, path) != LUA_OK) return 0;
+    lua_pushstring(L, name);
+    lua_pushstring(L, path);
+    if (lua_pcall(L, 2, 1, 0) != LUA_OK) return 0;
+    int new_table = lua_gettop(L);
+    lua_getglobal(L, "package");
+    lua_getfield(L, -1, "loaded");
+    int loaded = lua_gettop(L);
+    lua_getfield(L, loaded, name);
+    int old_table = lua_gettop(L);
+
+    if (lua_istable(L, new_table) && lua_istable(L, old_table)) {
+        // Patch in place so every `local m = require(name)` sees the new code.
+        // Functions are replaced; other fields keep their live values and are
+        // only added when the old table lacks them.
+        lua_pushnil(L);
+        while (lua_next(L, new_table)) {
+            int value = lua_gettop(L);
+            if (lua_isfunction(L, value)) {
+                rebind_module_upvalues(L, value, new_table, old_table);
+                lua_pushvalue(L, value - 1);
+                lua_pushvalue(L, value);
+                lua_rawset(L, old_table);
+            } else {
+                lua_pushvalue(L, value - 1);
+                if (lua_rawget(L, old_table) == LUA_TNIL) {
+                    lua_pushvalue(L, value - 1);
+                    lua_pushvalue(L, value);
+                    lua_rawset(L, old_table);
+                }
+                lua_pop(L, 1);
+            }
+            lua_pop(L, 1);
+        }
+        if (lua_getmetatable(L, new_table)) {
+            lua_setmetatable(L, old_table);
+        }
+        // Optional hook: M.on_reload() runs on the patched table
+        if (lua_getfield(L, old_table, "on_reload") == LUA_TFUNCTION) {
+            lua_pushvalue(L, old_table);
+            if (lua_pcall(L, 1, 0, 0) != LUA_OK) {
+                lua_replace(L, top + 1);
+                lua_settop(L, top + 1);
+                return 0;
+            }
+        } else {
+            lua_pop(L, 1);
+        }
+    } else if (!lua_isnil(L, new_table)) {
+        lua_pushvalue(L, new_table);
+        lua_setfield(L, loaded, name);
+    }
+    lua_settop(L, top);
+    return 1;
+}
+
+// Helper: Reload every tracked module whose file changed. Names of reloaded
+// modules are appended to the table at names_idx (0 = none), failures printed.
+static int reload_changed(lua_State *L, int names_idx) {
+    int changed = 0;
+    Uint64 now = SDL_GetTicksNS();
+    int scan = now - g_reload.last_scan_ns >= RELOAD_SCAN_NS;
+    if (scan) {
+        g_reload.last_scan_ns = now;
+        track_loaded_modules(L);
+    }
+#ifdef __linux__
+    if (g_reload.inotify_fd >= 0) {
+        char events[4096];
+        while (read(g_reload.inotify_fd, events, sizeof(events)) > 0) {
+            changed = 1;
+        }
+    } else {
+        changed = scan;
+    }
+#else
+    changed = scan;
+#endif
+    if (!changed) return 0;
+
+    int reloaded = 0;
+    for (int i = 0; i < g_reload.count; i++) {
+        reload_entry *e = &g_reload.entries[i];
+        Sint64 mtime = file_mtime(e->path);
+        if (mtime == 0 || mtime == e->mtime) continue;
+        e->mtime = mtime;
+        int category = app_log_category("hot reload");
+        // Packs shadow the disk file, reloading would run the old code again
+        if (asset_pack_contains(e->path)) {
+            app_log_printf(category, APP_LOG_WARN, "%s: %s is served from an asset pack, not reloaded",
+                           e->name, e->path);
+            continue;
+        }
+        Uint64 start = SDL_GetTicksNS();
+        if (!reload_module(L, e->name, e->path)) {
+            app_log_printf(category, APP_LOG_ERROR, "%s: %s", e->name, lua_tostring(L, -1));
+            lua_pop(L, 1);
+            continue;
+        }
+        app_log_printf(category, APP_LOG_INFO, "%s (%.2f ms)",
+                       e->name, (SDL_GetTicksNS() - start) / 1e6);
+        if (names_idx) {
+            lua_pushstring(L, e->name);
+            lua_rawseti(L, names_idx, (lua_Integer)lua_rawlen(L, names_idx) + 1);
+        }
+        reloaded++;
+    }
+    return reloaded;
+}
+
+void module_lua_reload_poll(lua_State *L) {
+    if (g_reload.enabled && lua_modules_kind(L) == LUA_MODULES_MAIN) {
+        reload_changed(L, 0);
+    }
+}
+
+// Lua: module_lua.hot_reload([enable]) -> bool
+// Watches the files of required Lua modules; sdl.run (or lua_util.reload_poll)
+// re-runs changed ones and patches them into their live module tables.
+static int lua_hot_reload(lua_State *L) {
+    int enable = lua_isnone(L, 1) ? 1 : lua_toboolean(L, 1);
+    if (enable && !g_reload.enabled) {
+        lua_newtable(L);
+        lua_setfield(L, LUA_REGISTRYINDEX, RELOAD_SEEN_KEY);
+#ifdef __linux__
+        g_reload.inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+        g_reload.enabled = 1;
+        g_reload.last_scan_ns = SDL_GetTicksNS();
+        track_loaded_modules(L);
+    } else if (!enable && g_reload.enabled) {
+#ifdef __linux__
+        if (g_reload.inotify_fd >= 0) close(g_reload.inotify_fd);
+#endif
+        for (int i = 0; i < g_reload.count; i++) {
+            SDL_free(g_reload.entries[i].name);
+            SDL_free(g_reload.entries[i].path);
+        }
+        SDL_free(g_reload.entries);
+        SDL_zero(g_reload);
+        lua_pushnil(L);
+        lua_setfield(L, LUA_REGISTRYINDEX, RELOAD_SEEN_KEY);
+    }
+    lua_pushboolean(L, g_reload.enabled);
+    return 1;
+}
+
+// Lua: module_lua.reload_poll() -> names | nil
+// Reloads changed modules now, for scripts with their own loop.
+static int lua_reload_poll(lua_State *L) {
+    if (!g_reload.enabled) {
+        lua_pushnil(L);
+        return 1;
+    }
+    lua_newtable(L);
+    if (reload_changed(L, lua_gettop(L)) == 0) {
+        lua_pushnil(L);
+    }
+    return 1;
+}
+
+// Lua: module_lua.reload(name) -> true | false, err
+static int lua_reload(lua_State *L) {
+    const char *name = luaL_checkstring(L, 1);
+    lua_getglobal(L, "package");
+    lua_getfield(L, -1, "searchpath");
+    lua_pushvalue(L, 1);
+    lua_getfield(L, -3, "path");
+    lua_call(L, 2, 2);
+    if (!lua_isstring(L, -2)) {
+        lua_pushboolean(L, 0);
+        lua_insert(L, -2);
+        return 2;
+    }
+    if (!reload_module(L, name, lua_tostring(L, -2))) {
+        lua_pushboolean(L, 0);
+        lua_insert(L, -2);
+        return 2;
+    }
+    lua_pushboolean(L, 1);
+    return 1;
+}
+
+// Lua: module_lua.state(name, [init]) -> table
+// Table that survives hot reloads: the first call stores init (or a new table),
+// later calls return the same table. Keep GL handles and game state here.
+static int lua_state(lua_State *L) {
+    luaL_checkstring(L, 1);
+    lua_settop(L, 2);
+    if (lua_getfield(L, LUA_REGISTRYINDEX, RELOAD_STATE_KEY) != LUA_TTABLE) {
+        lua_pop(L, 1);
+        lua_newtable(L);
+        lua_pushvalue(L, -1);
+        lua_setfield(L, LUA_REGISTRYINDEX, RELOAD_STATE_KEY);
+    }
+    lua_pushvalue(L, 1);
+    if (lua_rawget(L, -2) == LUA_TTABLE) {
+        return 1;
+    }
+    lua_pop(L, 1);
+    if (lua_istable(L, 2)) lua_pushvalue(L, 2);
+    else lua_newtable(L);
+    lua_pushvalue(L, 1);
+    lua_pushvalue(L, -2);
+    lua_rawset(L, -4);
+    return 1;
+}
+
+//===============================================
+// sampling profiler
+//===============================================
+
+#define SAMPLER_MAX_FUNCS 4096              // power of two
+#define SAMPLER_MAX_STACKS 16384            // power of two
+#define SAMPLER_STACK_IDS (SAMPLER_MAX_STACKS * 16)
+#define SAMPLER_NAME_BYTES (256 * 1024)
+#define SAMPLER_MAX_DEPTH 128
+
+typedef struct {
+    Uint64 key;                 // hash of source, line and (for C functions) name, 0 = free
+    const char *name;           // "name (source:line)", in the name arena
+    Uint64 self;                // samples with this function on top
+    Uint64 total;               // samples with this function anywhere on the stack
+    Uint64 last_sample;         // counts recursive functions once per sample
+} sampler_func;
+
+typedef struct {
+    Uint64 hash;
+    Uint32 offset;              // into stack_ids, leaf first
+    Uint32 depth;
+    Uint64 count;               // 0 = free
+} sampler_stack;
+
+// Everything the hook touches is allocated in profile_start, the hook itself
+// only hashes and counts. Samples that do not fit are counted as dropped.
+static struct {
+    int running;
+    int count;                  // instructions between hook calls
+    int max_depth;
+    SDL_TimerID timer;          // timer mode: the hook samples once per tick
+    SDL_AtomicInt tick;
+    sampler_func *funcs;
+    int func_count;
+    sampler_stack *stacks;
+    Uint32 *stack_ids;
+    Uint32 stack_ids_used;
+    char *names;
+    size_t names_used;
+    Uint64 samples;
+    Uint64 dropped;
+    lua_State *L;
+} g_sampler;
+
+static Uint64 sampler_hash(Uint64 h, const void *data, size_t size) {
+    const Uint8 *p = (const Uint8 *)data;
+    for (size_t i = 0; i < size; i++) {
+        h ^= p[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+// Helper: Copy a frame name into the arena, ';' would split it in collapsed stacks
+static const char *sampler_store_name(const lua_Debug *ar) {
+    char name[256];
+    const char *fn = ar->name ? ar->name : (*ar->what == 'm' ? "main chunk" : "?");
+    if (*ar->what == 'C') SDL_snprintf(name, sizeof(name), "%s [C]", fn);
+    else SDL_snprintf(name, sizeof(name), "%s (%s:%d)", fn, ar->short_src, ar->linedefined);
+    size_t len = SDL_strlen(name) + 1;
+    if (g_sampler.names_used + len > SAMPLER_NAME_BYTES) return "?";
+    char *out = g_sampler.names + g_sampler.names_used;
+    for (size_t i = 0; i < len; i++) {
+        out[i] = name[i] == ';' ? ':' : name[i];
+    }
+    g_sampler.names_used += len;
+    return out;
+}
+
+// Helper: Id of the function of frame ar, SAMPLER_MAX_FUNCS when the table is full
+static Uint32 sampler_intern(const lua_Debug *ar) {
+    Uint64 key = sampler_hash(0xcbf29ce484222325ULL, ar->short_src, SDL_strlen(ar->short_src));
+    key = sampler_hash(key, &ar->linedefined, sizeof(ar->linedefined));
+    if (*ar->what == 'C' && ar->name) {
+        key = sampler_hash(key, ar->name, SDL_strlen(ar->name));
+    }
+    if (key == 0) key = 1;
+    Uint32 mask = SAMPLER_MAX_FUNCS - 1;
+    for (Uint32 i = (Uint32)key & mask, n = 0; n < SAMPLER_MAX_FUNCS; i = (i + 1) & mask, n++) {
+        sampler_func *f = &g_sampler.funcs[i];
+        if (f->key == key) return i;
+        if (f->key == 0) {
+            // Keep the table at most 3/4 full so probes stay short
+            if (g_sampler.func_count >= SAMPLER_MAX_FUNCS / 4 * 3) break;
+            f->key = key;
+            f->name = sampler_store_name(ar);
+            g_sampler.func_count++;
+            return i;
+        }
+    }
+    return SAMPLER_MAX_FUNCS;
+}
+
+static int sampler_add_stack(const Uint32 *ids, int depth) {
+    Uint64 hash = sampler_hash(0xcbf29ce484222325ULL, ids, depth * sizeof(Uint32));
+    Uint32 mask = SAMPLER_MAX_STACKS - 1;
+    for (Uint32 i = (Uint32)hash & mask, n = 0; n < SAMPLER_MAX_STACKS; i = (i + 1) & mask, n++) {
+        sampler_stack *st = &g_sampler.stacks[i];
+        if (st->count == 0) {
+            if (g_sampler.stack_ids_used + depth > SAMPLER_STACK_IDS) return 0;
+            st->hash = hash;
+            st->offset = g_sampler.stack_ids_used;
+            st->depth = (Uint32)depth;
+            SDL_memcpy(g_sampler.stack_ids + st->offset, ids, depth * sizeof(Uint32));
+            g_sampler.stack_ids_used += depth;
+            st->count = 1;
+            return 1;
+        }
+        if (st->hash == hash && st->depth == (Uint32)depth &&
+            SDL_memcmp(g_sampler.stack_ids + st->offset, ids, depth * sizeof(Uint32)) == 0) {
+            st->count++;
+            return 1;
+        }
+    }
     return 0;
 }
 
+static void sampler_hook(lua_State *L, lua_Debug *ar) {
+    // Coroutines created while profiling inherited the hook; drop it after stop
+    if (!g_sampler.running) {
+        lua_sethook(L, NULL, 0, 0);
+        return;
+    }
+    if (g_sampler.timer && !SDL_CompareAndSwapAtomicInt(&g_sampler.tick, 1, 0)) {
+        return;
+    }
+    Uint32 ids[SAMPLER_MAX_DEPTH];
+    int depth = 0;
+    lua_Debug frame;
+    for (int level = 0; depth < g_sampler.max_depth && lua_getstack(L, level, &frame); level++) {
+        lua_getinfo(L, "Sn", &frame);
+        Uint32 id = sampler_intern(&frame);
+        if (id == SAMPLER_MAX_FUNCS) {
+            g_sampler.dropped++;
+            return;
+        }
+        ids[depth++] = id;
+    }
+    if (depth == 0) return;
+
+    Uint64 sample = ++g_sampler.samples;
+    g_sampler.funcs[ids[0]].self++;
+    for (int i = 0; i < depth; i++) {
+        sampler_func *f = &g_sampler.funcs[ids[i]];
+        if (f->last_sample != sample) {
+            f->last_sample = sample;
+            f->total++;
+        }
+    }
+    if (!sampler_add_stack(ids, depth)) {
+        g_sampler.dropped++;
+    }
+}
+
+static Uint64 SDLCALL sampler_timer(void *userdata, SDL_TimerID timer_id, Uint64 interval) {
+    SDL_SetAtomicInt(&g_sampler.tick, 1);
+    return interval;
+}
+
+static void sampler_stop(void) {
+    if (!g_sampler.running) return;
+    if (g_sampler.timer) {
+        SDL_RemoveTimer(g_sampler.timer);
+        g_sampler.timer = 0;
+    }
+    lua_sethook(g_sampler.L, NULL, 0, 0);
+    g_sampler.running = 0;
+}
+
+static void sampler_free(void) {
+    sampler_stop();
+    SDL_free(g_sampler.funcs);
+    SDL_free(g_sampler.stacks);
+    SDL_free(g_sampler.stack_ids);
+    SDL_free(g_sampler.names);
+    SDL_zero(g_sampler);
+}
+
+// Lua: module_lua.profile_start([{interval_us=1000, count=1000, max_depth=64}]) -> true | nil, err
+// interval_us > 0 samples once per interval (checked every count instructions),
+// interval_us = 0 samples every count instructions. Clears earlier samples.
+static int lua_profile_start(lua_State *L) {
+    lua_Integer interval_us = 1000, count = 1000, max_depth = 64;
+    if (lua_istable(L, 1)) {
+        lua_getfield(L, 1, "interval_us");
+        interval_us = luaL_optinteger(L, -1, interval_us);
+        lua_getfield(L, 1, "count");
+        count = luaL_optinteger(L, -1, count);
+        lua_getfield(L, 1, "max_depth");
+        max_depth = luaL_optinteger(L, -1, max_depth);
+        lua_pop(L, 3);
+    }
+    luaL_argcheck(L, interval_us >= 0 && count > 0, 1, "interval_us must be >= 0 and count > 0");
+    luaL_argcheck(L, max_depth > 0 && max_depth <= SAMPLER_MAX_DEPTH, 1, "max_depth out of range");
+
+    sampler_free();
+    g_sampler.funcs = (sampler_func *)SDL_calloc(SAMPLER_MAX_FUNCS, sizeof(sampler_func));
+    g_sampler.stacks = (sampler_stack *)SDL_calloc(SAMPLER_MAX_STACKS, sizeof(sampler_stack));
+    g_sampler.stack_ids = (Uint32 *)SDL_malloc(SAMPLER_STACK_IDS * sizeof(Uint32));
+    g_sampler.names = (char *)SDL_malloc(SAMPLER_NAME_BYTES);
+    if (!g_sampler.funcs || !g_sampler.stacks || !g_sampler.stack_ids || !g_sampler.names) {
+        sampler_free();
+        lua_pushnil(L);
+        lua_pushstring(L, "Out of memory");
+        return 2;
+    }
+    g_sampler.count = (int)count;
+    g_sampler.max_depth = (int)max_depth;
+    if (interval_us > 0) {
+        g_sampler.timer = SDL_AddTimerNS((Uint64)interval_us * SDL_NS_PER_US, sampler_timer, NULL);
+        if (!g_sampler.timer) {
+            sampler_free();
+            lua_pushnil(L);
+            lua_pushstring(L, SDL_GetError());
+            return 2;
+        }
+    }
+    // Hooks are per thread: the main thread is hooked here, coroutines created
+    // from now on inherit the hook of their creator, and lua_util tasks are hooked
+    // when the scheduler resumes them. Coroutines created earlier outside the
+    // scheduler (e.g. coroutine.wrap iterators) are not sampled.
+    lua_rawgeti(L, LUA_REGISTRYINDEX, LUA_RIDX_MAINTHREAD);
+    g_sampler.L = lua_tothread(L, -1);
+    lua_pop(L, 1);
+    lua_sethook(g_sampler.L, sampler_hook, LUA_MASKCOUNT, g_sampler.count);
+    g_sampler.running = 1;
+    lua_pushboolean(L, 1);
+    return 1;
+}
+
+// Lua: module_lua.profile_stop() -> samples, dropped
+// Stops sampling, the samples stay available for profile_top and profile_export.
+static int lua_profile_stop(lua_State *L) {
+    sampler_stop();
+    lua_pushinteger(L, (lua_Integer)g_sampler.samples);
+    lua_pushinteger(L, (lua_Integer)g_sampler.dropped);
+    return 2;
+}
+
+// Lua: module_lua.profile_clear()
+// Resets the counts, e.g. once per second for a live view of the recent frames.
+static int lua_profile_clear(lua_State *L) {
+    if (!g_sampler.funcs) return 0;
+    for (int i = 0; i < SAMPLER_MAX_FUNCS; i++) {
+        g_sampler.funcs[i].self = 0;
+        g_sampler.funcs[i].total = 0;
+        g_sampler.funcs[i].last_sample = 0;
+    }
+    SDL_memset(g_sampler.stacks, 0, SAMPLER_MAX_STACKS * sizeof(sampler_stack));
+    g_sampler.stack_ids_used = 0;
+    g_sampler.samples = 0;
+    g_sampler.dropped = 0;
+    return 0;
+}
+
+static int sampler_compare_self(const void *a, const void *b) {
+    const sampler_func *fa = &g_sampler.funcs[*(const int *)a];
+    const sampler_func *fb = &g_sampler.funcs[*(const int *)b];
+    if (fa->self != fb->self) return fa->self < fb->self ? 1 : -1;
+    if (fa->total != fb->total) return fa->total < fb->total ? 1 : -1;
+    return 0;
+}
+
+// Lua: module_lua.profile_top([n=20], [t]) -> t
+// The n functions with the most self samples: {name, self, total, self_pct, total_pct}.
+// Passing the same table each call reuses its entries.
+static int lua_profile_top(lua_State *L) {
+    int n = (int)luaL_optinteger(L, 1, 20);
+    if (lua_istable(L, 2)) {
+        lua_settop(L, 2);
+    } else {
+        lua_settop(L, 1);
+        lua_createtable(L, n > 0 ? n : 0, 0);
+    }
+    int found = 0;
+    int *order = NULL;
+    if (g_sampler.funcs && n > 0) {
+        order = (int *)SDL_malloc(SAMPLER_MAX_FUNCS * sizeof(int));
+    }
+    if (order) {
+        for (int i = 0; i < SAMPLER_MAX_FUNCS; i++) {
+            if (g_sampler.funcs[i].self > 0 || g_sampler.funcs[i].total > 0) order[found++] = i;
+        }
+        SDL_qsort(order, found, sizeof(int), sampler_compare_self);
+        if (found > n) found = n;
+    }
+    double scale = g_sampler.samples ? 100.0 / (double)g_sampler.samples : 0.0;
+    for (int i = 0; i < found; i++) {
+        const sampler_func *f = &g_sampler.funcs[order[i]];
+        if (lua_rawgeti(L, 2, i + 1) != LUA_TTABLE) {
+            lua_pop(L, 1);
+            lua_createtable(L, 0, 5);
+            lua_pushvalue(L, -1);
+            lua_rawseti(L, 2, i + 1);
+        }
+        lua_pushstring(L, f->name);
+        lua_setfield(L, -2, "name");
+        lua_pushinteger(L, (lua_Integer)f->self);
+        lua_setfield(L, -2, "self");
+        lua_pushinteger(L, (lua_Integer)f->total);
+        lua_setfield(L, -2, "total");
+        lua_pushnumber(L, f->self * scale);
+        lua_setfield(L, -2, "self_pct");
+        lua_pushnumber(L, f->total * scale);
+        lua_setfield(L, -2, "total_pct");
+        lua_pop(L, 1);
+    }
+    SDL_free(order);
+    // Trim stale entries from a reused table
+    for (lua_Integer i = found + 1; lua_rawgeti(L, 2, i) != LUA_TNIL; i++) {
+        lua_pop(L, 1);
+        lua_pushnil(L);
+        lua_rawseti(L, 2, i);
+    }
+    lua_pop(L, 1);
+    return 1;
+}
+
+// Lua: module_lua.profile_export(path) -> true | nil, err
+// Writes collapsed stacks ("outer;inner;leaf count" per line), the input of
+// flamegraph.pl, speedscope and inferno.
+static int lua_profile_export(lua_State *L) {
+    const char *path = luaL_checkstring(L, 1);
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        lua_pushnil(L);
+        lua_pushfstring(L, "Could not open '%s' for writing", path);
+        return 2;
+    }
+    for (int i = 0; g_sampler.stacks && i < SAMPLER_MAX_STACKS; i++) {
+        const sampler_stack *st = &g_sampler.stacks[i];
+        if (st->count == 0) continue;
+        const Uint32 *ids = g_sampler.stack_ids + st->offset;
+        for (int d = (int)st->depth - 1; d >= 0; d--) {
+            fputs(g_sampler.funcs[ids[d]].name, f);
+            if (d > 0) fputc(';', f);
+        }
+        fprintf(f, " %llu\n", (unsigned long long)st->count);
+    }
+    if (fclose(f) != 0) {
+        lua_pushnil(L);
+        lua_pushfstring(L, "Error writing '%s'", path);
+        return 2;
+    }
+    lua_pushboolean(L, 1);
+    return 1;
+}
+
+//===============================================
+// task scheduler
+//===============================================
+
+#define TASKS_KEY "lua_util.tasks"              // ref -> thread
+#define TASK_IDS_KEY "lua_util.task_ids"        // thread -> ref
+#define TASK_WAITERS_KEY "lua_util.task_waiters" // await key -> {ref, ...}
+#define TASK_VALUES_KEY "lua_util.task_values"  // ref -> value for the next resume
+
+enum { WAKE_START, WAKE_NEXT, WAKE_TIMER, WAKE_LOAD, WAKE_VALUE, WAKE_FENCE };
+
+typedef struct {
+    int ref;
+    int kind;
+    int nargs;                  // WAKE_START: arguments already on the task's stack
+    int ok;                     // WAKE_LOAD, WAKE_FENCE
+    void *data;                 // WAKE_LOAD: file contents, owned until resumed
+    size_t size;
+} task_wake;
+
+typedef struct {
+    Uint64 due_ns;
+    int ref;
+} task_timer;
+
+typedef struct {
+    void *sync;
+    int ref;
+} task_fence;
+
+// Suspended tasks sit in a timer heap, on the async IO queue, in a fence list or
+// in a waiter list; only tasks whose condition completed reach the ready list,
+// so a tick costs O(ready + expired timers + fences), not O(tasks).
+static struct {
+    task_wake *ready, *running;
+    int ready_count, ready_capacity, running_capacity;
+    task_timer *timers;         // binary min-heap on due_ns
+    int timer_count, timer_capacity;
+    task_fence *fences;
+    int fence_count, fence_capacity;
+    SDL_AsyncIOQueue *io;
+    int io_pending;
+    int task_count;
+    int ticking;
+    int registered;             // set by the await functions before yielding
+} g_tasks;
+
+// Helper: Grow a scheduler array to hold one more element
+static void *tasks_grow(lua_State *L, void *array, int count, int *capacity, size_t elem) {
+    if (count < *capacity) return array;
+    int new_capacity = *capacity ? *capacity * 2 : 64;
+    void *grown = SDL_realloc(array, (size_t)new_capacity * elem);
+    if (!grown) luaL_error(L, "out of memory");
+    *capacity = new_capacity;
+    return grown;
+}
+
+static void tasks_push_ready(lua_State *L, task_wake wake) {
+    g_tasks.ready = (task_wake *)tasks_grow(L, g_tasks.ready, g_tasks.ready_count, &g_tasks.ready_capacity, sizeof(task_wake));
+    g_tasks.ready[g_tasks.ready_count++] = wake;
+}
+
+static void timer_push(lua_State *L, Uint64 due_ns, int ref) {
+    g_tasks.timers = (task_timer *)tasks_grow(L, g_tasks.timers, g_tasks.timer_count, &g_tasks.timer_capacity, sizeof(task_timer));
+    int i = g_tasks.timer_count++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (g_tasks.timers[parent].due_ns <= due_ns) break;
+        g_tasks.timers[i] = g_tasks.timers[parent];
+        i = parent;
+    }
+    g_tasks.timers[i].due_ns = due_ns;
+    g_tasks.timers[i].ref = ref;
+}
+
+static task_timer timer_pop(void) {
+    task_timer top = g_tasks.timers[0];
+    task_timer last = g_tasks.timers[--g_tasks.timer_count];
+    int n = g_tasks.timer_count, i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= n) break;
+        if (child + 1 < n && g_tasks.timers[child + 1].due_ns < g_tasks.timers[child].due_ns) child++;
+        if (last.due_ns <= g_tasks.timers[child].due_ns) break;
+        g_tasks.timers[i] = g_tasks.timers[child];
+        i = child;
+    }
+    if (n > 0) g_tasks.timers[i] = last;
+    return top;
+}
+
+// Helper: Push registry table key, creating it on first use
+static void tasks_registry_table(lua_State *L, const char *key) {
+    if (lua_getfield(L, LUA_REGISTRYINDEX, key) != LUA_TTABLE) {
+        lua_pop(L, 1);
+        lua_newtable(L);
+        lua_pushvalue(L, -1);
+        lua_setfield(L, LUA_REGISTRYINDEX, key);
+    }
+}
+
+// Helper: Ref of the running task, raises outside a task or where the task
+// cannot yield. Callers register their wake afterwards, so a failed yield never
+// leaves a stale entry that would resume the task later with the wrong values.
+static int current_task(lua_State *L, const char *fn) {
+    tasks_registry_table(L, TASK_IDS_KEY);
+    lua_pushthread(L);
+    lua_rawget(L, -2);
+    int ref = lua_isinteger(L, -1) ? (int)lua_tointeger(L, -1) : LUA_NOREF;
+    lua_pop(L, 2);
+    if (ref == LUA_NOREF) {
+        return luaL_error(L, "lua_util.%s must be called from a task started with lua_util.spawn", fn);
+    }
+    if (!lua_isyieldable(L)) {
+        return luaL_error(L, "lua_util.%s cannot suspend the task here (inside a metamethod or a C call "
+                             "such as a table.sort comparator)", fn);
+    }
+    return ref;
+}
+
+// Helper: Yield the running task, the scheduler resumes it when its wait completes
+static int task_suspend(lua_State *L) {
+    g_tasks.registered = 1;
+    return lua_yield(L, 0);
+}
+
+// Lua: module_lua.spawn(fn, ...) -> task
+// Runs fn(...) as a task, starting at the next scheduler tick.
+static int lua_spawn(lua_State *L) {
+    luaL_checktype(L, 1, LUA_TFUNCTION);
+    int nargs = lua_gettop(L) - 1;
+    lua_State *co = lua_newthread(L);
+    lua_insert(L, 1);
+    lua_xmove(L, co, nargs + 1);
+
+    tasks_registry_table(L, TASKS_KEY);
+    lua_pushvalue(L, 1);
+    int ref = luaL_ref(L, -2);
+    lua_pop(L, 1);
+    tasks_registry_table(L, TASK_IDS_KEY);
+    lua_pushvalue(L, 1);
+    lua_pushinteger(L, ref);
+    lua_rawset(L, -3);
+    lua_pop(L, 1);
+
+    task_wake wake = {ref, WAKE_START, nargs, 0, NULL, 0};
+    tasks_push_ready(L, wake);
+    g_tasks.task_count++;
+    lua_settop(L, 1);
+    return 1;
+}
+
+// Lua: module_lua.sleep(seconds) -- inside a task
+static int lua_sleep(lua_State *L) {
+    double seconds = luaL_checknumber(L, 1);
+    int ref = current_task(L, "sleep");
+    Uint64 delay = seconds > 0.0 ? (Uint64)(seconds * 1e9) : 0;
+    timer_push(L, SDL_GetTicksNS() + delay, ref);
+    return task_suspend(L);
+}
+
+// Lua: module_lua.yield() -- inside a task, resumes at the next tick
+static int lua_task_yield(lua_State *L) {
+    int ref = current_task(L, "yield");
+    task_wake wake = {ref, WAKE_NEXT, 0, 0, NULL, 0};
+    tasks_push_ready(L, wake);
+    return task_suspend(L);
+}
+
+// Lua: module_lua.await_load(path) -> sdl.buffer | nil, err -- inside a task
+// Files in a mounted asset pack are copied out of the mapping without I/O.
+static int lua_await_load(lua_State *L) {
+    const char *path = luaL_checkstring(L, 1);
+    int ref = current_task(L, "await_load");
+    if (asset_pack_contains(path)) {
+        size_t size = 0;
+        void *data = asset_pack_load_file(path, &size);
+        task_wake wake = {ref, WAKE_LOAD, 0, data != NULL, data, size};
+        tasks_push_ready(L, wake);
+        return task_suspend(L);
+    }
+    if (!g_tasks.io) {
+        g_tasks.io = SDL_CreateAsyncIOQueue();
+        if (!g_tasks.io) {
+            lua_pushnil(L);
+            lua_pushstring(L, SDL_GetError());
+            return 2;
+        }
+    }
+    if (!SDL_LoadFileAsync(path, g_tasks.io, (void *)(intptr_t)ref)) {
+        lua_pushnil(L);
+        lua_pushstring(L, SDL_GetError());
+        return 2;
+    }
+    g_tasks.io_pending++;
+    return task_suspend(L);
+}
+
+// Lua: module_lua.await_fence(sync) -> bool -- inside a task, false if the wait failed
+static int lua_await_fence(lua_State *L) {
+    luaL_checktype(L, 1, LUA_TLIGHTUSERDATA);
+    int ref = current_task(L, "await_fence");
+    g_tasks.fences = (task_fence *)tasks_grow(L, g_tasks.fences, g_tasks.fence_count, &g_tasks.fence_capacity, sizeof(task_fence));
+    g_tasks.fences[g_tasks.fence_count].sync = lua_touserdata(L, 1);
+    g_tasks.fences[g_tasks.fence_count].ref = ref;
+    g_tasks.fence_count++;
+    return task_suspend(L);
+}
+
+// Lua: module_lua.await(key) -> value -- inside a task, until lua_util.signal(key, value)
+static int lua_await(lua_State *L) {
+    luaL_checkany(L, 1);
+    luaL_argcheck(L, !lua_isnil(L, 1), 1, "key must not be nil");
+    int ref = current_task(L, "await");
+    tasks_registry_table(L, TASK_WAITERS_KEY);
+    lua_pushvalue(L, 1);
+    if (lua_rawget(L, -2) != LUA_TTABLE) {
+        lua_pop(L, 1);
+        lua_newtable(L);
+        lua_pushvalue(L, 1);
+        lua_pushvalue(L, -2);
+        lua_rawset(L, -4);
+    }
+    lua_pushinteger(L, ref);
+    lua_rawseti(L, -2, (lua_Integer)lua_rawlen(L, -2) + 1);
+    lua_pop(L, 2);
+    return task_suspend(L);
+}
+
+int module_lua_tasks_signal(lua_State *L, int key_idx, int value_idx) {
+    // The scheduler belongs to the main state; workers (enet host_service in a job) have no tasks
+    if (lua_modules_kind(L) != LUA_MODULES_MAIN) return 0;
+    key_idx = lua_absindex(L, key_idx);
+    value_idx = lua_absindex(L, value_idx);
+    if (lua_isnil(L, key_idx) || lua_getfield(L, LUA_REGISTRYINDEX, TASK_WAITERS_KEY) != LUA_TTABLE) {
+        if (!lua_isnil(L, key_idx)) lua_pop(L, 1);
+        return 0;
+    }
+    int waiters = lua_gettop(L);
+    lua_pushvalue(L, key_idx);
+    if (lua_rawget(L, waiters) != LUA_TTABLE) {
+        lua_pop(L, 2);
+        return 0;
+    }
+    // Detach the list first, a woken task may wait on the same key again
+    lua_pushvalue(L, key_idx);
+    lua_pushnil(L);
+    lua_rawset(L, waiters);
+    tasks_registry_table(L, TASK_VALUES_KEY);
+    int n = (int)lua_rawlen(L, -2);
+    for (int i = 1; i <= n; i++) {
+        lua_rawgeti(L, -2, i);
+        int ref = (int)lua_tointeger(L, -1);
+        lua_pop(L, 1);
+        lua_pushvalue(L, value_idx);
+        lua_rawseti(L, -2, ref);
+        task_wake wake = {ref, WAKE_VALUE, 0, 0, NULL, 0};
+        tasks_push_ready(L, wake);
+    }
+    lua_pop(L, 3);
+    return n;
+}
+
+// Lua: module_lua.signal(key, [value]) -> woken
+// Wakes every task in lua_util.await(key); they resume at the next tick with value.
+static int lua_signal(lua_State *L) {
+    luaL_checkany(L, 1);
+    lua_settop(L, 2);
+    lua_pushinteger(L, module_lua_tasks_signal(L, 1, 2));
+    return 1;
+}
+
+// Helper: Drop a finished task
+static void task_release(lua_State *L, lua_State *co, int ref) {
+    tasks_registry_table(L, TASK_IDS_KEY);
+    lua_pushthread(co);
+    lua_xmove(co, L, 1);
+    lua_pushnil(L);
+    lua_rawset(L, -3);
+    lua_pop(L, 1);
+    tasks_registry_table(L, TASKS_KEY);
+    luaL_unref(L, -1, ref);
+    lua_pop(L, 1);
+    g_tasks.task_count--;
+}
+
+static void task_resume(lua_State *L, const task_wake *wake) {
+    tasks_registry_table(L, TASKS_KEY);
+    lua_rawgeti(L, -1, wake->ref);
+    lua_State *co = lua_tothread(L, -1);
+    lua_pop(L, 2);                  // the thread stays referenced by the tasks table
+    if (!co) {
+        SDL_free(wake->data);
+        return;
+    }
+
+    int nargs = 0;
+    switch (wake->kind) {
+    case WAKE_START:
+        nargs = wake->nargs;
+        break;
+    case WAKE_LOAD:
+        if (wake->ok) {
+            module_sdl_push_buffer(co, wake->data, wake->size);
+            nargs = 1;
+        } else {
+            SDL_free(wake->data);
+            lua_pushnil(co);
+            lua_pushstring(co, "async load failed");
+            nargs = 2;
+        }
+        break;
+    case WAKE_FENCE:
+        lua_pushboolean(co, wake->ok);
+        nargs = 1;
+        break;
+    case WAKE_VALUE:
+        tasks_registry_table(L, TASK_VALUES_KEY);
+        lua_rawgeti(L, -1, wake->ref);
+        lua_xmove(L, co, 1);
+        lua_pushnil(L);
+        lua_rawseti(L, -2, wake->ref);
+        lua_pop(L, 1);
+        nargs = 1;
+        break;
+    default:
+        break;
+    }
+
+    // Tasks spawned before profile_start have no hook of their own
+    if (g_sampler.running && lua_gethook(co) != sampler_hook) {
+        lua_sethook(co, sampler_hook, LUA_MASKCOUNT, g_sampler.count);
+    }
+    g_tasks.registered = 0;
+    int nres = 0;
+    int status = lua_resume(co, L, nargs, &nres);
+    if (status == LUA_YIELD) {
+        lua_pop(co, nres);
+        // A plain coroutine.yield() in the task body: run again next tick
+        if (!g_tasks.registered) {
+            task_wake next = {wake->ref, WAKE_NEXT, 0, 0, NULL, 0};
+            tasks_push_ready(L, next);
+        }
+        return;
+    }
+    if (status != LUA_OK) {
+        luaL_traceback(L, co, lua_tostring(co, -1), 0);
+        APP_LOG(APP_LOG_CAT_LUA, APP_LOG_ERROR, "[task] %s", lua_tostring(L, -1));
+        lua_pop(L, 1);
+    }
+    task_release(L, co, wake->ref);
+}
+
+int module_lua_tasks_tick(lua_State *L) {
+    if (lua_modules_kind(L) != LUA_MODULES_MAIN) return 0;
+    if (g_tasks.ticking || g_tasks.task_count == 0) return 0;
+    g_tasks.ticking = 1;
+    PROF_BEGIN("lua_util tasks");
+
+    Uint64 now = SDL_GetTicksNS();
+    while (g_tasks.timer_count > 0 && g_tasks.timers[0].due_ns <= now) {
+        task_timer t = timer_pop();
+        task_wake wake = {t.ref, WAKE_TIMER, 0, 0, NULL, 0};
+        tasks_push_ready(L, wake);
+    }
+    SDL_AsyncIOOutcome outcome;
+    while (g_tasks.io_pending > 0 && SDL_GetAsyncIOResult(g_tasks.io, &outcome)) {
+        g_tasks.io_pending--;
+        task_wake wake = {(int)(intptr_t)outcome.userdata, WAKE_LOAD, 0,
+                          outcome.result == SDL_ASYNCIO_COMPLETE, outcome.buffer, (size_t)outcome.bytes_transferred};
+        tasks_push_ready(L, wake);
+    }
+    for (int i = 0; i < g_tasks.fence_count;) {
+        int status = module_gl_sync_status(g_tasks.fences[i].sync);
+        if (status == 0) {
+            i++;
+            continue;
+        }
+        task_wake wake = {g_tasks.fences[i].ref, WAKE_FENCE, 0, status > 0, NULL, 0};
+        tasks_push_ready(L, wake);
+        g_tasks.fences[i] = g_tasks.fences[--g_tasks.fence_count];
+    }
+
+    // Tasks woken while this batch runs wait for the next tick
+    task_wake *batch = g_tasks.ready;
+    int count = g_tasks.ready_count;
+    int batch_capacity = g_tasks.ready_capacity;
+    g_tasks.ready = g_tasks.running;
+    g_tasks.ready_capacity = g_tasks.running_capacity;
+    g_tasks.ready_count = 0;
+    g_tasks.running = batch;
+    g_tasks.running_capacity = batch_capacity;
+    for (int i = 0; i < count; i++) {
+        task_resume(L, &batch[i]);
+    }
+
+    PROF_END();
+    g_tasks.ticking = 0;
+    return count;
+}
+
+// Lua: module_lua.run_tasks() -> resumed
+// One scheduler tick, for scripts with their own loop (sdl.run ticks every frame).
+static int lua_run_tasks(lua_State *L) {
+    lua_pushinteger(L, module_lua_tasks_tick(L));
+    return 1;
+}
+
+// Lua: module_lua.task_stats() -> table
+static int lua_task_stats(lua_State *L) {
+    lua_createtable(L, 0, 5);
+    lua_pushinteger(L, g_tasks.task_count);
+    lua_setfield(L, -2, "tasks");
+    lua_pushinteger(L, g_tasks.ready_count);
+    lua_setfield(L, -2, "ready");
+    lua_pushinteger(L, g_tasks.timer_count);
+    lua_setfield(L, -2, "sleeping");
+    lua_pushinteger(L, g_tasks.io_pending);
+    lua_setfield(L, -2, "loading");
+    lua_pushinteger(L, g_tasks.fence_count);
+    lua_setfield(L, -2, "fences");
+    return 1;
+}
+
 static const struct luaL_Reg lua_util_lib[] = {
     {"path_exists", lua_path_exists},
     {"log", lua_log},
+    {"logf", lua_logf},
+    {"log_enabled", lua_log_enabled},
+    {"log_category", lua_log_category},
+    {"log_level", lua_log_level},
+    {"log_rate", lua_log_rate},
+    {"log_file", lua_log_file},
+    {"log_flush", lua_log_flush},
+    {"log_stats", lua_log_stats},
+    {"mem_stats", lua_mem_stats},
+    {"blob", lua_blob_new},
+    {"load_asset", lua_load_asset},
+    {"pack_mount", lua_pack_mount},
+    {"state", lua_state},
+    {NULL, NULL}
+};
+
+// GC pacing, hot reload, the sampler and the task scheduler keep process-wide
+// state that belongs to the main state, so job workers do not get them
+static const struct luaL_Reg lua_util_main_lib[] = {
+    {"gc_frame_budget", lua_gc_frame_budget},
+    {"gc_step", lua_gc_step},
+    {"gc_mode", lua_gc_mode},
+    {"gc_stats", lua_gc_stats},
+    {"gc_get_pause_history", lua_gc_get_pause_history},
+    {"hot_reload", lua_hot_reload},
+    {"reload_poll", lua_reload_poll},
+    {"reload", lua_reload},
+    {"profile_start", lua_profile_start},
+    {"profile_stop", lua_profile_stop},
+    {"profile_clear", lua_profile_clear},
+    {"profile_top", lua_profile_top},
+    {"profile_export", lua_profile_export},
+    {"spawn", lua_spawn},
+    {"sleep", lua_sleep},
+    {"yield", lua_task_yield},
+    {"await_load", lua_await_load},
+    {"await_fence", lua_await_fence},
+    {"await", lua_await},
+    {"signal", lua_signal},
+    {"run_tasks", lua_run_tasks},
+    {"task_stats", lua_task_stats},
     {NULL, NULL}
 };
 
 int luaopen_module_lua(lua_State *L) {
     luaL_newlib(L, lua_util_lib);
+    if (lua_modules_kind(L) == LUA_MODULES_MAIN) luaL_setfuncs(L, lua_util_main_lib, 0);
     return 1;
 }
\ No newline at end of file
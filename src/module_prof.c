@@ -0,0 +1,279 @@
+#include "module_prof.h"
+#include <SDL3/SDL.h>
+#include <lauxlib.h>
+#include <stdio.h>
+
+// Each thread writes zone begin/end events into its own ring, so recording never
+// takes a lock: read the performance counter, store 16 bytes, publish the head.
+// The ring overwrites the oldest events, export writes whatever is still in it.
+
+#if defined(_MSC_VER)
+#define PROF_THREAD_LOCAL __declspec(thread)
+#else
+#define PROF_THREAD_LOCAL _Thread_local
+#endif
+
+#define PROF_RING_SIZE (1 << 16) // events per thread, power of two
+#define PROF_RING_MASK (PROF_RING_SIZE - 1)
+#define PROF_MAX_NAMES 4096
+#define PROF_END_MARK 0xFFFFFFFFu
+
+typedef struct {
+    Uint64 ticks;  // SDL_GetPerformanceCounter()
+    Uint32 name;   // name id, PROF_END_MARK for a zone end
+    Uint32 pad;
+} prof_event;
+
+typedef struct prof_ring {
+    struct prof_ring *next;
+    SDL_ThreadID thread_id;
+    volatile Uint32 head; // written by the owning thread only
+    prof_event events[PROF_RING_SIZE];
+} prof_ring;
+
+static void *g_rings = NULL; // prof_ring list, pushed with CAS
+static PROF_THREAD_LOCAL prof_ring *t_ring = NULL;
+static int g_enabled = 1;
+
+static const char *g_names[PROF_MAX_NAMES] = { "(unnamed)" };
+static int g_name_count = 1;
+static SDL_SpinLock g_name_lock = 0;
+
+//===============================================
+// recording
+//===============================================
+
+// Helper: Allocate the calling thread's ring and link it into the global list
+static prof_ring *prof_create_ring(void) {
+    prof_ring *ring = (prof_ring *)SDL_calloc(1, sizeof(prof_ring));
+    if (!ring) return NULL;
+    ring->thread_id = SDL_GetCurrentThreadID();
+    void *head;
+    do {
+        head = SDL_GetAtomicPointer(&g_rings);
+        ring->next = (prof_ring *)head;
+    } while (!SDL_CompareAndSwapAtomicPointer(&g_rings, head, ring));
+    return ring;
+}
+
+// Helper: Append one event to the calling thread's ring
+static inline void prof_push(Uint32 name) {
+    prof_ring *ring = t_ring;
+    if (!ring) {
+        ring = t_ring = prof_create_ring();
+        if (!ring) return;
+    }
+    Uint32 head = ring->head;
+    prof_event *ev = &ring->events[head & PROF_RING_MASK];
+    ev->ticks = SDL_GetPerformanceCounter();
+    ev->name = name;
+    SDL_MemoryBarrierRelease();
+    ring->head = head + 1;
+}
+
+// Returns an id for name, registering (and copying) it the first time
+int prof_register_name(const char *name) {
+    int id = 0;
+    SDL_LockSpinlock(&g_name_lock);
+    for (int i = 1; i < g_name_count; i++) {
+        if (SDL_strcmp(g_names[i], name) == 0) {
+            id = i;
+            break;
+        }
+    }
+    if (id == 0 && g_name_count < PROF_MAX_NAMES) {
+        char *copy = SDL_strdup(name);
+        if (copy) {
+            id = g_name_count;
+            g_names[g_name_count++] = copy;
+        }
+    }
+    SDL_UnlockSpinlock(&g_name_lock);
+    return id; // 0 = "(unnamed)" when the table is full
+}
+
+void prof_begin(int name_id) {
+    if (g_enabled) prof_push((Uint32)name_id);
+}
+
+void prof_end(void) {
+    if (g_enabled) prof_push(PROF_END_MARK);
+}
+
+//===============================================
+// export
+//===============================================
+
+// Helper: Write a JSON string body with escaping
+static void write_json_string(FILE *f, const char *s) {
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            fputc('\\', f);
+            fputc(c, f);
+        } else if (c < 0x20) {
+            fprintf(f, "\\u%04x", c);
+        } else {
+            fputc(c, f);
+        }
+    }
+}
+
+// Write every ring as Chrome trace "B"/"E" events, returns 0 on failure
+int prof_export_chrome(const char *path) {
+    FILE *f = fopen(path, "w");
+    if (!f) return 0;
+
+    double us_per_tick = 1e6 / (double)SDL_GetPerformanceFrequency();
+    prof_ring *rings = (prof_ring *)SDL_GetAtomicPointer(&g_rings);
+
+    // Base timestamps on the oldest event still recorded
+    Uint64 base = 0;
+    for (prof_ring *r = rings; r; r = r->next) {
+        Uint32 head = r->head;
+        SDL_MemoryBarrierAcquire();
+        if (head == 0) continue;
+        Uint32 n = head < PROF_RING_SIZE ? head : PROF_RING_SIZE;
+        Uint64 first = r->events[(head - n) & PROF_RING_MASK].ticks;
+        if (base == 0 || first < base) base = first;
+    }
+
+    SDL_LockSpinlock(&g_name_lock);
+    int name_count = g_name_count;
+    SDL_UnlockSpinlock(&g_name_lock);
+
+    fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    int first_event = 1;
+    for (prof_ring *r = rings; r; r = r->next) {
+        unsigned long long tid = (unsigned long long)r->thread_id;
+        fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%llu,\"args\":{\"name\":\"thread %llu\"}}",
+                first_event ? "" : ",\n", tid, tid);
+        first_event = 0;
+
+        Uint32 head = r->head;
+        SDL_MemoryBarrierAcquire();
+        Uint32 n = head < PROF_RING_SIZE ? head : PROF_RING_SIZE;
+        int depth = 0;
+        for (Uint32 i = head - n; i != head; i++) {
+            const prof_event *ev = &r->events[i & PROF_RING_MASK];
+            double ts = (double)(ev->ticks - base) * us_per_tick;
+            if (ev->name == PROF_END_MARK) {
+                // The ring may start in the middle of a zone, drop its unmatched end
+                if (depth == 0) continue;
+                depth--;
+                fprintf(f, ",\n{\"ph\":\"E\",\"pid\":1,\"tid\":%llu,\"ts\":%.3f}", tid, ts);
+            } else {
+                depth++;
+                const char *name = (int)ev->name < name_count ? g_names[ev->name] : g_names[0];
+                fprintf(f, ",\n{\"name\":\"");
+                write_json_string(f, name);
+                fprintf(f, "\",\"ph\":\"B\",\"pid\":1,\"tid\":%llu,\"ts\":%.3f}", tid, ts);
+            }
+        }
+    }
+    fprintf(f, "\n]}\n");
+    int ok = !ferror(f);
+    fclose(f);
+    return ok;
+}
+
+//===============================================
+// lua
+//===============================================
+
+// Helper: Resolve a zone name or id argument, interned names are cached in upvalue 1
+static int check_zone_id(lua_State *L, int idx) {
+    if (lua_type(L, idx) == LUA_TNUMBER) {
+        lua_Integer id = lua_tointeger(L, idx);
+        luaL_argcheck(L, id >= 0 && id < g_name_count, idx, "invalid zone id");
+        return (int)id;
+    }
+    const char *name = luaL_checkstring(L, idx);
+    lua_pushvalue(L, idx);
+    if (lua_rawget(L, lua_upvalueindex(1)) == LUA_TNUMBER) {
+        int id = (int)lua_tointeger(L, -1);
+        lua_pop(L, 1);
+        return id;
+    }
+    lua_pop(L, 1);
+    int id = prof_register_name(name);
+    lua_pushvalue(L, idx);
+    lua_pushinteger(L, id);
+    lua_rawset(L, lua_upvalueindex(1));
+    return id;
+}
+
+// Lua: prof.register(name) -> id
+static int prof_lua_register(lua_State *L) {
+    lua_pushinteger(L, check_zone_id(L, 1));
+    return 1;
+}
+
+// Lua: prof.begin(name | id)
+static int prof_lua_begin(lua_State *L) {
+    prof_begin(check_zone_id(L, 1));
+    return 0;
+}
+
+// Lua: prof.finish()
+static int prof_lua_finish(lua_State *L) {
+    prof_end();
+    return 0;
+}
+
+// Lua: prof.export(path) -> bool, err_msg
+static int prof_lua_export(lua_State *L) {
+    const char *path = luaL_checkstring(L, 1);
+    if (!prof_export_chrome(path)) {
+        lua_pushboolean(L, 0);
+        lua_pushfstring(L, "Failed to write profile: %s", path);
+        return 2;
+    }
+    lua_pushboolean(L, 1);
+    return 1;
+}
+
+// Lua: prof.clear() -- drop recorded events, call while other threads are idle
+static int prof_lua_clear(lua_State *L) {
+    for (prof_ring *r = (prof_ring *)SDL_GetAtomicPointer(&g_rings); r; r = r->next) {
+        r->head = 0;
+    }
+    return 0;
+}
+
+// Lua: prof.enable(bool)
+static int prof_lua_enable(lua_State *L) {
+    g_enabled = lua_toboolean(L, 1);
+    return 0;
+}
+
+// Lua: prof.is_enabled() -> bool
+static int prof_lua_is_enabled(lua_State *L) {
+    lua_pushboolean(L, g_enabled);
+    return 1;
+}
+
+// Lua: prof.now() -> seconds (high resolution, arbitrary origin)
+static int prof_lua_now(lua_State *L) {
+    lua_pushnumber(L, (double)SDL_GetPerformanceCounter() / (double)SDL_GetPerformanceFrequency());
+    return 1;
+}
+
+static const struct luaL_Reg prof_lib[] = {
+    {"register", prof_lua_register},
+    {"begin", prof_lua_begin},
+    {"finish", prof_lua_finish},
+    {"export", prof_lua_export},
+    {"clear", prof_lua_clear},
+    {"enable", prof_lua_enable},
+    {"is_enabled", prof_lua_is_enabled},
+    {"now", prof_lua_now},
+    {NULL, NULL}
+};
+
+int luaopen_module_prof(lua_State *L) {
+    luaL_newlibtable(L, prof_lib);
+    lua_newtable(L); // name -> id cache shared by all functions
+    luaL_setfuncs(L, prof_lib, 1);
+    return 1;
+}
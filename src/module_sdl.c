@@ -1,8 +1,91 @@
 #include "module_sdl.h"
+#include "module_gl.h"  // For module_gl_trace_frame
+#include "module_prof.h"
+#include "module_lua.h"     // For the per-frame GC budget, hot reload and task ticks
+#include "lua_alloc.h"
 #include <SDL3/SDL.h>
 #include <cimgui.h>  // For ImGui_ImplSDL3_ProcessEvent
 #include <cimgui_impl.h>
 #include <lauxlib.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Headless mode state
+static int g_headless = 0;
+static int g_headless_frames = 0;      // frames to run before pushing SDL_EVENT_QUIT
+static int g_frame_count = 0;          // frames swapped so far
+static Uint64 g_last_swap_ns = 0;
+static Uint64 *g_frame_times = NULL;   // per-frame time in ns (headless only)
+static Uint64 g_present_count = 0;     // total swaps, also the frame clock of input replay
+
+// Named scancodes outside the contiguous letter, digit and F-key ranges
+static const struct {
+    const char *name;
+    SDL_Scancode code;
+} g_scancode_names[] = {
+    {"SCANCODE_RETURN", SDL_SCANCODE_RETURN},
+    {"SCANCODE_ESCAPE", SDL_SCANCODE_ESCAPE},
+    {"SCANCODE_BACKSPACE", SDL_SCANCODE_BACKSPACE},
+    {"SCANCODE_TAB", SDL_SCANCODE_TAB},
+    {"SCANCODE_SPACE", SDL_SCANCODE_SPACE},
+    {"SCANCODE_MINUS", SDL_SCANCODE_MINUS},
+    {"SCANCODE_EQUALS", SDL_SCANCODE_EQUALS},
+    {"SCANCODE_GRAVE", SDL_SCANCODE_GRAVE},
+    {"SCANCODE_INSERT", SDL_SCANCODE_INSERT},
+    {"SCANCODE_HOME", SDL_SCANCODE_HOME},
+    {"SCANCODE_PAGEUP", SDL_SCANCODE_PAGEUP},
+    {"SCANCODE_DELETE", SDL_SCANCODE_DELETE},
+    {"SCANCODE_END", SDL_SCANCODE_END},
+    {"SCANCODE_PAGEDOWN", SDL_SCANCODE_PAGEDOWN},
+    {"SCANCODE_RIGHT", SDL_SCANCODE_RIGHT},
+    {"SCANCODE_LEFT", SDL_SCANCODE_LEFT},
+    {"SCANCODE_DOWN", SDL_SCANCODE_DOWN},
+    {"SCANCODE_UP", SDL_SCANCODE_UP},
+    {"SCANCODE_LCTRL", SDL_SCANCODE_LCTRL},
+    {"SCANCODE_LSHIFT", SDL_SCANCODE_LSHIFT},
+    {"SCANCODE_LALT", SDL_SCANCODE_LALT},
+    {"SCANCODE_LGUI", SDL_SCANCODE_LGUI},
+    {"SCANCODE_RCTRL", SDL_SCANCODE_RCTRL},
+    {"SCANCODE_RSHIFT", SDL_SCANCODE_RSHIFT},
+    {"SCANCODE_RALT", SDL_SCANCODE_RALT},
+    {"SCANCODE_RGUI", SDL_SCANCODE_RGUI},
+};
+
+// Helper: Push scancode and mouse button constants into the table on top
+static void push_input_constants(lua_State *L) {
+    char name[32];
+    // SCANCODE_A..SCANCODE_Z, SCANCODE_1..SCANCODE_0 and SCANCODE_F1..SCANCODE_F12 are contiguous
+    for (int i = 0; i < 26; i++) {
+        SDL_snprintf(name, sizeof(name), "SCANCODE_%c", 'A' + i);
+        lua_pushinteger(L, SDL_SCANCODE_A + i);
+        lua_setfield(L, -2, name);
+    }
+    for (int i = 0; i < 10; i++) {
+        SDL_snprintf(name, sizeof(name), "SCANCODE_%d", (i + 1) % 10);
+        lua_pushinteger(L, SDL_SCANCODE_1 + i);
+        lua_setfield(L, -2, name);
+    }
+    for (int i = 0; i < 12; i++) {
+        SDL_snprintf(name, sizeof(name), "SCANCODE_F%d", i + 1);
+        lua_pushinteger(L, SDL_SCANCODE_F1 + i);
+        lua_setfield(L, -2, name);
+    }
+    for (size_t i = 0; i < SDL_arraysize(g_scancode_names); i++) {
+        lua_pushinteger(L, g_scancode_names[i].code);
+        lua_setfield(L, -2, g_scancode_names[i].name);
+    }
+    // Mouse buttons
+    lua_pushinteger(L, SDL_BUTTON_LEFT);
+    lua_setfield(L, -2, "BUTTON_LEFT");
+    lua_pushinteger(L, SDL_BUTTON_MIDDLE);
+    lua_setfield(L, -2, "BUTTON_MIDDLE");
+    lua_pushinteger(L, SDL_BUTTON_RIGHT);
+    lua_setfield(L, -2, "BUTTON_RIGHT");
+    lua_pushinteger(L, SDL_BUTTON_X1);
+    lua_setfield(L, -2, "BUTTON_X1");
+    lua_pushinteger(L, SDL_BUTTON_X2);
+    lua_setfield(L, -2, "BUTTON_X2");
+}
 
 // Helper: Push event and subsystem constants table
 static void push_event_constants(lua_State *L) {
@@ -15,6 +98,16 @@ static void push_event_constants(lua_State *L) {
     lua_setfield(L, -2, "EVENT_KEY_DOWN");
     lua_pushinteger(L, SDL_EVENT_MOUSE_BUTTON_DOWN);
     lua_setfield(L, -2, "EVENT_MOUSE_BUTTON_DOWN");
+    lua_pushinteger(L, SDL_EVENT_KEY_UP);
+    lua_setfield(L, -2, "EVENT_KEY_UP");
+    lua_pushinteger(L, SDL_EVENT_MOUSE_BUTTON_UP);
+    lua_setfield(L, -2, "EVENT_MOUSE_BUTTON_UP");
+    lua_pushinteger(L, SDL_EVENT_MOUSE_MOTION);
+    lua_setfield(L, -2, "EVENT_MOUSE_MOTION");
+    lua_pushinteger(L, SDL_EVENT_MOUSE_WHEEL);
+    lua_setfield(L, -2, "EVENT_MOUSE_WHEEL");
+    lua_pushinteger(L, SDL_EVENT_TEXT_INPUT);
+    lua_setfield(L, -2, "EVENT_TEXT_INPUT");
     // Window flags
     lua_pushinteger(L, SDL_WINDOW_OPENGL);
     lua_setfield(L, -2, "WINDOW_OPENGL");
@@ -98,6 +191,11 @@ static int sdl_init_window(lua_State *L) {
     int height = (int)luaL_checkinteger(L, 3);
     Uint32 flags = (Uint32)luaL_checkinteger(L, 4);
 
+    // Never show a window in headless mode
+    if (g_headless) {
+        flags |= SDL_WINDOW_HIDDEN;
+    }
+
     if (flags & SDL_WINDOW_OPENGL) {
         SDL_GL_ResetAttributes();
         const struct { SDL_GLAttr attr; const char *name; int value; } attrs[] = {
@@ -142,80 +240,590 @@ static int sdl_init_window(lua_State *L) {
     return 1;
 }
 
-// Lua: sdl.poll_events() -> table of events
-static int sdl_poll_events(lua_State *L) {
-    lua_newtable(L);
-    int idx = 1;
-    SDL_Event event;
-    while (SDL_PollEvent(&event)) {
-        // Process event for ImGui input
-        // ImGui_ImplSDL3_ProcessEvent(&event);
+// Helper: Write the fields of an event into the table at idx
+// Only the fields of the event's type are written; a reused table keeps stale
+// fields from earlier events, so check type before reading them.
+static void set_event_fields(lua_State *L, int idx, const SDL_Event *event) {
+    idx = lua_absindex(L, idx);
+    lua_pushinteger(L, (lua_Integer)event->type);
+    lua_setfield(L, idx, "type");
+
+    switch (event->type) {
+    case SDL_EVENT_KEY_DOWN:
+    case SDL_EVENT_KEY_UP:
+        lua_pushinteger(L, (lua_Integer)event->key.key);
+        lua_setfield(L, idx, "key");
+        lua_pushinteger(L, (lua_Integer)event->key.scancode);
+        lua_setfield(L, idx, "scancode");
+        lua_pushinteger(L, (lua_Integer)event->key.mod);
+        lua_setfield(L, idx, "mod");
+        lua_pushboolean(L, event->key.repeat);
+        lua_setfield(L, idx, "repeat");
+        break;
+    case SDL_EVENT_MOUSE_BUTTON_DOWN:
+    case SDL_EVENT_MOUSE_BUTTON_UP:
+        lua_pushinteger(L, (lua_Integer)event->button.button);
+        lua_setfield(L, idx, "button");
+        lua_pushinteger(L, (lua_Integer)event->button.x);
+        lua_setfield(L, idx, "x");
+        lua_pushinteger(L, (lua_Integer)event->button.y);
+        lua_setfield(L, idx, "y");
+        lua_pushinteger(L, (lua_Integer)event->button.clicks);
+        lua_setfield(L, idx, "clicks");
+        break;
+    case SDL_EVENT_MOUSE_MOTION:
+        lua_pushnumber(L, event->motion.x);
+        lua_setfield(L, idx, "x");
+        lua_pushnumber(L, event->motion.y);
+        lua_setfield(L, idx, "y");
+        lua_pushnumber(L, event->motion.xrel);
+        lua_setfield(L, idx, "xrel");
+        lua_pushnumber(L, event->motion.yrel);
+        lua_setfield(L, idx, "yrel");
+        lua_pushinteger(L, (lua_Integer)event->motion.state);
+        lua_setfield(L, idx, "state");
+        break;
+    case SDL_EVENT_MOUSE_WHEEL:
+        lua_pushnumber(L, event->wheel.x);
+        lua_setfield(L, idx, "wheel_x");
+        lua_pushnumber(L, event->wheel.y);
+        lua_setfield(L, idx, "wheel_y");
+        lua_pushnumber(L, event->wheel.mouse_x);
+        lua_setfield(L, idx, "x");
+        lua_pushnumber(L, event->wheel.mouse_y);
+        lua_setfield(L, idx, "y");
+        break;
+    case SDL_EVENT_TEXT_INPUT:
+        lua_pushstring(L, event->text.text);
+        lua_setfield(L, idx, "text");
+        break;
+    case SDL_EVENT_WINDOW_RESIZED:
+        lua_pushinteger(L, (lua_Integer)event->window.data1);
+        lua_setfield(L, idx, "width");
+        lua_pushinteger(L, (lua_Integer)event->window.data2);
+        lua_setfield(L, idx, "height");
+        break;
+    default:
+        break;
+    }
+}
+
+//===============================================
+// keyboard / mouse state
+//===============================================
 
-        lua_pushinteger(L, idx++);
+// Keyboard state is read straight from SDL's array; edges are kept as bitsets
+// updated once per frame when the event queue has been drained. Events seen by
+// the poll functions are folded in so a tap shorter than a frame still counts.
+#define KEY_WORDS (SDL_SCANCODE_COUNT / 64)
+
+static const bool *g_keys = NULL;
+static int g_num_keys = 0;
+static Uint64 g_key_prev[KEY_WORDS];
+static Uint64 g_key_pressed[KEY_WORDS];
+static Uint64 g_key_released[KEY_WORDS];
+static Uint64 g_key_pending_pressed[KEY_WORDS];
+static Uint64 g_key_pending_released[KEY_WORDS];
+
+// While replaying, injected events do not update SDL's own keyboard/mouse state,
+// so the state views read from this shadow copy built from the events instead
+static int g_replaying = 0;
+static bool g_replay_keys[SDL_SCANCODE_COUNT];
+static struct {
+    float x, y;
+    SDL_MouseButtonFlags buttons;
+} g_replay_mouse;
+
+static struct {
+    float x, y;
+    float wheel_x, wheel_y;
+    float pending_wheel_x, pending_wheel_y;
+    SDL_MouseButtonFlags buttons, pressed, released;
+    SDL_MouseButtonFlags pending_pressed, pending_released;
+} g_mouse;
+
+// Helper: Fold one polled event into the pending edges
+static void track_input_event(const SDL_Event *event) {
+    switch (event->type) {
+    case SDL_EVENT_KEY_DOWN:
+    case SDL_EVENT_KEY_UP: {
+        int sc = (int)event->key.scancode;
+        if (sc < 0 || sc >= SDL_SCANCODE_COUNT) break;
+        if (g_replaying) g_replay_keys[sc] = event->type == SDL_EVENT_KEY_DOWN;
+        if (event->key.repeat) break;
+        Uint64 bit = (Uint64)1 << (sc & 63);
+        if (event->type == SDL_EVENT_KEY_DOWN) {
+            g_key_pending_pressed[sc >> 6] |= bit;
+        } else {
+            g_key_pending_released[sc >> 6] |= bit;
+        }
+        break;
+    }
+    case SDL_EVENT_MOUSE_BUTTON_DOWN:
+        g_mouse.pending_pressed |= SDL_BUTTON_MASK(event->button.button);
+        g_replay_mouse.buttons |= SDL_BUTTON_MASK(event->button.button);
+        g_replay_mouse.x = event->button.x;
+        g_replay_mouse.y = event->button.y;
+        break;
+    case SDL_EVENT_MOUSE_BUTTON_UP:
+        g_mouse.pending_released |= SDL_BUTTON_MASK(event->button.button);
+        g_replay_mouse.buttons &= ~SDL_BUTTON_MASK(event->button.button);
+        g_replay_mouse.x = event->button.x;
+        g_replay_mouse.y = event->button.y;
+        break;
+    case SDL_EVENT_MOUSE_MOTION:
+        g_replay_mouse.x = event->motion.x;
+        g_replay_mouse.y = event->motion.y;
+        break;
+    case SDL_EVENT_MOUSE_WHEEL:
+        g_mouse.pending_wheel_x += event->wheel.x;
+        g_mouse.pending_wheel_y += event->wheel.y;
+        break;
+    default:
+        break;
+    }
+}
+
+// Helper: Take the per-frame snapshot once the event queue is drained
+static void snapshot_input(void) {
+    if (!g_keys) {
+        g_keys = SDL_GetKeyboardState(&g_num_keys);
+    }
+    const bool *keys = g_replaying ? g_replay_keys : g_keys;
+    int count = g_num_keys < SDL_SCANCODE_COUNT ? g_num_keys : SDL_SCANCODE_COUNT;
+    for (int w = 0; w < KEY_WORDS; w++) {
+        Uint64 cur = 0;
+        int base = w * 64;
+        for (int b = 0; b < 64 && base + b < count; b++) {
+            cur |= (Uint64)(keys[base + b] ? 1 : 0) << b;
+        }
+        g_key_pressed[w] = (cur & ~g_key_prev[w]) | g_key_pending_pressed[w];
+        g_key_released[w] = (g_key_prev[w] & ~cur) | g_key_pending_released[w];
+        g_key_prev[w] = cur;
+        g_key_pending_pressed[w] = 0;
+        g_key_pending_released[w] = 0;
+    }
+
+    SDL_MouseButtonFlags prev = g_mouse.buttons;
+    if (g_replaying) {
+        g_mouse.buttons = g_replay_mouse.buttons;
+        g_mouse.x = g_replay_mouse.x;
+        g_mouse.y = g_replay_mouse.y;
+    } else {
+        g_mouse.buttons = SDL_GetMouseState(&g_mouse.x, &g_mouse.y);
+    }
+    g_mouse.pressed = (g_mouse.buttons & ~prev) | g_mouse.pending_pressed;
+    g_mouse.released = (prev & ~g_mouse.buttons) | g_mouse.pending_released;
+    g_mouse.pending_pressed = g_mouse.pending_released = 0;
+    g_mouse.wheel_x = g_mouse.pending_wheel_x;
+    g_mouse.wheel_y = g_mouse.pending_wheel_y;
+    g_mouse.pending_wheel_x = g_mouse.pending_wheel_y = 0.0f;
+}
+
+static int test_key_bit(const Uint64 *bits, lua_Integer sc) {
+    return sc >= 0 && sc < SDL_SCANCODE_COUNT && ((bits[sc >> 6] >> (sc & 63)) & 1);
+}
+
+static int test_button(SDL_MouseButtonFlags flags, lua_Integer button) {
+    return button >= 1 && button <= 32 && (flags & SDL_BUTTON_MASK(button));
+}
+
+// Lua: kb[scancode] -> bool (held), kb:down(sc), kb:pressed(sc), kb:released(sc)
+static int keyboard_down(lua_State *L) {
+    lua_Integer sc = luaL_checkinteger(L, 2);
+    const bool *keys = g_replaying ? g_replay_keys : g_keys;
+    lua_pushboolean(L, keys && sc >= 0 && sc < g_num_keys && keys[sc]);
+    return 1;
+}
+
+static int keyboard_pressed(lua_State *L) {
+    lua_pushboolean(L, test_key_bit(g_key_pressed, luaL_checkinteger(L, 2)));
+    return 1;
+}
+
+static int keyboard_released(lua_State *L) {
+    lua_pushboolean(L, test_key_bit(g_key_released, luaL_checkinteger(L, 2)));
+    return 1;
+}
+
+static int keyboard_index(lua_State *L) {
+    if (lua_type(L, 2) == LUA_TNUMBER) {
+        return keyboard_down(L);
+    }
+    lua_pushvalue(L, 2);
+    lua_rawget(L, lua_upvalueindex(1));
+    return 1;
+}
+
+static int keyboard_len(lua_State *L) {
+    lua_pushinteger(L, g_num_keys);
+    return 1;
+}
+
+// Lua: mouse[button] -> bool (held), mouse.x, mouse.y, mouse.wheel_x, mouse.wheel_y,
+//      mouse.buttons, mouse:down(b), mouse:pressed(b), mouse:released(b)
+static int mouse_down(lua_State *L) {
+    lua_pushboolean(L, test_button(g_mouse.buttons, luaL_checkinteger(L, 2)));
+    return 1;
+}
+
+static int mouse_pressed(lua_State *L) {
+    lua_pushboolean(L, test_button(g_mouse.pressed, luaL_checkinteger(L, 2)));
+    return 1;
+}
+
+static int mouse_released(lua_State *L) {
+    lua_pushboolean(L, test_button(g_mouse.released, luaL_checkinteger(L, 2)));
+    return 1;
+}
+
+static int mouse_index(lua_State *L) {
+    if (lua_type(L, 2) == LUA_TNUMBER) {
+        return mouse_down(L);
+    }
+    lua_pushvalue(L, 2);
+    if (lua_rawget(L, lua_upvalueindex(1)) != LUA_TNIL) {
+        return 1;
+    }
+    const char *key = lua_tostring(L, 2);
+    if (!key) return 1;
+    if (SDL_strcmp(key, "x") == 0) lua_pushnumber(L, g_mouse.x);
+    else if (SDL_strcmp(key, "y") == 0) lua_pushnumber(L, g_mouse.y);
+    else if (SDL_strcmp(key, "wheel_x") == 0) lua_pushnumber(L, g_mouse.wheel_x);
+    else if (SDL_strcmp(key, "wheel_y") == 0) lua_pushnumber(L, g_mouse.wheel_y);
+    else if (SDL_strcmp(key, "buttons") == 0) lua_pushinteger(L, (lua_Integer)g_mouse.buttons);
+    else lua_pushnil(L);
+    return 1;
+}
+
+static const struct luaL_Reg keyboard_methods[] = {
+    {"down", keyboard_down},
+    {"pressed", keyboard_pressed},
+    {"released", keyboard_released},
+    {NULL, NULL}
+};
+
+static const struct luaL_Reg mouse_methods[] = {
+    {"down", mouse_down},
+    {"pressed", mouse_pressed},
+    {"released", mouse_released},
+    {NULL, NULL}
+};
+
+// Helper: Push the singleton view userdata for tname, creating it on first use.
+// The views hold no data, the instance is kept in its metatable.
+static void push_input_view(lua_State *L, const char *tname, const luaL_Reg *methods,
+                            lua_CFunction index, lua_CFunction len) {
+    if (luaL_newmetatable(L, tname)) {
         lua_newtable(L);
-        
-        lua_pushinteger(L, (lua_Integer)event.type);
-        lua_setfield(L, -2, "type");
-        
-        if (event.type == SDL_EVENT_KEY_DOWN) {
-            lua_pushinteger(L, (lua_Integer)event.key.key);
-            lua_setfield(L, -2, "key");
-        } else if (event.type == SDL_EVENT_MOUSE_BUTTON_DOWN) {
-            lua_pushinteger(L, (lua_Integer)event.button.button);
-            lua_setfield(L, -2, "button");
-            lua_pushinteger(L, (lua_Integer)event.button.x);
-            lua_setfield(L, -2, "x");
-            lua_pushinteger(L, (lua_Integer)event.button.y);
-            lua_setfield(L, -2, "y");
-        } else if (event.type == SDL_EVENT_WINDOW_RESIZED) {
-            lua_pushinteger(L, (lua_Integer)event.window.data1);
-            lua_setfield(L, -2, "width");
-            lua_pushinteger(L, (lua_Integer)event.window.data2);
-            lua_setfield(L, -2, "height");
+        luaL_setfuncs(L, methods, 0);
+        lua_pushcclosure(L, index, 1);
+        lua_setfield(L, -2, "__index");
+        if (len) {
+            lua_pushcfunction(L, len);
+            lua_setfield(L, -2, "__len");
         }
-        
-        lua_settable(L, -3);
+        lua_alloc_newuserdata(L, 0, 0, LUA_TAG_SDL);
+        lua_pushvalue(L, -2);
+        lua_setmetatable(L, -2);
+        lua_setfield(L, -2, "instance");
+    }
+    lua_getfield(L, -1, "instance");
+    lua_remove(L, -2);
+}
+
+// Lua: sdl.get_keyboard_state() -> kb
+// Zero-copy view of SDL_GetKeyboardState indexed by scancode (sdl.SCANCODE_*).
+// Edges (pressed/released) cover the last drained event queue.
+static int sdl_get_keyboard_state(lua_State *L) {
+    if (!g_keys) {
+        g_keys = SDL_GetKeyboardState(&g_num_keys);
     }
+    push_input_view(L, "sdl.keyboard", keyboard_methods, keyboard_index, keyboard_len);
     return 1;
 }
 
-// Lua: sdl.poll_events() -> table of events and imgui ProcessEvent
-static int sdl_poll_events_ig(lua_State *L) {
+// Lua: sdl.get_mouse_state() -> mouse
+static int sdl_get_mouse_state(lua_State *L) {
+    push_input_view(L, "sdl.mouse", mouse_methods, mouse_index, NULL);
+    return 1;
+}
+
+// Lua: sdl.update_input() -- snapshot input without polling (scripts that never poll)
+static int sdl_update_input(lua_State *L) {
+    SDL_PumpEvents();
+    snapshot_input();
+    return 0;
+}
+
+//===============================================
+// input recording / replay
+//===============================================
+
+// File layout: input_rec_header, then input_record + payload (repeated).
+// Payload is the event's own struct (SDL_KeyboardEvent, ...) or the text of a
+// TEXT_INPUT event including its terminator. A record with type 0 marks the
+// frame the recording was stopped on.
+#define INPUT_REC_MAGIC 0x52504E49u // "INPR"
+#define INPUT_REC_VERSION 1
+#define INPUT_REPLAY_MARK 0x52504C59u // stored in event.common.reserved of injected events
+
+typedef struct {
+    Uint32 magic;
+    Uint32 version;
+} input_rec_header;
+
+typedef struct {
+    Uint32 frame;    // swapped frames since recording started
+    Uint32 type;     // SDL_EventType, 0 = end of recording
+    Uint64 time_ns;  // since recording started
+    Uint32 size;     // payload bytes
+    Uint32 reserved;
+} input_record;
+
+static FILE *g_rec_file = NULL;
+static Uint64 g_rec_start_frame = 0;
+static Uint64 g_rec_start_ns = 0;
+
+static Uint8 *g_replay_data = NULL; // whole file, kept until the next replay (text events point into it)
+static size_t g_replay_size = 0;
+static size_t g_replay_pos = 0;
+static Uint64 g_replay_start_frame = 0;
+static int g_replay_quit_at_end = 1;
+
+// Helper: Payload size for a recordable event, 0 if the type is not recorded
+static Uint32 input_payload_size(const SDL_Event *event) {
+    switch (event->type) {
+    case SDL_EVENT_KEY_DOWN:
+    case SDL_EVENT_KEY_UP:
+        return sizeof(SDL_KeyboardEvent);
+    case SDL_EVENT_MOUSE_MOTION:
+        return sizeof(SDL_MouseMotionEvent);
+    case SDL_EVENT_MOUSE_BUTTON_DOWN:
+    case SDL_EVENT_MOUSE_BUTTON_UP:
+        return sizeof(SDL_MouseButtonEvent);
+    case SDL_EVENT_MOUSE_WHEEL:
+        return sizeof(SDL_MouseWheelEvent);
+    case SDL_EVENT_TEXT_INPUT:
+        return event->text.text ? (Uint32)SDL_strlen(event->text.text) + 1 : 0;
+    case SDL_EVENT_QUIT:
+        return sizeof(SDL_QuitEvent);
+    default:
+        return 0;
+    }
+}
+
+static int is_replayed_input(const SDL_Event *event) {
+    return input_payload_size(event) != 0 && event->type != SDL_EVENT_QUIT;
+}
+
+// Helper: Append a polled event to the recording
+static void record_input_event(const SDL_Event *event) {
+    Uint32 size = input_payload_size(event);
+    if (!size) return;
+    input_record rec = {0};
+    rec.frame = (Uint32)(g_present_count - g_rec_start_frame);
+    rec.type = event->type;
+    rec.time_ns = SDL_GetTicksNS() - g_rec_start_ns;
+    rec.size = size;
+    fwrite(&rec, sizeof(rec), 1, g_rec_file);
+    fwrite(event->type == SDL_EVENT_TEXT_INPUT ? (const void *)event->text.text : (const void *)event, size, 1, g_rec_file);
+}
+
+int module_sdl_record_begin(const char *path) {
+    if (g_rec_file || g_replaying) return 0;
+    g_rec_file = fopen(path, "wb");
+    if (!g_rec_file) return 0;
+    input_rec_header header = { INPUT_REC_MAGIC, INPUT_REC_VERSION };
+    fwrite(&header, sizeof(header), 1, g_rec_file);
+    g_rec_start_frame = g_present_count;
+    g_rec_start_ns = SDL_GetTicksNS();
+    return 1;
+}
+
+void module_sdl_record_end(void) {
+    if (!g_rec_file) return;
+    input_record rec = {0};
+    rec.frame = (Uint32)(g_present_count - g_rec_start_frame);
+    rec.time_ns = SDL_GetTicksNS() - g_rec_start_ns;
+    fwrite(&rec, sizeof(rec), 1, g_rec_file);
+    fclose(g_rec_file);
+    g_rec_file = NULL;
+}
+
+int module_sdl_replay_begin(const char *path, int quit_at_end) {
+    if (g_rec_file) return 0;
+    size_t size = 0;
+    Uint8 *data = (Uint8 *)SDL_LoadFile(path, &size);
+    if (!data) return 0;
+    const input_rec_header *header = (const input_rec_header *)data;
+    if (size < sizeof(*header) || header->magic != INPUT_REC_MAGIC || header->version != INPUT_REC_VERSION) {
+        SDL_free(data);
+        SDL_SetError("Not an input recording: %s", path);
+        return 0;
+    }
+    SDL_free(g_replay_data);
+    g_replay_data = data;
+    g_replay_size = size;
+    g_replay_pos = sizeof(*header);
+    g_replay_start_frame = g_present_count;
+    g_replay_quit_at_end = quit_at_end;
+    SDL_zeroa(g_replay_keys);
+    SDL_zero(g_replay_mouse);
+    g_replaying = 1;
+    return 1;
+}
+
+// Helper: Push every recorded event due on the current frame
+static void replay_inject(void) {
+    Uint64 frame = g_present_count - g_replay_start_frame;
+    while (g_replay_pos + sizeof(input_record) <= g_replay_size) {
+        input_record rec;
+        SDL_memcpy(&rec, g_replay_data + g_replay_pos, sizeof(rec));
+        if (rec.frame > frame) return;
+        const Uint8 *payload = g_replay_data + g_replay_pos + sizeof(rec);
+        if (payload + rec.size > g_replay_data + g_replay_size) break;
+        g_replay_pos += sizeof(rec) + rec.size;
+
+        if (rec.type == 0) break; // end of recording
+
+        SDL_Event event;
+        SDL_zero(event);
+        if (rec.type == SDL_EVENT_TEXT_INPUT) {
+            event.text.type = SDL_EVENT_TEXT_INPUT;
+            event.text.text = (const char *)payload;
+        } else if (rec.size <= sizeof(event)) {
+            SDL_memcpy(&event, payload, rec.size);
+        }
+        event.common.timestamp = 0; // let SDL stamp it
+        event.common.reserved = INPUT_REPLAY_MARK;
+        SDL_PushEvent(&event);
+    }
+
+    // Recording exhausted
+    g_replaying = 0;
+    if (g_replay_quit_at_end) {
+        SDL_Event quit_event;
+        SDL_zero(quit_event);
+        quit_event.type = SDL_EVENT_QUIT;
+        SDL_PushEvent(&quit_event);
+    }
+}
+
+// Helper: Common per-event work of the poll functions, returns 0 to drop the event
+static int filter_polled_event(const SDL_Event *event) {
+    if (g_replaying && is_replayed_input(event) && event->common.reserved != INPUT_REPLAY_MARK) {
+        return 0; // live input is ignored while a recording plays back
+    }
+    if (g_rec_file) {
+        record_input_event(event);
+    }
+    track_input_event(event);
+    return 1;
+}
+
+// Lua: sdl.record_input(path) -> bool, err_msg
+// Records every event returned by the poll functions, with frame numbers, until
+// sdl.stop_recording() or exit.
+static int sdl_record_input(lua_State *L) {
+    const char *path = luaL_checkstring(L, 1);
+    if (!module_sdl_record_begin(path)) {
+        lua_pushboolean(L, 0);
+        lua_pushfstring(L, "Cannot record input to '%s' (already recording or replaying?)", path);
+        return 2;
+    }
+    lua_pushboolean(L, 1);
+    return 1;
+}
+
+// Lua: sdl.stop_recording()
+static int sdl_stop_recording(lua_State *L) {
+    module_sdl_record_end();
+    return 0;
+}
+
+// Lua: sdl.replay_input(path, [quit_at_end=true]) -> bool, err_msg
+static int sdl_replay_input(lua_State *L) {
+    const char *path = luaL_checkstring(L, 1);
+    int quit_at_end = lua_isnoneornil(L, 2) ? 1 : lua_toboolean(L, 2);
+    if (!module_sdl_replay_begin(path, quit_at_end)) {
+        lua_pushboolean(L, 0);
+        lua_pushstring(L, SDL_GetError());
+        return 2;
+    }
+    lua_pushboolean(L, 1);
+    return 1;
+}
+
+// Lua: sdl.is_replaying() -> bool
+static int sdl_is_replaying(lua_State *L) {
+    lua_pushboolean(L, g_replaying);
+    return 1;
+}
+
+// Helper: Poll all events into a new table of event tables
+static int push_event_list(lua_State *L, int imgui) {
     lua_newtable(L);
     int idx = 1;
     SDL_Event event;
+    if (g_replaying) replay_inject();
     while (SDL_PollEvent(&event)) {
+        if (!filter_polled_event(&event)) continue;
         // Process event for ImGui input
-        ImGui_ImplSDL3_ProcessEvent(&event);
-
-        lua_pushinteger(L, idx++);
+        if (imgui) {
+            ImGui_ImplSDL3_ProcessEvent(&event);
+        }
         lua_newtable(L);
-        
-        lua_pushinteger(L, (lua_Integer)event.type);
-        lua_setfield(L, -2, "type");
-        
-        if (event.type == SDL_EVENT_KEY_DOWN) {
-            lua_pushinteger(L, (lua_Integer)event.key.key);
-            lua_setfield(L, -2, "key");
-        } else if (event.type == SDL_EVENT_MOUSE_BUTTON_DOWN) {
-            lua_pushinteger(L, (lua_Integer)event.button.button);
-            lua_setfield(L, -2, "button");
-            lua_pushinteger(L, (lua_Integer)event.button.x);
-            lua_setfield(L, -2, "x");
-            lua_pushinteger(L, (lua_Integer)event.button.y);
-            lua_setfield(L, -2, "y");
-        } else if (event.type == SDL_EVENT_WINDOW_RESIZED) {
-            lua_pushinteger(L, (lua_Integer)event.window.data1);
-            lua_setfield(L, -2, "width");
-            lua_pushinteger(L, (lua_Integer)event.window.data2);
-            lua_setfield(L, -2, "height");
+        set_event_fields(L, -1, &event);
+        lua_rawseti(L, -2, idx++);
+    }
+    snapshot_input();
+    return 1;
+}
+
+// Lua: sdl.poll_events() -> table of events
+static int sdl_poll_events(lua_State *L) {
+    return push_event_list(L, 0);
+}
+
+// Lua: sdl.poll_events() -> table of events and imgui ProcessEvent
+static int sdl_poll_events_ig(lua_State *L) {
+    return push_event_list(L, 1);
+}
+
+// Helper: Poll one event into a caller-supplied table
+static int poll_event_into(lua_State *L, int imgui) {
+    luaL_checktype(L, 1, LUA_TTABLE);
+    SDL_Event event;
+    if (g_replaying) replay_inject();
+    do {
+        if (!SDL_PollEvent(&event)) {
+            snapshot_input();
+            lua_pushboolean(L, 0);
+            return 1;
         }
-        
-        lua_settable(L, -3);
+    } while (!filter_polled_event(&event));
+    if (imgui) {
+        ImGui_ImplSDL3_ProcessEvent(&event);
     }
+    set_event_fields(L, 1, &event);
+    lua_pushboolean(L, 1);
     return 1;
 }
 
+// Lua: sdl.poll_event(ev) -> bool
+// Allocation-free: fills the reused table ev with the next event
+//   local ev = {}
+//   while sdl.poll_event(ev) do ... end
+static int sdl_poll_event(lua_State *L) {
+    return poll_event_into(L, 0);
+}
+
+// Lua: sdl.poll_event_ig(ev) -> bool (also forwards the event to ImGui)
+static int sdl_poll_event_ig(lua_State *L) {
+    return poll_event_into(L, 1);
+}
+
 // Lua: sdl.quit()
 static int sdl_quit(lua_State *L) {
     // Destroy window if it exists
@@ -266,6 +874,63 @@ static int sdl_gl_get_attribute(lua_State *L) {
     return 1;
 }
 
+// Helper: Record frame time and stop the script after the requested frame count
+static void record_headless_frame(void) {
+    Uint64 now = SDL_GetTicksNS();
+    if (g_last_swap_ns != 0 && g_frame_count < g_headless_frames) {
+        g_frame_times[g_frame_count++] = now - g_last_swap_ns;
+        if (g_frame_count == g_headless_frames) {
+            // Scripts already exit their loop on EVENT_QUIT, so they run unchanged
+            SDL_Event quit_event;
+            SDL_zero(quit_event);
+            quit_event.type = SDL_EVENT_QUIT;
+            quit_event.quit.timestamp = SDL_GetTicksNS();
+            SDL_PushEvent(&quit_event);
+        }
+    }
+    g_last_swap_ns = now;
+}
+
+//===============================================
+// swap interval and present timing
+//===============================================
+
+#define PRESENT_HISTORY 256
+
+static Uint64 g_present_ns[PRESENT_HISTORY];  // time SDL_GL_SwapWindow blocked
+static Uint64 g_interval_ns[PRESENT_HISTORY]; // swap-to-swap time
+static Uint64 g_prev_present_end_ns = 0;
+
+// Set the swap interval, falling back from adaptive (-1) to vsync (1) when the
+// driver does not support late swap tearing. Returns the interval applied or -2 on failure.
+int module_sdl_set_swap_interval(int interval) {
+    if (SDL_GL_SetSwapInterval(interval)) {
+        return interval;
+    }
+    if (interval == -1 && SDL_GL_SetSwapInterval(1)) {
+        return 1;
+    }
+    return -2;
+}
+
+// Helper: Swap buffers and do the per-frame bookkeeping
+static void swap_window(SDL_Window *window) {
+    PROF_BEGIN("sdl.gl_swap_window");
+    Uint64 start = SDL_GetTicksNS();
+    SDL_GL_SwapWindow(window);
+    Uint64 end = SDL_GetTicksNS();
+    PROF_END();
+    int slot = (int)(g_present_count % PRESENT_HISTORY);
+    g_present_ns[slot] = end - start;
+    g_interval_ns[slot] = g_prev_present_end_ns ? end - g_prev_present_end_ns : 0;
+    g_prev_present_end_ns = end;
+    g_present_count++;
+    module_gl_trace_frame();
+    if (g_headless) {
+        record_headless_frame();
+    }
+}
+
 // Lua: sdl.gl_swap_window(window)
 static int sdl_gl_swap_window(lua_State *L) {
     if (!lua_islightuserdata(L, 1)) {
@@ -279,7 +944,7 @@ static int sdl_gl_swap_window(lua_State *L) {
         lua_pushstring(L, "Invalid window handle");
         return 2;
     }
-    SDL_GL_SwapWindow(window);
+    swap_window(window);
     return 0;
 }
 
@@ -405,17 +1070,453 @@ static int sdl_get_ticks(lua_State *L) {
     return 1;
 }
 
+// Lua: sdl.get_ticks_ns() -> nanoseconds since SDL init
+static int sdl_get_ticks_ns(lua_State *L) {
+    lua_pushinteger(L, (lua_Integer)SDL_GetTicksNS());
+    return 1;
+}
+
+
+// Lua: sdl.gl_set_swap_interval(interval) -> applied_interval | nil, err_msg
+// interval: 0 = immediate, 1 = vsync, -1 = adaptive vsync (falls back to 1)
+static int sdl_gl_set_swap_interval(lua_State *L) {
+    int interval = (int)luaL_checkinteger(L, 1);
+    int applied = module_sdl_set_swap_interval(interval);
+    if (applied == -2) {
+        lua_pushnil(L);
+        lua_pushstring(L, SDL_GetError());
+        return 2;
+    }
+    lua_pushinteger(L, applied);
+    return 1;
+}
+
+// Lua: sdl.gl_get_swap_interval() -> interval | nil, err_msg
+static int sdl_gl_get_swap_interval(lua_State *L) {
+    int interval = 0;
+    if (!SDL_GL_GetSwapInterval(&interval)) {
+        lua_pushnil(L);
+        lua_pushstring(L, SDL_GetError());
+        return 2;
+    }
+    lua_pushinteger(L, interval);
+    return 1;
+}
+
+// Lua: sdl.get_present_stats() -> {count, last_ms, avg_ms, min_ms, max_ms, interval_ms}
+// Statistics over the last PRESENT_HISTORY swaps of how long SDL_GL_SwapWindow blocked.
+static int sdl_get_present_stats(lua_State *L) {
+    int n = g_present_count < PRESENT_HISTORY ? (int)g_present_count : PRESENT_HISTORY;
+    Uint64 total = 0, min_ns = 0, max_ns = 0;
+    for (int i = 0; i < n; i++) {
+        Uint64 v = g_present_ns[i];
+        total += v;
+        if (i == 0 || v < min_ns) min_ns = v;
+        if (v > max_ns) max_ns = v;
+    }
+    int last = (int)((g_present_count + PRESENT_HISTORY - 1) % PRESENT_HISTORY);
+
+    lua_createtable(L, 0, 6);
+    lua_pushinteger(L, (lua_Integer)g_present_count);
+    lua_setfield(L, -2, "count");
+    lua_pushnumber(L, n ? g_present_ns[last] / 1e6 : 0.0);
+    lua_setfield(L, -2, "last_ms");
+    lua_pushnumber(L, n ? (double)total / n / 1e6 : 0.0);
+    lua_setfield(L, -2, "avg_ms");
+    lua_pushnumber(L, min_ns / 1e6);
+    lua_setfield(L, -2, "min_ms");
+    lua_pushnumber(L, max_ns / 1e6);
+    lua_setfield(L, -2, "max_ms");
+    lua_pushnumber(L, n ? g_interval_ns[last] / 1e6 : 0.0);
+    lua_setfield(L, -2, "interval_ms");
+    return 1;
+}
+
+// Lua: sdl.get_present_history([t]) -> t
+// Fills t (or a new table) with {present_ms, interval_ms} pairs, oldest first.
+// Passing the same table each call reuses its entries.
+static int sdl_get_present_history(lua_State *L) {
+    int n = g_present_count < PRESENT_HISTORY ? (int)g_present_count : PRESENT_HISTORY;
+    if (lua_istable(L, 1)) {
+        lua_settop(L, 1);
+    } else {
+        lua_settop(L, 0);
+        lua_createtable(L, n, 0);
+    }
+    Uint64 first = g_present_count - (Uint64)n;
+    for (int i = 0; i < n; i++) {
+        int slot = (int)((first + i) % PRESENT_HISTORY);
+        if (lua_rawgeti(L, 1, i + 1) != LUA_TTABLE) {
+            lua_pop(L, 1);
+            lua_createtable(L, 2, 0);
+            lua_pushvalue(L, -1);
+            lua_rawseti(L, 1, i + 1);
+        }
+        lua_pushnumber(L, g_present_ns[slot] / 1e6);
+        lua_rawseti(L, -2, 1);
+        lua_pushnumber(L, g_interval_ns[slot] / 1e6);
+        lua_rawseti(L, -2, 2);
+        lua_pop(L, 1);
+    }
+    // Trim stale entries from a reused table
+    for (lua_Integer i = n + 1; lua_rawgeti(L, 1, i) != LUA_TNIL; i++) {
+        lua_pop(L, 1);
+        lua_pushnil(L);
+        lua_rawseti(L, 1, i);
+    }
+    lua_pop(L, 1);
+    return 1;
+}
+
+//===============================================
+// buffers / async file io
+//===============================================
+
+sdl_buffer *module_sdl_push_buffer(lua_State *L, void *data, size_t size) {
+    sdl_buffer *buf = (sdl_buffer *)lua_alloc_newuserdata(L, sizeof(sdl_buffer), 0, LUA_TAG_SDL);
+    buf->data = data;
+    buf->size = size;
+    luaL_setmetatable(L, SDL_BUFFER_MT);
+    return buf;
+}
+
+sdl_buffer *module_sdl_test_buffer(lua_State *L, int idx) {
+    return (sdl_buffer *)luaL_testudata(L, idx, SDL_BUFFER_MT);
+}
+
+// Lua: buf:size() / #buf -> bytes
+static int sdl_buffer_size(lua_State *L) {
+    sdl_buffer *buf = (sdl_buffer *)luaL_checkudata(L, 1, SDL_BUFFER_MT);
+    lua_pushinteger(L, (lua_Integer)(buf->data ? buf->size : 0));
+    return 1;
+}
+
+// Lua: buf:to_string([offset], [length]) -> string (copies)
+static int sdl_buffer_to_string(lua_State *L) {
+    sdl_buffer *buf = (sdl_buffer *)luaL_checkudata(L, 1, SDL_BUFFER_MT);
+    luaL_argcheck(L, buf->data != NULL, 1, "buffer was freed");
+    lua_Integer offset = luaL_optinteger(L, 2, 0);
+    luaL_argcheck(L, offset >= 0 && (size_t)offset <= buf->size, 2, "offset out of range");
+    lua_Integer length = luaL_optinteger(L, 3, (lua_Integer)(buf->size - (size_t)offset));
+    luaL_argcheck(L, length >= 0 && (size_t)(offset + length) <= buf->size, 3, "length out of range");
+    lua_pushlstring(L, (const char *)buf->data + offset, (size_t)length);
+    return 1;
+}
+
+// Lua: buf:get_data() -> lightuserdata (valid until the buffer is freed or collected)
+static int sdl_buffer_get_data(lua_State *L) {
+    sdl_buffer *buf = (sdl_buffer *)luaL_checkudata(L, 1, SDL_BUFFER_MT);
+    if (!buf->data) {
+        lua_pushnil(L);
+        return 1;
+    }
+    lua_pushlightuserdata(L, buf->data);
+    return 1;
+}
+
+// Lua: buf:free() -- release the memory now instead of at collection
+static int sdl_buffer_free(lua_State *L) {
+    sdl_buffer *buf = (sdl_buffer *)luaL_checkudata(L, 1, SDL_BUFFER_MT);
+    SDL_free(buf->data);
+    buf->data = NULL;
+    buf->size = 0;
+    return 0;
+}
+
+static const luaL_Reg sdl_buffer_methods[] = {
+    {"size", sdl_buffer_size},
+    {"to_string", sdl_buffer_to_string},
+    {"get_data", sdl_buffer_get_data},
+    {"free", sdl_buffer_free},
+    {NULL, NULL}
+};
+
+#define ASYNC_QUEUE_MT "sdl.async_queue"
+
+typedef struct {
+    SDL_AsyncIOQueue *queue;
+    int pending;      // requests not yet returned by poll/wait
+    int next_id;      // request ids, the Lua tag is kept in the uservalue table under the id
+} sdl_async_queue;
+
+static sdl_async_queue *check_async_queue(lua_State *L, int idx) {
+    sdl_async_queue *q = (sdl_async_queue *)luaL_checkudata(L, idx, ASYNC_QUEUE_MT);
+    luaL_argcheck(L, q->queue != NULL, idx, "async queue was destroyed");
+    return q;
+}
+
+// Lua: sdl.async_queue() -> queue | nil, err_msg
+static int sdl_async_queue_new(lua_State *L) {
+    SDL_AsyncIOQueue *queue = SDL_CreateAsyncIOQueue();
+    if (!queue) {
+        lua_pushnil(L);
+        lua_pushstring(L, SDL_GetError());
+        return 2;
+    }
+    sdl_async_queue *q = (sdl_async_queue *)lua_alloc_newuserdata(L, sizeof(sdl_async_queue), 1, LUA_TAG_SDL);
+    q->queue = queue;
+    q->pending = 0;
+    q->next_id = 1;
+    lua_newtable(L);
+    lua_setiuservalue(L, -2, 1);
+    luaL_setmetatable(L, ASYNC_QUEUE_MT);
+    return 1;
+}
+
+// Lua: queue:load_file(path, [tag]) -> bool, err_msg
+// Starts reading the whole file on SDL's I/O threads. tag (default path) is
+// returned by poll/wait with the result.
+static int sdl_async_queue_load_file(lua_State *L) {
+    sdl_async_queue *q = check_async_queue(L, 1);
+    const char *path = luaL_checkstring(L, 2);
+    int id = q->next_id++;
+    if (!SDL_LoadFileAsync(path, q->queue, (void *)(intptr_t)id)) {
+        lua_pushboolean(L, 0);
+        lua_pushstring(L, SDL_GetError());
+        return 2;
+    }
+    q->pending++;
+    lua_getiuservalue(L, 1, 1);
+    lua_pushvalue(L, lua_isnoneornil(L, 3) ? 2 : 3);
+    lua_rawseti(L, -2, id);
+    lua_pop(L, 1);
+    lua_pushboolean(L, 1);
+    return 1;
+}
+
+// Helper: Push tag, buffer | nil, err_msg for a finished request
+static int push_async_outcome(lua_State *L, sdl_async_queue *q, SDL_AsyncIOOutcome *outcome) {
+    q->pending--;
+    int id = (int)(intptr_t)outcome->userdata;
+    lua_getiuservalue(L, 1, 1);
+    lua_rawgeti(L, -1, id);
+    lua_pushnil(L);
+    lua_rawseti(L, -3, id);
+    lua_remove(L, -2);
+
+    if (outcome->result == SDL_ASYNCIO_COMPLETE) {
+        module_sdl_push_buffer(L, outcome->buffer, (size_t)outcome->bytes_transferred);
+        return 2;
+    }
+    SDL_free(outcome->buffer);
+    lua_pushnil(L);
+    lua_pushstring(L, outcome->result == SDL_ASYNCIO_CANCELED ? "canceled" : SDL_GetError());
+    return 3;
+}
+
+// Lua: queue:poll() -> tag, buffer | tag, nil, err_msg | nil
+// Returns one finished request without blocking, nil when none is ready.
+//   while true do
+//       local tag, buf, err = queue:poll()
+//       if tag == nil then break end
+//   end
+static int sdl_async_queue_poll(lua_State *L) {
+    sdl_async_queue *q = check_async_queue(L, 1);
+    SDL_AsyncIOOutcome outcome;
+    if (q->pending == 0 || !SDL_GetAsyncIOResult(q->queue, &outcome)) {
+        lua_pushnil(L);
+        return 1;
+    }
+    return push_async_outcome(L, q, &outcome);
+}
+
+// Lua: queue:wait([timeout_ms=-1]) -> tag, buffer | tag, nil, err_msg | nil
+static int sdl_async_queue_wait(lua_State *L) {
+    sdl_async_queue *q = check_async_queue(L, 1);
+    Sint32 timeout = (Sint32)luaL_optinteger(L, 2, -1);
+    SDL_AsyncIOOutcome outcome;
+    if (q->pending == 0 || !SDL_WaitAsyncIOResult(q->queue, &outcome, timeout)) {
+        lua_pushnil(L);
+        return 1;
+    }
+    return push_async_outcome(L, q, &outcome);
+}
+
+// Lua: queue:pending() -> count
+static int sdl_async_queue_pending(lua_State *L) {
+    sdl_async_queue *q = check_async_queue(L, 1);
+    lua_pushinteger(L, q->pending);
+    return 1;
+}
+
+// Lua: queue:destroy() -- waits for outstanding requests and drops their results
+static int sdl_async_queue_destroy(lua_State *L) {
+    sdl_async_queue *q = (sdl_async_queue *)luaL_checkudata(L, 1, ASYNC_QUEUE_MT);
+    if (!q->queue) return 0;
+    SDL_AsyncIOOutcome outcome;
+    while (q->pending > 0 && SDL_WaitAsyncIOResult(q->queue, &outcome, -1)) {
+        SDL_free(outcome.buffer);
+        q->pending--;
+    }
+    SDL_DestroyAsyncIOQueue(q->queue);
+    q->queue = NULL;
+    return 0;
+}
+
+static const luaL_Reg sdl_async_queue_methods[] = {
+    {"load_file", sdl_async_queue_load_file},
+    {"poll", sdl_async_queue_poll},
+    {"wait", sdl_async_queue_wait},
+    {"pending", sdl_async_queue_pending},
+    {"destroy", sdl_async_queue_destroy},
+    {NULL, NULL}
+};
+
+// Helper: Create a metatable with methods as __index, plus __gc / __len
+static void register_metatable(lua_State *L, const char *tname, const luaL_Reg *methods,
+                               lua_CFunction gc, lua_CFunction len) {
+    luaL_newmetatable(L, tname);
+    lua_newtable(L);
+    luaL_setfuncs(L, methods, 0);
+    lua_setfield(L, -2, "__index");
+    if (gc) {
+        lua_pushcfunction(L, gc);
+        lua_setfield(L, -2, "__gc");
+    }
+    if (len) {
+        lua_pushcfunction(L, len);
+        lua_setfield(L, -2, "__len");
+    }
+    lua_pop(L, 1);
+}
+
+//===============================================
+// native main loop
+//===============================================
+
+static int g_run_active = 0;
+
+// Helper: Call the function at stack index fn with one number argument.
+// Returns 0 when the callback returned false (stop the loop).
+static int call_loop_callback(lua_State *L, int fn, double arg) {
+    lua_pushvalue(L, fn);
+    lua_pushnumber(L, arg);
+    lua_call(L, 1, 1);
+    int keep_running = !(lua_isboolean(L, -1) && !lua_toboolean(L, -1));
+    lua_pop(L, 1);
+    return keep_running;
+}
+
+// Helper: Read an optional number field from the table at idx
+static double opt_number_field(lua_State *L, int idx, const char *name, double def) {
+    lua_getfield(L, idx, name);
+    double value = lua_isnil(L, -1) ? def : luaL_checknumber(L, -1);
+    lua_pop(L, 1);
+    return value;
+}
+
+// Lua: sdl.run{update=fn(dt), render=fn(alpha), hz=60, max_frame_skip=5, window=window} -> frames, updates
+// Fixed-timestep loop: update runs at exactly hz with dt = 1/hz, render runs once per
+// frame with alpha = leftover fraction of a step for interpolation. When window is given
+// the buffers are swapped after render. Without vsync the loop sleeps until the next
+// update is due. A GC budget (lua_util.gc_frame_budget) runs between render and swap,
+// changed modules are reloaded and lua_util tasks resumed before the frame.
+// Returning false from update or render, or calling sdl.stop(), ends the loop.
+static int sdl_run(lua_State *L) {
+    luaL_checktype(L, 1, LUA_TTABLE);
+    lua_getfield(L, 1, "update");
+    luaL_argcheck(L, lua_isfunction(L, -1), 1, "update function expected");
+    int update_fn = lua_gettop(L);
+    lua_getfield(L, 1, "render");
+    luaL_argcheck(L, lua_isfunction(L, -1) || lua_isnil(L, -1), 1, "render must be a function");
+    int render_fn = lua_isnil(L, -1) ? 0 : lua_gettop(L);
+    lua_getfield(L, 1, "window");
+    SDL_Window *window = lua_islightuserdata(L, -1) ? (SDL_Window *)lua_touserdata(L, -1) : NULL;
+    lua_pop(L, 1);
+
+    double hz = opt_number_field(L, 1, "hz", 60.0);
+    int max_frame_skip = (int)opt_number_field(L, 1, "max_frame_skip", 5.0);
+    luaL_argcheck(L, hz > 0.0, 1, "hz must be positive");
+    if (max_frame_skip < 1) max_frame_skip = 1;
+
+    const Uint64 step_ns = (Uint64)(SDL_NS_PER_SECOND / hz);
+    luaL_argcheck(L, step_ns > 0, 1, "hz too large, a step must last at least 1 ns");
+    const double step_sec = (double)step_ns / SDL_NS_PER_SECOND;
+    lua_Integer frames = 0, updates = 0;
+    Uint64 accumulator = 0;
+    Uint64 previous = SDL_GetTicksNS();
+
+    g_run_active = 1;
+    while (g_run_active) {
+        module_lua_reload_poll(L);
+        module_lua_tasks_tick(L);
+        Uint64 now = SDL_GetTicksNS();
+        Uint64 elapsed = now - previous;
+        previous = now;
+        // Clamp long stalls (debugger, window drag) instead of spiralling
+        if (elapsed > step_ns * (Uint64)max_frame_skip) {
+            elapsed = step_ns * (Uint64)max_frame_skip;
+        }
+        accumulator += elapsed;
+
+        int steps = 0;
+        while (g_run_active && accumulator >= step_ns && steps < max_frame_skip) {
+            PROF_BEGIN("sdl.run update");
+            if (!call_loop_callback(L, update_fn, step_sec)) g_run_active = 0;
+            PROF_END();
+            accumulator -= step_ns;
+            steps++;
+            updates++;
+        }
+        if (!g_run_active) break;
+
+        double alpha = (double)accumulator / (double)step_ns;
+        if (render_fn) {
+            PROF_BEGIN("sdl.run render");
+            int keep_running = call_loop_callback(L, render_fn, alpha);
+            PROF_END();
+            if (!keep_running) break;
+        }
+        // Spend the time left in this step on the collector (lua_util.gc_frame_budget)
+        Uint64 frame_ns = SDL_GetTicksNS() - now;
+        module_lua_gc_frame(L, frame_ns < step_ns ? (step_ns - frame_ns) / 1e6 : 0.0);
+        if (window) swap_window(window);
+        frames++;
+
+        // No vsync to pace us: sleep until the next update is due
+        int interval = 0;
+        if (!window || !SDL_GL_GetSwapInterval(&interval) || interval == 0) {
+            Uint64 spent = accumulator + (SDL_GetTicksNS() - previous);
+            if (spent < step_ns) {
+                SDL_DelayPrecise(step_ns - spent);
+            }
+        }
+    }
+    g_run_active = 0;
+
+    lua_pushinteger(L, frames);
+    lua_pushinteger(L, updates);
+    return 2;
+}
+
+// Lua: sdl.stop() -- ends sdl.run after the current callback
+static int sdl_stop(lua_State *L) {
+    g_run_active = 0;
+    return 0;
+}
+
+// Lua: sdl.is_headless() -> bool
+static int sdl_is_headless(lua_State *L) {
+    lua_pushboolean(L, g_headless);
+    return 1;
+}
 
 static const struct luaL_Reg sdl_lib[] = {
     {"init", sdl_init},
     {"init_window", sdl_init_window},
     {"poll_events", sdl_poll_events},
     {"poll_events_ig", sdl_poll_events_ig},
+    {"poll_event", sdl_poll_event},
+    {"poll_event_ig", sdl_poll_event_ig},
     {"quit", sdl_quit},
     {"gl_reset_attribute", sdl_gl_reset_attribute},
     {"gl_set_attribute", sdl_gl_set_attribute},
     {"gl_get_attribute", sdl_gl_get_attribute},
     {"gl_swap_window", sdl_gl_swap_window},
+    {"gl_set_swap_interval", sdl_gl_set_swap_interval},
+    {"gl_get_swap_interval", sdl_gl_get_swap_interval},
+    {"get_present_stats", sdl_get_present_stats},
+    {"get_present_history", sdl_get_present_history},
 
     {"get_primary_display", sdl_get_primary_display},
     {"get_display_content_scale", sdl_get_display_content_scale},
@@ -426,15 +1527,116 @@ static const struct luaL_Reg sdl_lib[] = {
     {"get_window_id", sdl_get_window_id},
     {"delay", sdl_delay},
     {"get_ticks", sdl_get_ticks},
+    {"get_ticks_ns", sdl_get_ticks_ns},
 
     {"get_current_gl_context", sdl_get_current_gl_context},
+    {"is_headless", sdl_is_headless},
+    {"run", sdl_run},
+    {"get_keyboard_state", sdl_get_keyboard_state},
+    {"get_mouse_state", sdl_get_mouse_state},
+    {"update_input", sdl_update_input},
+    {"record_input", sdl_record_input},
+    {"stop_recording", sdl_stop_recording},
+    {"replay_input", sdl_replay_input},
+    {"is_replaying", sdl_is_replaying},
+    {"async_queue", sdl_async_queue_new},
+    {"stop", sdl_stop},
 
     {NULL, NULL}
 };
 
 int luaopen_module_sdl(lua_State *L) {
+    register_metatable(L, SDL_BUFFER_MT, sdl_buffer_methods, sdl_buffer_free, sdl_buffer_size);
+    register_metatable(L, ASYNC_QUEUE_MT, sdl_async_queue_methods, sdl_async_queue_destroy, NULL);
     luaL_newlib(L, sdl_lib);
     push_event_constants(L);
+    push_input_constants(L);
 
     return 1;
-}
\ No newline at end of file
+}
+
+//===============================================
+// headless
+//===============================================
+
+int module_sdl_set_headless(int frames, const char *video_driver) {
+    int n = frames > 0 ? frames : 1;
+    Uint64 *times = (Uint64 *)calloc((size_t)n, sizeof(Uint64));
+    if (!times) return SDL_OutOfMemory();
+    free(g_frame_times);
+    g_frame_times = times;
+    g_headless = 1;
+    g_headless_frames = n;
+    g_frame_count = 0;
+    g_last_swap_ns = 0;
+
+    // "offscreen" renders through an EGL pbuffer, which works with Mesa llvmpipe
+    SDL_SetHint(SDL_HINT_VIDEO_DRIVER, video_driver ? video_driver : "offscreen");
+    // Fall back to software GL when no GPU driver is present (does not override the caller's env)
+    SDL_setenv_unsafe("LIBGL_ALWAYS_SOFTWARE", "1", 0);
+    return 1;
+}
+
+int module_sdl_is_headless(void) {
+    return g_headless;
+}
+
+void module_sdl_headless_end(void) {
+    free(g_frame_times);
+    g_frame_times = NULL;
+    g_headless = 0;
+    g_headless_frames = 0;
+    g_frame_count = 0;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    Uint64 x = *(const Uint64 *)a;
+    Uint64 y = *(const Uint64 *)b;
+    return (x > y) - (x < y);
+}
+
+void module_sdl_frame_report(const char *json_path) {
+    if (!g_headless) return;
+    int n = g_frame_count;
+    if (n == 0) {
+        printf("Headless report: no frames swapped\n");
+        return;
+    }
+
+    Uint64 *sorted = (Uint64 *)malloc((size_t)n * sizeof(Uint64));
+    if (!sorted) return;
+    Uint64 total = 0;
+    for (int i = 0; i < n; i++) {
+        sorted[i] = g_frame_times[i];
+        total += g_frame_times[i];
+    }
+    qsort(sorted, (size_t)n, sizeof(Uint64), compare_u64);
+
+    double avg_ms = (double)total / n / 1e6;
+    double min_ms = sorted[0] / 1e6;
+    double max_ms = sorted[n - 1] / 1e6;
+    double p50_ms = sorted[(n - 1) * 50 / 100] / 1e6;
+    double p95_ms = sorted[(n - 1) * 95 / 100] / 1e6;
+    double p99_ms = sorted[(n - 1) * 99 / 100] / 1e6;
+    double fps = avg_ms > 0.0 ? 1000.0 / avg_ms : 0.0;
+    free(sorted);
+
+    printf("Headless report: driver=%s frames=%d avg=%.3fms min=%.3fms p50=%.3fms p95=%.3fms p99=%.3fms max=%.3fms fps=%.1f\n",
+           SDL_GetHint(SDL_HINT_VIDEO_DRIVER), n, avg_ms, min_ms, p50_ms, p95_ms, p99_ms, max_ms, fps);
+
+    if (json_path) {
+        FILE *f = fopen(json_path, "w");
+        if (!f) {
+            fprintf(stderr, "Failed to write frame report '%s'\n", json_path);
+            return;
+        }
+        fprintf(f, "{\"frames\": %d, \"avg_ms\": %.4f, \"min_ms\": %.4f, \"p50_ms\": %.4f, "
+                   "\"p95_ms\": %.4f, \"p99_ms\": %.4f, \"max_ms\": %.4f, \"fps\": %.2f, \"frame_ms\": [",
+                n, avg_ms, min_ms, p50_ms, p95_ms, p99_ms, max_ms, fps);
+        for (int i = 0; i < n; i++) {
+            fprintf(f, "%s%.4f", i ? ", " : "", g_frame_times[i] / 1e6);
+        }
+        fprintf(f, "]}\n");
+        fclose(f);
+    }
+}
@@ -1,5 +1,9 @@
 // module_stb.c (relevant parts only)
 #include "module_stb.h"
+#include "module_sdl.h" // sdl.buffer from the async file loader
+#include "lua_alloc.h"
+#include "lua_blob.h"
+#include "asset_pack.h"
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 #define STB_TRUETYPE_IMPLEMENTATION
@@ -7,6 +11,10 @@
 #include <lauxlib.h>
 #include <lua.h>
 #include <lualib.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 
 static const char *STB_FONT_MT = "stb_font";
@@ -14,6 +22,8 @@ static const char *STB_IMAGE_MT = "stb_image";
 
 typedef struct {
     unsigned char *ttf_buffer;
+    lua_blob *ttf_blob;         // set when baked from a blob: ttf_buffer points into it
+    lua_blob *bitmap_blob;      // owns bitmap, shared by get_bitmap
     unsigned char *bitmap;
     stbtt_bakedchar *cdata;
     int width;
@@ -24,6 +34,7 @@ typedef struct {
 
 typedef struct {
     unsigned char *data;
+    lua_blob *blob;             // set by get_blob, then owns data
     int width;
     int height;
     int channels;
@@ -47,19 +58,44 @@ local height = img:get_height()
 local channels = img:get_channels()
 */
 
-// Lua: stb.load_image(file_path, [desired_channels]) -> image | nil, err_msg
+// Lua: stb.load_image(file_path | buffer | blob, [desired_channels]) -> image | nil, err_msg
+// buffer: an sdl.buffer (e.g. from sdl.async_queue) holding the encoded file
+// blob: a lua_blob holding the encoded file
+// file_path is looked up in the mounted asset packs first.
 static int stb_load_image(lua_State *L) {
-    const char *file_path = luaL_checkstring(L, 1);
+    sdl_buffer *buf = module_sdl_test_buffer(L, 1);
+    lua_blob *blob = buf ? NULL : lua_blob_test(L, 1);
+    const char *file_path = buf || blob ? NULL : luaL_checkstring(L, 1);
     int desired_channels = (int)luaL_optinteger(L, 2, 0); // 0 means use file's channels
     int width, height, channels;
-    unsigned char *data = stbi_load(file_path, &width, &height, &channels, desired_channels);
+    unsigned char *data;
+    lua_blob *packed = file_path ? asset_pack_load(file_path) : NULL;
+    if (packed) {
+        blob = packed;
+        file_path = NULL;
+    }
+    if (buf) {
+        luaL_argcheck(L, buf->data != NULL && buf->size <= INT_MAX, 1, "invalid buffer");
+        data = stbi_load_from_memory((const stbi_uc *)buf->data, (int)buf->size, &width, &height, &channels, desired_channels);
+    } else if (blob) {
+        if (lua_blob_size(blob) > INT_MAX) {
+            if (packed) lua_blob_release(packed); // raising would leak the pack's reference
+            return luaL_argerror(L, 1, "blob too large");
+        }
+        data = stbi_load_from_memory((const stbi_uc *)lua_blob_data(blob), (int)lua_blob_size(blob),
+                                     &width, &height, &channels, desired_channels);
+    } else {
+        data = stbi_load(file_path, &width, &height, &channels, desired_channels);
+    }
+    if (packed) lua_blob_release(packed);
     if (!data) {
         lua_pushnil(L);
         lua_pushstring(L, stbi_failure_reason() ? stbi_failure_reason() : "Unknown error loading image");
         return 2;
     }
-    stb_image *img = (stb_image *)lua_newuserdata(L, sizeof(stb_image));
+    stb_image *img = (stb_image *)lua_alloc_newuserdata(L, sizeof(stb_image), 1, LUA_TAG_STB);
     img->data = data;
+    img->blob = NULL;
     img->width = width;
     img->height = height;
     img->channels = desired_channels ? desired_channels : channels;
@@ -70,13 +106,39 @@ static int stb_load_image(lua_State *L) {
 // Lua: image:free()
 static int stb_image_free(lua_State *L) {
     stb_image *img = (stb_image *)luaL_checkudata(L, 1, STB_IMAGE_MT);
-    if (img->data) {
+    if (img->blob) {
+        lua_blob_release(img->blob); // blobs handed out keep the pixels alive
+        img->blob = NULL;
+    } else if (img->data) {
         stbi_image_free(img->data);
-        img->data = NULL; // Prevent double-free
     }
+    img->data = NULL; // Prevent double-free
     return 0;
 }
 
+static void free_image_pixels(void *data, void *userdata) {
+    stbi_image_free(data);
+}
+
+// Lua: image:get_blob() -> blob | nil
+// The decoded pixels as a lua_blob, without copying; they stay valid after
+// image:free() until every blob is released. Can be sent to jobs and gl.
+static int stb_image_get_blob(lua_State *L) {
+    stb_image *img = (stb_image *)luaL_checkudata(L, 1, STB_IMAGE_MT);
+    if (!img->data) {
+        lua_pushnil(L);
+        return 1;
+    }
+    if (!img->blob) {
+        size_t size = (size_t)img->width * (size_t)img->height * (size_t)img->channels;
+        img->blob = lua_blob_wrap(img->data, size, free_image_pixels, NULL);
+        if (!img->blob) return luaL_error(L, "Out of memory");
+    }
+    lua_blob_retain(img->blob);
+    lua_blob_push(L, img->blob);
+    return 1;
+}
+
 static int stb_free_image(lua_State *L) {
     void *data = lua_touserdata(L, 1);
     if (data) {
@@ -119,6 +181,7 @@ static int stb_image_get_channels(lua_State *L) {
 static const luaL_Reg stb_image_methods[] = {
     {"free", stb_image_free},
     {"get_data", stb_image_get_data},
+    {"get_blob", stb_image_get_blob},
     {"get_width", stb_image_get_width},
     {"get_height", stb_image_get_height},
     {"get_channels", stb_image_get_channels},
@@ -129,59 +192,83 @@ static const luaL_Reg stb_image_methods[] = {
 // typefont
 //===============================================
 
+// Helper: Read a whole file into a malloc'd buffer, NULL on failure
+static unsigned char *read_file(const char *filename) {
+    FILE *f = fopen(filename, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long file_size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    unsigned char *data = file_size > 0 ? (unsigned char *)malloc(file_size) : NULL;
+    if (data && fread(data, 1, file_size, f) != (size_t)file_size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    return data;
+}
+
+// Lua: stb.bake_font(file_path | buffer | blob, pixel_height, bitmap_width, bitmap_height, [first_char], [num_chars]) -> font
+// file_path is looked up in the mounted asset packs first.
 static int stb_bake_font(lua_State *L) {
-    const char *filename = luaL_checkstring(L, 1);
+    sdl_buffer *buf = module_sdl_test_buffer(L, 1);
+    lua_blob *ttf_blob = buf ? NULL : lua_blob_test(L, 1);
+    const char *filename = buf || ttf_blob ? NULL : luaL_checkstring(L, 1);
     float pixel_height = (float)luaL_checknumber(L, 2);
     int bitmap_width = (int)luaL_checkinteger(L, 3);
     int bitmap_height = (int)luaL_checkinteger(L, 4);
     int first_char = (int)luaL_optinteger(L, 5, 32);
     int num_chars = (int)luaL_optinteger(L, 6, 96);
 
-    FILE *f = fopen(filename, "rb");
-    if (!f) {
-        return luaL_error(L, "Failed to open font file: %s", filename);
+    luaL_argcheck(L, bitmap_width > 0 && bitmap_height > 0, 3, "bitmap size must be positive");
+    if (filename && (ttf_blob = asset_pack_load(filename)) != NULL) {
+        // From a mounted asset pack: the stack owns this ref, the font retains its own
+        lua_blob_push(L, ttf_blob);
     }
-
-    fseek(f, 0, SEEK_END);
-    long file_size = ftell(f);
-    fseek(f, 0, SEEK_SET);
-
-    unsigned char *ttf_buffer = (unsigned char *)malloc(file_size);
-    if (!ttf_buffer) {
-        fclose(f);
-        return luaL_error(L, "Memory allocation failed for TTF buffer");
+    unsigned char *ttf_buffer = NULL;
+    if (ttf_blob) {
+        // Blobs are immutable: keep a reference instead of a copy
+        ttf_buffer = (unsigned char *)lua_blob_data(ttf_blob);
+    } else if (buf) {
+        // The font keeps its TTF data, copy it so the buffer can be freed
+        luaL_argcheck(L, buf->data != NULL, 1, "buffer was freed");
+        ttf_buffer = (unsigned char *)malloc(buf->size);
+        if (!ttf_buffer) {
+            return luaL_error(L, "Memory allocation failed for TTF buffer");
+        }
+        memcpy(ttf_buffer, buf->data, buf->size);
+    } else if (!(ttf_buffer = read_file(filename))) {
+        return luaL_error(L, "Failed to read font file: %s", filename);
     }
 
-    if (fread(ttf_buffer, 1, file_size, f) != (size_t)file_size) {
-        free(ttf_buffer);
-        fclose(f);
-        return luaL_error(L, "Failed to read font file");
-    }
-    fclose(f);
-
-    unsigned char *bitmap = (unsigned char *)calloc(bitmap_width * bitmap_height, sizeof(unsigned char));
-    if (!bitmap) {
-        free(ttf_buffer);
+    // The atlas lives in a blob so get_bitmap can share it without copying
+    lua_blob *bitmap_blob = lua_blob_create((size_t)bitmap_width * (size_t)bitmap_height);
+    if (!bitmap_blob) {
+        if (!ttf_blob) free(ttf_buffer);
         return luaL_error(L, "Memory allocation failed for bitmap");
     }
+    unsigned char *bitmap = (unsigned char *)lua_blob_bytes(bitmap_blob);
 
     stbtt_bakedchar *cdata = (stbtt_bakedchar *)malloc(num_chars * sizeof(stbtt_bakedchar));
     if (!cdata) {
-        free(bitmap);
-        free(ttf_buffer);
+        lua_blob_release(bitmap_blob);
+        if (!ttf_blob) free(ttf_buffer);
         return luaL_error(L, "Memory allocation failed for cdata");
     }
 
     int bake_result = stbtt_BakeFontBitmap(ttf_buffer, 0, pixel_height, bitmap, bitmap_width, bitmap_height, first_char, num_chars, cdata);
     if (bake_result <= 0) {
         free(cdata);
-        free(bitmap);
-        free(ttf_buffer);
+        lua_blob_release(bitmap_blob);
+        if (!ttf_blob) free(ttf_buffer);
         return luaL_error(L, "stbtt_BakeFontBitmap failed with code: %d", bake_result);
     }
 
-    stb_font *font = (stb_font *)lua_newuserdata(L, sizeof(stb_font));
+    if (ttf_blob) lua_blob_retain(ttf_blob);
+    stb_font *font = (stb_font *)lua_alloc_newuserdata(L, sizeof(stb_font), 1, LUA_TAG_STB);
     font->ttf_buffer = ttf_buffer;
+    font->ttf_blob = ttf_blob;
+    font->bitmap_blob = bitmap_blob;
     font->bitmap = bitmap;
     font->cdata = cdata;
     font->width = bitmap_width;
@@ -196,15 +283,25 @@ static int stb_bake_font(lua_State *L) {
 
 static int stb_font_gc(lua_State *L) {
     stb_font *font = (stb_font *)luaL_checkudata(L, 1, STB_FONT_MT);
-    if (font->ttf_buffer) free(font->ttf_buffer);
-    if (font->bitmap) free(font->bitmap);
+    if (font->ttf_blob) lua_blob_release(font->ttf_blob);
+    else if (font->ttf_buffer) free(font->ttf_buffer);
+    if (font->bitmap_blob) lua_blob_release(font->bitmap_blob);
     if (font->cdata) free(font->cdata);
+    font->ttf_buffer = NULL;
+    font->ttf_blob = NULL;
+    font->bitmap_blob = NULL;
+    font->bitmap = NULL;
+    font->cdata = NULL;
     return 0;
 }
 
+// Lua: font:get_bitmap() -> blob, width, height
+// The 8-bit alpha atlas as a lua_blob shared with the font (no copy); pass it to
+// gl.tex_image_2d, or blob:to_string() for a string copy.
 static int stb_font_get_bitmap(lua_State *L) {
     stb_font *font = (stb_font *)luaL_checkudata(L, 1, STB_FONT_MT);
-    lua_pushlstring(L, (const char *)font->bitmap, font->width * font->height);
+    lua_blob_retain(font->bitmap_blob);
+    lua_blob_push(L, font->bitmap_blob);
     lua_pushinteger(L, font->width);
     lua_pushinteger(L, font->height);
     return 3;
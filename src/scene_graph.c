@@ -0,0 +1,379 @@
+// scene_graph.c
+#include "scene_graph.h"
+#include "module_jobs.h"
+#include "module_prof.h"
+#include <SDL3/SDL.h>
+#include <cglm/cglm.h>
+
+// Dirty subtrees smaller than this in total are updated on the calling thread
+#define PARALLEL_MIN_NODES 4096
+#define MAX_CHUNKS 256
+
+// Per-slot columns, moved together when slots shift
+#define SCENE_COLUMNS(X) \
+    X(world) X(position) X(rotation) X(scale) X(parent) X(size) X(slot_id) X(dirty)
+
+struct scene_graph {
+    int count;
+    int capacity;
+    // per slot, in depth-first order
+    mat4 *world;                // 64-byte aligned
+    vec3 *position;
+    vec3 *rotation;
+    vec3 *scale;
+    int *parent;                // slot of the parent, -1 for roots
+    int *size;                  // nodes in the subtree, itself included
+    int *slot_id;
+    Uint8 *dirty;               // local transform changed since the last update
+    // per id
+    int *id_slot;               // -1 for free ids
+    int id_limit;               // ids handed out so far
+    int *free_ids;
+    int free_count;
+    // ids of dirty nodes, each at most once
+    int *dirty_ids;
+    int dirty_count;
+    // update scratch: slots starting the subtrees to recompute
+    int *ranges;
+};
+
+// Helper: Grow every array to hold capacity nodes
+static int reserve(scene_graph *g, int capacity) {
+    if (capacity <= g->capacity) return 1;
+    if (capacity > SCENE_GRAPH_MAX_NODES) return SDL_SetError("Scene graph full");
+    int n = SDL_max(capacity, g->capacity * 2);
+    n = SDL_min(SDL_max(n, 64), SCENE_GRAPH_MAX_NODES);
+
+    mat4 *world = (mat4 *)SDL_aligned_alloc(64, (size_t)n * sizeof(mat4));
+    if (!world) return 0;
+    if (g->count) SDL_memcpy(world, g->world, (size_t)g->count * sizeof(mat4));
+    SDL_aligned_free(g->world);
+    g->world = world;
+#define GROW(col) \
+    { void *p = SDL_realloc(g->col, (size_t)n * sizeof(*g->col)); if (!p) return 0; g->col = p; }
+    GROW(position) GROW(rotation) GROW(scale) GROW(parent) GROW(size) GROW(slot_id) GROW(dirty)
+    GROW(id_slot) GROW(free_ids) GROW(dirty_ids) GROW(ranges)
+#undef GROW
+    g->capacity = n;
+    return 1;
+}
+
+scene_graph *scene_graph_create(int capacity) {
+    scene_graph *g = (scene_graph *)SDL_calloc(1, sizeof(scene_graph));
+    if (!g) return NULL;
+    if (!reserve(g, SDL_max(capacity, 1))) {
+        scene_graph_destroy(g);
+        return NULL;
+    }
+    return g;
+}
+
+void scene_graph_destroy(scene_graph *g) {
+    if (!g) return;
+    SDL_aligned_free(g->world);
+    SDL_free(g->position);
+    SDL_free(g->rotation);
+    SDL_free(g->scale);
+    SDL_free(g->parent);
+    SDL_free(g->size);
+    SDL_free(g->slot_id);
+    SDL_free(g->dirty);
+    SDL_free(g->id_slot);
+    SDL_free(g->free_ids);
+    SDL_free(g->dirty_ids);
+    SDL_free(g->ranges);
+    SDL_free(g);
+}
+
+//===============================================
+// structure
+//===============================================
+
+// Helper: Move the n slots from src to dst in every column
+static void move_slots(scene_graph *g, int dst, int src, int n) {
+    if (n <= 0 || dst == src) return;
+#define MOVE_COLUMN(col) SDL_memmove(&g->col[dst], &g->col[src], (size_t)n * sizeof(*g->col));
+    SCENE_COLUMNS(MOVE_COLUMN)
+#undef MOVE_COLUMN
+}
+
+// Helper: Open n free slots at slot, shifting the slots after it up
+static void open_gap(scene_graph *g, int slot, int n) {
+    move_slots(g, slot + n, slot, g->count - slot);
+    g->count += n;
+    for (int s = slot + n; s < g->count; s++) {
+        g->id_slot[g->slot_id[s]] = s;
+        if (g->parent[s] >= slot) g->parent[s] += n;
+    }
+}
+
+// Helper: Drop the n slots at slot, shifting the slots after it down
+static void close_gap(scene_graph *g, int slot, int n) {
+    move_slots(g, slot, slot + n, g->count - slot - n);
+    g->count -= n;
+    for (int s = slot; s < g->count; s++) {
+        g->id_slot[g->slot_id[s]] = s;
+        if (g->parent[s] >= slot + n) g->parent[s] -= n;
+    }
+}
+
+// Helper: Copy the n slots at slot to buf (to_buf) or back from it
+static void copy_slots(scene_graph *g, int slot, int n, Uint8 *buf, int to_buf) {
+#define COPY_COLUMN(col) { \
+        size_t bytes = (size_t)n * sizeof(*g->col); \
+        if (to_buf) SDL_memcpy(buf, &g->col[slot], bytes); \
+        else SDL_memcpy(&g->col[slot], buf, bytes); \
+        buf += bytes; \
+    }
+    SCENE_COLUMNS(COPY_COLUMN)
+#undef COPY_COLUMN
+}
+
+// Helper: Add delta to the subtree size of slot and its ancestors
+static void grow_ancestors(scene_graph *g, int slot, int delta) {
+    for (int p = slot; p >= 0; p = g->parent[p]) {
+        g->size[p] += delta;
+    }
+}
+
+static void mark_dirty(scene_graph *g, int slot) {
+    if (g->dirty[slot]) return;
+    g->dirty[slot] = 1;
+    g->dirty_ids[g->dirty_count++] = g->slot_id[slot];
+}
+
+int scene_graph_valid(const scene_graph *g, int id) {
+    return id >= 0 && id < g->id_limit && g->id_slot[id] >= 0;
+}
+
+int scene_graph_add(scene_graph *g, int parent) {
+    if (!reserve(g, g->count + 1)) return -1;
+    int pslot = parent == SCENE_GRAPH_NONE ? -1 : g->id_slot[parent];
+    int slot = pslot < 0 ? g->count : pslot + g->size[pslot];
+    int id = g->free_count ? g->free_ids[--g->free_count] : g->id_limit++;
+    open_gap(g, slot, 1);
+
+    glm_mat4_identity(g->world[slot]);
+    glm_vec3_zero(g->position[slot]);
+    glm_vec3_zero(g->rotation[slot]);
+    glm_vec3_one(g->scale[slot]);
+    g->parent[slot] = pslot;
+    g->size[slot] = 1;
+    g->slot_id[slot] = id;
+    g->dirty[slot] = 0;
+    g->id_slot[id] = slot;
+    grow_ancestors(g, pslot, 1);
+    mark_dirty(g, slot);  // picks up the parent's world matrix
+    return id;
+}
+
+void scene_graph_remove(scene_graph *g, int id) {
+    int slot = g->id_slot[id];
+    int n = g->size[slot];
+    int had_dirty = 0;
+    for (int s = slot; s < slot + n; s++) {
+        g->id_slot[g->slot_id[s]] = -1;
+        g->free_ids[g->free_count++] = g->slot_id[s];
+        had_dirty |= g->dirty[s];
+    }
+    grow_ancestors(g, g->parent[slot], -n);
+    close_gap(g, slot, n);
+    if (had_dirty) {
+        // Forget the removed ids, they may be handed out again
+        int kept = 0;
+        for (int i = 0; i < g->dirty_count; i++) {
+            if (g->id_slot[g->dirty_ids[i]] >= 0) g->dirty_ids[kept++] = g->dirty_ids[i];
+        }
+        g->dirty_count = kept;
+    }
+}
+
+int scene_graph_set_parent(scene_graph *g, int id, int parent) {
+    int slot = g->id_slot[id];
+    int n = g->size[slot];
+    int pslot = parent == SCENE_GRAPH_NONE ? -1 : g->id_slot[parent];
+    if (pslot >= slot && pslot < slot + n) {
+        return SDL_SetError("A node cannot become its own descendant");
+    }
+    if (pslot == g->parent[slot]) return 1;
+
+#define COLUMN_SIZE(col) + sizeof(*g->col)
+    Uint8 *buf = (Uint8 *)SDL_malloc((size_t)n * (0 SCENE_COLUMNS(COLUMN_SIZE)));
+#undef COLUMN_SIZE
+    if (!buf) return 0;
+    copy_slots(g, slot, n, buf, 1);
+    grow_ancestors(g, g->parent[slot], -n);
+    close_gap(g, slot, n);
+    if (pslot > slot) pslot -= n;  // pslot is not in the subtree
+
+    int dst = pslot < 0 ? g->count : pslot + g->size[pslot];
+    open_gap(g, dst, n);
+    copy_slots(g, dst, n, buf, 0);
+    SDL_free(buf);
+    g->parent[dst] = pslot;
+    for (int s = dst; s < dst + n; s++) {
+        if (s > dst) g->parent[s] += dst - slot;  // copied parents are the old slots
+        g->id_slot[g->slot_id[s]] = s;
+    }
+    grow_ancestors(g, pslot, n);
+    mark_dirty(g, dst);
+    return 1;
+}
+
+int scene_graph_parent(const scene_graph *g, int id) {
+    int p = g->parent[g->id_slot[id]];
+    return p < 0 ? SCENE_GRAPH_NONE : g->slot_id[p];
+}
+
+int scene_graph_count(const scene_graph *g) {
+    return g->count;
+}
+
+int scene_graph_id_limit(const scene_graph *g) {
+    return g->id_limit;
+}
+
+//===============================================
+// transforms
+//===============================================
+
+void scene_graph_set_position(scene_graph *g, int id, const float v[3]) {
+    int slot = g->id_slot[id];
+    SDL_memcpy(g->position[slot], v, sizeof(vec3));
+    mark_dirty(g, slot);
+}
+
+void scene_graph_set_rotation(scene_graph *g, int id, const float v[3]) {
+    int slot = g->id_slot[id];
+    SDL_memcpy(g->rotation[slot], v, sizeof(vec3));
+    mark_dirty(g, slot);
+}
+
+void scene_graph_set_scale(scene_graph *g, int id, const float v[3]) {
+    int slot = g->id_slot[id];
+    SDL_memcpy(g->scale[slot], v, sizeof(vec3));
+    mark_dirty(g, slot);
+}
+
+void scene_graph_get_position(const scene_graph *g, int id, float out[3]) {
+    SDL_memcpy(out, g->position[g->id_slot[id]], sizeof(vec3));
+}
+
+void scene_graph_get_rotation(const scene_graph *g, int id, float out[3]) {
+    SDL_memcpy(out, g->rotation[g->id_slot[id]], sizeof(vec3));
+}
+
+void scene_graph_get_scale(const scene_graph *g, int id, float out[3]) {
+    SDL_memcpy(out, g->scale[g->id_slot[id]], sizeof(vec3));
+}
+
+const float *scene_graph_world(const scene_graph *g, int id) {
+    return (const float *)g->world[g->id_slot[id]];
+}
+
+//===============================================
+// update
+//===============================================
+
+// Helper: World matrices of slots [first, end); the parent of first is up to date
+static void compute_slots(scene_graph *g, int first, int end) {
+    for (int s = first; s < end; s++) {
+        mat4 local;
+        glm_euler_xyz(g->rotation[s], local);
+        glm_vec4_scale(local[0], g->scale[s][0], local[0]);
+        glm_vec4_scale(local[1], g->scale[s][1], local[1]);
+        glm_vec4_scale(local[2], g->scale[s][2], local[2]);
+        local[3][0] = g->position[s][0];
+        local[3][1] = g->position[s][1];
+        local[3][2] = g->position[s][2];
+        int p = g->parent[s];
+        if (p >= 0) {
+            glm_mat4_mul(g->world[p], local, g->world[s]);
+        } else {
+            glm_mat4_copy(local, g->world[s]);
+        }
+        g->dirty[s] = 0;
+    }
+}
+
+typedef struct {
+    scene_graph *g;
+    int chunk_first[MAX_CHUNKS + 1];    // chunk i: ranges [chunk_first[i], chunk_first[i + 1])
+} update_batch;
+
+static void compute_chunk(void *userdata, int index) {
+    update_batch *b = (update_batch *)userdata;
+    scene_graph *g = b->g;
+    for (int r = b->chunk_first[index]; r < b->chunk_first[index + 1]; r++) {
+        int first = g->ranges[r];
+        compute_slots(g, first, first + g->size[first]);
+    }
+}
+
+static int compare_ints(const void *a, const void *b) {
+    int x = *(const int *)a;
+    int y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+int scene_graph_update(scene_graph *g, int parallel) {
+    if (g->dirty_count == 0) return 0;
+    PROF_BEGIN("scene_graph.update");
+
+    // Dirty slots in order; a dirty node's subtree covers any dirty descendant
+    int range_count = 0, total = 0, covered_end = 0;
+    for (int i = 0; i < g->dirty_count; i++) {
+        g->ranges[i] = g->id_slot[g->dirty_ids[i]];
+    }
+    SDL_qsort(g->ranges, (size_t)g->dirty_count, sizeof(int), compare_ints);
+    for (int i = 0; i < g->dirty_count; i++) {
+        int slot = g->ranges[i];
+        if (slot < covered_end) continue;
+        covered_end = slot + g->size[slot];
+        total += g->size[slot];
+        g->ranges[range_count++] = slot;
+    }
+    g->dirty_count = 0;
+
+    int threads = parallel ? module_jobs_thread_count() : 0;
+    if (threads == 0 || total < PARALLEL_MIN_NODES) {
+        for (int r = 0; r < range_count; r++) {
+            compute_slots(g, g->ranges[r], g->ranges[r] + g->size[g->ranges[r]]);
+        }
+        PROF_END();
+        return total;
+    }
+
+    // Split subtrees larger than a chunk: compute the root here, queue its children
+    int chunk_nodes = SDL_max(total / ((threads + 1) * 4), 1);
+    for (int r = 0; r < range_count; r++) {
+        int root = g->ranges[r];
+        while (g->size[root] > chunk_nodes && g->size[root] > 1) {
+            compute_slots(g, root, root + 1);
+            int end = root + g->size[root];
+            int child = root + 1;
+            root = child;                   // the first child takes this range's place
+            for (child += g->size[child]; child < end; child += g->size[child]) {
+                g->ranges[range_count++] = child;
+            }
+        }
+        g->ranges[r] = root;
+    }
+
+    // Group consecutive ranges into chunks of about chunk_nodes nodes
+    update_batch batch;
+    batch.g = g;
+    int chunks = 0, nodes = 0;
+    batch.chunk_first[0] = 0;
+    for (int r = 0; r < range_count; r++) {
+        nodes += g->size[g->ranges[r]];
+        if (nodes >= chunk_nodes && chunks < MAX_CHUNKS - 1) {
+            batch.chunk_first[++chunks] = r + 1;
+            nodes = 0;
+        }
+    }
+    if (batch.chunk_first[chunks] < range_count) batch.chunk_first[++chunks] = range_count;
+    module_jobs_parallel_for(chunks, compute_chunk, &batch);
+    PROF_END();
+    return total;
+}
@@ -0,0 +1,283 @@
+// script_cache.c
+// Cache file: cache_header, the script path, then the lua_dump output. The file
+// name is a hash of the path; the path stored inside guards against collisions.
+#include "script_cache.h"
+#include "asset_pack.h"
+#include <SDL3/SDL.h>
+#include <lauxlib.h>
+
+#define CACHE_MAGIC "LBC1"
+
+typedef struct {
+    char magic[4];
+    Uint32 path_len;
+    Sint64 mtime;               // SDL_PathInfo.modify_time of the source
+    Uint64 source_hash;
+    Uint64 bytecode_size;
+} cache_header;
+
+#ifdef SDL3_LUA_EMBED_SCRIPTS
+extern const script_bundle_entry script_bundle[];  // generated by tools/lua_embed.c
+#else
+static const script_bundle_entry script_bundle[] = {{NULL, NULL, 0}};
+#endif
+
+static char *g_cache_dir = NULL;
+
+// FNV-1a, 64 bit
+static Uint64 hash_bytes(const void *data, size_t size) {
+    const Uint8 *p = (const Uint8 *)data;
+    Uint64 h = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < size; i++) {
+        h ^= p[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+// Helper: "./examples\lua/a.lua" -> "examples/lua/a.lua", the form bundle entries use
+static void normalize_path(const char *path, char *out, size_t out_size) {
+    while (path[0] == '.' && (path[1] == '/' || path[1] == '\\')) {
+        path += 2;
+    }
+    size_t n = 0;
+    for (; *path && n + 1 < out_size; path++) {
+        out[n++] = *path == '\\' ? '/' : *path;
+    }
+    out[n] = '\0';
+}
+
+static const script_bundle_entry *find_bundled(const char *path) {
+    char key[1024];
+    normalize_path(path, key, sizeof(key));
+    for (const script_bundle_entry *e = script_bundle; e->path; e++) {
+        if (SDL_strcmp(e->path, key) == 0) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+int script_cache_is_bundled(const char *path) {
+    return find_bundled(path) != NULL;
+}
+
+typedef struct {
+    char *data;
+    size_t size;
+    size_t capacity;
+} dump_buffer;
+
+static int dump_writer(lua_State *L, const void *p, size_t sz, void *ud) {
+    dump_buffer *buf = (dump_buffer *)ud;
+    if (buf->size + sz > buf->capacity) {
+        size_t capacity = buf->capacity ? buf->capacity * 2 : 4096;
+        while (capacity < buf->size + sz) capacity *= 2;
+        char *data = (char *)SDL_realloc(buf->data, capacity);
+        if (!data) return 1;
+        buf->data = data;
+        buf->capacity = capacity;
+    }
+    SDL_memcpy(buf->data + buf->size, p, sz);
+    buf->size += sz;
+    return 0;
+}
+
+static void cache_file_path(const char *path, char *out, size_t out_size) {
+    SDL_snprintf(out, out_size, "%s/%016llx.luac", g_cache_dir,
+                 (unsigned long long)hash_bytes(path, SDL_strlen(path)));
+}
+
+// Helper: Push the cached chunk of path if it is still valid, returns 1 on a hit
+static int load_cached(lua_State *L, const char *path, const char *chunkname, Sint64 mtime, Uint64 hash) {
+    char file[1024];
+    cache_file_path(path, file, sizeof(file));
+    size_t size = 0;
+    Uint8 *data = (Uint8 *)SDL_LoadFile(file, &size);
+    if (!data) return 0;
+
+    cache_header h;
+    size_t path_len = SDL_strlen(path);
+    int valid = size >= sizeof(h);
+    if (valid) {
+        SDL_memcpy(&h, data, sizeof(h));
+        valid = SDL_memcmp(h.magic, CACHE_MAGIC, 4) == 0 &&
+                h.path_len == path_len && h.mtime == mtime && h.source_hash == hash &&
+                h.bytecode_size == size - sizeof(h) - path_len &&
+                SDL_memcmp(data + sizeof(h), path, path_len) == 0;
+    }
+    // Bytecode from another Lua build fails to load here and is rebuilt by the caller
+    int status = valid ? luaL_loadbufferx(L, (const char *)data + sizeof(h) + path_len,
+                                          (size_t)h.bytecode_size, chunkname, "b") : LUA_ERRFILE;
+    SDL_free(data);
+    if (status != LUA_OK) {
+        if (valid) lua_pop(L, 1);
+        return 0;
+    }
+    return 1;
+}
+
+// Helper: Dump the chunk on top of the stack into the cache
+static void store_cached(lua_State *L, const char *path, Sint64 mtime, Uint64 hash) {
+    dump_buffer buf = {0};
+    if (lua_dump(L, dump_writer, &buf, 0) != 0 || !buf.data) {
+        SDL_free(buf.data);
+        return;
+    }
+    SDL_CreateDirectory(g_cache_dir);
+
+    char file[1024], tmp[1100];
+    cache_file_path(path, file, sizeof(file));
+    // Per-thread temporary name, worker states (module_jobs) share the cache
+    SDL_snprintf(tmp, sizeof(tmp), "%s.%llu.tmp", file, (unsigned long long)SDL_GetCurrentThreadID());
+    SDL_IOStream *io = SDL_IOFromFile(tmp, "wb");
+    if (io) {
+        cache_header h;
+        SDL_memcpy(h.magic, CACHE_MAGIC, 4);
+        h.path_len = (Uint32)SDL_strlen(path);
+        h.mtime = mtime;
+        h.source_hash = hash;
+        h.bytecode_size = buf.size;
+        int ok = SDL_WriteIO(io, &h, sizeof(h)) == sizeof(h) &&
+                 SDL_WriteIO(io, path, h.path_len) == h.path_len &&
+                 SDL_WriteIO(io, buf.data, buf.size) == buf.size;
+        ok = SDL_CloseIO(io) && ok;
+        // Write then rename, so a crash never leaves a torn cache file behind
+        if (!ok || !SDL_RenamePath(tmp, file)) {
+            SDL_RemovePath(tmp);
+        }
+    }
+    SDL_free(buf.data);
+}
+
+// Helper: Compile source, skipping a UTF-8 BOM and a '#' first line like
+// luaL_loadfile, keeping the newline so line numbers in error messages stay the same.
+// Text only: binary chunks are loaded from the bundle and the cache, which we wrote
+static int load_source(lua_State *L, const char *text, size_t size, const char *chunkname) {
+    if (size >= 3 && SDL_memcmp(text, "\xEF\xBB\xBF", 3) == 0) {
+        text += 3;
+        size -= 3;
+    }
+    if (size > 0 && text[0] == '#') {
+        while (size > 0 && *text != '\n') {
+            text++;
+            size--;
+        }
+    }
+    return luaL_loadbufferx(L, text, size, chunkname, "t");
+}
+
+int script_cache_loadfile(lua_State *L, const char *path) {
+    char chunkname[1024];
+    SDL_snprintf(chunkname, sizeof(chunkname), "@%s", path);
+    // Asset packs hold source, compiled in place from the mapping
+    lua_blob *packed = asset_pack_load(path);
+    if (packed) {
+        int status = load_source(L, (const char *)lua_blob_data(packed), lua_blob_size(packed), chunkname);
+        lua_blob_release(packed);
+        return status;
+    }
+    // The bundle is only a fallback for scripts missing on disk, so edited files
+    // win over the bytecode compiled into the binary
+    const script_bundle_entry *e = find_bundled(path);
+    SDL_PathInfo info;
+    if (e && !(SDL_GetPathInfo(path, &info) && info.type == SDL_PATHTYPE_FILE)) {
+        return luaL_loadbufferx(L, (const char *)e->data, e->size, chunkname, "b");
+    }
+    if (!g_cache_dir) {
+        return luaL_loadfile(L, path);
+    }
+
+    size_t size = 0;
+    char *source = (char *)SDL_LoadFile(path, &size);
+    if (!source) {
+        return luaL_loadfile(L, path);  // for Lua's usual error message
+    }
+    Sint64 mtime = SDL_GetPathInfo(path, &info) ? (Sint64)info.modify_time : 0;
+    Uint64 hash = hash_bytes(source, size);
+    if (load_cached(L, path, chunkname, mtime, hash)) {
+        SDL_free(source);
+        return LUA_OK;
+    }
+
+    int status = load_source(L, source, size, chunkname);
+    if (status == LUA_OK) {
+        store_cached(L, path, mtime, hash);
+    }
+    SDL_free(source);
+    return status;
+}
+
+// package.searchers entry: look name up on package.path like the stock Lua
+// searcher, but load through asset packs, the bytecode cache and the bundle. Misses fall
+// through to the stock searcher, which also reports the paths tried.
+static int cache_searcher(lua_State *L) {
+    const char *name = luaL_checkstring(L, 1);
+    lua_getglobal(L, "package");
+    lua_getfield(L, -1, "path");
+    const char *templates = lua_tostring(L, -1);
+    if (!templates) return 0;
+
+    char module_path[512];
+    SDL_strlcpy(module_path, name, sizeof(module_path));
+    for (char *c = module_path; *c; c++) {
+        if (*c == '.') *c = '/';
+    }
+
+    while (*templates) {
+        const char *end = SDL_strchr(templates, ';');
+        if (!end) end = templates + SDL_strlen(templates);
+        luaL_Buffer b;
+        luaL_buffinit(L, &b);
+        for (const char *c = templates; c < end; c++) {
+            if (*c == '?') luaL_addstring(&b, module_path);
+            else luaL_addchar(&b, *c);
+        }
+        luaL_pushresult(&b);
+        const char *filename = lua_tostring(L, -1);
+
+        SDL_PathInfo info;
+        if (asset_pack_contains(filename) ||
+            (SDL_GetPathInfo(filename, &info) && info.type == SDL_PATHTYPE_FILE) || find_bundled(filename)) {
+            if (script_cache_loadfile(L, filename) != LUA_OK) {
+                return luaL_error(L, "error loading module '%s' from file '%s':\n\t%s",
+                                  name, filename, lua_tostring(L, -1));
+            }
+            lua_insert(L, -2);  // loader, filename
+            return 2;
+        }
+        lua_pop(L, 1);
+        templates = *end ? end + 1 : end;
+    }
+    return 0;
+}
+
+void script_cache_init(lua_State *L, const char *cache_dir) {
+    SDL_free(g_cache_dir);
+    g_cache_dir = cache_dir ? SDL_strdup(cache_dir) : NULL;
+    script_cache_install(L);
+}
+
+void script_cache_install(lua_State *L) {
+    if (!g_cache_dir && !script_bundle[0].path && asset_pack_mount_count() == 0) {
+        return;
+    }
+
+    // Insert right after the preload searcher, once (lua_util.pack_mount calls this again)
+    lua_getglobal(L, "package");
+    lua_getfield(L, -1, "searchers");
+    lua_rawgeti(L, -1, 2);
+    int installed = lua_tocfunction(L, -1) == cache_searcher;
+    lua_pop(L, 1);
+    if (installed) {
+        lua_pop(L, 2);
+        return;
+    }
+    for (int i = (int)lua_rawlen(L, -1); i >= 2; i--) {
+        lua_rawgeti(L, -1, i);
+        lua_rawseti(L, -2, i + 1);
+    }
+    lua_pushcfunction(L, cache_searcher);
+    lua_rawseti(L, -2, 2);
+    lua_pop(L, 2);
+}
@@ -0,0 +1,202 @@
+// bench_bindings.c
+// Measures the cost of Lua -> C binding calls. Hosts a Lua state with every
+// project module preloaded and GLAD loaded from no-op stubs, so module_gl calls
+// cost only the binding, then runs tools/bench_bindings.lua, which calls each
+// registered function with representative arguments and writes a JSON report.
+//
+// Usage: sdl3_lua_bench [harness.lua] [out.json]
+#include <SDL3/SDL.h>
+#include <glad/gl.h>  // GLAD 2.0
+#include <lua.h>
+#include <lauxlib.h>
+#include <lualib.h>
+#include <stdio.h>
+#include "lua_alloc.h"
+#include "lua_modules.h"
+#include "module_gl.h"
+
+#define BENCH_MIN_NS (10 * SDL_NS_PER_MS)   // calibration target per measurement
+#define BENCH_RUNS 3                        // best of
+
+//===============================================
+// GL stubs
+//===============================================
+
+// Every GL entry point without a dedicated stub returns 0 and ignores its
+// arguments; the caller cleans up the stack on the supported ABIs.
+static uintptr_t GLAD_API_PTR stub_zero(void) {
+    return 0;
+}
+
+static const GLubyte *GLAD_API_PTR stub_get_string(GLenum name) {
+    return (const GLubyte *)(name == GL_VERSION ? "3.3.0 bench stub" : "");
+}
+
+static const GLubyte *GLAD_API_PTR stub_get_stringi(GLenum name, GLuint index) {
+    return (const GLubyte *)"";
+}
+
+static void GLAD_API_PTR stub_get_integerv(GLenum pname, GLint *data) {
+    *data = 0;  // also GL_NUM_EXTENSIONS during gladLoadGL
+}
+
+// Shaders and programs report success so the bindings skip the info log path
+static void GLAD_API_PTR stub_get_iv(GLuint object, GLenum pname, GLint *params) {
+    *params = GL_TRUE;
+}
+
+static GLADapiproc stub_loader(const char *name) {
+    if (SDL_strcmp(name, "glGetString") == 0) return (GLADapiproc)stub_get_string;
+    if (SDL_strcmp(name, "glGetStringi") == 0) return (GLADapiproc)stub_get_stringi;
+    if (SDL_strcmp(name, "glGetIntegerv") == 0) return (GLADapiproc)stub_get_integerv;
+    if (SDL_strcmp(name, "glGetShaderiv") == 0) return (GLADapiproc)stub_get_iv;
+    if (SDL_strcmp(name, "glGetProgramiv") == 0) return (GLADapiproc)stub_get_iv;
+    return (GLADapiproc)stub_zero;
+}
+
+//===============================================
+// bench library
+//===============================================
+
+// Helper: Call the function at fn with the nargs values after it, iterations times
+static int run_calls(lua_State *L, int fn, int nargs, Uint64 iterations, Uint64 *elapsed_ns) {
+    Uint64 start = SDL_GetTicksNS();
+    for (Uint64 i = 0; i < iterations; i++) {
+        lua_pushvalue(L, fn);
+        for (int a = 1; a <= nargs; a++) {
+            lua_pushvalue(L, fn + a);
+        }
+        int status = lua_pcall(L, nargs, 0, 0);
+        if (status != LUA_OK) return status;
+    }
+    *elapsed_ns = SDL_GetTicksNS() - start;
+    return LUA_OK;
+}
+
+// Lua: bench.measure(fn, ...) -> {ns, allocs, bytes, iterations} | nil, err
+// Calls fn(...) in a C loop: ns per call is the best of BENCH_RUNS runs of
+// about BENCH_MIN_NS each; allocs and bytes per call are the minimum over the same
+// runs, counted by the pooled allocator.
+static int bench_measure(lua_State *L) {
+    luaL_checktype(L, 1, LUA_TFUNCTION);
+    int nargs = lua_gettop(L) - 1;
+    luaL_checkstack(L, nargs + LUA_MINSTACK, "too many arguments");
+
+    Uint64 iterations = 16;
+    Uint64 elapsed = 0;
+    for (;;) {
+        if (run_calls(L, 1, nargs, iterations, &elapsed) != LUA_OK) {
+            lua_pushnil(L);
+            lua_insert(L, -2);
+            return 2;
+        }
+        if (elapsed >= BENCH_MIN_NS || iterations >= ((Uint64)1 << 32)) break;
+        iterations *= 2;
+    }
+
+    double best_ns = 0.0;
+    Uint64 min_allocs = 0, min_bytes = 0;
+    lua_alloc_stats before, after;
+    SDL_zero(before);
+    SDL_zero(after);
+    for (int run = 0; run < BENCH_RUNS; run++) {
+        lua_gc(L, LUA_GCCOLLECT);
+        lua_alloc_get_stats(L, &before);
+        if (run_calls(L, 1, nargs, iterations, &elapsed) != LUA_OK) {
+            lua_pushnil(L);
+            lua_insert(L, -2);
+            return 2;
+        }
+        lua_alloc_get_stats(L, &after);
+        double ns = (double)elapsed / (double)iterations;
+        Uint64 allocs = after.allocs - before.allocs;
+        Uint64 bytes = after.total_bytes - before.total_bytes;
+        if (run == 0 || ns < best_ns) best_ns = ns;
+        if (run == 0 || allocs < min_allocs) min_allocs = allocs;
+        if (run == 0 || bytes < min_bytes) min_bytes = bytes;
+    }
+
+    lua_createtable(L, 0, 4);
+    lua_pushnumber(L, best_ns);
+    lua_setfield(L, -2, "ns");
+    lua_pushnumber(L, (double)min_allocs / (double)iterations);
+    lua_setfield(L, -2, "allocs");
+    lua_pushnumber(L, (double)min_bytes / (double)iterations);
+    lua_setfield(L, -2, "bytes");
+    lua_pushinteger(L, (lua_Integer)iterations);
+    lua_setfield(L, -2, "iterations");
+    return 1;
+}
+
+// Baselines: a bare call, argument checking alone, and a userdata allocation
+// alone, to split up the cost of a real binding.
+
+// Lua: bench.noop()
+static int bench_noop(lua_State *L) {
+    return 0;
+}
+
+// Lua: bench.check4(a, b, c, d) -- four luaL_checkinteger
+static int bench_check4(lua_State *L) {
+    lua_Integer sum = luaL_checkinteger(L, 1) + luaL_checkinteger(L, 2) +
+                      luaL_checkinteger(L, 3) + luaL_checkinteger(L, 4);
+    (void)sum;
+    return 0;
+}
+
+// Lua: bench.userdata() -> userdata -- 64 bytes with a metatable, like a cglm mat4
+static int bench_userdata(lua_State *L) {
+    lua_alloc_newuserdata(L, 64, 0, LUA_TAG_LUA);
+    luaL_setmetatable(L, "bench.userdata");
+    return 1;
+}
+
+static const luaL_Reg bench_lib[] = {
+    {"measure", bench_measure},
+    {"noop", bench_noop},
+    {"check4", bench_check4},
+    {"userdata", bench_userdata},
+    {NULL, NULL}
+};
+
+int main(int argc, char **argv) {
+    const char *harness = argc > 1 ? argv[1] : "tools/bench_bindings.lua";
+    const char *out_path = argc > 2 ? argv[2] : "bench_bindings.json";
+
+    if (!gladLoadGL(stub_loader)) {
+        fprintf(stderr, "Failed to load the GL stubs\n");
+        return 1;
+    }
+    void *alloc_ud = lua_alloc_create();
+    lua_State *L = alloc_ud ? lua_newstate(lua_alloc_fn, alloc_ud) : NULL;
+    if (!L) {
+        fprintf(stderr, "Failed to create Lua state\n");
+        lua_alloc_destroy(alloc_ud);
+        return 1;
+    }
+    luaL_openlibs(L);
+    lua_modules_preload(L, LUA_MODULES_MAIN);
+    // Any non-NULL context passes module_gl's context checks, GL calls hit the stubs
+    static int dummy_context;
+    module_gl_set_context(&dummy_context);
+
+    luaL_newmetatable(L, "bench.userdata");
+    lua_pop(L, 1);
+    luaL_newlib(L, bench_lib);
+    lua_setglobal(L, "bench");
+    lua_createtable(L, 1, 0);
+    lua_pushstring(L, out_path);
+    lua_rawseti(L, -2, 1);
+    lua_setglobal(L, "arg");
+
+    int result = 0;
+    if (luaL_dofile(L, harness) != LUA_OK) {
+        fprintf(stderr, "Error: %s\n", lua_tostring(L, -1));
+        result = 1;
+    }
+    module_gl_set_context(NULL);
+    lua_close(L);
+    lua_alloc_destroy(alloc_ud);
+    SDL_Quit();
+    return result;
+}
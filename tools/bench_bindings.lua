@@ -0,0 +1,552 @@
+-- bench_bindings.lua
+-- Binding call-overhead benchmark, run by sdl3_lua_bench (tools/bench_bindings.c):
+--   cmake --build build --target bench_bindings
+-- Every function registered by the project's modules (module tables and the
+-- metatables of their userdata types) appears in the report: measured with the
+-- arguments in CASES, skipped with a reason from SKIP, or "no_case" so new
+-- bindings show up until someone gives them arguments.
+-- Output: JSON with ns/call, net_ns (minus a bare bench.noop call) and
+-- allocations/bytes per call from the pooled allocator.
+
+local out_path = arg and arg[1] or "bench_bindings.json"
+
+local gl = require("module_gl")
+local cglm = require("module_cglm")
+local enet = require("module_enet")
+local stb = require("module_stb")
+local lua_util = require("lua_util")
+
+-- Modules listed in the report, in order
+local MODULES = {
+    "module_gl", "module_cglm", "module_enet", "module_stb", "lua_util",
+    "module_sdl", "module_imgui", "module_audio", "module_jobs", "module_prof", "module_test",
+}
+
+-- Whole modules that cannot run in the harness
+local SKIP_MODULES = {
+    module_sdl = "needs SDL video and a window",
+    module_imgui = "needs an ImGui context",
+    module_audio = "needs an audio device",
+    module_jobs = "starts worker threads",
+    module_test = "test module",
+}
+
+local SKIP = {
+    ["module_gl.init"] = "needs a window",
+    ["module_gl.destroy"] = "would destroy the bench context",
+    ["module_gl.trace_begin"] = "file IO",
+    ["module_gl.trace_end"] = "file IO",
+    ["module_cglm.debug_perspective"] = "prints",
+    ["module_enet.deinitialize"] = "shuts enet down",
+    ["module_enet.host_create"] = "opens a socket per call",
+    ["module_enet.host_destroy"] = "consumes its argument",
+    ["module_enet.host_connect"] = "uses up the host's peer slots",
+    ["module_enet.packet_destroy"] = "consumes its argument",
+    ["module_enet.peer_send"] = "consumes its packet",
+    ["module_enet.host_broadcast"] = "consumes its packet",
+    ["ENetHost.destroy"] = "consumes its argument",
+    ["ENetHost.broadcast"] = "consumes its packet",
+    ["ENetPacket.destroy"] = "consumes its argument",
+    ["ENetPeer.send"] = "consumes its packet",
+    ["module_stb.free_image"] = "consumes its argument",
+    ["stb_image.free"] = "consumes its argument",
+    ["lua_blob.release"] = "consumes its argument",
+    ["cglm.scene.add"] = "accumulates nodes",
+    ["cglm.scene.remove"] = "consumes its argument",
+    ["lua_util.log"] = "prints",
+    ["lua_util.log_level"] = "changes what the log cases measure",
+    ["lua_util.log_file"] = "file IO",
+    ["lua_util.log_flush"] = "waits for the log writer",
+    ["lua_util.pack_mount"] = "maps a file",
+    ["lua_util.hot_reload"] = "starts a file watcher",
+    ["lua_util.profile_start"] = "installs a hook that slows every other case",
+    ["lua_util.profile_export"] = "file IO",
+    ["lua_util.reload"] = "reloads modules",
+    ["lua_util.sleep"] = "only valid inside a task",
+    ["lua_util.yield"] = "only valid inside a task",
+    ["lua_util.await"] = "only valid inside a task",
+    ["lua_util.await_load"] = "only valid inside a task",
+    ["lua_util.await_fence"] = "only valid inside a task",
+    ["lua_util.spawn"] = "accumulates tasks",
+}
+
+--===============================================
+-- fixtures
+--===============================================
+
+local v3 = cglm.vec3(1, 2, 3)
+local v4 = cglm.vec4(1, 2, 3, 4)
+local m4 = cglm.mat4_identity()
+-- Targets of the in-place cases, kept apart so the shared fixtures stay unchanged
+local v3_out = cglm.vec3(1, 2, 3)
+local v3_zero = cglm.vec3(0, 0, 0)
+local v4_out = cglm.vec4(1, 2, 3, 4)
+local v4_zero = cglm.vec4(0, 0, 0, 0)
+local m4_out = cglm.mat4_identity()
+-- Bulk cases run over 1024 elements; divide their ns/call for the per-element cost
+local ARRAY_N = 1024
+local m4_array = cglm.mat4_array(ARRAY_N)
+local m4_array_out = cglm.mat4_array(ARRAY_N)
+local v3_array = cglm.vec3_array(ARRAY_N, 1, 2, 3)
+local v3_array_out = cglm.vec3_array(ARRAY_N)
+local scene = cglm.scene(ARRAY_N)
+local scene_root = scene:add()
+local scene_node = scene:add(scene_root)
+for _ = 3, ARRAY_N do scene:add(scene_root) end
+scene:update()
+local projection = cglm.perspective(0.785, 1.333, 0.1, 100)
+local frustum = cglm.frustum(projection)
+local spheres = cglm.sphere_array(ARRAY_N, 1):set_centers(v3_array)
+local aabbs = cglm.aabb_array(ARRAY_N, 1):set_centers(v3_array)
+local visible = cglm.index_array(ARRAY_N)
+local vertices = string.rep("\0", 36 * 8 * 4)   -- a cube: 36 vertices of 8 floats
+local pixels = string.rep("\255", 64 * 64 * 4)
+local blob = lua_util.blob(vertices)
+local fake_handle = gl.get_gl_context()        -- any lightuserdata, GL is stubbed
+
+enet.initialize()
+local host = enet.host_create(nil, 1, 2, 0, 0)
+local peer = host and enet.host_connect(host, { host = "127.0.0.1", port = 17091 }, 2, 0)
+local packet = enet.packet_create("hello bench", enet.PACKET_FLAG_RELIABLE)
+
+local function read_file(path)
+    local f = io.open(path, "rb")
+    if not f then return nil end
+    local data = f:read("a")
+    f:close()
+    return data
+end
+local png = read_file("resources/ph16.png")
+local png_blob = png and lua_util.blob(png)
+local image = png_blob and stb.load_image(png_blob, stb.RGBA)
+local ttf = read_file("resources/Kenney Mini.ttf")
+local font = ttf and stb.bake_font(lua_util.blob(ttf), 32, 256, 256)
+
+-- Userdata types whose metatable functions are listed, by metatable name
+local TYPES = {
+    { "cglm.vec3", v3 }, { "cglm.vec4", v4 }, { "cglm.mat4", m4 },
+    { "cglm.mat4_array", m4_array }, { "cglm.vec3_array", v3_array }, { "cglm.scene", scene },
+    { "cglm.frustum", frustum }, { "cglm.bounds", spheres }, { "cglm.index_array", visible },
+    { "ENetHost", host }, { "ENetPeer", peer }, { "ENetPacket", packet },
+    { "stb_image", image }, { "stb_font", font }, { "lua_blob", blob },
+}
+
+-- Arguments of a case; a nil means its fixture could not be created
+local A = table.pack
+
+local T, F = gl.TRIANGLES, gl.FLOAT
+local CASES = {
+    -- module_gl: the bindings, GL itself is stubbed
+    ["module_gl.get_gl_context"] = A(),
+    ["module_gl.clear"] = A(gl.COLOR_BUFFER_BIT),
+    ["module_gl.clear_color"] = A(0.1, 0.2, 0.3, 1.0),
+    ["module_gl.viewport"] = A(0, 0, 800, 600),
+    ["module_gl.create_shader"] = A(gl.VERTEX_SHADER),
+    ["module_gl.delete_shader"] = A(1),
+    ["module_gl.shader_source"] = A(1, "void main() {}"),
+    ["module_gl.compile_shader"] = A(1),
+    ["module_gl.create_program"] = A(),
+    ["module_gl.delete_program"] = A(1),
+    ["module_gl.attach_shader"] = A(1, 1),
+    ["module_gl.link_program"] = A(1),
+    ["module_gl.use_program"] = A(1),
+    ["module_gl.gen_vertex_arrays"] = A(),
+    ["module_gl.bind_vertex_array"] = A(1),
+    ["module_gl.gen_buffers"] = A(),
+    ["module_gl.bind_buffer"] = A(gl.ARRAY_BUFFER, 1),
+    ["module_gl.buffer_data"] = A(gl.ARRAY_BUFFER, vertices, #vertices, gl.STATIC_DRAW),
+    ["module_gl.vertex_attrib_pointer"] = A(0, 3, F, gl.FALSE, 32, 0),
+    ["module_gl.enable_vertex_attrib_array"] = A(0),
+    ["module_gl.draw_arrays"] = A(T, 0, 36),
+    ["module_gl.gen_textures"] = A(),
+    ["module_gl.bind_texture"] = A(gl.TEXTURE_2D, 1),
+    ["module_gl.tex_image_2d"] = A(gl.TEXTURE_2D, 0, gl.RGBA, 64, 64, 0, gl.RGBA, gl.UNSIGNED_BYTE, false),
+    ["module_gl.tex_parameter_i"] = A(gl.TEXTURE_2D, gl.TEXTURE_MIN_FILTER, gl.LINEAR),
+    ["module_gl.draw_elements"] = A(T, 36, gl.UNSIGNED_INT, 0),
+    ["module_gl.uniform_matrix4fv"] = A(0, 1, 0, m4),
+    ["module_gl.dummy_uniform_matrix4fv"] = A(0, 1, 0),
+    ["module_gl.get_uniform_location"] = A(1, "u_mvp"),
+    ["module_gl.active_texture"] = A(gl.TEXTURE0),
+    ["module_gl.uniform1i"] = A(0, 1),
+    ["module_gl.uniform1f"] = A(0, 1.5),
+    ["module_gl.uniform4f"] = A(0, 1, 2, 3, 4),
+    ["module_gl.enable"] = A(gl.DEPTH_TEST),
+    ["module_gl.disable"] = A(gl.DEPTH_TEST),
+    ["module_gl.get_error"] = A(),
+    ["module_gl.blend_func"] = A(gl.SRC_ALPHA, gl.ONE_MINUS_SRC_ALPHA),
+    ["module_gl.delete_textures"] = A({ 1, 2, 3 }),
+    ["module_gl.delete_buffers"] = A({ 1, 2, 3 }),
+    ["module_gl.delete_vertex_arrays"] = A({ 1, 2, 3 }),
+    ["module_gl.cull_face"] = A(gl.BACK),
+    ["module_gl.polygon_mode"] = A(gl.FRONT_AND_BACK, gl.LINE),
+    ["module_gl.get_integer"] = A(gl.TEXTURE_BINDING_2D),
+    ["module_gl.is_tracing"] = A(),
+    ["module_gl.fence_sync"] = A(),
+    ["module_gl.client_wait_sync"] = A(fake_handle, 0),
+    ["module_gl.buffer_sub_data"] = A(gl.ARRAY_BUFFER, 0, vertices),
+    ["module_gl.bind_buffer_base"] = A(gl.UNIFORM_BUFFER, 0, 1),
+    ["module_gl.vertex_attrib_divisor"] = A(2, 1),
+    ["module_gl.draw_arrays_instanced"] = A(T, 0, 36, 1000),
+    ["module_gl.draw_elements_instanced"] = A(T, 36, gl.UNSIGNED_INT, 0, 1000),
+    ["module_gl.delete_sync"] = A(fake_handle),
+
+    -- module_cglm
+    ["module_cglm.vec3"] = A(1, 2, 3),
+    ["module_cglm.vec4"] = A(1, 2, 3, 4),
+    ["module_cglm.mat4"] = A(),
+    ["module_cglm.mat4_identity"] = A(),
+    ["module_cglm.ortho"] = A(0, 800, 600, 0, -1, 1),
+    ["module_cglm.perspective"] = A(0.785, 1.333, 0.1, 100),
+    ["module_cglm.rotate"] = A(m4, 0.5, v3),
+    ["module_cglm.translate"] = A(m4, v3),
+    ["module_cglm.mat4_mul"] = A(m4, m4),
+    ["cglm.vec3.dot"] = A(v3, v3),
+    ["cglm.vec3.cross"] = A(v3, v3),
+    ["cglm.vec3.normalize"] = A(v3),
+    ["cglm.vec3.length"] = A(v3),
+    ["cglm.vec3.get"] = A(v3, 0),
+    ["cglm.vec3.set"] = A(v3, 0, 1),
+    ["cglm.vec3.__add"] = A(v3, v3),
+    ["cglm.vec3.__sub"] = A(v3, v3),
+    ["cglm.vec3.__mul"] = A(v3, 2),
+    ["cglm.vec3.__tostring"] = A(v3),
+    ["cglm.vec4.dot"] = A(v4, v4),
+    ["cglm.vec4.normalize"] = A(v4),
+    ["cglm.vec4.length"] = A(v4),
+    ["cglm.vec4.get"] = A(v4, 0),
+    ["cglm.vec4.set"] = A(v4, 0, 1),
+    ["cglm.vec4.__add"] = A(v4, v4),
+    ["cglm.vec4.__sub"] = A(v4, v4),
+    ["cglm.vec4.__mul"] = A(v4, 2),
+    ["cglm.vec4.__tostring"] = A(v4),
+    ["cglm.mat4.get"] = A(m4, 0, 0),
+    ["cglm.mat4.set"] = A(m4, 0, 0, 1),
+    ["cglm.mat4.__mul"] = A(m4, m4),
+    ["cglm.mat4.__tostring"] = A(m4),
+    -- in-place and out-parameter forms: expect 0 allocs
+    ["module_cglm.mat4_mul_into"] = A(m4_out, m4, m4),
+    ["module_cglm.mat4_mulv_into"] = A(v4_out, m4, v4),
+    ["module_cglm.rotate_into"] = A(m4_out, m4, 0.5, 0, 1, 0),
+    ["module_cglm.translate_into"] = A(m4_out, m4, 1, 2, 3),
+    ["module_cglm.vec3_add_into"] = A(v3_out, v3, v3),
+    ["module_cglm.vec3_sub_into"] = A(v3_out, v3, v3),
+    ["module_cglm.vec3_scale_into"] = A(v3_out, v3, 2),
+    ["module_cglm.vec3_cross_into"] = A(v3_out, v3, v3),
+    ["module_cglm.mat4_array"] = A(16),
+    ["module_cglm.vec3_array"] = A(16),
+    ["module_cglm.mat4_array_mul"] = A(m4_array_out, m4, m4_array),
+    ["module_cglm.mat4_array_compose"] = A(m4_array_out, v3_array, v3_array, v3_array),
+    ["module_cglm.vec3_array_transform"] = A(v3_array_out, m4, v3_array),
+    ["cglm.mat4_array.count"] = A(m4_array),
+    ["cglm.mat4_array.size"] = A(m4_array),
+    ["cglm.mat4_array.get"] = A(m4_array, 0, m4_out),
+    ["cglm.mat4_array.set"] = A(m4_array_out, 0, m4),
+    ["cglm.mat4_array.identity_"] = A(m4_array_out),
+    ["cglm.mat4_array.__len"] = A(m4_array),
+    ["cglm.mat4_array.__tostring"] = A(m4_array),
+    ["cglm.vec3_array.count"] = A(v3_array),
+    ["cglm.vec3_array.size"] = A(v3_array),
+    ["cglm.vec3_array.get"] = A(v3_array, 0, v3_out),
+    ["cglm.vec3_array.set"] = A(v3_array_out, 0, 1, 2, 3),
+    ["cglm.vec3_array.fill_"] = A(v3_array_out, 0, 0, 0),
+    ["cglm.vec3_array.add_"] = A(v3_array_out, 0, 0, 0),
+    ["cglm.vec3_array.__len"] = A(v3_array),
+    ["cglm.vec3_array.__tostring"] = A(v3_array),
+    ["module_cglm.scene"] = A(16),
+    ["cglm.scene.set_parent"] = A(scene, scene_node, scene_root),
+    ["cglm.scene.parent"] = A(scene, scene_node),
+    ["cglm.scene.valid"] = A(scene, scene_node),
+    ["cglm.scene.count"] = A(scene),
+    ["cglm.scene.set_position"] = A(scene, scene_node, 1, 2, 3),
+    ["cglm.scene.set_rotation"] = A(scene, scene_node, 0, 0.5, 0),
+    ["cglm.scene.set_scale"] = A(scene, scene_node, 2),
+    ["cglm.scene.get_position"] = A(scene, scene_node),
+    ["cglm.scene.get_rotation"] = A(scene, scene_node),
+    ["cglm.scene.get_scale"] = A(scene, scene_node),
+    ["cglm.scene.update"] = A(scene),               -- nothing dirty: the static-scene cost
+    ["cglm.scene.world"] = A(scene, scene_node, m4_out),
+    ["cglm.scene.copy_worlds"] = A(scene, m4_array_out),
+    ["cglm.scene.__len"] = A(scene),
+    ["cglm.scene.__tostring"] = A(scene),
+    ["module_cglm.frustum"] = A(projection),
+    ["module_cglm.sphere_array"] = A(16),
+    ["module_cglm.aabb_array"] = A(16),
+    ["module_cglm.index_array"] = A(16),
+    ["module_cglm.frustum_cull"] = A(frustum, spheres, visible),
+    ["module_cglm.mat4_array_gather"] = A(m4_array_out, m4_array, visible),
+    ["cglm.frustum.set_"] = A(frustum, projection),
+    ["cglm.frustum.plane"] = A(frustum, 0),
+    ["cglm.frustum.test_sphere"] = A(frustum, 0, 0, -5, 1),
+    ["cglm.frustum.test_aabb"] = A(frustum, 0, 0, -5, 1, 1, 1),
+    ["cglm.frustum.__tostring"] = A(frustum),
+    ["cglm.bounds.count"] = A(spheres),
+    ["cglm.bounds.set"] = A(spheres, 0, 1, 2, 3, 1),
+    ["cglm.bounds.get"] = A(spheres, 0),
+    ["cglm.bounds.set_centers"] = A(spheres, v3_array),
+    ["cglm.bounds.fill_extent_"] = A(spheres, 1),
+    ["cglm.bounds.__len"] = A(spheres),
+    ["cglm.bounds.__tostring"] = A(spheres),
+    ["cglm.index_array.count"] = A(visible),
+    ["cglm.index_array.size"] = A(visible),
+    ["cglm.index_array.get"] = A(visible, 0),
+    ["cglm.index_array.set"] = A(visible, 0, 0),
+    ["cglm.index_array.__len"] = A(visible),
+    ["cglm.index_array.__tostring"] = A(visible),
+    ["cglm.vec3.set_"] = A(v3_out, 1, 2, 3),
+    ["cglm.vec3.add_"] = A(v3_out, v3_zero),
+    ["cglm.vec3.sub_"] = A(v3_out, 0, 0, 0),
+    ["cglm.vec3.scale_"] = A(v3_out, 1),
+    ["cglm.vec3.normalize_"] = A(v3_out),
+    ["cglm.vec4.set_"] = A(v4_out, 1, 2, 3, 4),
+    ["cglm.vec4.add_"] = A(v4_out, v4_zero),
+    ["cglm.vec4.sub_"] = A(v4_out, v4_zero),
+    ["cglm.vec4.scale_"] = A(v4_out, 1),
+    ["cglm.vec4.normalize_"] = A(v4_out),
+    ["cglm.mat4.identity_"] = A(m4_out),
+    ["cglm.mat4.copy_"] = A(m4_out, m4),
+    ["cglm.mat4.rotate_"] = A(m4_out, 0.5, 0, 1, 0),
+    ["cglm.mat4.translate_"] = A(m4_out, 0, 0, 0),
+    ["cglm.mat4.scale_"] = A(m4_out, 1),
+    ["cglm.mat4.mul_"] = A(m4_out, m4),
+    ["cglm.mat4.perspective_"] = A(m4_out, 0.785, 1.333, 0.1, 100),
+    ["cglm.mat4.ortho_"] = A(m4_out, 0, 800, 600, 0, -1, 1),
+
+    -- module_enet: a client host that never services the network
+    ["module_enet.initialize"] = A(),
+    ["module_enet.host_service"] = A(host, 0),
+    ["module_enet.host_check_events"] = A(host),
+    ["module_enet.host_flush"] = A(host),
+    ["module_enet.host_bandwidth_limit"] = A(host, 0, 0),
+    ["module_enet.packet_create"] = A("hello bench", enet.PACKET_FLAG_RELIABLE),
+    ["module_enet.packet_create_str"] = A("hello bench", enet.PACKET_FLAG_RELIABLE),
+    ["module_enet.packet_create_table"] = A({ name = "bench", x = 1, y = 2 }, enet.PACKET_FLAG_RELIABLE),
+    ["module_enet.packet_data"] = A(packet),
+    ["module_enet.peer_reset"] = A(peer),
+    ["module_enet.peer_disconnect"] = A(peer, 0),
+    ["module_enet.peer_disconnect_later"] = A(peer, 0),
+    ["module_enet.peer_disconnect_now"] = A(peer, 0),
+    ["module_enet.peer_set_data"] = A(peer, "bench"),
+    ["module_enet.peer_get_data"] = A(peer),
+    ["module_enet.peer_get_connect_id"] = A(peer),
+    ["module_enet.peer_get_incoming_peer_id"] = A(peer),
+    ["module_enet.peer_get_state"] = A(peer),
+    ["module_enet.peer_throttle_configure"] = A(peer, 5000, 2, 2),
+    ["module_enet.peer_ping"] = A(peer),
+    ["module_enet.peer_timeout"] = A(peer, 32, 5000, 30000),
+    ["ENetHost.flush"] = A(host),
+    ["ENetHost.check_events"] = A(host),
+    ["ENetHost.bandwidth_limit"] = A(host, 0, 0),
+    ["ENetPeer.reset"] = A(peer),
+    ["ENetPeer.disconnect"] = A(peer, 0),
+    ["ENetPeer.disconnect_later"] = A(peer, 0),
+    ["ENetPeer.disconnect_now"] = A(peer, 0),
+    ["ENetPeer.set_data"] = A(peer, "bench"),
+    ["ENetPeer.get_data"] = A(peer),
+    ["ENetPeer.get_connect_id"] = A(peer),
+    ["ENetPeer.get_incoming_peer_id"] = A(peer),
+    ["ENetPeer.get_state"] = A(peer),
+    ["ENetPeer.throttle_configure"] = A(peer, 5000, 2, 2),
+    ["ENetPeer.ping"] = A(peer),
+    ["ENetPeer.timeout"] = A(peer, 32, 5000, 30000),
+
+    -- module_stb
+    ["module_stb.load_image"] = A(png_blob, stb.RGBA),
+    ["module_stb.bake_font"] = A(ttf and lua_util.blob(ttf), 32, 256, 256),
+    ["stb_image.get_data"] = A(image),
+    ["stb_image.get_blob"] = A(image),
+    ["stb_image.get_width"] = A(image),
+    ["stb_image.get_height"] = A(image),
+    ["stb_image.get_channels"] = A(image),
+    ["stb_font.get_bitmap"] = A(font),
+    ["stb_font.get_baked_quad"] = A(font, 65, 0, 0),
+
+    -- lua_util
+    ["lua_util.path_exists"] = A("README.md"),
+    ["lua_util.mem_stats"] = A(),
+    ["lua_util.blob"] = A(pixels),
+    ["lua_util.gc_stats"] = A(),
+    ["lua_util.task_stats"] = A(),
+    ["lua_util.run_tasks"] = A(),
+    ["lua_util.reload_poll"] = A(),
+    ["lua_util.signal"] = A("bench"),
+    -- filtered out at the default info level: the cost of a disabled log call
+    ["lua_util.logf"] = A("debug", "bench", "value %d", 1),
+    ["lua_util.log_enabled"] = A("debug", "bench"),
+    ["lua_util.log_category"] = A("bench"),
+    ["lua_util.log_rate"] = A("bench", 0),
+    ["lua_util.log_stats"] = A(),
+    ["lua_util.load_asset"] = A("resources/ph16.png"),
+    ["lua_blob.size"] = A(blob),
+    ["lua_blob.sub"] = A(blob, 0, 64),
+    ["lua_blob.to_string"] = A(blob, 0, 64),
+    ["lua_blob.__len"] = A(blob),
+    ["lua_blob.__tostring"] = A(blob),
+}
+
+-- Extra cases for one function with other argument kinds
+local VARIANTS = {
+    { "module_gl.buffer_data(blob)", gl.buffer_data, A(gl.ARRAY_BUFFER, blob, #vertices, gl.STATIC_DRAW) },
+    { "module_gl.tex_image_2d(string)", gl.tex_image_2d,
+      A(gl.TEXTURE_2D, 0, gl.RGBA, 64, 64, 0, gl.RGBA, gl.UNSIGNED_BYTE, pixels) },
+    { "module_enet.packet_create(blob)", enet.packet_create, A(blob, enet.PACKET_FLAG_RELIABLE) },
+    { "module_cglm.rotate(x, y, z)", cglm.rotate, A(m4, 0.5, 0, 1, 0) },
+    { "module_gl.buffer_data(mat4_array)", gl.buffer_data, A(gl.ARRAY_BUFFER, m4_array, m4_array:size(), gl.STREAM_DRAW) },
+    { "module_gl.uniform_matrix4fv(mat4_array)", gl.uniform_matrix4fv, A(0, 16, 0, m4_array) },
+    { "module_cglm.frustum_cull(aabbs)", cglm.frustum_cull, A(frustum, aabbs, visible) },
+    { "cglm.scene.update(root moved)", function()
+        scene:set_position(scene_root, 0, 0, 0)
+        return scene:update()
+    end, A() },
+}
+
+--===============================================
+-- run
+--===============================================
+
+local function collect_functions()
+    local list = {}
+    for _, module_name in ipairs(MODULES) do
+        local ok, mod = pcall(require, module_name)
+        if ok and type(mod) == "table" then
+            for name, fn in pairs(mod) do
+                if type(fn) == "function" then
+                    list[#list + 1] = { name = module_name .. "." .. name, fn = fn, module = module_name }
+                end
+            end
+        end
+    end
+    for _, t in ipairs(TYPES) do
+        local type_name, value = t[1], t[2]
+        local mt = value ~= nil and getmetatable(value)
+        if type(mt) == "table" then
+            local seen = {}
+            local function add(tbl)
+                for name, fn in pairs(tbl) do
+                    if type(fn) == "function" and name ~= "__gc" and name ~= "__index" and not seen[name] then
+                        seen[name] = true
+                        list[#list + 1] = { name = type_name .. "." .. name, fn = fn, module = type_name }
+                    end
+                end
+            end
+            add(mt)
+            if type(mt.__index) == "table" and mt.__index ~= mt then add(mt.__index) end
+        end
+    end
+    table.sort(list, function(a, b) return a.name < b.name end)
+    return list
+end
+
+local function has_missing_fixture(args)
+    for i = 1, args.n do
+        if args[i] == nil then return true end
+    end
+    return false
+end
+
+local baseline = {
+    noop = assert(bench.measure(bench.noop)),
+    check4 = assert(bench.measure(bench.check4, 1, 2, 3, 4)),
+    userdata = assert(bench.measure(bench.userdata)),
+}
+local noop_ns = baseline.noop.ns
+
+local results = {}
+local counts = { ok = 0, skipped = 0, no_case = 0, error = 0 }
+
+local function add_result(name, fn, args)
+    local r = { name = name }
+    if has_missing_fixture(args) then
+        r.status, r.reason = "skipped", "fixture unavailable"
+    else
+        local m, err = bench.measure(fn, table.unpack(args, 1, args.n))
+        if m then
+            r.status = "ok"
+            r.ns, r.net_ns = m.ns, math.max(0, m.ns - noop_ns)
+            r.allocs, r.bytes, r.iterations = m.allocs, m.bytes, m.iterations
+        else
+            r.status, r.error = "error", tostring(err)
+        end
+    end
+    counts[r.status] = counts[r.status] + 1
+    results[#results + 1] = r
+end
+
+for _, f in ipairs(collect_functions()) do
+    local reason = SKIP_MODULES[f.module] or SKIP[f.name]
+    local args = CASES[f.name]
+    if reason then
+        counts.skipped = counts.skipped + 1
+        results[#results + 1] = { name = f.name, status = "skipped", reason = reason }
+    elseif not args then
+        counts.no_case = counts.no_case + 1
+        results[#results + 1] = { name = f.name, status = "no_case" }
+    else
+        add_result(f.name, f.fn, args)
+    end
+end
+for _, v in ipairs(VARIANTS) do
+    add_result(v[1], v[2], v[3])
+end
+
+--===============================================
+-- report
+--===============================================
+
+local function json_string(s)
+    return '"' .. tostring(s):gsub('[%c"\\]', function(c)
+        return string.format("\\u%04x", c:byte())
+    end) .. '"'
+end
+
+local function json_value(v)
+    if type(v) == "number" then
+        if v ~= v or v == math.huge or v == -math.huge then return "null" end
+        return math.type(v) == "integer" and tostring(v) or string.format("%.3f", v)
+    end
+    return json_string(v)
+end
+
+local function json_object(t, keys)
+    local parts = {}
+    for _, k in ipairs(keys) do
+        if t[k] ~= nil then
+            parts[#parts + 1] = json_string(k) .. ": " .. json_value(t[k])
+        end
+    end
+    return "{" .. table.concat(parts, ", ") .. "}"
+end
+
+local MEASURE_KEYS = { "ns", "allocs", "bytes", "iterations" }
+local RESULT_KEYS = { "name", "status", "ns", "net_ns", "allocs", "bytes", "iterations", "reason", "error" }
+
+local lines = {}
+lines[#lines + 1] = "{"
+lines[#lines + 1] = '  "lua": ' .. json_string(_VERSION) .. ","
+lines[#lines + 1] = '  "baseline": {'
+lines[#lines + 1] = '    "noop": ' .. json_object(baseline.noop, MEASURE_KEYS) .. ","
+lines[#lines + 1] = '    "check4": ' .. json_object(baseline.check4, MEASURE_KEYS) .. ","
+lines[#lines + 1] = '    "userdata": ' .. json_object(baseline.userdata, MEASURE_KEYS)
+lines[#lines + 1] = "  },"
+lines[#lines + 1] = '  "summary": ' .. json_object(counts, { "ok", "skipped", "no_case", "error" }) .. ","
+lines[#lines + 1] = '  "functions": ['
+for i, r in ipairs(results) do
+    lines[#lines + 1] = "    " .. json_object(r, RESULT_KEYS) .. (i < #results and "," or "")
+end
+lines[#lines + 1] = "  ]"
+lines[#lines + 1] = "}"
+
+local f = assert(io.open(out_path, "w"))
+f:write(table.concat(lines, "\n"), "\n")
+f:close()
+
+print(string.format("baseline: noop %.1f ns, check4 %.1f ns, userdata %.1f ns (%.2f allocs)",
+    baseline.noop.ns, baseline.check4.ns, baseline.userdata.ns, baseline.userdata.allocs))
+for _, r in ipairs(results) do
+    if r.status == "ok" then
+        print(string.format("%-44s %9.1f ns %6.2f allocs %8.1f bytes", r.name, r.ns, r.allocs, r.bytes))
+    elseif r.status == "error" then
+        print(string.format("%-44s error: %s", r.name, r.error))
+    end
+end
+print(string.format("%d measured, %d skipped, %d without a case, %d errors -> %s",
+    counts.ok, counts.skipped, counts.no_case, counts.error, out_path))
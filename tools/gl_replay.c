@@ -0,0 +1,372 @@
+// gl_replay.c
+// Replays a GL call trace recorded by module_gl (gl.trace_begin / --gl-trace) as fast as
+// possible and reports per-call and per-frame timings.
+//
+// Usage: sdl3_gl_replay trace.bin [--loops N] [--finish-each] [--headless]
+#include <SDL3/SDL.h>
+#include <glad/gl.h>  // GLAD 2.0
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gl_trace.h"
+
+// Recorded GL object name -> replayed GL object name
+typedef struct {
+    GLuint *names;
+    size_t capacity;
+} name_map;
+
+enum { MAP_SHADER, MAP_PROGRAM, MAP_VERTEX_ARRAY, MAP_BUFFER, MAP_TEXTURE, MAP_COUNT };
+
+typedef struct {
+    int64_t program;    // recorded program
+    int64_t location;   // recorded location
+    GLint replayed;
+} location_entry;
+
+typedef struct {
+    Uint64 count;
+    Uint64 total_ns;
+    Uint64 max_ns;
+} call_stats;
+
+static name_map g_maps[MAP_COUNT];
+static location_entry *g_locations = NULL;
+static size_t g_location_count = 0;
+static int64_t g_current_program = 0;
+
+static void map_set(int map, int64_t recorded, GLuint replayed) {
+    name_map *m = &g_maps[map];
+    if (recorded < 0) return;
+    if ((size_t)recorded >= m->capacity) {
+        size_t capacity = m->capacity ? m->capacity : 64;
+        while (capacity <= (size_t)recorded) capacity *= 2;
+        GLuint *names = (GLuint *)realloc(m->names, capacity * sizeof(GLuint));
+        if (!names) return;
+        memset(names + m->capacity, 0, (capacity - m->capacity) * sizeof(GLuint));
+        m->names = names;
+        m->capacity = capacity;
+    }
+    m->names[recorded] = replayed;
+}
+
+static GLuint map_get(int map, int64_t recorded) {
+    name_map *m = &g_maps[map];
+    if (recorded <= 0 || (size_t)recorded >= m->capacity) return 0;
+    return m->names[recorded];
+}
+
+static void location_set(int64_t program, int64_t location, GLint replayed) {
+    for (size_t i = 0; i < g_location_count; i++) {
+        if (g_locations[i].program == program && g_locations[i].location == location) {
+            g_locations[i].replayed = replayed;
+            return;
+        }
+    }
+    location_entry *entries = (location_entry *)realloc(g_locations, (g_location_count + 1) * sizeof(location_entry));
+    if (!entries) return;
+    g_locations = entries;
+    g_locations[g_location_count].program = program;
+    g_locations[g_location_count].location = location;
+    g_locations[g_location_count].replayed = replayed;
+    g_location_count++;
+}
+
+// Uniform locations are per program, resolve against the currently used program
+static GLint location_get(int64_t location) {
+    if (location < 0) return -1;
+    for (size_t i = 0; i < g_location_count; i++) {
+        if (g_locations[i].program == g_current_program && g_locations[i].location == location) {
+            return g_locations[i].replayed;
+        }
+    }
+    return (GLint)location;
+}
+
+// Delete calls carry the recorded names as payload
+static void delete_names(int map, const gl_trace_arg *a, const unsigned char *payload, uint32_t payload_size,
+                         PFNGLDELETETEXTURESPROC delete_fn) {
+    GLsizei n = (GLsizei)(payload_size / sizeof(GLuint));
+    if (n <= 0 || n != (GLsizei)a[0].i) return;
+    GLuint *names = (GLuint *)malloc((size_t)n * sizeof(GLuint));
+    if (!names) return;
+    for (GLsizei i = 0; i < n; i++) {
+        GLuint recorded;
+        memcpy(&recorded, payload + i * sizeof(GLuint), sizeof(GLuint));
+        names[i] = map_get(map, recorded);
+    }
+    delete_fn(n, names);
+    free(names);
+}
+
+static void replay_call(const gl_trace_record *rec, const gl_trace_arg *a, const unsigned char *payload) {
+    switch (rec->call) {
+    case GLT_CLEAR: glClear((GLbitfield)a[0].i); break;
+    case GLT_CLEAR_COLOR: glClearColor((GLfloat)a[0].f, (GLfloat)a[1].f, (GLfloat)a[2].f, (GLfloat)a[3].f); break;
+    case GLT_VIEWPORT: glViewport((GLint)a[0].i, (GLint)a[1].i, (GLsizei)a[2].i, (GLsizei)a[3].i); break;
+    case GLT_CREATE_SHADER: map_set(MAP_SHADER, a[1].i, glCreateShader((GLenum)a[0].i)); break;
+    case GLT_DELETE_SHADER: glDeleteShader(map_get(MAP_SHADER, a[0].i)); break;
+    case GLT_SHADER_SOURCE: {
+        const GLchar *source = (const GLchar *)payload;
+        GLint length = (GLint)rec->payload_size;
+        glShaderSource(map_get(MAP_SHADER, a[0].i), 1, &source, &length);
+        break;
+    }
+    case GLT_COMPILE_SHADER: glCompileShader(map_get(MAP_SHADER, a[0].i)); break;
+    case GLT_CREATE_PROGRAM: map_set(MAP_PROGRAM, a[0].i, glCreateProgram()); break;
+    case GLT_DELETE_PROGRAM: glDeleteProgram(map_get(MAP_PROGRAM, a[0].i)); break;
+    case GLT_ATTACH_SHADER: glAttachShader(map_get(MAP_PROGRAM, a[0].i), map_get(MAP_SHADER, a[1].i)); break;
+    case GLT_LINK_PROGRAM: glLinkProgram(map_get(MAP_PROGRAM, a[0].i)); break;
+    case GLT_USE_PROGRAM:
+        g_current_program = a[0].i;
+        glUseProgram(map_get(MAP_PROGRAM, a[0].i));
+        break;
+    case GLT_GEN_VERTEX_ARRAYS: {
+        GLuint vao;
+        glGenVertexArrays(1, &vao);
+        map_set(MAP_VERTEX_ARRAY, a[0].i, vao);
+        break;
+    }
+    case GLT_BIND_VERTEX_ARRAY: glBindVertexArray(map_get(MAP_VERTEX_ARRAY, a[0].i)); break;
+    case GLT_GEN_BUFFERS: {
+        GLuint vbo;
+        glGenBuffers(1, &vbo);
+        map_set(MAP_BUFFER, a[0].i, vbo);
+        break;
+    }
+    case GLT_BIND_BUFFER: glBindBuffer((GLenum)a[0].i, map_get(MAP_BUFFER, a[1].i)); break;
+    case GLT_BUFFER_DATA:
+        glBufferData((GLenum)a[0].i, (GLsizeiptr)rec->payload_size, payload, (GLenum)a[2].i);
+        break;
+    case GLT_VERTEX_ATTRIB_POINTER:
+        glVertexAttribPointer((GLuint)a[0].i, (GLint)a[1].i, (GLenum)a[2].i, (GLboolean)a[3].i,
+                              (GLsizei)a[4].i, (const void *)(GLintptr)a[5].i);
+        break;
+    case GLT_ENABLE_VERTEX_ATTRIB_ARRAY: glEnableVertexAttribArray((GLuint)a[0].i); break;
+    case GLT_DRAW_ARRAYS: glDrawArrays((GLenum)a[0].i, (GLint)a[1].i, (GLsizei)a[2].i); break;
+    case GLT_GEN_TEXTURES: {
+        GLuint texture;
+        glGenTextures(1, &texture);
+        map_set(MAP_TEXTURE, a[0].i, texture);
+        break;
+    }
+    case GLT_BIND_TEXTURE: glBindTexture((GLenum)a[0].i, map_get(MAP_TEXTURE, a[1].i)); break;
+    case GLT_TEX_IMAGE_2D:
+        glTexImage2D((GLenum)a[0].i, (GLint)a[1].i, (GLint)a[2].i, (GLsizei)a[3].i, (GLsizei)a[4].i,
+                     (GLint)a[5].i, (GLenum)a[6].i, (GLenum)a[7].i, rec->payload_size ? payload : NULL);
+        break;
+    case GLT_TEX_PARAMETER_I: glTexParameteri((GLenum)a[0].i, (GLenum)a[1].i, (GLint)a[2].i); break;
+    case GLT_DRAW_ELEMENTS:
+        glDrawElements((GLenum)a[0].i, (GLsizei)a[1].i, (GLenum)a[2].i, (const void *)(GLintptr)a[3].i);
+        break;
+    case GLT_UNIFORM_MATRIX4FV:
+        glUniformMatrix4fv(location_get(a[0].i), (GLsizei)(rec->payload_size / 64), (GLboolean)a[2].i,
+                           (const GLfloat *)payload);
+        break;
+    case GLT_GET_UNIFORM_LOCATION:
+        location_set(a[0].i, a[1].i, glGetUniformLocation(map_get(MAP_PROGRAM, a[0].i), (const GLchar *)payload));
+        break;
+    case GLT_UNIFORM1I: glUniform1i(location_get(a[0].i), (GLint)a[1].i); break;
+    case GLT_UNIFORM1F: glUniform1f(location_get(a[0].i), (GLfloat)a[1].f); break;
+    case GLT_UNIFORM4F:
+        glUniform4f(location_get(a[0].i), (GLfloat)a[1].f, (GLfloat)a[2].f, (GLfloat)a[3].f, (GLfloat)a[4].f);
+        break;
+    case GLT_ACTIVE_TEXTURE: glActiveTexture((GLenum)a[0].i); break;
+    case GLT_ENABLE: glEnable((GLenum)a[0].i); break;
+    case GLT_DISABLE: glDisable((GLenum)a[0].i); break;
+    case GLT_GET_ERROR: glGetError(); break;
+    case GLT_BLEND_FUNC: glBlendFunc((GLenum)a[0].i, (GLenum)a[1].i); break;
+    case GLT_DELETE_TEXTURES: delete_names(MAP_TEXTURE, a, payload, rec->payload_size, glDeleteTextures); break;
+    case GLT_DELETE_BUFFERS: delete_names(MAP_BUFFER, a, payload, rec->payload_size, glDeleteBuffers); break;
+    case GLT_DELETE_VERTEX_ARRAYS:
+        delete_names(MAP_VERTEX_ARRAY, a, payload, rec->payload_size, glDeleteVertexArrays);
+        break;
+    case GLT_CULL_FACE: glCullFace((GLenum)a[0].i); break;
+    case GLT_POLYGON_MODE: glPolygonMode((GLenum)a[0].i, (GLenum)a[1].i); break;
+    case GLT_GET_INTEGER: {
+        GLint value;
+        glGetIntegerv((GLenum)a[0].i, &value);
+        break;
+    }
+    case GLT_BUFFER_SUB_DATA:
+        glBufferSubData((GLenum)a[0].i, (GLintptr)a[1].i, (GLsizeiptr)rec->payload_size, payload);
+        break;
+    case GLT_BIND_BUFFER_BASE: glBindBufferBase((GLenum)a[0].i, (GLuint)a[1].i, map_get(MAP_BUFFER, a[2].i)); break;
+    case GLT_VERTEX_ATTRIB_DIVISOR: glVertexAttribDivisor((GLuint)a[0].i, (GLuint)a[1].i); break;
+    case GLT_DRAW_ARRAYS_INSTANCED:
+        glDrawArraysInstanced((GLenum)a[0].i, (GLint)a[1].i, (GLsizei)a[2].i, (GLsizei)a[3].i);
+        break;
+    case GLT_DRAW_ELEMENTS_INSTANCED:
+        glDrawElementsInstanced((GLenum)a[0].i, (GLsizei)a[1].i, (GLenum)a[2].i,
+                                (const void *)(GLintptr)a[3].i, (GLsizei)a[4].i);
+        break;
+    default: break;
+    }
+}
+
+static int compare_u64(const void *a, const void *b) {
+    Uint64 x = *(const Uint64 *)a;
+    Uint64 y = *(const Uint64 *)b;
+    return (x > y) - (x < y);
+}
+
+static unsigned char *read_file(const char *path, size_t *size) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long file_size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    unsigned char *data = (unsigned char *)malloc(file_size > 0 ? (size_t)file_size : 1);
+    if (data && fread(data, 1, (size_t)file_size, f) != (size_t)file_size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    *size = (size_t)file_size;
+    return data;
+}
+
+int main(int argc, char **argv) {
+    const char *trace_path = NULL;
+    int loops = 1;
+    int finish_each = 0;
+    int headless = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--loops") == 0 && i + 1 < argc) {
+            loops = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--finish-each") == 0) {
+            finish_each = 1;  // glFinish after every call so timings include GPU work
+        } else if (strcmp(argv[i], "--headless") == 0) {
+            headless = 1;
+        } else {
+            trace_path = argv[i];
+        }
+    }
+    if (!trace_path) {
+        fprintf(stderr, "Usage: %s trace.bin [--loops N] [--finish-each] [--headless]\n", argv[0]);
+        return 1;
+    }
+
+    size_t size = 0;
+    unsigned char *data = read_file(trace_path, &size);
+    if (!data || size < sizeof(gl_trace_header)) {
+        fprintf(stderr, "Failed to read trace '%s'\n", trace_path);
+        return 1;
+    }
+    gl_trace_header header;
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != GL_TRACE_MAGIC || header.version != GL_TRACE_VERSION) {
+        fprintf(stderr, "'%s' is not a GL trace (or unsupported version)\n", trace_path);
+        free(data);
+        return 1;
+    }
+
+    if (headless) {
+        SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen");
+    }
+    if (!SDL_Init(SDL_INIT_VIDEO)) {
+        fprintf(stderr, "SDL_Init failed: %s\n", SDL_GetError());
+        free(data);
+        return 1;
+    }
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
+    SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
+    SDL_Window *window = SDL_CreateWindow("sdl3_gl_replay", 800, 600, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+    SDL_GLContext context = window ? SDL_GL_CreateContext(window) : NULL;
+    if (!context || !gladLoadGL((GLADloadfunc)SDL_GL_GetProcAddress)) {
+        fprintf(stderr, "Failed to create OpenGL context: %s\n", SDL_GetError());
+        if (window) SDL_DestroyWindow(window);
+        SDL_Quit();
+        free(data);
+        return 1;
+    }
+    SDL_GL_SetSwapInterval(0);  // As fast as possible
+    printf("Replaying %s on %s\n", trace_path, glGetString(GL_RENDERER));
+
+    call_stats stats[GLT_COUNT];
+    memset(stats, 0, sizeof(stats));
+    Uint64 *frame_ns = NULL;
+    size_t frame_count = 0, frame_capacity = 0;
+    Uint64 recorded_frame_total = 0, recorded_frames = 0;
+
+    for (int loop = 0; loop < loops; loop++) {
+        size_t offset = sizeof(gl_trace_header);
+        Uint64 frame_start = SDL_GetTicksNS();
+        Uint64 recorded_frame_start = 0;
+        while (offset + sizeof(gl_trace_record) <= size) {
+            gl_trace_record rec;
+            memcpy(&rec, data + offset, sizeof(rec));
+            offset += sizeof(rec);
+            size_t args_size = (size_t)rec.argc * sizeof(gl_trace_arg);
+            if (offset + args_size + rec.payload_size > size) break;  // truncated trace
+            gl_trace_arg args[16];
+            memset(args, 0, sizeof(args));
+            memcpy(args, data + offset, rec.argc <= 16 ? args_size : 16 * sizeof(gl_trace_arg));
+            offset += args_size;
+            const unsigned char *payload = data + offset;
+            offset += rec.payload_size;
+
+            if (rec.call == GLT_FRAME_END) {
+                glFinish();
+                SDL_GL_SwapWindow(window);
+                Uint64 now = SDL_GetTicksNS();
+                if (frame_count == frame_capacity) {
+                    frame_capacity = frame_capacity ? frame_capacity * 2 : 1024;
+                    Uint64 *frames = (Uint64 *)realloc(frame_ns, frame_capacity * sizeof(Uint64));
+                    if (!frames) break;
+                    frame_ns = frames;
+                }
+                frame_ns[frame_count++] = now - frame_start;
+                if (loop == 0 && recorded_frame_start != 0) {
+                    recorded_frame_total += rec.time_ns - recorded_frame_start;
+                    recorded_frames++;
+                }
+                recorded_frame_start = rec.time_ns;
+                frame_start = now;
+                continue;
+            }
+
+            Uint64 t0 = SDL_GetTicksNS();
+            replay_call(&rec, args, payload);
+            if (finish_each) glFinish();
+            Uint64 dt = SDL_GetTicksNS() - t0;
+            if (rec.call < GLT_COUNT) {
+                stats[rec.call].count++;
+                stats[rec.call].total_ns += dt;
+                if (dt > stats[rec.call].max_ns) stats[rec.call].max_ns = dt;
+            }
+        }
+    }
+
+    printf("\n%-28s %10s %12s %10s %10s\n", "call", "count", "total_ms", "avg_us", "max_us");
+    for (int i = 0; i < GLT_COUNT; i++) {
+        if (stats[i].count == 0) continue;
+        printf("%-28s %10llu %12.3f %10.3f %10.3f\n", gl_trace_call_name(i),
+               (unsigned long long)stats[i].count, stats[i].total_ns / 1e6,
+               stats[i].total_ns / 1e3 / stats[i].count, stats[i].max_ns / 1e3);
+    }
+
+    if (frame_count > 0) {
+        Uint64 total = 0;
+        for (size_t i = 0; i < frame_count; i++) total += frame_ns[i];
+        qsort(frame_ns, frame_count, sizeof(Uint64), compare_u64);
+        printf("\nframes=%zu avg=%.3fms min=%.3fms p50=%.3fms p95=%.3fms max=%.3fms\n", frame_count,
+               (double)total / frame_count / 1e6, frame_ns[0] / 1e6, frame_ns[(frame_count - 1) * 50 / 100] / 1e6,
+               frame_ns[(frame_count - 1) * 95 / 100] / 1e6, frame_ns[frame_count - 1] / 1e6);
+        if (recorded_frames > 0) {
+            printf("recorded avg frame=%.3fms\n", (double)recorded_frame_total / recorded_frames / 1e6);
+        }
+    }
+
+    free(frame_ns);
+    free(g_locations);
+    for (int i = 0; i < MAP_COUNT; i++) free(g_maps[i].names);
+    free(data);
+    SDL_GL_DestroyContext(context);
+    SDL_DestroyWindow(window);
+    SDL_Quit();
+    return 0;
+}
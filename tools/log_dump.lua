@@ -0,0 +1,43 @@
+-- log_dump.lua
+-- Prints a binary log (sdl3_lua --log-binary FILE, lua_util.log_file(path, true))
+-- in the format of text log files. Record layout: include/app_log.h.
+-- Usage: lua tools/log_dump.lua FILE [min_level]
+local LEVELS = {[0] = "trace", "debug", "info", "warn", "error"}
+local LABELS = {[0] = "TRACE: ", "DEBUG: ", "", "WARN: ", "ERROR: "}
+
+local path = arg[1]
+if not path then
+    io.stderr:write("usage: lua tools/log_dump.lua FILE [trace|debug|info|warn|error]\n")
+    os.exit(1)
+end
+local min_level = 0
+for level, name in pairs(LEVELS) do
+    if name == arg[2] then min_level = level end
+end
+
+local f = assert(io.open(path, "rb"))
+local data = f:read("a")
+f:close()
+assert(data:sub(1, 4) == "SLG1", path .. ": not a binary log")
+
+local names = {}
+local pos = 5
+while pos <= #data do
+    local kind = data:byte(pos)
+    if kind == 1 then
+        local id, len
+        id, len, pos = string.unpack("=BB", data, pos + 1)
+        names[id] = data:sub(pos, pos + len - 1)
+        pos = pos + len
+    elseif kind == 2 then
+        local level, category, _, len, time_ns
+        level, category, _, len, time_ns, pos = string.unpack("=BBBI4I8", data, pos + 1)
+        if level >= min_level then
+            io.write(string.format("[%.3f] [%s] %s%s\n", time_ns / 1e9, names[category] or category,
+                                   LABELS[level] or "", data:sub(pos, pos + len - 1)))
+        end
+        pos = pos + len
+    else
+        error(string.format("%s: bad record type %d at offset %d", path, kind, pos - 1))
+    end
+end
@@ -0,0 +1,95 @@
+// lua_embed.c
+// Compiles Lua scripts to stripped bytecode and writes them as a C source file
+// defining script_bundle[] (see script_cache.h). Run by the build when the
+// SDL3_LUA_EMBED_SCRIPTS option is on.
+//
+// Usage: sdl3_lua_embed out.c root_dir script.lua [script.lua ...]
+//   Each script path is relative to root_dir and becomes its bundle key.
+#include <lua.h>
+#include <lauxlib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    FILE *out;
+    size_t size;
+} writer_state;
+
+static int write_bytes(lua_State *L, const void *p, size_t sz, void *ud) {
+    writer_state *w = (writer_state *)ud;
+    const unsigned char *bytes = (const unsigned char *)p;
+    for (size_t i = 0; i < sz; i++, w->size++) {
+        fprintf(w->out, "%s%u,", (w->size % 20) == 0 ? "\n    " : "", bytes[i]);
+    }
+    return 0;
+}
+
+// Bundle keys use '/' so they match on every platform
+static void print_key(FILE *out, const char *path) {
+    fputc('"', out);
+    for (; *path; path++) {
+        if (*path == '\\') fputc('/', out);
+        else if (*path == '"') fputs("\\\"", out);
+        else fputc(*path, out);
+    }
+    fputc('"', out);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s out.c root_dir [script.lua ...]\n", argv[0]);
+        return 1;
+    }
+    FILE *out = fopen(argv[1], "w");
+    if (!out) {
+        fprintf(stderr, "Error: could not open '%s' for writing.\n", argv[1]);
+        return 1;
+    }
+    lua_State *L = luaL_newstate();
+    if (!L) {
+        fclose(out);
+        return 1;
+    }
+
+    fprintf(out, "// Generated by lua_embed, do not edit.\n#include \"script_cache.h\"\n");
+    int count = argc - 3;
+    size_t *sizes = (size_t *)calloc(count > 0 ? count : 1, sizeof(size_t));
+    int failed = 0;
+    for (int i = 0; i < count && !failed; i++) {
+        const char *script = argv[i + 3];
+        char path[4096];
+        snprintf(path, sizeof(path), "%s/%s", argv[2], script);
+        if (luaL_loadfile(L, path) != LUA_OK) {
+            fprintf(stderr, "Error: %s\n", lua_tostring(L, -1));
+            failed = 1;
+            break;
+        }
+        // Stripped of debug info; script_cache names the chunk after its bundle key
+        writer_state w = {out, 0};
+        fprintf(out, "\n// %s\nstatic const unsigned char script_%d[] = {", script, i);
+        lua_dump(L, write_bytes, &w, 1);
+        fprintf(out, "\n};\n");
+        sizes[i] = w.size;
+        lua_pop(L, 1);
+    }
+
+    if (!failed) {
+        fprintf(out, "\nconst script_bundle_entry script_bundle[] = {\n");
+        for (int i = 0; i < count; i++) {
+            fprintf(out, "    {");
+            print_key(out, argv[i + 3]);
+            fprintf(out, ", script_%d, %zu},\n", i, sizes[i]);
+        }
+        fprintf(out, "    {NULL, NULL, 0}\n};\n");
+    }
+    free(sizes);
+    lua_close(L);
+    if (fclose(out) != 0) failed = 1;
+    if (failed) {
+        remove(argv[1]);
+        return 1;
+    }
+    printf("lua_embed: %d scripts -> %s\n", count, argv[1]);
+    return 0;
+}
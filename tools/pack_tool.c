@@ -0,0 +1,207 @@
+// pack_tool.c
+// Builds an asset pack (see asset_pack.h) from files and directories.
+// Entries are LZ4-compressed (high compression mode) when that saves at least
+// an eighth of their size, so already-compressed formats like PNG stay stored
+// and load without a copy.
+//
+// Usage: sdl3_lua_pack [--no-compress] [--level N] out.pak root_dir path [path ...]
+//   Each path is relative to root_dir and becomes the entry name; directories
+//   are added recursively, skipping names that start with '.'.
+#include "asset_pack.h"
+#include <SDL3/SDL.h>
+#include <lz4hc.h>
+#include <stdio.h>
+
+typedef struct {
+    char *name;
+    size_t name_len;
+    Uint64 hash;
+    void *data;                 // stored bytes
+    size_t size;
+    size_t raw_size;
+    Uint32 flags;
+} pack_item;
+
+static struct {
+    pack_item *items;
+    int count;
+    int capacity;
+    const char *root;
+} g_pack;
+
+static int add_file(const char *name) {
+    if (g_pack.count == g_pack.capacity) {
+        int capacity = g_pack.capacity ? g_pack.capacity * 2 : 256;
+        pack_item *items = (pack_item *)SDL_realloc(g_pack.items, capacity * sizeof(pack_item));
+        if (!items) return 0;
+        g_pack.items = items;
+        g_pack.capacity = capacity;
+    }
+    char normalized[1024];
+    asset_pack_normalize(name, normalized, sizeof(normalized));
+    pack_item *item = &g_pack.items[g_pack.count++];
+    SDL_zerop(item);
+    item->name = SDL_strdup(normalized);
+    item->name_len = SDL_strlen(normalized);
+    item->hash = asset_pack_hash(normalized, item->name_len);
+    return item->name != NULL;
+}
+
+static int add_path(const char *name);
+
+static SDL_EnumerationResult SDLCALL add_child(void *userdata, const char *dirname, const char *fname) {
+    if (fname[0] == '.') return SDL_ENUM_CONTINUE;
+    char name[1024];
+    SDL_snprintf(name, sizeof(name), "%s/%s", (const char *)userdata, fname);
+    return add_path(name) ? SDL_ENUM_CONTINUE : SDL_ENUM_FAILURE;
+}
+
+static int add_path(const char *name) {
+    char full[2048];
+    SDL_snprintf(full, sizeof(full), "%s/%s", g_pack.root, name);
+    SDL_PathInfo info;
+    if (!SDL_GetPathInfo(full, &info)) {
+        fprintf(stderr, "Error: '%s' not found.\n", full);
+        return 0;
+    }
+    if (info.type == SDL_PATHTYPE_DIRECTORY) {
+        return SDL_EnumerateDirectory(full, add_child, (void *)name);
+    }
+    return info.type == SDL_PATHTYPE_FILE ? add_file(name) : 1;
+}
+
+static int compare_items(const void *a, const void *b) {
+    const pack_item *x = (const pack_item *)a;
+    const pack_item *y = (const pack_item *)b;
+    if (x->hash != y->hash) return x->hash < y->hash ? -1 : 1;
+    return SDL_strcmp(x->name, y->name);
+}
+
+// Helper: Read an item and compress it if that pays off
+static int load_item(pack_item *item, int compress, int level) {
+    char full[2048];
+    SDL_snprintf(full, sizeof(full), "%s/%s", g_pack.root, item->name);
+    item->data = SDL_LoadFile(full, &item->raw_size);
+    if (!item->data) {
+        fprintf(stderr, "Error: could not read '%s': %s\n", full, SDL_GetError());
+        return 0;
+    }
+    item->size = item->raw_size;
+    if (!compress || item->raw_size < 64 || item->raw_size > LZ4_MAX_INPUT_SIZE) return 1;
+
+    int bound = LZ4_compressBound((int)item->raw_size);
+    char *packed = (char *)SDL_malloc((size_t)bound);
+    if (!packed) return 0;
+    int n = LZ4_compress_HC((const char *)item->data, packed, (int)item->raw_size, bound, level);
+    if (n > 0 && (size_t)n < item->raw_size - item->raw_size / 8) {
+        SDL_free(item->data);
+        item->data = packed;
+        item->size = (size_t)n;
+        item->flags = ASSET_PACK_LZ4;
+    } else {
+        SDL_free(packed);
+    }
+    return 1;
+}
+
+static int write_pack(const char *out_path) {
+    Uint64 names_size = 0;
+    for (int i = 0; i < g_pack.count; i++) {
+        names_size += g_pack.items[i].name_len;
+    }
+    Uint64 names_offset = sizeof(asset_pack_header) + (Uint64)g_pack.count * sizeof(asset_pack_entry);
+    Uint64 offset = (names_offset + names_size + 15) & ~(Uint64)15;
+
+    asset_pack_entry *entries = (asset_pack_entry *)SDL_calloc(g_pack.count ? g_pack.count : 1, sizeof(asset_pack_entry));
+    if (!entries) return 0;
+    Uint32 name_offset = 0;
+    for (int i = 0; i < g_pack.count; i++) {
+        pack_item *item = &g_pack.items[i];
+        entries[i].hash = item->hash;
+        entries[i].offset = offset;
+        entries[i].size = item->size;
+        entries[i].raw_size = item->raw_size;
+        entries[i].name_offset = name_offset;
+        entries[i].name_len = (Uint32)item->name_len;
+        entries[i].flags = item->flags;
+        name_offset += (Uint32)item->name_len;
+        offset = (offset + item->size + 15) & ~(Uint64)15;
+    }
+
+    asset_pack_header h;
+    SDL_zero(h);
+    SDL_memcpy(h.magic, ASSET_PACK_MAGIC, 4);
+    h.version = ASSET_PACK_VERSION;
+    h.count = (Uint32)g_pack.count;
+    h.names_offset = names_offset;
+    h.names_size = names_size;
+
+    SDL_IOStream *io = SDL_IOFromFile(out_path, "wb");
+    if (!io) {
+        SDL_free(entries);
+        return 0;
+    }
+    static const Uint8 zeros[16] = {0};
+    Uint64 pos = 0;
+    int ok = SDL_WriteIO(io, &h, sizeof(h)) == sizeof(h) &&
+             SDL_WriteIO(io, entries, g_pack.count * sizeof(asset_pack_entry)) == g_pack.count * sizeof(asset_pack_entry);
+    pos = names_offset;
+    for (int i = 0; ok && i < g_pack.count; i++) {
+        ok = SDL_WriteIO(io, g_pack.items[i].name, g_pack.items[i].name_len) == g_pack.items[i].name_len;
+        pos += g_pack.items[i].name_len;
+    }
+    for (int i = 0; ok && i < g_pack.count; i++) {
+        size_t pad = (size_t)(entries[i].offset - pos);
+        ok = SDL_WriteIO(io, zeros, pad) == pad &&
+             SDL_WriteIO(io, g_pack.items[i].data, g_pack.items[i].size) == g_pack.items[i].size;
+        pos = entries[i].offset + g_pack.items[i].size;
+    }
+    ok = SDL_CloseIO(io) && ok;
+    SDL_free(entries);
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    int compress = 1;
+    int level = LZ4HC_CLEVEL_MAX;
+    int arg = 1;
+    for (; arg < argc && SDL_strncmp(argv[arg], "--", 2) == 0; arg++) {
+        if (SDL_strcmp(argv[arg], "--no-compress") == 0) {
+            compress = 0;
+        } else if (SDL_strcmp(argv[arg], "--level") == 0 && arg + 1 < argc) {
+            level = SDL_atoi(argv[++arg]);
+        } else {
+            break;
+        }
+    }
+    if (argc - arg < 3) {
+        fprintf(stderr, "Usage: %s [--no-compress] [--level N] out.pak root_dir path [path ...]\n", argv[0]);
+        return 1;
+    }
+    const char *out_path = argv[arg];
+    g_pack.root = argv[arg + 1];
+    for (int i = arg + 2; i < argc; i++) {
+        if (!add_path(argv[i])) return 1;
+    }
+
+    SDL_qsort(g_pack.items, (size_t)g_pack.count, sizeof(pack_item), compare_items);
+    Uint64 raw_total = 0, stored_total = 0;
+    int compressed = 0;
+    for (int i = 0; i < g_pack.count; i++) {
+        if (i > 0 && compare_items(&g_pack.items[i - 1], &g_pack.items[i]) == 0) {
+            fprintf(stderr, "Error: '%s' added twice.\n", g_pack.items[i].name);
+            return 1;
+        }
+        if (!load_item(&g_pack.items[i], compress, level)) return 1;
+        raw_total += g_pack.items[i].raw_size;
+        stored_total += g_pack.items[i].size;
+        compressed += g_pack.items[i].flags & ASSET_PACK_LZ4 ? 1 : 0;
+    }
+    if (!write_pack(out_path)) {
+        fprintf(stderr, "Error: could not write '%s': %s\n", out_path, SDL_GetError());
+        return 1;
+    }
+    printf("%s: %d entries (%d compressed), %llu -> %llu bytes\n", out_path, g_pack.count, compressed,
+           (unsigned long long)raw_total, (unsigned long long)stored_total);
+    return 0;
+}